@@ -2,8 +2,14 @@
 
 #include <eosio/eosio.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
 
 #include <pieos.hpp>
+#include <pieos-sco-math.hpp>
+
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace pieos::eosiosystem {
 
@@ -30,6 +36,14 @@ namespace pieos::eosiosystem {
 
    typedef eosio::multi_index< "stat"_n, currency_stats > stats_table;
 
+   /**
+    * recipient and quantity of a PIEOS token contract `bulktransfer`
+    */
+   struct token_transfer_entry {
+      name     to;
+      asset    quantity;
+   };
+
    class token_contract_action_interface {
    public:
 
@@ -55,10 +69,22 @@ namespace pieos::eosiosystem {
                              const name&    to,
                              const asset&   quantity,
                              const string&  memo );
+
+      /**
+       * Allows `from` account to transfer tokens to several accounts in one action (PIEOS token contract only, not `eosio.token`).
+       *
+       * @param from - the account to transfer from,
+       * @param transfers - the recipients and quantities,
+       * @param memo - the memo string to accompany the transaction.
+       */
+      virtual void bulktransfer( const name&                                from,
+                                 const std::vector<token_transfer_entry>&   transfers,
+                                 const string&                              memo );
    };
 
    using token_issue_action = eosio::action_wrapper<"issue"_n, &token_contract_action_interface::issue>;
    using token_transfer_action = eosio::action_wrapper<"transfer"_n, &token_contract_action_interface::transfer>;
+   using token_bulktransfer_action = eosio::action_wrapper<"bulktransfer"_n, &token_contract_action_interface::bulktransfer>;
 
    asset get_token_balance_from_contract( const name& contract, const name& account, const symbol& symbol ) {
       accounts_table accounts(contract, account.value);
@@ -137,6 +163,65 @@ namespace pieos::eosiosystem {
 
    typedef eosio::multi_index< "rexbal"_n, rex_balance > rex_balance_table;
 
+   struct rex_fund {
+      uint8_t version = 0;
+      name    owner;
+      asset   balance;
+
+      uint64_t primary_key()const { return owner.value; }
+   };
+
+   typedef eosio::multi_index< "rexfund"_n, rex_fund > rex_fund_table;
+
+   struct rex_loan {
+      uint8_t             version = 0;
+      name                from;
+      name                receiver;
+      asset               payment;
+      asset               balance;
+      asset               total_staked;
+      uint64_t            loan_num;
+      eosio::time_point   expiration;
+
+      uint64_t primary_key()const { return loan_num; }
+      uint64_t by_expr()const     { return expiration.elapsed.count(); }
+   };
+
+   typedef eosio::multi_index< "cpuloan"_n, rex_loan,
+                               indexed_by<"byexpr"_n, const_mem_fun<rex_loan, uint64_t, &rex_loan::by_expr>>
+                             > rex_cpu_loan_table;
+
+   typedef eosio::multi_index< "netloan"_n, rex_loan,
+                               indexed_by<"byexpr"_n, const_mem_fun<rex_loan, uint64_t, &rex_loan::by_expr>>
+                             > rex_net_loan_table;
+
+   struct rex_order {
+      uint8_t             version = 0;
+      name                owner;
+      asset               rex_requested;
+      asset               proceeds;
+      asset               stake_change;
+      eosio::time_point   order_time;
+      bool                is_open = true;
+
+      uint64_t primary_key()const { return owner.value; }
+      uint64_t by_time()const     { return is_open ? order_time.elapsed.count() : std::numeric_limits<uint64_t>::max(); }
+   };
+
+   typedef eosio::multi_index< "rexqueue"_n, rex_order,
+                               indexed_by<"bytime"_n, const_mem_fun<rex_order, uint64_t, &rex_order::by_time>>
+                             > rex_order_table;
+
+   // queued sell orders are filled within 30 days at most, as the REX loans expire
+   static constexpr uint32_t rex_order_max_fill_sec = 30 * seconds_per_day;
+
+   // open sell orders the system contract's `runrex` fills before a new `sellrex`
+   static constexpr uint32_t rex_orders_filled_per_action = 2;
+
+   // bounds of the `rexqueue` and loan table scans of `estimate_rex_order_fill_time`
+   static constexpr uint32_t rex_order_scan_limit = 20;
+   static constexpr uint32_t rex_loan_scan_limit  = 50;
+
    class system_contract_action_interface {
    public:
       /**
@@ -340,10 +425,23 @@ namespace pieos::eosiosystem {
 
       const int64_t S0 = rp_itr->total_lendable.amount + rex_pool_lendable_change_amount;
       const int64_t R0 = rp_itr->total_rex.amount;
-      const int64_t eos_balance = (uint128_t(rex_balance.amount) * S0) / R0;
+      const int64_t eos_balance = sco_math::rex_to_core_token( rex_balance.amount, S0, R0 );
       return asset( eos_balance, CORE_TOKEN_SYMBOL );
    }
 
+   asset core_token_to_rex_balance( const asset& core_token, const int64_t rex_pool_lendable_change_amount ) {
+      rex_pool_table rex_pool( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto rp_itr = rex_pool.begin();
+      if ( rp_itr == rex_pool.end() || rp_itr->total_rex.amount == 0 ) {
+         // the system contract's initial REX rate, 1 EOS = 10000 REX
+         return asset( core_token.amount * 10000, REX_SYMBOL );
+      }
+
+      const int64_t S0 = rp_itr->total_lendable.amount + rex_pool_lendable_change_amount;
+      const int64_t R0 = rp_itr->total_rex.amount;
+      return asset( sco_math::core_token_to_rex( core_token.amount, S0, R0 ), REX_SYMBOL );
+   }
+
    asset rex_to_core_token_balance( const asset& rex_balance ) {
       return rex_to_core_token_balance( rex_balance, calc_rex_pool_lendable_change_amount() );
    }
@@ -357,6 +455,184 @@ namespace pieos::eosiosystem {
       return rex_to_core_token_balance( account_rex_balance );
    }
 
+   /**
+    * @brief REX fund balance of `account`, including the proceeds of its filled sell order,
+    * which the system contract moves to the REX fund on the account's next REX action
+    */
+   asset get_rex_fund_balance( const name& account ) {
+      asset balance( 0, CORE_TOKEN_SYMBOL );
+
+      rex_fund_table rex_funds( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto rf_itr = rex_funds.find( account.value );
+      if ( rf_itr != rex_funds.end() ) {
+         balance += rf_itr->balance;
+      }
+
+      rex_order_table rex_orders( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto ro_itr = rex_orders.find( account.value );
+      if ( ro_itr != rex_orders.end() && !ro_itr->is_open ) {
+         balance += ro_itr->proceeds;
+      }
+      return balance;
+   }
+
+   /**
+    * @brief open (queued) sell order of `account`, an order of zero REX if there is none
+    */
+   rex_order get_open_rex_order( const name& account ) {
+      rex_order_table rex_orders( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto ro_itr = rex_orders.find( account.value );
+      if ( ro_itr == rex_orders.end() || !ro_itr->is_open ) {
+         return rex_order{ 0, account, asset( 0, REX_SYMBOL ), asset( 0, CORE_TOKEN_SYMBOL ), asset( 0, CORE_TOKEN_SYMBOL ), eosio::time_point(), false };
+      }
+      return *ro_itr;
+   }
+
+   /**
+    * @brief REX amount of the open (queued) sell order of `account`, zero if there is none
+    */
+   asset get_open_rex_order_amount( const name& account ) {
+      return get_open_rex_order( account ).rex_requested;
+   }
+
+   /**
+    * @brief EOS value of the open sell orders in the `rexqueue`, in order time, up to `max_orders` orders
+    *
+    * @return EOS value of the scanned orders and whether the scan reached the end of the open orders
+    */
+   std::pair<int64_t, bool> get_queued_rex_order_value( const uint32_t max_orders, const int64_t rex_pool_lendable_change_amount ) {
+      rex_order_table rex_orders( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto idx = rex_orders.get_index<"bytime"_n>();
+
+      int64_t value = 0;
+      uint32_t scanned = 0;
+      for ( auto itr = idx.begin(); itr != idx.end() && itr->is_open; ++itr ) {
+         if ( scanned++ == max_orders ) {
+            return { value, false };
+         }
+         value += rex_to_core_token_balance( itr->rex_requested, rex_pool_lendable_change_amount ).amount;
+      }
+      return { value, true };
+   }
+
+   /**
+    * @brief EOS a new `sellrex` order can be filled with immediately: the REX pool's available unlent EOS
+    * less the open orders `runrex` fills first
+    */
+   int64_t get_rex_available_unlent( const int64_t rex_pool_lendable_change_amount ) {
+      rex_pool_table rex_pool( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto rp_itr = rex_pool.begin();
+      if ( rp_itr == rex_pool.end() ) {
+         return 0;
+      }
+
+      // REX return proceeds are added to both the lendable and the unlent EOS of the pool
+      const int64_t available_unlent = sco_math::rex_available_unlent( rp_itr->total_unlent.amount + rex_pool_lendable_change_amount, rp_itr->total_lent.amount );
+      return available_unlent - get_queued_rex_order_value( rex_orders_filled_per_action, rex_pool_lendable_change_amount ).first;
+   }
+
+   /**
+    * @brief Estimates when a queued sell order of `proceeds` EOS is filled.
+    * The open orders ahead in the queue are filled first, and expiring CPU and NET loans return
+    * their staked EOS (plus its 20% lower bound share) to the available unlent EOS of the REX pool.
+    *
+    * @return expiration of the loan after which the order can be filled,
+    * or `rex_order_max_fill_sec` from now if the scanned orders and loans do not settle the estimate
+    */
+   time_point_sec estimate_rex_order_fill_time( const int64_t proceeds, const int64_t rex_pool_lendable_change_amount ) {
+      const time_point_sec ct = current_time_point();
+      const time_point_sec max_fill_time = ct + rex_order_max_fill_sec;
+
+      rex_pool_table rex_pool( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto rp_itr = rex_pool.begin();
+      if ( rp_itr == rex_pool.end() ) {
+         return max_fill_time;
+      }
+
+      const auto [queued_value, queue_scanned] = get_queued_rex_order_value( rex_order_scan_limit, rex_pool_lendable_change_amount );
+      if ( !queue_scanned ) {
+         return max_fill_time;
+      }
+
+      const int64_t available_unlent = sco_math::rex_available_unlent( rp_itr->total_unlent.amount + rex_pool_lendable_change_amount, rp_itr->total_lent.amount );
+      int64_t shortfall = queued_value + proceeds - available_unlent;
+      if ( shortfall <= 0 ) {
+         return ct;
+      }
+
+      rex_cpu_loan_table cpu_loans( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      rex_net_loan_table net_loans( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto cpu_idx = cpu_loans.get_index<"byexpr"_n>();
+      auto net_idx = net_loans.get_index<"byexpr"_n>();
+      auto cpu_itr = cpu_idx.begin();
+      auto net_itr = net_idx.begin();
+
+      // merge the two loan tables in expiration order
+      for ( uint32_t scanned = 0; scanned < rex_loan_scan_limit; ++scanned ) {
+         const bool has_cpu = cpu_itr != cpu_idx.end(), has_net = net_itr != net_idx.end();
+         if ( !has_cpu && !has_net ) {
+            break;
+         }
+
+         const bool take_cpu = has_cpu && ( !has_net || cpu_itr->expiration <= net_itr->expiration );
+         const rex_loan& loan = take_cpu ? *cpu_itr : *net_itr;
+         shortfall -= loan.total_staked.amount + sco_math::mul_div( 2, loan.total_staked.amount, 10 );
+         if ( shortfall <= 0 ) {
+            return std::max( ct, time_point_sec( loan.expiration ) );
+         }
+
+         if ( take_cpu ) ++cpu_itr; else ++net_itr;
+      }
+      return max_fill_time;
+   }
+
+   struct voter_info {
+      name                owner;
+      name                proxy;
+      std::vector<name>   producers;
+      int64_t             staked = 0;
+      double              last_vote_weight = 0;
+      double              proxied_vote_weight = 0;
+      bool                is_proxy = 0;
+      uint32_t            flags1 = 0;
+      uint32_t            reserved2 = 0;
+      eosio::asset        reserved3;
+
+      uint64_t primary_key()const { return owner.value; }
+   };
+
+   typedef eosio::multi_index< "voters"_n, voter_info > voters_table;
+
+   /**
+    * @brief EOS amount `voter` votes with through `proxy`, its staked EOS (including the REX vote stake)
+    * if its vote is proxied to `proxy`, zero otherwise
+    */
+   int64_t get_proxied_vote_stake( const name& voter, const name& proxy ) {
+      voters_table voters( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      auto itr = voters.find( voter.value );
+      if ( itr == voters.end() || itr->proxy != proxy ) {
+         return 0;
+      }
+      return itr->staked;
+   }
+
+   struct abi_hash {
+      name              owner;
+      checksum256       hash;
+
+      uint64_t primary_key()const { return owner.value; }
+   };
+
+   typedef eosio::multi_index< "abihash"_n, abi_hash > abi_hash_table;
+
+   /**
+    * @brief whether `account` has set a contract ABI (`setabi`), i.e. runs a contract which may reject the notifications it receives
+    */
+   bool has_contract_abi( const name& account ) {
+      abi_hash_table abi_hashes( EOSIO_SYSTEM_CONTRACT, EOSIO_SYSTEM_CONTRACT.value );
+      return abi_hashes.find( account.value ) != abi_hashes.end();
+   }
+
    /**
     * @brief Calculates maturity time of purchased REX tokens which is 4 days from end
     * of the day UTC
@@ -364,15 +640,7 @@ namespace pieos::eosiosystem {
     * @return time_point_sec
     */
    time_point_sec get_rex_maturity(block_timestamp buyrex_block_time) {
-      const uint32_t num_of_maturity_buckets = 5;
-      static const uint32_t buyrex_time_sec = buyrex_block_time.to_time_point().sec_since_epoch();
-      static const uint32_t r   = buyrex_time_sec % seconds_per_day;
-      static const time_point_sec rms{ buyrex_time_sec - r + num_of_maturity_buckets * seconds_per_day };
-
-//      static const uint32_t buyrex_time_sec = buyrex_block_time.to_time_point().sec_since_epoch();
-//      static const time_point_sec rms{ buyrex_time_sec + 60*3 }; // 3 minutes
-
-      return rms;
+      return time_point_sec( sco_math::rex_maturity_sec( buyrex_block_time.to_time_point().sec_since_epoch() ) );
    }
 
 } // namespace pieos::eosiosystem
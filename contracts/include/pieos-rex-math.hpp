@@ -0,0 +1,350 @@
+#pragma once
+
+#include <pieos-sco-math.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <utility>
+
+/**
+ * REX market arithmetic of the `eosio` system contract (rex.cpp), free of eosio dependencies so that it
+ * is shared by the native simulator (tools/pieos-sco-sim) and the REX emulator test contract
+ * (contracts/pieos-rex-emulator).
+ *
+ * The functions update plain copies of the `rexpool`, `rexretpool`, `retbuckets` and `rexbal` rows
+ * with the system contract's integer arithmetic and rounding. Times are seconds since epoch.
+ * Authorization, token transfers and the `check()`s of the system contract actions are left to the callers.
+ */
+namespace pieos::rex_math {
+
+   static constexpr uint32_t TOTAL_INTERVALS  = 30 * 144;    // return buckets are distributed over 30 days
+   static constexpr uint32_t DIST_INTERVAL    = 10 * 60;     // in 10 minute intervals
+   static constexpr uint32_t BUCKET_INTERVAL  = 12 * 3600;   // proceeds are collected in 12 hour buckets
+   static constexpr uint32_t RETURN_PERIOD    = TOTAL_INTERVALS * DIST_INTERVAL;
+   static constexpr uint32_t TIME_MAX         = std::numeric_limits<uint32_t>::max();
+
+   static constexpr int64_t  REX_RATIO        = 10000;       // initial REX rate, 1 EOS = 10000 REX
+   static constexpr int64_t  INIT_TOTAL_RENT  = 20'000'0000; // initial rent connector balance
+   static constexpr uint32_t LOAN_PERIOD_SEC  = 30 * sco_math::SECONDS_PER_DAY;
+   static constexpr uint16_t ORDERS_FILLED_PER_ACTION = 2;     // open sell orders `runrex` fills in each REX action
+
+   /// `rexpool` row
+   struct pool {
+      int64_t  total_lent       = 0;
+      int64_t  total_unlent     = 0;
+      int64_t  total_rent       = 0;
+      int64_t  total_lendable   = 0;
+      int64_t  total_rex        = 0;
+      int64_t  namebid_proceeds = 0;
+      uint64_t loan_num         = 0;
+   };
+
+   /// `rexretpool` row
+   struct return_pool {
+      uint32_t last_dist_time           = 0;
+      uint32_t pending_bucket_time      = TIME_MAX;
+      uint32_t oldest_bucket_time       = 0;
+      int64_t  pending_bucket_proceeds  = 0;
+      int64_t  current_rate_of_increase = 0;
+      int64_t  proceeds                 = 0;
+   };
+
+   /// `rexretpool` and `retbuckets` rows, created by the first proceeds channeled to REX
+   struct return_state {
+      bool                        initialized = false;
+      return_pool                 pool;
+      std::map<uint32_t, int64_t> buckets; // bucket time => rate of increase per interval
+   };
+
+   /// `rexbal` row
+   struct balance {
+      int64_t vote_stake  = 0;
+      int64_t rex_balance = 0;
+      int64_t matured_rex = 0;
+      std::deque<std::pair<uint32_t, int64_t>> rex_maturities; // maturity time => REX
+   };
+
+   struct order_fill {
+      bool    success      = false;
+      int64_t proceeds     = 0;
+      int64_t stake_change = 0;
+   };
+
+   constexpr uint32_t elapsed_intervals( const uint32_t t1, const uint32_t t0 ) {
+      return ( t1 - t0 ) / DIST_INTERVAL;
+   }
+
+   constexpr uint32_t return_threshold( const uint32_t effective_time ) {
+      return effective_time > RETURN_PERIOD ? effective_time - RETURN_PERIOD : 0;
+   }
+
+   /**
+    * @brief distributes the return buckets' proceeds accrued up to `now` to the pool (`update_rex_pool`)
+    * @return EOS added to the lendable and unlent EOS of the pool
+    */
+   inline int64_t update_rex_pool( pool& p, return_state& ret, const uint32_t now ) {
+      auto& rp = ret.pool;
+      const uint32_t effective_time = now - now % DIST_INTERVAL;
+      if ( !ret.initialized || effective_time <= rp.last_dist_time ) {
+         return 0;
+      }
+
+      int64_t change_estimate = rp.current_rate_of_increase * elapsed_intervals( effective_time, rp.last_dist_time );
+
+      if ( rp.pending_bucket_time <= effective_time ) {
+         const int64_t  remainder       = rp.pending_bucket_proceeds % TOTAL_INTERVALS;
+         const int64_t  new_bucket_rate = ( rp.pending_bucket_proceeds - remainder ) / TOTAL_INTERVALS;
+         const uint32_t new_bucket_time = rp.pending_bucket_time;
+         rp.current_rate_of_increase += new_bucket_rate;
+         change_estimate             += remainder + new_bucket_rate * elapsed_intervals( effective_time, new_bucket_time );
+         rp.pending_bucket_proceeds   = 0;
+         rp.pending_bucket_time       = TIME_MAX;
+         if ( new_bucket_time < rp.oldest_bucket_time ) {
+            rp.oldest_bucket_time = new_bucket_time;
+         }
+         if ( new_bucket_rate > 0 ) {
+            ret.buckets[new_bucket_time] += new_bucket_rate;
+         }
+      }
+      rp.proceeds      -= change_estimate;
+      rp.last_dist_time = effective_time;
+
+      const uint32_t time_threshold = return_threshold( effective_time );
+      if ( rp.oldest_bucket_time <= time_threshold ) {
+         int64_t expired_rate = 0;
+         int64_t surplus      = 0;
+         auto itr = ret.buckets.begin();
+         while ( itr != ret.buckets.end() && itr->first <= time_threshold ) {
+            surplus      += itr->second * elapsed_intervals( effective_time, itr->first + RETURN_PERIOD );
+            expired_rate += itr->second;
+            itr = ret.buckets.erase( itr );
+         }
+         rp.oldest_bucket_time = ret.buckets.empty() ? 0 : ret.buckets.begin()->first;
+         if ( expired_rate > 0 ) {
+            rp.current_rate_of_increase -= expired_rate;
+         }
+         if ( surplus > 0 ) {
+            change_estimate -= surplus;
+            rp.proceeds     += surplus;
+         }
+      }
+
+      if ( change_estimate > 0 && rp.proceeds < 0 ) {
+         change_estimate += rp.proceeds;
+         rp.proceeds      = 0;
+      }
+
+      if ( change_estimate <= 0 ) {
+         return 0;
+      }
+      p.total_unlent  += change_estimate;
+      p.total_lendable = p.total_unlent + p.total_lent;
+      return change_estimate;
+   }
+
+   /**
+    * @brief EOS the next `update_rex_pool` at `now` adds to the pool, without updating the rows.
+    * Same algorithm as the SCO contract's `calc_rex_pool_lendable_change_amount`.
+    */
+   inline int64_t lendable_change_amount( const return_state& ret, const uint32_t now ) {
+      const auto& rp = ret.pool;
+      const uint32_t effective_time = now - now % DIST_INTERVAL;
+      if ( !ret.initialized || effective_time <= rp.last_dist_time ) {
+         return 0;
+      }
+
+      int64_t  change_estimate    = rp.current_rate_of_increase * elapsed_intervals( effective_time, rp.last_dist_time );
+      int64_t  proceeds           = rp.proceeds;
+      uint32_t oldest_bucket_time = rp.oldest_bucket_time;
+
+      int64_t  new_bucket_rate = 0;
+      uint32_t new_bucket_time = 0;
+      if ( rp.pending_bucket_time <= effective_time ) {
+         const int64_t remainder = rp.pending_bucket_proceeds % TOTAL_INTERVALS;
+         new_bucket_rate  = ( rp.pending_bucket_proceeds - remainder ) / TOTAL_INTERVALS;
+         new_bucket_time  = rp.pending_bucket_time;
+         change_estimate += remainder + new_bucket_rate * elapsed_intervals( effective_time, new_bucket_time );
+         if ( new_bucket_time < oldest_bucket_time ) {
+            oldest_bucket_time = new_bucket_time;
+         }
+      }
+      proceeds -= change_estimate;
+
+      const uint32_t time_threshold = return_threshold( effective_time );
+      if ( oldest_bucket_time <= time_threshold ) {
+         int64_t surplus = 0;
+         for ( auto itr = ret.buckets.begin(); itr != ret.buckets.end() && itr->first <= time_threshold; ++itr ) {
+            surplus += itr->second * elapsed_intervals( effective_time, itr->first + RETURN_PERIOD );
+         }
+         if ( new_bucket_rate > 0 && new_bucket_time <= time_threshold ) {
+            surplus += new_bucket_rate * elapsed_intervals( effective_time, new_bucket_time + RETURN_PERIOD );
+         }
+         if ( surplus > 0 ) {
+            change_estimate -= surplus;
+            proceeds        += surplus;
+         }
+      }
+
+      if ( change_estimate > 0 && proceeds < 0 ) {
+         change_estimate += proceeds;
+      }
+      return change_estimate > 0 ? change_estimate : 0;
+   }
+
+   /**
+    * @brief channels `fee` (rent, name bid and RAM fees) to the REX return pool (`add_to_rex_return_pool`),
+    * it is added to the 12 hour bucket ending after `now` and distributed to the pool over the next 30 days
+    */
+   inline void add_to_rex_return_pool( pool& p, return_state& ret, const int64_t fee, const uint32_t now ) {
+      update_rex_pool( p, ret, now );
+      if ( fee <= 0 ) {
+         return;
+      }
+
+      const uint32_t effective_time = now - now % BUCKET_INTERVAL + BUCKET_INTERVAL;
+      auto& rp = ret.pool;
+      if ( !ret.initialized ) {
+         ret.initialized            = true;
+         rp                         = return_pool();
+         rp.last_dist_time          = effective_time;
+         rp.pending_bucket_proceeds = fee;
+         rp.pending_bucket_time     = effective_time;
+         rp.proceeds                = fee;
+         ret.buckets.clear();
+      } else {
+         rp.pending_bucket_proceeds += fee;
+         rp.proceeds                += fee;
+         if ( rp.pending_bucket_time == TIME_MAX ) {
+            rp.pending_bucket_time = effective_time;
+         }
+      }
+   }
+
+   /**
+    * @brief adds `payment` EOS to the pool for newly issued REX (`add_to_rex_pool`), an empty or depleted pool
+    * restarts at the initial REX rate
+    * @return REX issued
+    */
+   inline int64_t add_to_rex_pool( pool& p, const int64_t payment ) {
+      if ( p.total_rex <= 0 ) {
+         p.total_lendable = payment;
+         p.total_lent     = 0;
+         p.total_unlent   = payment;
+         p.total_rent     = INIT_TOTAL_RENT;
+         p.total_rex      = payment * REX_RATIO;
+         return p.total_rex;
+      }
+
+      const int64_t S0 = p.total_lendable;
+      const int64_t S1 = S0 + payment;
+      const int64_t R0 = p.total_rex;
+      const int64_t R1 = sco_math::mul_div( S1, R0, S0 );
+
+      p.total_lendable = S1;
+      p.total_rex      = R1;
+      p.total_unlent   = p.total_lendable - p.total_lent;
+      return R1 - R0;
+   }
+
+   /**
+    * @brief moves the REX maturity buckets due at `now` to the matured REX (`process_rex_maturities`)
+    */
+   inline void process_rex_maturities( balance& b, const uint32_t now ) {
+      while ( !b.rex_maturities.empty() && b.rex_maturities.front().first <= now ) {
+         b.matured_rex += b.rex_maturities.front().second;
+         b.rex_maturities.pop_front();
+      }
+   }
+
+   /**
+    * @brief adds `rex_received` REX bought for `payment` EOS at `now` to a REX balance (`add_to_rex_balance`),
+    * maturing at the start of the fifth day from now
+    * @return vote stake change
+    */
+   inline int64_t add_to_rex_balance( balance& b, const bool new_balance, const pool& p, const int64_t payment,
+                                      const int64_t rex_received, const uint32_t now ) {
+      const int64_t init_rex_stake = new_balance ? 0 : b.vote_stake;
+      b.rex_balance += rex_received;
+      b.vote_stake   = new_balance ? payment : sco_math::mul_div( b.rex_balance, p.total_lendable, p.total_rex );
+
+      process_rex_maturities( b, now );
+      const uint32_t maturity = sco_math::rex_maturity_sec( now );
+      if ( !b.rex_maturities.empty() && b.rex_maturities.back().first == maturity ) {
+         b.rex_maturities.back().second += rex_received;
+      } else {
+         b.rex_maturities.emplace_back( maturity, rex_received );
+      }
+      return b.vote_stake - init_rex_stake;
+   }
+
+   /**
+    * @brief sells `rex` matured REX of a balance if the pool's available unlent EOS covers the proceeds
+    * (`fill_rex_order`), otherwise nothing changes and the order is left to be queued
+    */
+   inline order_fill fill_rex_order( pool& p, balance& b, const int64_t rex ) {
+      const int64_t S0 = p.total_lendable;
+      const int64_t R0 = p.total_rex;
+      const int64_t proceeds = sco_math::mul_div( rex, S0, R0 );
+
+      order_fill fill;
+      if ( proceeds > sco_math::rex_available_unlent( p.total_unlent, p.total_lent ) ) {
+         return fill;
+      }
+
+      const int64_t init_vote_stake     = b.vote_stake;
+      const int64_t current_stake_value = sco_math::mul_div( b.rex_balance, S0, R0 );
+
+      p.total_rex      = R0 - rex;
+      p.total_lendable = S0 - proceeds;
+      p.total_unlent   = p.total_lendable - p.total_lent;
+
+      b.vote_stake   = current_stake_value - proceeds;
+      b.rex_balance -= rex;
+      b.matured_rex -= rex;
+
+      fill.success      = true;
+      fill.proceeds     = proceeds;
+      fill.stake_change = b.vote_stake - init_vote_stake;
+      return fill;
+   }
+
+   /**
+    * @brief recomputes the vote stake of a REX balance from the pool price (`updaterex`)
+    * @return vote stake change
+    */
+   inline int64_t update_vote_stake( balance& b, const pool& p ) {
+      const int64_t init_vote_stake = b.vote_stake;
+      b.vote_stake = p.total_rex > 0 ? sco_math::mul_div( b.rex_balance, p.total_lendable, p.total_rex ) : 0;
+      return b.vote_stake - init_vote_stake;
+   }
+
+   constexpr int64_t bancor_output( const int64_t in_balance, const int64_t out_balance, const int64_t in ) {
+      return sco_math::mul_div( in, out_balance, in_balance + in );
+   }
+
+   /**
+    * @brief lends EOS of the pool for a CPU/NET loan paid with `payment` (`rent_rex`),
+    * the caller channels the payment to the return pool
+    * @return EOS lent
+    */
+   inline int64_t rent_rex( pool& p, const int64_t payment ) {
+      const int64_t rented = bancor_output( p.total_rent, p.total_unlent, payment );
+      p.total_lent   += rented;
+      p.total_unlent -= rented;
+      p.total_rent   += payment;
+      ++p.loan_num;
+      return rented;
+   }
+
+   /**
+    * @brief returns the EOS lent for an expired loan to the unlent EOS of the pool
+    */
+   inline void return_loan( pool& p, const int64_t total_staked ) {
+      p.total_lent    -= total_staked;
+      p.total_unlent  += total_staked;
+      p.total_lendable = p.total_unlent + p.total_lent;
+   }
+
+} // namespace pieos::rex_math
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * PIEOS SCO(Stake-Coin-Offering) share and issuance arithmetic.
+ *
+ * Plain integer functions without eosio dependencies, shared by the SCO contract
+ * and the native SCO tools (tools/) so that both produce identical rounding.
+ */
+namespace pieos::sco_math {
+
+   typedef unsigned __int128 uint128;
+
+   /**
+    * The maximum supply of core token (EOS,4) is 10^10 tokens (10 billion tokens), i.e., maximum amount
+    * of indivisible units is 10^14. SHARE_RATIO = 10^4 sets the upper bound on (SEOS,4) indivisible units to
+    * 10^18 and that is within the maximum allowable amount field of asset type which is set to 2^62
+    * (approximately 4.6 * 10^18)
+    */
+   static constexpr int64_t SHARE_RATIO = 10000;
+
+   static constexpr int64_t STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT = 10000;
+   static constexpr int32_t PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT = 2500; // weight 25.00% of EOS staking share
+
+   static constexpr int32_t EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN = 1000; // 10.00% of EOS REX + BP voting profits
+
+   /**
+    * @brief a * b / c with 128-bit intermediate product, rounded down
+    */
+   constexpr int64_t mul_div( const int64_t a, const int64_t b, const int64_t c ) {
+      return int64_t( (uint128(a) * uint128(b)) / uint128(c) );
+   }
+
+   /**
+    * @brief proxy vote amount weighted for the token share, `weight_percent` in 0.01% units
+    * (default PIEOS campaign: 25.00% of EOS staking)
+    */
+   constexpr int64_t weighted_proxy_vote( const int64_t proxy_vote, const int32_t weight_percent = PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT ) {
+      return proxy_vote * weight_percent / 10000;
+   }
+
+   /**
+    * @brief staked EOS amount plus weighted proxy vote amount, the EOS amount a token share(SPIEOS) balance is issued for
+    */
+   constexpr int64_t weighted_staking_amount( const int64_t staked, const int64_t proxy_vote, const int32_t weight_percent = PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT ) {
+      return staked + weighted_proxy_vote( proxy_vote, weight_percent );
+   }
+
+   /**
+    * @brief total value backing the token shares(SPIEOS), weighted EOS amount (scaled) + unredeemed PIEOS amount
+    */
+   constexpr int64_t token_share_pool_value( const int64_t total_weighted_staking_amount, const int64_t sco_token_unredeemed ) {
+      return (total_weighted_staking_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT) + sco_token_unredeemed;
+   }
+
+   /**
+    * @brief token shares(SPIEOS) to redeem for the SCO tokens earned by a `token_share` balance, its value in a token share pool
+    * of `pool_value` represented by `total_token_share` shares above its weighted staking amount (scaled), 0 if nothing is earned.
+    * The redeemed shares are worth `mul_div( shares, pool_value, total_token_share )` SCO tokens.
+    *
+    * @pre total_token_share > 0 and pool_value > 0
+    */
+   constexpr int64_t earned_token_share( const int64_t token_share, const int64_t weighted_staking_amount,
+                                         const int64_t pool_value, const int64_t total_token_share ) {
+      const int64_t earned = mul_div( token_share, pool_value, total_token_share ) - (weighted_staking_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT);
+      return earned > 0 ? mul_div( earned, total_token_share, pool_value ) : 0;
+   }
+
+   /**
+    * @brief amount of shares to issue for `added_value` joining a pool of `total_value` represented by `total_share` shares
+    *
+    * @pre total_share > 0 and total_value > 0
+    */
+   constexpr int64_t shares_to_issue( const int64_t total_share, const int64_t total_value, const int64_t added_value ) {
+      return mul_div( total_value + added_value, total_share, total_value ) - total_share;
+   }
+
+   /**
+    * @brief contract admin's share of EOS staking (REX + BP voting) profits
+    */
+   constexpr int64_t contract_profit_share( const int64_t profit ) {
+      return profit * EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN / 10000;
+   }
+
+   /**
+    * @brief linearly vested amount of `total` for `elapsed` out of `period`
+    */
+   constexpr int64_t linear_vested_amount( const int64_t total, const int64_t elapsed, const int64_t period ) {
+      return mul_div( total, elapsed, period );
+   }
+
+   /**
+    * @brief amount of `total` vested at `now`, vesting linearly from `start` to `end` with nothing vested before `cliff`
+    * (block timestamp slots)
+    */
+   constexpr int64_t scheduled_vested_amount( const int64_t total, const int64_t now, const int64_t start, const int64_t cliff, const int64_t end ) {
+      if ( now < start || now < cliff ) {
+         return 0;
+      }
+      if ( now >= end ) {
+         return total;
+      }
+      return linear_vested_amount( total, now - start, end - start );
+   }
+
+   /**
+    * Piecewise linear emission curve, the cumulative fraction of a distribution issued over a distribution period.
+    *
+    * `breakpoint[i]` is a point of time in EMISSION_TIME_SCALE units of the period (0 = start, EMISSION_TIME_SCALE = end)
+    * and `cumulative[i]` the fraction of the total distribution issued up to that point in EMISSION_AMOUNT_SCALE units.
+    * Segment `i` spans [breakpoint[i], breakpoint[i+1]] and issues at a constant rate, so the curve is the closed-form
+    * integral of a stepped issuance rate. Curves are generated at compile time by the make_*_emission_curve functions.
+    */
+   static constexpr int64_t EMISSION_TIME_SCALE   = 10000;   // breakpoints in 0.01% of the distribution period
+   static constexpr int64_t EMISSION_AMOUNT_SCALE = 1000000; // cumulative issuance in 0.0001% of the total distribution
+
+   template<size_t K>
+   struct emission_curve {
+      static constexpr size_t segments = K;
+
+      int64_t breakpoint[K + 1] = {};
+      int64_t cumulative[K + 1] = {};
+
+      /**
+       * @brief breakpoints strictly increasing from 0 to EMISSION_TIME_SCALE,
+       * cumulative issuance non-decreasing from 0 to EMISSION_AMOUNT_SCALE
+       */
+      constexpr bool is_valid() const {
+         if ( breakpoint[0] != 0 || breakpoint[K] != EMISSION_TIME_SCALE || cumulative[0] != 0 || cumulative[K] != EMISSION_AMOUNT_SCALE ) {
+            return false;
+         }
+         for ( size_t i = 0; i < K; ++i ) {
+            if ( breakpoint[i] >= breakpoint[i + 1] || cumulative[i] > cumulative[i + 1] ) {
+               return false;
+            }
+         }
+         return true;
+      }
+   };
+
+   /**
+    * @brief constant issuance rate over the whole period
+    */
+   constexpr emission_curve<1> make_linear_emission_curve() {
+      emission_curve<1> curve;
+      curve.breakpoint[1] = EMISSION_TIME_SCALE;
+      curve.cumulative[1] = EMISSION_AMOUNT_SCALE;
+      return curve;
+   }
+
+   /**
+    * @brief K equal-length phases issuing `weight[i]` parts of the total distribution in phase `i`
+    */
+   template<size_t K>
+   constexpr emission_curve<K> make_stepped_emission_curve( const int64_t (&weight)[K] ) {
+      int64_t total_weight = 0;
+      for ( size_t i = 0; i < K; ++i ) {
+         total_weight += weight[i];
+      }
+
+      emission_curve<K> curve;
+      int64_t weight_sum = 0;
+      for ( size_t i = 1; i <= K; ++i ) {
+         weight_sum += weight[i - 1];
+         curve.breakpoint[i] = mul_div( EMISSION_TIME_SCALE, int64_t(i), int64_t(K) );
+         curve.cumulative[i] = mul_div( EMISSION_AMOUNT_SCALE, weight_sum, total_weight );
+      }
+      return curve;
+   }
+
+   /**
+    * @brief K equal-length phases, each issuing `decay_percent` (0.01% units) of the previous phase's issuance
+    */
+   template<size_t K>
+   constexpr emission_curve<K> make_decaying_emission_curve( const int32_t decay_percent ) {
+      int64_t weight[K] = {};
+      weight[0] = EMISSION_AMOUNT_SCALE;
+      for ( size_t i = 1; i < K; ++i ) {
+         weight[i] = weight[i - 1] * decay_percent / 10000;
+      }
+      return make_stepped_emission_curve( weight );
+   }
+
+   /**
+    * @brief cumulative amount of `total` issued by the curve at `elapsed` out of `period` (0 <= elapsed <= period).
+    * The segment of `elapsed` is found by a binary search over the breakpoints, O(log K)
+    */
+   template<size_t K>
+   constexpr int64_t emitted_amount( const emission_curve<K>& curve, const int64_t total, const int64_t elapsed, const int64_t period ) {
+      if ( elapsed >= period ) {
+         return total;
+      }
+
+      // find the last breakpoint at or before `elapsed`: breakpoint[i] * period <= elapsed * EMISSION_TIME_SCALE
+      const uint128 t = uint128(elapsed) * uint128(EMISSION_TIME_SCALE);
+      size_t lo = 0, hi = K;
+      while ( hi - lo > 1 ) {
+         const size_t mid = (lo + hi) / 2;
+         if ( uint128(curve.breakpoint[mid]) * uint128(period) <= t ) {
+            lo = mid;
+         } else {
+            hi = mid;
+         }
+      }
+
+      // cumulative[lo] + (cumulative[lo+1] - cumulative[lo]) * (t - breakpoint[lo] * period) / (segment length * period),
+      // evaluated as a single fraction of EMISSION_AMOUNT_SCALE so that only the final division rounds
+      const uint128 segment = uint128(curve.breakpoint[lo + 1] - curve.breakpoint[lo]) * uint128(period);
+      const uint128 fraction = uint128(curve.cumulative[lo]) * segment
+                               + uint128(curve.cumulative[lo + 1] - curve.cumulative[lo]) * ( t - uint128(curve.breakpoint[lo]) * uint128(period) );
+      return int64_t( uint128(total) * fraction / ( uint128(EMISSION_AMOUNT_SCALE) * segment ) );
+   }
+
+   /**
+    * @brief amount of `total` issued by the curve between `from_elapsed` and `to_elapsed` out of `period`.
+    * Accruals over consecutive intervals add up to exactly `total` over the whole period
+    */
+   template<size_t K>
+   constexpr int64_t accrued_emission( const emission_curve<K>& curve, const int64_t total, const int64_t from_elapsed, const int64_t to_elapsed, const int64_t period ) {
+      return emitted_amount( curve, total, to_elapsed, period ) - emitted_amount( curve, total, from_elapsed, period );
+   }
+
+   /**
+    * PIEOS SCO emission schedule, linear over the SCO period
+    */
+   static constexpr auto PIEOS_SCO_EMISSION_CURVE = make_linear_emission_curve();
+   static_assert( PIEOS_SCO_EMISSION_CURVE.is_valid(), "invalid PIEOS SCO emission curve" );
+
+   /**
+    * @brief EOS value of a REX balance, given the REX pool's total lendable EOS and total REX
+    */
+   constexpr int64_t rex_to_core_token( const int64_t rex, const int64_t total_lendable, const int64_t total_rex ) {
+      return mul_div( rex, total_lendable, total_rex );
+   }
+
+   /**
+    * @brief REX amount bought by `core_token` EOS, given the REX pool's total lendable EOS and total REX
+    * (same rounding as the system contract's `add_to_rex_pool`)
+    */
+   constexpr int64_t core_token_to_rex( const int64_t core_token, const int64_t total_lendable, const int64_t total_rex ) {
+      return shares_to_issue( total_rex, total_lendable, core_token );
+   }
+
+   /**
+    * @brief EOS the system contract's `sellrex` can pay out without queueing the order,
+    * the REX pool's unlent EOS above its lower bound of 20% of the lent EOS (may be negative)
+    */
+   constexpr int64_t rex_available_unlent( const int64_t total_unlent, const int64_t total_lent ) {
+      return total_unlent - mul_div( 2, total_lent, 10 );
+   }
+
+   /**
+    * @brief EOS to add to a pool's liquid reserve of `balance`, up to `target_percent` (0.01% units) of the pool value
+    * `pool_value`, at most `available`
+    */
+   constexpr int64_t liquid_reserve_refill( const int64_t pool_value, const int32_t target_percent, const int64_t balance, const int64_t available ) {
+      const int64_t target = mul_div( pool_value, target_percent, 10000 );
+      if ( balance >= target || available <= 0 ) {
+         return 0;
+      }
+      return ( target - balance < available ) ? target - balance : available;
+   }
+
+   /**
+    * @brief how the EOS redeemed by an unstake is settled
+    *
+    * liquid - paid from the pool's liquid EOS (liquid reserve and BP voting rewards), no REX is sold
+    * sellrex - the pool's REX share is sold, filled immediately and paid out in the same transaction
+    * queued - the REX sell order is queued by the system contract, the redeemed EOS is credited on-contract
+    */
+   enum class unstake_settlement : uint8_t {
+      liquid  = 0,
+      sellrex = 1,
+      queued  = 2
+   };
+
+   /**
+    * @brief the cheapest settlement of an unstake redeeming `eos_proceeds`, of which `rex_sold_core_token`
+    * would come from selling REX, with `liquid_core_token` liquid EOS in the pool and `rex_available_unlent`
+    * EOS fillable by `sellrex`. A sale is queued behind the contract's own open sell order, if any.
+    */
+   constexpr unstake_settlement plan_unstake_settlement( const int64_t eos_proceeds, const int64_t liquid_core_token,
+                                                         const int64_t rex_sold_core_token, const int64_t rex_available_unlent,
+                                                         const bool has_open_rex_order ) {
+      if ( eos_proceeds <= liquid_core_token || rex_sold_core_token <= 0 ) {
+         return unstake_settlement::liquid;
+      }
+      if ( !has_open_rex_order && rex_sold_core_token <= rex_available_unlent ) {
+         return unstake_settlement::sellrex;
+      }
+      return unstake_settlement::queued;
+   }
+
+   static constexpr uint32_t REX_MATURITY_DAYS = 5; // maturity buckets of the system contract's `buyrex`
+   static constexpr uint32_t SECONDS_PER_DAY = 24 * 3600;
+
+   /**
+    * @brief REX maturity time (seconds since epoch) of a `buyrex` at `buyrex_time_sec`, the start of its day UTC plus `maturity_days`
+    */
+   constexpr uint32_t rex_maturity_sec( const uint32_t buyrex_time_sec, const uint32_t maturity_days = REX_MATURITY_DAYS ) {
+      return buyrex_time_sec - buyrex_time_sec % SECONDS_PER_DAY + maturity_days * SECONDS_PER_DAY;
+   }
+
+   /**
+    * @brief EOS staked by an account on one day, its REX bought on that day matures at `maturity` (seconds since epoch)
+    */
+   struct stake_lot {
+      uint32_t maturity;
+      int64_t  amount;
+   };
+
+   /**
+    * @brief adds a stake of `amount` maturing at `maturity` to a lot ledger ordered by maturity,
+    * stakes of the same day are merged into one lot
+    */
+   template<typename Lots>
+   void add_stake_lot( Lots& lots, const uint32_t maturity, const int64_t amount ) {
+      if ( !lots.empty() && lots.back().maturity == maturity ) {
+         lots.back().amount += amount;
+      } else {
+         lots.push_back( stake_lot{ maturity, amount } );
+      }
+   }
+
+   /**
+    * @brief drops the lots matured at `now_sec` (seconds since epoch, matured after the maturity time) from a lot ledger
+    * ordered by maturity, so that the ledger only keeps the few days of stakes still maturing
+    *
+    * @return EOS amount of the unmatured lots
+    */
+   template<typename Lots>
+   int64_t prune_matured_stake_lots( Lots& lots, const uint32_t now_sec ) {
+      size_t matured = 0;
+      while ( matured < lots.size() && now_sec > lots[matured].maturity ) {
+         ++matured;
+      }
+      lots.erase( lots.begin(), lots.begin() + matured );
+
+      int64_t unmatured = 0;
+      for ( const auto& lot : lots ) {
+         unmatured += lot.amount;
+      }
+      return unmatured;
+   }
+
+} // namespace pieos::sco_math
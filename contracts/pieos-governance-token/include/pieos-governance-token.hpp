@@ -6,6 +6,7 @@
 #include <pieos.hpp>
 
 #include <string>
+#include <vector>
 
 using namespace eosio;
 
@@ -73,6 +74,30 @@ namespace pieos {
                         const name&    to,
                         const asset&   quantity,
                         const string&  memo );
+
+         /**
+          * A recipient and quantity of a `bulktransfer`
+          */
+         struct transfer_entry {
+            name     to;
+            asset    quantity;
+         };
+
+         /**
+          * Allows `from` account to transfer tokens of one symbol to several accounts in one action,
+          * `from` is debited once with the sum of the quantities and every recipient is credited and notified.
+          *
+          * @param from - the account to transfer from,
+          * @param transfers - the recipients and quantities, at most `MAX_BULK_TRANSFERS` entries,
+          * @param memo - the memo string to accompany the transaction.
+          *
+          * @pre Every recipient account has to exist and must not be `from`,
+          * @pre Every quantity has to be positive and of the same token symbol.
+          */
+         [[eosio::action]]
+         void bulktransfer( const name&                          from,
+                            const std::vector<transfer_entry>&   transfers,
+                            const string&                        memo );
          /**
           * Allows `ram_payer` to create an account `owner` with zero balance for
           * token `symbol` at the expense of `ram_payer`.
@@ -100,6 +125,33 @@ namespace pieos {
          [[eosio::action]]
          void close( const name& owner, const symbol& symbol );
 
+         /**
+          * Delegates the voting power of `owner`'s `symbol` token balance to `delegate`, replacing a previous delegation.
+          * The delegate's voting power follows every later balance change of `owner` until the delegation is revoked.
+          * An account votes with its own balance by delegating to itself.
+          *
+          * @param owner - the account delegating its voting power,
+          * @param symbol - the token whose balance is delegated,
+          * @param delegate - the account receiving the voting power.
+          *
+          * @pre `delegate` account has to exist,
+          * @pre `owner` must not be already delegating to `delegate`.
+          */
+         [[eosio::action]]
+         void delegate( const name& owner, const symbol& symbol, const name& delegate );
+
+         /**
+          * Revokes the voting power delegation of `owner` for token `symbol`,
+          * the `owner`'s balance is subtracted from the voting power of its delegate.
+          *
+          * @param owner - the account revoking its delegation,
+          * @param symbol - the token whose delegation is revoked.
+          *
+          * @pre `owner` has to be delegating its `symbol` balance.
+          */
+         [[eosio::action]]
+         void undelegate( const name& owner, const symbol& symbol );
+
          static asset get_supply( const name& token_contract_account, const symbol_code& sym_code )
          {
             stats statstable( token_contract_account, sym_code.raw() );
@@ -114,12 +166,28 @@ namespace pieos {
             return ac.balance;
          }
 
+         /**
+          * Voting power delegated to `delegate` for token `sym_code`, the sum of the balances of its delegators
+          */
+         static asset get_vote_power( const name& token_contract_account, const name& delegate, const symbol_code& sym_code )
+         {
+            vote_powers votepowertable( token_contract_account, sym_code.raw() );
+            auto vp = votepowertable.find( delegate.value );
+            if ( vp == votepowertable.end() ) {
+               return asset{ 0, get_supply( token_contract_account, sym_code ).symbol };
+            }
+            return vp->power;
+         }
+
          using create_action = eosio::action_wrapper<"create"_n, &pieos_governance_token::create>;
          using issue_action = eosio::action_wrapper<"issue"_n, &pieos_governance_token::issue>;
          using retire_action = eosio::action_wrapper<"retire"_n, &pieos_governance_token::retire>;
          using transfer_action = eosio::action_wrapper<"transfer"_n, &pieos_governance_token::transfer>;
+         using bulktransfer_action = eosio::action_wrapper<"bulktransfer"_n, &pieos_governance_token::bulktransfer>;
          using open_action = eosio::action_wrapper<"open"_n, &pieos_governance_token::open>;
          using close_action = eosio::action_wrapper<"close"_n, &pieos_governance_token::close>;
+         using delegate_action = eosio::action_wrapper<"delegate"_n, &pieos_governance_token::delegate>;
+         using undelegate_action = eosio::action_wrapper<"undelegate"_n, &pieos_governance_token::undelegate>;
       private:
          struct [[eosio::table]] account {
             asset    balance;
@@ -135,11 +203,40 @@ namespace pieos {
             uint64_t primary_key()const { return supply.symbol.code().raw(); }
          };
 
+         /**
+          * voting power delegation of an account (scope) for a token
+          */
+         struct [[eosio::table]] delegation {
+            symbol_code sym_code;
+            name        delegate;
+
+            uint64_t primary_key()const { return sym_code.raw(); }
+         };
+
+         /**
+          * voting power of a delegate (primary key) for a token (scope: token symbol code),
+          * kept up to date by every balance change of the delegators so that a tally only reads these rows
+          */
+         struct [[eosio::table]] vote_power {
+            name     delegate;
+            asset    power;
+            uint32_t delegators;
+
+            uint64_t primary_key()const { return delegate.value; }
+         };
+
          typedef eosio::multi_index< "accounts"_n, account > accounts;
          typedef eosio::multi_index< "stat"_n, currency_stats > stats;
+         typedef eosio::multi_index< "delegation"_n, delegation > delegations;
+         typedef eosio::multi_index< "votepower"_n, vote_power > vote_powers;
+
+         static constexpr size_t MAX_BULK_TRANSFERS = 100;
 
          void sub_balance( const name& owner, const asset& value );
          void add_balance( const name& owner, const asset& value, const name& ram_payer );
+
+         void add_delegated_vote_power( const name& owner, const asset& value );
+         void add_vote_power( const name& delegate, const asset& value, const int32_t delegators_delta, const name& ram_payer );
    };
 
 }
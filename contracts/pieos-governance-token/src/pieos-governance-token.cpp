@@ -102,6 +102,40 @@ void pieos_governance_token::transfer( const name&    from,
     add_balance( to, quantity, payer );
 }
 
+void pieos_governance_token::bulktransfer( const name&                          from,
+                                          const std::vector<transfer_entry>&   transfers,
+                                          const string&                        memo )
+{
+    check( !transfers.empty(), "no transfers" );
+    check( transfers.size() <= MAX_BULK_TRANSFERS, "too many transfers" );
+    require_auth( from );
+    auto sym = transfers.front().quantity.symbol.code();
+    stats statstable( get_self(), sym.raw() );
+    const auto& st = statstable.get( sym.raw() );
+
+    check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+    require_recipient( from );
+
+    asset total{ 0, st.supply.symbol };
+    for( const auto& t : transfers ) {
+       check( t.to != from, "cannot transfer to self" );
+       check( is_account( t.to ), "to account does not exist");
+       check( t.quantity.is_valid(), "invalid quantity" );
+       check( t.quantity.amount > 0, "must transfer positive quantity" );
+       check( t.quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+
+       require_recipient( t.to );
+       total += t.quantity;
+    }
+
+    sub_balance( from, total );
+    for( const auto& t : transfers ) {
+       auto payer = has_auth( t.to ) ? t.to : from;
+       add_balance( t.to, t.quantity, payer );
+    }
+}
+
 void pieos_governance_token::sub_balance( const name& owner, const asset& value ) {
    accounts from_acnts( get_self(), owner.value );
 
@@ -111,6 +145,8 @@ void pieos_governance_token::sub_balance( const name& owner, const asset& value
    from_acnts.modify( from, owner, [&]( auto& a ) {
          a.balance -= value;
       });
+
+   add_delegated_vote_power( owner, -value );
 }
 
 void pieos_governance_token::add_balance( const name& owner, const asset& value, const name& ram_payer )
@@ -126,6 +162,47 @@ void pieos_governance_token::add_balance( const name& owner, const asset& value,
         a.balance += value;
       });
    }
+
+   add_delegated_vote_power( owner, value );
+}
+
+void pieos_governance_token::add_delegated_vote_power( const name& owner, const asset& value )
+{
+   delegations dlgs( get_self(), owner.value );
+   auto dlg = dlgs.find( value.symbol.code().raw() );
+   if( dlg == dlgs.end() ) {
+      return;
+   }
+   // the delegate's row exists as long as it has delegators, no RAM is billed to the balance change
+   add_vote_power( dlg->delegate, value, 0, same_payer );
+}
+
+void pieos_governance_token::add_vote_power( const name& delegate, const asset& value, const int32_t delegators_delta, const name& ram_payer )
+{
+   vote_powers vps( get_self(), value.symbol.code().raw() );
+   auto vp = vps.find( delegate.value );
+   if( vp == vps.end() ) {
+      check( delegators_delta > 0 && value.amount >= 0, "vote power row of delegate not found" );
+      vps.emplace( ram_payer, [&]( auto& v ){
+        v.delegate   = delegate;
+        v.power      = value;
+        v.delegators = delegators_delta;
+      });
+      return;
+   }
+
+   check( vp->power.amount + value.amount >= 0, "negative vote power" );
+   check( int64_t( vp->delegators ) + delegators_delta >= 0, "negative delegator count" );
+
+   if( vp->delegators + delegators_delta == 0 ) {
+      check( vp->power.amount + value.amount == 0, "vote power left without delegators" );
+      vps.erase( vp );
+   } else {
+      vps.modify( vp, same_payer, [&]( auto& v ) {
+        v.power      += value;
+        v.delegators += delegators_delta;
+      });
+   }
 }
 
 void pieos_governance_token::open( const name& owner, const symbol& symbol, const name& ram_payer )
@@ -158,4 +235,60 @@ void pieos_governance_token::close( const name& owner, const symbol& symbol )
    acnts.erase( it );
 }
 
+void pieos_governance_token::delegate( const name& owner, const symbol& symbol, const name& delegate )
+{
+   require_auth( owner );
+
+   check( is_account( delegate ), "delegate account does not exist" );
+
+   auto sym_code_raw = symbol.code().raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
+   check( st.supply.symbol == symbol, "symbol precision mismatch" );
+
+   asset balance{0, symbol};
+   accounts acnts( get_self(), owner.value );
+   auto ac = acnts.find( sym_code_raw );
+   if( ac != acnts.end() ) {
+      balance = ac->balance;
+   }
+
+   delegations dlgs( get_self(), owner.value );
+   auto dlg = dlgs.find( sym_code_raw );
+   if( dlg == dlgs.end() ) {
+      dlgs.emplace( owner, [&]( auto& d ){
+        d.sym_code = symbol.code();
+        d.delegate = delegate;
+      });
+   } else {
+      check( dlg->delegate != delegate, "already delegating to this account" );
+      add_vote_power( dlg->delegate, -balance, -1, owner );
+      dlgs.modify( dlg, same_payer, [&]( auto& d ) {
+        d.delegate = delegate;
+      });
+   }
+
+   add_vote_power( delegate, balance, 1, owner );
+}
+
+void pieos_governance_token::undelegate( const name& owner, const symbol& symbol )
+{
+   require_auth( owner );
+
+   auto sym_code_raw = symbol.code().raw();
+   delegations dlgs( get_self(), owner.value );
+   const auto& dlg = dlgs.get( sym_code_raw, "no vote power delegation found" );
+
+   asset balance{0, symbol};
+   accounts acnts( get_self(), owner.value );
+   auto ac = acnts.find( sym_code_raw );
+   if( ac != acnts.end() ) {
+      check( ac->balance.symbol == symbol, "symbol precision mismatch" );
+      balance = ac->balance;
+   }
+
+   add_vote_power( dlg.delegate, -balance, -1, owner );
+   dlgs.erase( dlg );
+}
+
 } /// namespace eosio
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <eosio/asset.hpp>
+#include <eosio/eosio.hpp>
+#include <eosio/system.hpp>
+
+#include <pieos.hpp>
+#include <pieos-rex-math.hpp>
+#include <eosio-system-contracts-interface.hpp>
+
+#include <string>
+
+using namespace eosio;
+
+namespace pieos {
+
+   using std::string;
+
+   /**
+    * pieos-rex-emulator contract is a test stand-in for the REX market of the `eosio` system contract.
+    * Deployed to the `eosio` account of a local test chain, it serves the REX actions the PIEOS SCO contract sends
+    * and keeps the `rexpool`, `rexretpool`, `retbuckets`, `rexbal`, `rexfund`, `rexqueue`, `cpuloan` and `netloan`
+    * tables in the system contract's layout, so that the SCO contract's REX valuation and unstake settlement read
+    * them unchanged.
+    *
+    * The REX arithmetic is shared with the native simulator (pieos-rex-math.hpp). Voting requirements,
+    * resource limits of the loans, loan renewal funds and the REX savings bucket are not emulated.
+    */
+   class [[eosio::contract("pieos-rex-emulator")]] pieos_rex_emulator : public contract {
+   public:
+      using contract::contract;
+
+      pieos_rex_emulator( name s, name code, datastream<const char*> ds );
+
+      /**
+       * Deposit to REX fund action, transfers `amount` core tokens from `owner` to `eosio.rex`.
+       *
+       * @param owner - REX fund owner account,
+       * @param amount - amount of tokens to be deposited.
+       */
+      [[eosio::action]]
+      void deposit( const name& owner, const asset& amount );
+
+      /**
+       * Withdraw from REX fund action, transfers `amount` core tokens from `eosio.rex` to `owner`.
+       *
+       * @param owner - REX fund owner account,
+       * @param amount - amount of tokens to be withdrawn.
+       */
+      [[eosio::action]]
+      void withdraw( const name& owner, const asset& amount );
+
+      /**
+       * Buyrex action, buys REX with `amount` core tokens of `from`'s REX fund.
+       * The REX matures at the start of the fifth day from the purchase.
+       *
+       * @param from - owner account name,
+       * @param amount - amount of tokens taken out of 'from' REX fund.
+       */
+      [[eosio::action]]
+      void buyrex( const name& from, const asset& amount );
+
+      /**
+       * Sellrex action, sells matured REX of `from`. An order the available unlent EOS of the pool
+       * cannot cover is queued and filled by later REX actions in order time.
+       *
+       * @param from - owner account of REX,
+       * @param rex - amount of REX to be sold.
+       */
+      [[eosio::action]]
+      void sellrex( const name& from, const asset& rex );
+
+      /**
+       * Updaterex action, updates the vote stake of `owner` to the current value of its REX.
+       *
+       * @param owner - REX owner account.
+       */
+      [[eosio::action]]
+      void updaterex( const name& owner );
+
+      /**
+       * Runrex action, distributes the REX return buckets, returns expired loans and fills queued sell orders.
+       *
+       * @param user - any account can execute this action,
+       * @param max - number of each of the queues processed.
+       */
+      [[eosio::action]]
+      void runrex( const name& user, uint16_t max );
+
+      /**
+       * Rentcpu action, rents EOS of the REX pool for 30 days with `loan_payment` of `from`'s REX fund.
+       * The payment is channeled to the REX return buckets.
+       *
+       * @param from - account creating and paying for the loan,
+       * @param receiver - account receiving the rented resources,
+       * @param loan_payment - tokens paid for the loan,
+       * @param loan_fund - must be zero, loan renewals are not emulated.
+       */
+      [[eosio::action]]
+      void rentcpu( const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund );
+
+      /**
+       * Rentnet action, same as `rentcpu` for the `netloan` table.
+       */
+      [[eosio::action]]
+      void rentnet( const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund );
+
+      /**
+       * Donatetorex action, transfers `quantity` core tokens of `payer` to `eosio.rex` and channels them
+       * to the REX return buckets, standing in for the rent, name bid and RAM fees of the system contract.
+       *
+       * @param payer - account paying the donation,
+       * @param quantity - amount of tokens donated,
+       * @param memo - the memo string to accompany the transfer.
+       */
+      [[eosio::action]]
+      void donatetorex( const name& payer, const asset& quantity, const string& memo );
+
+   private:
+
+      /// `rexpool`, `rexretpool` and `retbuckets` rows, updated by the shared REX arithmetic and written back once per action
+      struct rex_rows {
+         rex_math::pool         pool;
+         rex_math::return_state ret;
+      };
+
+      rex_rows load_rex_rows();
+      void store_rex_rows( const rex_rows& rows );
+
+      void transfer_to_fund( const name& owner, const int64_t amount );
+      void transfer_from_fund( const name& owner, const int64_t amount );
+      int64_t update_rex_account( const name& owner, const int64_t proceeds );
+      void process_rex_queues( rex_rows& rows, const uint16_t max );
+      bool rex_loans_available( const rex_rows& rows );
+
+      template <typename T>
+      void rent_rex( T& table, const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund );
+
+      eosiosystem::rex_pool_table           _rexpool;
+      eosiosystem::rex_return_pool_table    _rexretpool;
+      eosiosystem::rex_return_buckets_table _rexretbuckets;
+      eosiosystem::rex_balance_table        _rexbalance;
+      eosiosystem::rex_fund_table           _rexfunds;
+      eosiosystem::rex_order_table          _rexorders;
+      eosiosystem::rex_cpu_loan_table       _cpuloans;
+      eosiosystem::rex_net_loan_table       _netloans;
+   };
+
+} /// namespace pieos
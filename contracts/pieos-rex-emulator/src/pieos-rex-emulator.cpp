@@ -0,0 +1,434 @@
+#include <pieos-rex-emulator.hpp>
+
+using namespace eosio;
+
+namespace pieos {
+
+   using namespace pieos::eosiosystem;
+
+   namespace {
+
+      uint32_t now_sec() {
+         return current_time_point().sec_since_epoch();
+      }
+
+      rex_math::balance to_rex_math( const rex_balance& rb ) {
+         rex_math::balance b;
+         b.vote_stake  = rb.vote_stake.amount;
+         b.rex_balance = rb.rex_balance.amount;
+         b.matured_rex = rb.matured_rex;
+         for ( const auto& [maturity, rex] : rb.rex_maturities ) {
+            b.rex_maturities.emplace_back( maturity.sec_since_epoch(), rex );
+         }
+         return b;
+      }
+
+      void from_rex_math( rex_balance& rb, const rex_math::balance& b ) {
+         rb.vote_stake  = asset( b.vote_stake, CORE_TOKEN_SYMBOL );
+         rb.rex_balance = asset( b.rex_balance, REX_SYMBOL );
+         rb.matured_rex = b.matured_rex;
+         rb.rex_maturities.clear();
+         for ( const auto& [maturity, rex] : b.rex_maturities ) {
+            rb.rex_maturities.emplace_back( time_point_sec( maturity ), rex );
+         }
+      }
+
+   } // namespace
+
+   pieos_rex_emulator::pieos_rex_emulator( name s, name code, datastream<const char*> ds )
+   : contract(s, code, ds),
+     _rexpool(get_self(), get_self().value),
+     _rexretpool(get_self(), get_self().value),
+     _rexretbuckets(get_self(), get_self().value),
+     _rexbalance(get_self(), get_self().value),
+     _rexfunds(get_self(), get_self().value),
+     _rexorders(get_self(), get_self().value),
+     _cpuloans(get_self(), get_self().value),
+     _netloans(get_self(), get_self().value) {
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::deposit( const name& owner, const asset& amount ) {
+      require_auth( owner );
+      check( amount.symbol == CORE_TOKEN_SYMBOL, "must deposit core token" );
+      check( 0 < amount.amount, "must deposit a positive amount" );
+
+      token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { owner, "active"_n } } };
+      transfer_act.send( owner, REX_FUND_ACCOUNT, amount, string("deposit to REX fund") );
+
+      transfer_to_fund( owner, amount.amount );
+      update_rex_account( owner, 0 );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::withdraw( const name& owner, const asset& amount ) {
+      require_auth( owner );
+      check( amount.symbol == CORE_TOKEN_SYMBOL, "must withdraw core token" );
+      check( 0 < amount.amount, "must withdraw a positive amount" );
+
+      update_rex_account( owner, 0 );
+      transfer_from_fund( owner, amount.amount );
+
+      token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { REX_FUND_ACCOUNT, "active"_n } } };
+      transfer_act.send( REX_FUND_ACCOUNT, owner, amount, string("withdraw from REX fund") );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::buyrex( const name& from, const asset& amount ) {
+      require_auth( from );
+      check( amount.symbol == CORE_TOKEN_SYMBOL, "asset must be core token" );
+      check( 0 < amount.amount, "must use positive amount" );
+
+      transfer_from_fund( from, amount.amount );
+
+      auto rows = load_rex_rows();
+      const int64_t rex_received = rex_math::add_to_rex_pool( rows.pool, amount.amount );
+
+      auto bitr = _rexbalance.find( from.value );
+      const bool new_balance = bitr == _rexbalance.end();
+      rex_math::balance b = new_balance ? rex_math::balance() : to_rex_math( *bitr );
+      rex_math::add_to_rex_balance( b, new_balance, rows.pool, amount.amount, rex_received, now_sec() );
+      if ( new_balance ) {
+         _rexbalance.emplace( from, [&]( auto& rb ) {
+            rb.owner = from;
+            from_rex_math( rb, b );
+         });
+      } else {
+         _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
+            from_rex_math( rb, b );
+         });
+      }
+
+      process_rex_queues( rows, rex_math::ORDERS_FILLED_PER_ACTION );
+      store_rex_rows( rows );
+
+      update_rex_account( from, 0 );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::sellrex( const name& from, const asset& rex ) {
+      require_auth( from );
+
+      auto rows = load_rex_rows();
+      process_rex_queues( rows, rex_math::ORDERS_FILLED_PER_ACTION );
+
+      auto bitr = _rexbalance.require_find( from.value, "user must first buyrex" );
+      check( rex.amount > 0 && rex.symbol == bitr->rex_balance.symbol, "asset must be a positive amount of (REX, 4)" );
+
+      rex_math::balance b = to_rex_math( *bitr );
+      rex_math::process_rex_maturities( b, now_sec() );
+      check( rex.amount <= b.matured_rex, "insufficient available rex" );
+
+      const auto fill = rex_math::fill_rex_order( rows.pool, b, rex.amount );
+      check( !fill.success || fill.proceeds > 0, "proceeds are negligible" );
+
+      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
+         from_rex_math( rb, b );
+      });
+      store_rex_rows( rows );
+
+      int64_t pending_sell_order = update_rex_account( from, fill.proceeds );
+      if ( !fill.success ) {
+         // queued, the REX of a second order is added to the open order
+         auto oitr = _rexorders.find( from.value );
+         if ( oitr == _rexorders.end() ) {
+            oitr = _rexorders.emplace( from, [&]( auto& order ) {
+               order.owner         = from;
+               order.rex_requested = rex;
+               order.is_open       = true;
+               order.proceeds      = asset( 0, CORE_TOKEN_SYMBOL );
+               order.stake_change  = asset( 0, CORE_TOKEN_SYMBOL );
+               order.order_time    = current_time_point();
+            });
+         } else {
+            _rexorders.modify( oitr, same_payer, [&]( auto& order ) {
+               order.rex_requested.amount += rex.amount;
+            });
+         }
+         pending_sell_order = oitr->rex_requested.amount;
+      }
+      check( pending_sell_order <= b.matured_rex, "insufficient funds for current and scheduled orders" );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::updaterex( const name& owner ) {
+      require_auth( owner );
+
+      auto rows = load_rex_rows();
+      process_rex_queues( rows, rex_math::ORDERS_FILLED_PER_ACTION );
+      store_rex_rows( rows );
+
+      auto bitr = _rexbalance.require_find( owner.value, "account has no REX balance" );
+      rex_math::balance b = to_rex_math( *bitr );
+      rex_math::update_vote_stake( b, rows.pool );
+      rex_math::process_rex_maturities( b, now_sec() );
+      _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
+         from_rex_math( rb, b );
+      });
+
+      update_rex_account( owner, 0 );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::runrex( const name& user, uint16_t max ) {
+      require_auth( user );
+      check( max > 0, "max must be positive" );
+
+      auto rows = load_rex_rows();
+      process_rex_queues( rows, max );
+      store_rex_rows( rows );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::rentcpu( const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund ) {
+      rent_rex( _cpuloans, from, receiver, loan_payment, loan_fund );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::rentnet( const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund ) {
+      rent_rex( _netloans, from, receiver, loan_payment, loan_fund );
+   }
+
+   // [[eosio::action]]
+   void pieos_rex_emulator::donatetorex( const name& payer, const asset& quantity, const string& memo ) {
+      require_auth( payer );
+      check( quantity.symbol == CORE_TOKEN_SYMBOL, "quantity must be core token" );
+      check( 0 < quantity.amount, "quantity must be positive" );
+      check( memo.size() <= 256, "memo has more than 256 bytes" );
+
+      auto rows = load_rex_rows();
+      check( rows.pool.total_rex > 0, "rex system not initialized yet" );
+
+      token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { payer, "active"_n } } };
+      transfer_act.send( payer, REX_FUND_ACCOUNT, quantity, memo );
+
+      rex_math::add_to_rex_return_pool( rows.pool, rows.ret, quantity.amount, now_sec() );
+      store_rex_rows( rows );
+   }
+
+   pieos_rex_emulator::rex_rows pieos_rex_emulator::load_rex_rows() {
+      rex_rows rows;
+
+      auto rp_itr = _rexpool.begin();
+      if ( rp_itr != _rexpool.end() ) {
+         auto& p = rows.pool;
+         p.total_lent       = rp_itr->total_lent.amount;
+         p.total_unlent     = rp_itr->total_unlent.amount;
+         p.total_rent       = rp_itr->total_rent.amount;
+         p.total_lendable   = rp_itr->total_lendable.amount;
+         p.total_rex        = rp_itr->total_rex.amount;
+         p.namebid_proceeds = rp_itr->namebid_proceeds.amount;
+         p.loan_num         = rp_itr->loan_num;
+      }
+
+      auto ret_itr = _rexretpool.begin();
+      if ( ret_itr != _rexretpool.end() ) {
+         auto& rp = rows.ret.pool;
+         rows.ret.initialized        = true;
+         rp.last_dist_time           = ret_itr->last_dist_time.sec_since_epoch();
+         rp.pending_bucket_time      = ret_itr->pending_bucket_time.sec_since_epoch();
+         rp.oldest_bucket_time       = ret_itr->oldest_bucket_time.sec_since_epoch();
+         rp.pending_bucket_proceeds  = ret_itr->pending_bucket_proceeds;
+         rp.current_rate_of_increase = ret_itr->current_rate_of_increase;
+         rp.proceeds                 = ret_itr->proceeds;
+
+         auto rb_itr = _rexretbuckets.begin();
+         if ( rb_itr != _rexretbuckets.end() ) {
+            for ( const auto& [bucket_time, rate] : rb_itr->return_buckets ) {
+               rows.ret.buckets.emplace_hint( rows.ret.buckets.end(), bucket_time.sec_since_epoch(), rate );
+            }
+         }
+      }
+      return rows;
+   }
+
+   void pieos_rex_emulator::store_rex_rows( const rex_rows& rows ) {
+      auto write_pool = [&]( auto& rp ) {
+         const auto& p = rows.pool;
+         rp.total_lent       = asset( p.total_lent, CORE_TOKEN_SYMBOL );
+         rp.total_unlent     = asset( p.total_unlent, CORE_TOKEN_SYMBOL );
+         rp.total_rent       = asset( p.total_rent, CORE_TOKEN_SYMBOL );
+         rp.total_lendable   = asset( p.total_lendable, CORE_TOKEN_SYMBOL );
+         rp.total_rex        = asset( p.total_rex, REX_SYMBOL );
+         rp.namebid_proceeds = asset( p.namebid_proceeds, CORE_TOKEN_SYMBOL );
+         rp.loan_num         = p.loan_num;
+      };
+      auto rp_itr = _rexpool.begin();
+      if ( rp_itr != _rexpool.end() ) {
+         _rexpool.modify( rp_itr, same_payer, write_pool );
+      } else if ( rows.pool.total_rex > 0 ) {
+         _rexpool.emplace( get_self(), write_pool );
+      }
+
+      if ( !rows.ret.initialized ) {
+         return;
+      }
+
+      auto write_return_pool = [&]( auto& rp ) {
+         const auto& r = rows.ret.pool;
+         rp.last_dist_time           = time_point_sec( r.last_dist_time );
+         rp.pending_bucket_time      = time_point_sec( r.pending_bucket_time );
+         rp.oldest_bucket_time       = time_point_sec( r.oldest_bucket_time );
+         rp.pending_bucket_proceeds  = r.pending_bucket_proceeds;
+         rp.current_rate_of_increase = r.current_rate_of_increase;
+         rp.proceeds                 = r.proceeds;
+      };
+      auto ret_itr = _rexretpool.begin();
+      if ( ret_itr != _rexretpool.end() ) {
+         _rexretpool.modify( ret_itr, same_payer, write_return_pool );
+      } else {
+         _rexretpool.emplace( get_self(), write_return_pool );
+      }
+
+      auto write_buckets = [&]( auto& rb ) {
+         rb.return_buckets.clear();
+         for ( const auto& [bucket_time, rate] : rows.ret.buckets ) {
+            rb.return_buckets.emplace_hint( rb.return_buckets.end(), time_point_sec( bucket_time ), rate );
+         }
+      };
+      auto rb_itr = _rexretbuckets.begin();
+      if ( rb_itr != _rexretbuckets.end() ) {
+         _rexretbuckets.modify( rb_itr, same_payer, write_buckets );
+      } else {
+         _rexretbuckets.emplace( get_self(), write_buckets );
+      }
+   }
+
+   void pieos_rex_emulator::transfer_to_fund( const name& owner, const int64_t amount ) {
+      auto itr = _rexfunds.find( owner.value );
+      if ( itr == _rexfunds.end() ) {
+         _rexfunds.emplace( owner, [&]( auto& fund ) {
+            fund.owner   = owner;
+            fund.balance = asset( amount, CORE_TOKEN_SYMBOL );
+         });
+      } else {
+         _rexfunds.modify( itr, same_payer, [&]( auto& fund ) {
+            fund.balance.amount += amount;
+         });
+      }
+   }
+
+   void pieos_rex_emulator::transfer_from_fund( const name& owner, const int64_t amount ) {
+      auto itr = _rexfunds.require_find( owner.value, "must deposit to REX fund first" );
+      check( amount <= itr->balance.amount, "insufficient funds" );
+      _rexfunds.modify( itr, same_payer, [&]( auto& fund ) {
+         fund.balance.amount -= amount;
+      });
+   }
+
+   /**
+    * @brief moves the proceeds of `owner`'s filled sell order and `proceeds` to its REX fund
+    * @return REX amount of `owner`'s open sell order
+    */
+   int64_t pieos_rex_emulator::update_rex_account( const name& owner, const int64_t proceeds ) {
+      int64_t to_fund = proceeds;
+      int64_t rex_in_sell_order = 0;
+
+      auto itr = _rexorders.find( owner.value );
+      if ( itr != _rexorders.end() ) {
+         if ( itr->is_open ) {
+            rex_in_sell_order = itr->rex_requested.amount;
+         } else {
+            to_fund += itr->proceeds.amount;
+            _rexorders.erase( itr );
+         }
+      }
+
+      if ( to_fund > 0 ) {
+         transfer_to_fund( owner, to_fund );
+      }
+      return rex_in_sell_order;
+   }
+
+   /**
+    * @brief `runrex`: distributes the return buckets, returns up to `max` expired CPU and NET loans each
+    * and tries to fill up to `max` open sell orders in order time
+    */
+   void pieos_rex_emulator::process_rex_queues( rex_rows& rows, const uint16_t max ) {
+      rex_math::update_rex_pool( rows.pool, rows.ret, now_sec() );
+
+      const time_point ct = current_time_point();
+      auto return_expired_loans = [&]( auto& loans ) {
+         auto idx = loans.template get_index<"byexpr"_n>();
+         for ( uint16_t i = 0; i < max; ++i ) {
+            auto itr = idx.begin();
+            if ( itr == idx.end() || itr->expiration > ct ) {
+               break;
+            }
+            rex_math::return_loan( rows.pool, itr->total_staked.amount );
+            idx.erase( itr );
+         }
+      };
+      return_expired_loans( _cpuloans );
+      return_expired_loans( _netloans );
+
+      auto idx = _rexorders.get_index<"bytime"_n>();
+      auto oitr = idx.begin();
+      for ( uint16_t i = 0; i < max; ++i ) {
+         if ( oitr == idx.end() || !oitr->is_open ) {
+            break;
+         }
+         auto next = oitr;
+         ++next;
+
+         auto bitr = _rexbalance.find( oitr->owner.value );
+         if ( bitr != _rexbalance.end() ) {
+            rex_math::balance b = to_rex_math( *bitr );
+            const auto fill = rex_math::fill_rex_order( rows.pool, b, oitr->rex_requested.amount );
+            if ( fill.success ) {
+               _rexbalance.modify( bitr, same_payer, [&]( auto& rb ) {
+                  from_rex_math( rb, b );
+               });
+               idx.modify( oitr, same_payer, [&]( auto& order ) {
+                  order.proceeds.amount     = fill.proceeds;
+                  order.stake_change.amount = fill.stake_change;
+                  order.is_open             = false;
+               });
+            }
+         }
+         oitr = next;
+      }
+   }
+
+   bool pieos_rex_emulator::rex_loans_available( const rex_rows& rows ) {
+      if ( rows.pool.total_rex <= 0 ) {
+         return false;
+      }
+      // no loans while sell orders are queued
+      auto idx = _rexorders.get_index<"bytime"_n>();
+      return idx.begin() == idx.end() || !idx.begin()->is_open;
+   }
+
+   template <typename T>
+   void pieos_rex_emulator::rent_rex( T& table, const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund ) {
+      require_auth( from );
+
+      auto rows = load_rex_rows();
+      process_rex_queues( rows, rex_math::ORDERS_FILLED_PER_ACTION );
+
+      check( rex_loans_available( rows ), "rex loans are currently not available" );
+      check( loan_payment.symbol == CORE_TOKEN_SYMBOL && loan_fund.symbol == CORE_TOKEN_SYMBOL, "must use core token" );
+      check( 0 < loan_payment.amount, "must use positive asset amount" );
+      check( loan_fund.amount == 0, "loan renewal funds are not emulated" );
+
+      update_rex_account( from, 0 );
+      transfer_from_fund( from, loan_payment.amount );
+
+      const int64_t rented = rex_math::bancor_output( rows.pool.total_rent, rows.pool.total_unlent, loan_payment.amount );
+      check( loan_payment.amount < rented, "loan price does not favor renting" );
+      rex_math::rent_rex( rows.pool, loan_payment.amount );
+      rex_math::add_to_rex_return_pool( rows.pool, rows.ret, loan_payment.amount, now_sec() );
+      store_rex_rows( rows );
+
+      table.emplace( from, [&]( auto& loan ) {
+         loan.from         = from;
+         loan.receiver     = receiver;
+         loan.payment      = loan_payment;
+         loan.balance      = loan_fund;
+         loan.total_staked = asset( rented, CORE_TOKEN_SYMBOL );
+         loan.loan_num     = rows.pool.loan_num;
+         loan.expiration   = current_time_point() + seconds( rex_math::LOAN_PERIOD_SEC );
+      });
+   }
+
+} /// namespace pieos
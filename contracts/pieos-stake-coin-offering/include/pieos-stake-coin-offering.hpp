@@ -1,13 +1,16 @@
 #pragma once
 
 #include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/print.hpp>
 #include <eosio/system.hpp>
 
 #include <pieos.hpp>
+#include <pieos-sco-math.hpp>
 
 #include <string>
+#include <vector>
 
 using namespace eosio;
 
@@ -25,19 +28,109 @@ namespace pieos {
 
       pieos_sco( name s, name code, datastream<const char*> ds );
 
+      /**
+       * Action return values (ACTION_RETURN_VALUE protocol feature), so that clients learn the outcome
+       * of a user action without reading the `stakeaccount` and token tables again.
+       */
+      struct stake_core_token_outcome {
+         asset staked;                      // symbol:(EOS,4) - staked EOS amount
+         asset staked_share;                // symbol:(SEOS,4) - received EOS-share amount
+         asset token_share;                 // symbol:(SPIEOS,4) or (SSCO,4) - received token share amount
+      };
+
+      struct unstake_core_token_outcome {
+         asset staked_and_profit_redeemed;  // symbol:(EOS,4) - original staked EOS + staking profits, before the contract admin's profit share
+         asset token_earned;                // symbol:(PIEOS,4) - received PIEOS token balance
+         asset rex_to_sell;                 // symbol:(REX,4) - REX amount to sell
+         asset rex_sold_core_token;         // symbol:(EOS,4) - core token proceeds from the REX to be sold
+         name  settlement;                  // `liquid`, `sellrex` or `queued`, see `sco_math::plan_unstake_settlement`
+         asset reserve_refill;              // symbol:(EOS,4) - proceeds of the REX sold to refill the pool's liquid reserve
+         time_point_sec settlement_time;    // expected time the redeemed EOS is payable, estimated for a queued REX sell order
+      };
+
+      static constexpr name UNSTAKE_SETTLEMENT_LIQUID = "liquid"_n;   // paid from the pool's liquid EOS, no REX sold
+      static constexpr name UNSTAKE_SETTLEMENT_SELLREX = "sellrex"_n; // REX sold, filled and paid out in the same transaction
+      static constexpr name UNSTAKE_SETTLEMENT_QUEUED = "queued"_n;   // REX sell order queued, redeemed EOS credited to the on-contract balance
+
+      struct compound_core_token_outcome {
+         asset staking_profit;              // symbol:(EOS,4) - EOS staking profits above the staked EOS amount
+         asset contract_profit;             // symbol:(EOS,4) - contract admin's share of the staking profits
+         asset compounded;                  // symbol:(EOS,4) - EOS amount added to the staked EOS balance
+      };
+
+      struct unstake_by_proxy_outcome {
+         asset proxy_vote_profit_redeemed;  // symbol:(EOS,4) - redeemed proxy-vote profits, before the contract admin's profit share
+         asset token_earned;                // symbol:(PIEOS,4) - received PIEOS token balance
+      };
+
+      struct sync_proxy_outcome {
+         uint32_t synced;                   // voters whose proxy voting amount was updated
+         uint32_t skipped;                  // voters already in sync, whose change is below the minimum proxy vote change, or whose stake exceeds the maximum proxy vote amount
+      };
+
+      struct distribute_payout {
+         name  owner;                       // staker paid
+         asset token_share;                 // symbol:(SPIEOS,4) - redeemed PIEOS-token share amount
+         asset token_earned;                // symbol:(PIEOS,4) - paid PIEOS token amount
+      };
+
+      struct distribute_outcome {
+         uint32_t visited;                  // `stakers` entries visited
+         asset    distributed;              // symbol:(PIEOS,4) - total PIEOS paid by this batch
+         std::vector<distribute_payout> payouts; // stakers paid, the only record of the payouts (no receipts are sent)
+      };
+
+      struct withdraw_outcome {
+         asset withdrawn;                   // withdrawn EOS, PIEOS or campaign token amount
+         asset on_contract_balance;         // remaining on-contract balance of the withdrawn token
+      };
+
+      /**
+       * Receipt balances, used as the deltas, the account balances and the pool totals of the receipt actions
+       */
+      struct stake_balances {
+         asset staked;                      // symbol:(EOS,4)
+         asset staked_share;                // symbol:(SEOS,4)
+         asset token_share;                 // symbol:(SPIEOS,4) or (SSCO,4)
+      };
+
+      struct proxy_vote_balances {
+         asset proxy_vote;                  // symbol:(EOS,4)
+         asset proxy_vote_share;            // symbol:(SPROXY,4)
+         asset token_share;                 // symbol:(SPIEOS,4) or (SSCO,4)
+      };
+
       /**
        * token transfer action notification handler,
        * called when EOS token on eosio.token contract is transferred to this pieos-sco contract account
        *
+       * `apply` only reads the fixed-size `from`, `to` and `quantity` fields of the transfer (see `read_transfer_notification`),
+       * and drops outgoing transfers, non-EOS tokens and non-positive amounts before calling this handler.
+       * The memo is never deserialized.
+       *
        * @param from - the account to transfer from,
        * @param to - the account to be transferred to,
-       * @param quantity - the quantity of tokens to be transferred,
-       * @param memo - the memo string to accompany the transaction.
+       * @param quantity - the quantity of tokens to be transferred.
        */
       void receive_token( const name&    from,
                           const name&    to,
-                          const asset&   quantity,
-                          const string&  memo );
+                          const asset&   quantity );
+
+      /**
+       * `from`, `to` and `quantity` of an eosio.token `transfer` action, the fixed-size prefix of its action data
+       */
+      struct transfer_notification {
+         name  from;
+         name  to;
+         asset quantity;
+      };
+
+      /**
+       * Reads the `transfer_notification` fields of the current eosio.token `transfer` action data without copying the memo.
+       *
+       * @return false if the action data is shorter than the fixed-size prefix
+       */
+      static bool read_transfer_notification( transfer_notification& notification );
 
       /**
        * @brief [Admin] Initialize contract state.
@@ -50,6 +143,24 @@ namespace pieos {
       [[eosio::action]]
       void init();
 
+      /**
+       * @brief [Admin] Add Token Distribution Campaign
+       *
+       * The PIEOS SCO contract admin account adds a stake-coin-offering campaign distributing {{total_dist}}
+       * linearly from {{start_time}} to {{end_time}}. The campaign pool is identified by the symbol code of the distributed token,
+       * and runs on the same stake account records and the same REX position as the PIEOS SCO campaign.
+       * Proxy votes are weighted by {{proxy_vote_weight_percent}} (in 0.01%) of the EOS staking for the campaign token share.
+       *
+       * @param total_dist - total token amount distributed by the campaign, and its token contract
+       * @param start_time - distribution start time
+       * @param end_time - distribution end time
+       * @param proxy_vote_weight_percent - token share weight of proxy votes relative to staked EOS, in 0.01% (1 ~ 10000)
+       *
+       * @pre the SCO contract must be the issuer of the campaign token
+       */
+      [[eosio::action]]
+      void addcampaign( const extended_asset& total_dist, const block_timestamp& start_time, const block_timestamp& end_time, const int32_t proxy_vote_weight_percent );
+
       /**
        * @brief Open Stake Account
        *
@@ -62,6 +173,21 @@ namespace pieos {
       [[eosio::action]]
       void open( const name& owner, const name& ram_payer );
 
+      /**
+       * @brief Migrate On-Contract Balances of Stake Account
+       *
+       * Moves the on-contract EOS and PIEOS balances that earlier contract versions kept on the PIEOS SCO `stakeaccount` record
+       * of {{owner}} (`core_token_bal`, `sco_token_bal`) to the `deposits` records of {{owner}}.
+       * Anyone can run `migrate`, the new deposit records are paid by {{owner}} if authorized, otherwise by the contract.
+       * `stake` and `withdraw` migrate the balances of the owner themselves when needed.
+       *
+       * @param owner - account whose on-contract balances are migrated
+       *
+       * @pre the `stakeaccount` record of {{owner}} must hold a non-zero `core_token_bal` or `sco_token_bal`
+       */
+      [[eosio::action]]
+      void migrate( const name& owner );
+
       /**
        * @brief Close Stake Account
        *
@@ -85,9 +211,10 @@ namespace pieos {
        * @param amount - amount of EOS tokens to be staked
        *
        * @pre the staking EOS amount must be deposited (transferred) to this SCO contract accout
+       * @return staked EOS, received EOS-share(SEOS) and PIEOS-token share(SPIEOS) amounts
        */
       [[eosio::action]]
-      void stake( const name& owner, const asset& amount );
+      stake_core_token_outcome stake( const name& owner, const asset& amount );
 
       /**
        * @brief Unstake EOS tokens on PIEOS SCO(Stake-Coin-Offering) contract to redeem staked EOS tokens and receive PIEOS tokens
@@ -96,40 +223,164 @@ namespace pieos {
        * The {{owner}} receives the redeemed EOS fund including original staked EOS and staking profits, and earned PIEOS token from the contract.
        * The amount of the received SEOS represents the ownership of the {{owner}}’s staked EOS tokens and the profits(excluding contract operation costs) from the staked EOS (EOS-REX profits and BP voting rewards).
        * SPIEOS owner gets the newly-issued PIEOS tokens proportional to their SCO-staked EOS token amount and the staking time span, inversely proportional to the total amount of EOS tokens being staked by all SCO participants.
+       * The redeemed EOS is paid from the pool's liquid EOS if it covers the redemption, otherwise from selling the pool's REX share.
+       * If the REX pool cannot fill the sale, the sell order is queued and the redeemed EOS is credited to the on-contract EOS balance of the {{owner}}.
        *
        * @param owner - account unstaking its staked EOS fund
        * @param amount - unstaking EOS balance
        *
        * @pre the staking EOS amount must be equal or less than the owner's staked EOS amount
+       * @return redeemed EOS fund, earned PIEOS tokens, REX sold and EOS proceeds of the REX sale, settlement path and expected settlement time
+       */
+      [[eosio::action]]
+      unstake_core_token_outcome unstake( const name& owner, const asset& amount );
+
+      /**
+       * @brief Stake EOS tokens on a token distribution campaign to earn the campaign tokens
+       *
+       * Same as `stake`, for the campaign pool {{pool_id}} added by `addcampaign`.
+       *
+       * @param owner - account staking EOS to earn the campaign tokens
+       * @param pool_id - symbol code of the campaign token
+       * @param amount - amount of EOS tokens to be staked
+       *
+       * @pre the staking EOS amount must be deposited (transferred) to this SCO contract accout
+       * @pre the campaign must not be ended
+       * @return staked EOS, received EOS-share(SEOS) and campaign token share(SSCO) amounts
        */
       [[eosio::action]]
-      void unstake( const name& owner, const asset& amount );
+      stake_core_token_outcome stakecamp( const name& owner, const symbol_code& pool_id, const asset& amount );
+
+      /**
+       * @brief Unstake EOS tokens from a token distribution campaign to redeem staked EOS tokens and receive the campaign tokens
+       *
+       * Same as `unstake`, for the campaign pool {{pool_id}} added by `addcampaign`.
+       *
+       * @param owner - account unstaking its staked EOS fund
+       * @param pool_id - symbol code of the campaign token
+       * @param amount - unstaking EOS balance
+       * @return redeemed EOS fund, earned campaign tokens, REX sold and EOS proceeds of the REX sale, settlement path and expected settlement time
+       */
+      [[eosio::action]]
+      unstake_core_token_outcome unstakecamp( const name& owner, const symbol_code& pool_id, const asset& amount );
+
+      /**
+       * @brief Compound EOS staking profits into the staked EOS balance without selling and re-buying REX
+       *
+       * {{owner}} reinvests the EOS staking profits (EOS-REX profits and BP voting rewards) held in its staked share (SEOS).
+       * The profit above the `staked` EOS amount, less the contract admin's profit share, is added to the `staked` balance
+       * and the {{owner}} receives the PIEOS-token share(SPIEOS) for the compounded EOS amount.
+       * The contract's REX position is not changed and no system contract actions are sent,
+       * so the `last_stake_time` and the stake lots (REX maturity) of the {{owner}} are kept, the compounded EOS is matured at once.
+       * The contract admin's profit share is paid from the on-contract BP voting reward balance for staked EOS,
+       * or staked for the contract admin with its staked share(SEOS), left in REX, when that balance does not cover it.
+       * The contract admin compounds its own profit without a profit share.
+       *
+       * @param owner - account compounding its EOS staking profits
+       *
+       * @return staking profit, contract admin's profit share and compounded EOS amount
+       */
+      [[eosio::action]]
+      compound_core_token_outcome compound( const name& owner );
+
+      /**
+       * @brief Move a staked EOS position of the PIEOS SCO pool from {{from}} to {{to}} without touching REX
+       *
+       * The `staked` EOS `amount` and the proportional EOS-share(SEOS) and PIEOS-token share(SPIEOS) of {{from}}
+       * are moved to the stake account record of {{to}}, with the staking profits and the earned PIEOS tokens they hold.
+       * The pool totals are not changed, so no PIEOS is issued, and no system contract or token actions are sent.
+       * Only the matured stake of {{from}} can be moved, it is matured for {{to}} as well, while the unmatured stake
+       * of {{to}} keeps its REX maturity time.
+       *
+       * @param from - account moving its staked EOS position
+       * @param to - account receiving the staked EOS position
+       * @param amount - staked EOS amount to move
+       *
+       * @pre `amount` must be equal or less than the matured staked EOS of {{from}}
+       * @return moved staked EOS, EOS-share and PIEOS-token share amounts
+       */
+      [[eosio::action]]
+      stake_core_token_outcome movestake( const name& from, const name& to, const asset& amount );
 
       /**
        * @brief Update the current proxy voting amount of account {{nowrap $action.account}}
        *
        * The PIEOS-proxy account can run `proxyvoted` action to allocate a PIEOS token share amount
        * to the PIEOS SCO participant {{$action.account}} who proxy-voted to the PIEOS-proxy account.
+       * The proxy voting amount is applied to the PIEOS SCO pool and to every campaign pool added by `addcampaign`.
        *
        * @param account - the account that proxy-voted to PIEOS proxy account.
        * @param proxy_vote - the maximum supply set for the token created.
        *
        * @pre Transaction must be signed by PIEOS proxy voting account
+       * @return redeemed proxy-vote profits and earned PIEOS tokens of the PIEOS SCO pool, zero amounts if the proxy voting amount is increased
+       */
+      [[eosio::action]]
+      unstake_by_proxy_outcome proxyvoted( const name&  account,
+                                           const asset& proxy_vote );
+
+      /**
+       * @brief Harvest the proxy-vote profits of account {{nowrap $action.account}} without changing the proxy voting amount
+       *
+       * {{account}} redeems the EOS proxy-vote profits above its proxy voting amount from its proxy-vote share(SPROXY),
+       * and the earned PIEOS tokens above its weighted staking amount from its PIEOS-token share(SPIEOS).
+       * The proxy voting amount and the PIEOS-token share weight of {{account}} are not changed.
+       *
+       * @param account - the account that proxy-voted to PIEOS proxy account.
+       *
+       * @pre Transaction must be signed by {{account}} or PIEOS proxy voting account
+       * @return harvested proxy-vote profits and earned PIEOS tokens
+       */
+      [[eosio::action]]
+      unstake_by_proxy_outcome harvestproxy( const name& account );
+
+      /**
+       * @brief Sync the proxy voting amounts of `voters` from the `eosio` voters table
+       *
+       * Reads the `staked` and `proxy` fields of each voter's `voters` row and applies the change of its proxy voting amount
+       * as `proxyvoted` does: the voter's staked EOS if it proxies its vote to the PIEOS-proxy account, zero otherwise.
+       * Voters already in sync, changes of the PIEOS SCO pool below the minimum proxy vote change, and voters whose staked EOS
+       * exceeds the maximum proxy vote amount are skipped, they do not fail the batch.
+       * Anyone can run `syncproxy`, the proxy voting amounts are read on-chain.
+       *
+       * @param voters - accounts to sync, at most `MAX_SYNC_PROXY_VOTERS`
+       *
+       * @return number of synced and skipped voters
+       */
+      [[eosio::action]]
+      sync_proxy_outcome syncproxy( const std::vector<name>& voters );
+
+      /**
+       * @brief Pay the earned PIEOS tokens of up to {{max_accounts}} stakers of the PIEOS SCO pool
+       *
+       * Anyone can run `distribute` to visit the `stakers` registry in account name order from where the last run stopped,
+       * and redeem the PIEOS earned by each visited staker's PIEOS-token share(SPIEOS) above its weighted staking amount,
+       * as `harvestproxy` does, if it is at least `DISTRIBUTE_MIN_TOKEN_AMOUNT`.
+       * The PIEOS accrued since the last issuance is issued once, and the stakers are paid by a single `bulktransfer`
+       * of the PIEOS token contract. Stakers without a PIEOS balance record, and contract accounts (with an ABI set)
+       * whose notification handler could reject the whole batch, are skipped and redeem by `unstake` or `harvestproxy`.
+       * No receipts are sent, the payouts are listed by the action return value.
+       * The staked EOS, proxy voting amounts and EOS staking profits of the stakers are not changed.
+       *
+       * @param max_accounts - maximum number of stakers to visit, at most `DISTRIBUTE_MAX_ACCOUNTS_PER_ACTION`
+       *
+       * @return number of visited stakers, total PIEOS paid and the payout of each paid staker
        */
       [[eosio::action]]
-      void proxyvoted( const name&  account,
-                       const asset& proxy_vote );
+      distribute_outcome distribute( const uint32_t max_accounts );
 
       /**
        * @brief Withdraw EOS fund or PIEOS tokens from PIEOS SCO(Stake-Coin-Offering) Contract
        *
-       *  {{owner}} withdraws the EOS or PIEOS token amount of {{amount}} from the SCO contract.
+       *  {{owner}} withdraws the EOS, PIEOS or campaign token amount of {{amount}} from the SCO contract.
+       *  EOS not held liquid by the contract is withdrawn from the contract's REX fund, where the proceeds of the queued REX sell orders are paid.
        *
        * @param owner - account withdrawing its tokens
-       * @param amount - withdrawing token balance (EOS or PIEOS)
+       * @param amount - withdrawing token balance (EOS, PIEOS or a campaign token)
+       * @return withdrawn amount and the remaining on-contract balance of the token
        */
       [[eosio::action]]
-      void withdraw( const name& owner, const asset& amount );
+      withdraw_outcome withdraw( const name& owner, const asset& amount );
 
       /**
        * @brief Claim vested/reserved PIEOS token balance
@@ -142,6 +393,33 @@ namespace pieos {
       [[eosio::action]]
       void claimvested( const name& account, const asset& amount );
 
+      /**
+       * @brief [Admin] Set Vesting Schedule
+       *
+       * The PIEOS SCO contract admin account sets the PIEOS vesting schedule of {{beneficiary}}.
+       * Nothing is vested before {{cliff_time}}, the {{total}} amount vests linearly from {{start_time}} to {{end_time}}.
+       * The reserved fund accounts have built-in schedules until a schedule is set for them.
+       *
+       * @param beneficiary - account receiving the vested PIEOS tokens
+       * @param total - total vesting PIEOS amount, not less than the amount already claimed, 0 removes the schedule
+       * @param start_time - vesting start time
+       * @param cliff_time - time before which nothing can be claimed
+       * @param end_time - time the total amount is vested
+       */
+      [[eosio::action]]
+      void setvesting( const name& beneficiary, const asset& total, const block_timestamp& start_time, const block_timestamp& cliff_time, const block_timestamp& end_time );
+
+      /**
+       * @brief [Admin] Claim Vested PIEOS Tokens for Beneficiaries
+       *
+       * The PIEOS SCO contract admin account claims all vested and unclaimed PIEOS tokens of {{beneficiaries}}.
+       * The claimed amounts are issued by a single `issue` action and transferred to each beneficiary.
+       *
+       * @param beneficiaries - vesting beneficiary accounts, at most `MAX_VESTING_CLAIMS_PER_ACTION` accounts
+       */
+      [[eosio::action]]
+      void claimall( const std::vector<name>& beneficiaries );
+
       /**
        * @brief Update REX for contract account
        *
@@ -152,6 +430,48 @@ namespace pieos {
       [[eosio::action]]
       void updaterex( const name& updater );
 
+      /**
+       * @brief [Admin] Set Maintenance Task Interval
+       *
+       * The PIEOS SCO contract admin account sets the run interval of the contract housekeeping task {{task}}.
+       * Overdue housekeeping tasks are run inline by the user actions (`stake`, `unstake`, `compound`, `proxyvoted`, `harvestproxy`, `withdraw`),
+       * at most `MAINTENANCE_TASKS_PER_ACTION` task per action, so that housekeeping needs no separate transactions
+       * and no single user action pays for a maintenance backlog.
+       *
+       * @param task - maintenance task name (`updaterex`, `gc`)
+       * @param interval_sec - minimum seconds between task runs, 0 removes the task from the schedule
+       */
+      [[eosio::action]]
+      void setmaint( const name& task, const uint32_t interval_sec );
+
+      /**
+       * @brief [Admin] Set Liquid EOS Reserve Target of a Pool
+       *
+       * The PIEOS SCO contract admin account sets the liquid EOS reserve of the pool {{pool_id}} to {{target_percent}} (in 0.01%) of the pool's staked EOS value.
+       * The reserve is kept outside REX and pays out the unstakes it covers with a single transfer, without `sellrex` and `withdraw` on the system contract.
+       * It is refilled up to the target from new stakes, before their EOS is deposited to REX, and from the REX sales of the unstakes it does not cover.
+       * A lowered target is reached as unstakes draw on the reserve.
+       *
+       * @param pool_id - symbol code of the campaign token of the pool, PIEOS for the PIEOS SCO pool
+       * @param target_percent - reserve target in 0.01% of the pool's staked EOS value, at most `MAX_LIQUID_RESERVE_PERCENT`
+       */
+      [[eosio::action]]
+      void setreserve( const symbol_code& pool_id, const uint32_t target_percent );
+
+      /**
+       * @brief Collect empty stake account records paid by the contract
+       *
+       * Anyone can run `gc` to erase up to {{max_rows}} `stakeaccount` and `deposits` records with all-zero balances
+       * whose RAM is paid by the SCO contract (records created for proxy voters and for on-contract balance credits).
+       * Records paid by their owner are left to `close`.
+       * Records are visited in the order they were created from where the last `gc` run stopped.
+       * The freed RAM bytes are added to the contract's reclaimable RAM amount, which the contract admin can sell by `sellram`.
+       *
+       * @param max_rows - maximum number of contract-paid records to visit
+       */
+      [[eosio::action]]
+      void gc( const uint32_t max_rows );
+
       /**
        * @brief [Admin] Set Account Type
        *
@@ -184,18 +504,93 @@ namespace pieos {
       [[eosio::action]]
       void voteproducer( const name& proxy, const std::vector<name>& producers );
 
+      /**
+       * Receipt actions, sent inline by the contract to itself and doing nothing, so that indexers can follow
+       * the contract state by streaming action traces instead of polling the `stakepool` and `stakeaccount` tables.
+       * Each receipt carries the signed deltas of a state change and the resulting balances.
+       */
+
+      /**
+       * @brief [Receipt] staked EOS, EOS-share and token share of {{owner}} on pool {{pool_id}} changed
+       * by `stake`, `unstake`, `stakecamp`, `unstakecamp` or `compound`
+       *
+       * @param owner - staking account
+       * @param pool_id - symbol code of the pool token
+       * @param delta - signed changes of the account balances
+       * @param account - resulting account balances
+       * @param pool - resulting pool totals
+       */
+      [[eosio::action]]
+      void stakelog( const name& owner, const symbol_code& pool_id, const stake_balances& delta, const stake_balances& account, const stake_balances& pool );
+
+      /**
+       * @brief [Receipt] proxy voting amount, proxy-vote share and token share of {{account}} on pool {{pool_id}} changed
+       * by `proxyvoted` or `harvestproxy`
+       *
+       * @param account - proxy-voted account
+       * @param pool_id - symbol code of the pool token
+       * @param delta - signed changes of the account balances
+       * @param balances - resulting account balances
+       * @param pool - resulting pool totals
+       */
+      [[eosio::action]]
+      void proxylog( const name& account, const symbol_code& pool_id, const proxy_vote_balances& delta, const proxy_vote_balances& balances, const proxy_vote_balances& pool );
+
+      /**
+       * @brief [Receipt] {{issued}} SCO tokens accrued to pool {{pool_id}} and issued to the SCO contract
+       *
+       * @param pool_id - symbol code of the pool token
+       * @param issued - issued token amount
+       * @param sco_token_unredeemed - resulting unredeemed token balance of the pool
+       * @param last_total_issued - resulting total token amount issued by the pool
+       */
+      [[eosio::action]]
+      void issuelog( const symbol_code& pool_id, const asset& issued, const asset& sco_token_unredeemed, const asset& last_total_issued );
+
+      /**
+       * @brief [Receipt] redeemed EOS and earned SCO tokens of {{owner}} settled by an unstake, proxy vote withdrawal or harvest
+       * on pool {{pool_id}}
+       *
+       * @param owner - account receiving the settlement
+       * @param pool_id - symbol code of the pool token
+       * @param core_token - EOS paid to {{owner}}, after the contract admin's profit share
+       * @param contract_fee - contract admin's profit share credited to the admin's on-contract balance
+       * @param sco_token - SCO tokens paid to {{owner}}
+       */
+      [[eosio::action]]
+      void settlelog( const name& owner, const symbol_code& pool_id, const asset& core_token, const asset& contract_fee, const asset& sco_token );
+
+      /**
+       * @brief [Receipt] on-contract token balance of {{owner}} changed by a deposit, a stake, a withdrawal,
+       * a contract fee credit or a payout kept for later withdrawal
+       *
+       * @param owner - balance owner
+       * @param delta - signed change of the on-contract balance
+       * @param balance - resulting on-contract balance
+       */
+      [[eosio::action]]
+      void balancelog( const name& owner, const asset& delta, const asset& balance );
+
+      using stakelog_action = eosio::action_wrapper<"stakelog"_n, &pieos_sco::stakelog>;
+      using proxylog_action = eosio::action_wrapper<"proxylog"_n, &pieos_sco::proxylog>;
+      using issuelog_action = eosio::action_wrapper<"issuelog"_n, &pieos_sco::issuelog>;
+      using settlelog_action = eosio::action_wrapper<"settlelog"_n, &pieos_sco::settlelog>;
+      using balancelog_action = eosio::action_wrapper<"balancelog"_n, &pieos_sco::balancelog>;
+
 
    private:
 
       static constexpr symbol STAKED_SHARE_SYMBOL = symbol(symbol_code("S" CORE_TOKEN_SYMBOL_STR ), 4);
       static constexpr symbol PROXY_VOTE_SHARE_SYMBOL = symbol(symbol_code("SPROXY"), 4);
       static constexpr symbol TOKEN_SHARE_SYMBOL = symbol(symbol_code("S" PIEOS_SYMBOL_STR ), 4);
+      static constexpr symbol CAMPAIGN_TOKEN_SHARE_SYMBOL = symbol(symbol_code("SSCO"), 4); // token share of the campaign pools
 
-      static constexpr int64_t STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT = 10000;
-      static constexpr int32_t PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT = 2500; // weight 25.00% of EOS staking share
+      static constexpr int64_t STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT = sco_math::STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT;
+      static constexpr int32_t PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT = sco_math::PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT; // weight 25.00% of EOS staking share
 
       static constexpr uint32_t SCO_START_TIMESTAMP = 1594771200; // July 15, 2020 12:00:00 AM (GMT)
       static constexpr uint32_t SCO_END_TIMESTAMP = 1626307200; // July 15, 2021 12:00:00 AM (GMT)
+      static constexpr auto SCO_EMISSION_CURVE = sco_math::PIEOS_SCO_EMISSION_CURVE; // issuance schedule of the PIEOS and campaign pools
 
       static constexpr int64_t PIEOS_DIST_STAKE_COIN_OFFERING       = 128'000'000'0000ll;
       static constexpr int64_t PIEOS_DIST_STABILITY_FUND            = 18'000'000'0000ll;
@@ -211,7 +606,7 @@ namespace pieos {
       // The admin account exists because the ownership of PIEOS SCO contract account will be resigned to EOS block producers
       static constexpr name PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT   = name("pieosadminac");
 
-      static constexpr int32_t EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN = 1000; // 10.00% of EOS REX + BP voting profits
+      static constexpr int32_t EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN = sco_math::EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN; // 10.00% of EOS REX + BP voting profits
 
 
       /**
@@ -245,14 +640,18 @@ namespace pieos {
       stake_pool_global _stake_pool_db;
 
       /**
-       * core_token_bal - symbol:(EOS,4), on-contract EOS token balance, which can be withdrawn from contract account
-       * sco_token_bal - symbol:(PIEOS,4), on-contract received PIEOS token balance, which can be withdrawn from contract account
+       * core_token_bal - symbol:(EOS,4), on-contract EOS token balance kept by earlier contract versions, moved to `deposits` by `migrate`
+       * sco_token_bal - symbol:(PIEOS,4), on-contract PIEOS token balance kept by earlier contract versions, moved to `deposits` by `migrate`
+       *                 (both kept in the layout so that the existing records stay readable, zero on every record written by this version)
        * staked - symbol:(EOS,4), current staked EOS token amount
        * staked_share - symbol:(SEOS,4), share of staked EOS token plus contract eos profit (EOSREX and BP voting rewards profit) currently held on this PIEOS SCO contract account
        * proxy_vote - symbol:(EOS,4), amount of proxy vote, the EOS amount staked through eosio.system for BP voting
        * proxy_vote_share - symbol:(SPROXY,4), share of proxy voting BP reward profit (EOS transferred from accounts having account-type as ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_PROXY_VOTE_SCO)
        * token_share - symbol:(SPIEOS,4), share of newly-minted SCO token (PIEOS) balance held on this PIEOS SCO contract account
        * last_stake_time - last EOS stake block timestamp
+       * pool_id - symbol code of the pool token (PIEOS or a campaign token), the primary key,
+       *           appended as a binary extension so that the PIEOS SCO records written before the campaign pools,
+       *           which have no `pool_id`, keep their layout and their PIEOS primary key
        */
       struct [[eosio::table]] stake_account {
          asset            core_token_bal;
@@ -263,12 +662,95 @@ namespace pieos {
          asset            proxy_vote_share;
          asset            token_share;
          block_timestamp  last_stake_time;
+         binary_extension<symbol_code> pool_id;
 
-         uint64_t primary_key() const { return PIEOS_SYMBOL.code().raw(); }
+         symbol_code pool() const { return pool_id.has_value() ? pool_id.value() : PIEOS_SYMBOL.code(); }
+         uint64_t primary_key() const { return pool().raw(); }
       };
 
       typedef eosio::multi_index< "stakeaccount"_n, stake_account > stake_accounts;
 
+      /**
+       * REX maturity ledger of an account's stake in a pool (scope: owner), the EOS staked per day whose REX is not matured yet.
+       * `unstake` spends the matured part of the stake, `staked` minus the unmatured lots, so a new stake only locks its own lot.
+       * Matured lots are dropped on every stake and unstake, the record is erased when no lot is left.
+       * Without a record (stakes before the ledger) the whole stake matures with `last_stake_time`, a later stake opens
+       * the record with that stake as its first lot while it is unmatured.
+       *
+       * pool_id - symbol code of the pool token (PIEOS or a campaign token)
+       * lots - unmatured stake lots ordered by maturity time, at most one per day of the REX maturity period
+       */
+      struct [[eosio::table]] stake_lot_ledger {
+         symbol_code                     pool_id;
+         std::vector<sco_math::stake_lot> lots;
+
+         uint64_t primary_key() const { return pool_id.raw(); }
+      };
+
+      typedef eosio::multi_index< "stakelots"_n, stake_lot_ledger > stake_lot_ledgers;
+
+      /**
+       * On-contract token balance which can be withdrawn from contract account, one record per token (EOS, PIEOS or a campaign token).
+       * Deposits, withdrawals and payout credits change only this record, not the `stakeaccount` positions.
+       *
+       * balance - on-contract token balance
+       */
+      struct [[eosio::table]] deposit {
+         asset    balance;
+
+         uint64_t primary_key() const { return balance.symbol.code().raw(); }
+      };
+
+      typedef eosio::multi_index< "deposits"_n, deposit > deposits;
+
+      /**
+       * A token distribution campaign pool, keyed by the symbol code of the distributed token.
+       * Each campaign has its own `stakepool` record (scope: pool id) and `stakeaccount` records (primary key: pool id),
+       * the on-contract token balances are kept on the `deposits` records.
+       * The PIEOS SCO campaign is the default pool, defined by the SCO constants, and has no `campaign` record.
+       *
+       * total_dist - total token amount distributed from `start_time` to `end_time`, and its token contract
+       * start_time - distribution start block timestamp
+       * end_time - distribution end block timestamp
+       * proxy_vote_weight_percent - token share weight of proxy votes relative to staked EOS, in 0.01%
+       * rex_balance - symbol:(REX,4), part of the contract's REX balance bought for the campaign's staked EOS,
+       *               the rest of the contract's REX balance belongs to the PIEOS SCO pool
+       * rex_queued - symbol:(REX,4), REX sold by the campaign's unstakes into the contract's open `rexqueue` sell order
+       *              (already taken out of `rex_balance`, still in the contract's REX balance until the order is filled)
+       * rex_queued_order_time - order time of the open sell order `rex_queued` belongs to, a different or no open order means it is filled
+       */
+      struct [[eosio::table]] campaign {
+         extended_asset   total_dist;
+         block_timestamp  start_time;
+         block_timestamp  end_time;
+         int32_t          proxy_vote_weight_percent;
+         asset            rex_balance;
+         asset            rex_queued;
+         time_point       rex_queued_order_time;
+
+         symbol_code pool_id() const { return total_dist.quantity.symbol.code(); }
+         uint64_t primary_key() const { return pool_id().raw(); }
+      };
+
+      typedef eosio::multi_index< "campaigns"_n, campaign > campaigns;
+
+      /**
+       * pool_id - symbol code of the campaign token of the pool
+       * target_percent - reserve target in 0.01% of the pool's staked EOS value (REX value plus liquid EOS)
+       * balance - symbol:(EOS,4), liquid EOS of the pool's staked EOS value kept outside REX
+       */
+      struct [[eosio::table]] liquid_reserve {
+         symbol_code      pool_id;
+         uint32_t         target_percent;
+         asset            balance;
+
+         uint64_t primary_key() const { return pool_id.raw(); }
+      };
+
+      typedef eosio::multi_index< "liqreserve"_n, liquid_reserve > liquid_reserves;
+
+      static constexpr uint32_t MAX_LIQUID_RESERVE_PERCENT = 2000; // 20.00% of the pool's staked EOS value
+
       /**
        * issued - symbol:(PIEOS,4)
        */
@@ -279,6 +761,26 @@ namespace pieos {
       };
       typedef eosio::multi_index< "reserved"_n, reserved_vesting > reserved_vesting_accounts;
 
+      /**
+       * beneficiary - account receiving the vested PIEOS tokens
+       * total - symbol:(PIEOS,4), total vesting amount
+       * start_time, end_time - linear vesting period
+       * cliff_time - time before which nothing is vested
+       */
+      struct [[eosio::table]] vesting_schedule {
+         name             beneficiary;
+         asset            total;
+         block_timestamp  start_time;
+         block_timestamp  cliff_time;
+         block_timestamp  end_time;
+
+         uint64_t primary_key() const { return beneficiary.value; }
+      };
+
+      typedef eosio::multi_index< "vesting"_n, vesting_schedule > vesting_schedules;
+
+      static constexpr uint32_t MAX_VESTING_CLAIMS_PER_ACTION = 50;
+
 
       struct [[eosio::table]] account_type {
          uint32_t acc_type;
@@ -288,12 +790,114 @@ namespace pieos {
 
       typedef eosio::multi_index< "acctype"_n, account_type > account_type_table;
 
+      static constexpr uint32_t MAX_SYNC_PROXY_VOTERS = 50;
+      static constexpr int64_t MAX_PROXY_VOTE_AMOUNT = 100000000'0000;
+
       static constexpr uint32_t ACCOUNT_TYPE_NORMAL_USER_ACCOUNT = 0;
       static constexpr uint32_t ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_EOS_STAKED_SCO = 1;
       static constexpr uint32_t ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_PROXY_VOTE_SCO = 2;
 
+      /**
+       * task - maintenance task name
+       * interval_sec - minimum seconds between task runs
+       * last_run - last task run block timestamp
+       */
+      struct [[eosio::table]] maintenance_task {
+         name             task;
+         uint32_t         interval_sec;
+         block_timestamp  last_run;
+
+         uint64_t primary_key() const { return task.value; }
+      };
+
+      typedef eosio::multi_index< "maintenance"_n, maintenance_task > maintenance_tasks;
+
+      static constexpr name MAINTENANCE_TASK_UPDATEREX = "updaterex"_n; // `updaterex` of the contract's REX balance on the system contract
+      static constexpr name MAINTENANCE_TASK_GC = "gc"_n; // `gc` of empty contract-paid stake account records
+      static constexpr uint32_t MAINTENANCE_TASKS_PER_ACTION = 1;
+
+      /**
+       * id - entry id
+       * owner - scope of a `stakeaccount` or `deposits` record whose RAM is paid by this contract
+       * table - `stakeaccount` or `deposits`
+       * key - primary key of the record (pool id or token symbol code)
+       */
+      struct [[eosio::table]] contract_paid_row {
+         uint64_t id;
+         name     owner;
+         name     table;
+         uint64_t key;
+
+         uint64_t primary_key() const { return id; }
+         uint128_t by_row() const { return ( static_cast<uint128_t>( owner.value ) << 64 ) | key; }
+      };
+
+      typedef eosio::multi_index< "paidrows"_n, contract_paid_row,
+                                  indexed_by< "byrow"_n, const_mem_fun< contract_paid_row, uint128_t, &contract_paid_row::by_row > >
+                                > contract_paid_rows;
+
+      /**
+       * cursor - `paidrows` id where the next `gc` run starts
+       * rows_erased - total number of `stakeaccount` and `deposits` records erased by `gc`
+       * bytes_freed - total RAM bytes freed by `gc`
+       * bytes_unsold - RAM bytes freed by `gc` and not yet sold by `sellram`
+       */
+      struct [[eosio::table]] gc_state {
+         uint64_t cursor;
+         uint64_t rows_erased;
+         int64_t  bytes_freed;
+         int64_t  bytes_unsold;
+
+         uint64_t primary_key() const { return 0; }
+      };
+
+      typedef eosio::multi_index< "gcstate"_n, gc_state > gc_state_table;
+
+      /**
+       * owner - account holding PIEOS-token shares(SPIEOS) of the PIEOS SCO pool, registered on its stake, proxy vote or moved-in stake
+       * (stakers before the registry are registered on their next stake or proxy vote change),
+       * erased by `distribute` when the account holds no token share any more
+       */
+      struct [[eosio::table]] staker {
+         name     owner;
+
+         uint64_t primary_key() const { return owner.value; }
+      };
+
+      typedef eosio::multi_index< "stakers"_n, staker > stakers;
+
+      /**
+       * cursor - `stakers` owner where the next `distribute` run starts
+       * distributed - symbol:(PIEOS,4), total PIEOS paid by `distribute`
+       */
+      struct [[eosio::table]] distribute_state {
+         name     cursor;
+         asset    distributed;
+
+         uint64_t primary_key() const { return 0; }
+      };
+
+      typedef eosio::multi_index< "diststate"_n, distribute_state > distribute_state_table;
+
+      static constexpr uint32_t DISTRIBUTE_MAX_ACCOUNTS_PER_ACTION = 100; // `MAX_BULK_TRANSFERS` of the PIEOS token contract
+      static constexpr int64_t DISTRIBUTE_MIN_TOKEN_AMOUNT = 100'0000; // 100 PIEOS, smaller earnings are left for a later run
+
+      static constexpr uint32_t GC_MAX_ROWS_PER_ACTION = 100;
+      static constexpr uint32_t GC_ROWS_PER_MAINTENANCE_RUN = 4;
+
+      // billable RAM of erased records: serialized row + key_value_object overhead (108 bytes),
+      // the table_id_object (108 bytes) of a `stakeaccount` or `deposits` scope is freed with its last record
+      static constexpr int64_t STAKE_ACCOUNT_ROW_RAM_BYTES = 7 * 16 + 4 + 8 + 108;
+      static constexpr int64_t DEPOSIT_ROW_RAM_BYTES = 16 + 108;
+      static constexpr int64_t TABLE_RAM_BYTES = 108;
+      static constexpr int64_t CONTRACT_PAID_ROW_RAM_BYTES = 4 * 8 + 108 + 136; // with its `byrow` index entry
+
+      static constexpr name STAKE_ACCOUNT_TABLE = "stakeaccount"_n;
+      static constexpr name DEPOSIT_TABLE = "deposits"_n;
+
       void add_on_contract_token_balance( const name& owner, const asset& value, const name& ram_payer );
-      void sub_on_contract_token_balance( const name& owner, const asset& value );
+      asset sub_on_contract_token_balance( const name& owner, const asset& value );
+      bool migrate_on_contract_token_balances( const name& owner, const name& ram_payer );
       //asset get_on_contract_token_balance( const name& account, const symbol& symbol ) const;
 
       void set_account_type( const name& account, const uint32_t account_type );
@@ -301,29 +905,71 @@ namespace pieos {
       void check_staking_allowed_account( const name& account ) const;
 
       bool stake_pool_initialized() const { return _stake_pool_db.begin() != _stake_pool_db.end(); }
-      asset get_total_core_token_amount_for_staked( const stake_pool_global::const_iterator& sp_itr ) const;
 
-      void require_auth_of_owner_or_admin_after_sco_period( const name& owner );
+      static bool is_default_pool( const symbol_code& pool_id ) { return pool_id == PIEOS_SYMBOL.code(); }
+      static symbol token_share_symbol( const symbol_code& pool_id ) { return is_default_pool( pool_id ) ? TOKEN_SHARE_SYMBOL : CAMPAIGN_TOKEN_SHARE_SYMBOL; }
+      static void set_zero_balances( stake_account& sa, const symbol_code& pool_id );
+      campaign get_campaign( const symbol_code& pool_id ) const;
+      bool has_campaign( const symbol_code& pool_id ) const;
+      uint64_t stake_pool_scope( const symbol_code& pool_id ) const { return is_default_pool( pool_id ) ? get_self().value : pool_id.raw(); }
+      asset get_pool_rex_balance( const campaign& cmp ) const;
+      void add_pool_rex_balance( const symbol_code& pool_id, const int64_t rex_amount );
+      void add_pool_rex_queued( const symbol_code& pool_id, const int64_t rex_amount );
+      static int64_t get_pool_rex_queued( const campaign& cmp, const asset& open_order_rex, const time_point& open_order_time );
+      liquid_reserve get_liquid_reserve( const symbol_code& pool_id ) const;
+      void add_liquid_reserve_balance( const symbol_code& pool_id, const int64_t amount );
+      asset get_total_core_token_amount_for_staked( const campaign& cmp, const stake_pool_global::const_iterator& sp_itr ) const;
+
+      void require_auth_of_owner_or_admin_after_sco_period( const name& owner, const campaign& cmp );
+
+      vesting_schedule get_vesting_schedule( const name& beneficiary ) const;
+      int64_t get_claimed_vested_amount( const name& beneficiary ) const;
+      void add_claimed_vested_amount( const name& beneficiary, const asset& amount );
+
+      static bool is_empty_stake_account( const stake_account& sa );
+      void track_contract_paid_row( const name& owner, const name& table, const uint64_t key );
+      void untrack_contract_paid_rows( const name& owner );
+      void track_staker( const name& owner );
+
+      struct gc_outcome {
+         uint32_t rows_visited;
+         uint32_t rows_erased;
+         int64_t  bytes_freed;
+      };
+      gc_outcome collect_contract_paid_rows( const uint32_t max_rows );
 
-      void stake_core_token( const name& owner, const asset& stake, const stake_pool_global::const_iterator& sp_itr );
+      bool is_maintenance_task( const name& task ) const;
+      void run_scheduled_maintenance();
+      void run_maintenance_task( const name& task );
+      void set_maintenance_task_run( const name& task );
 
-      struct unstake_core_token_outcome {
-         asset staked_and_profit_redeemed;  // symbol:(EOS,4) - original staked EOS + staking profits
-         asset token_earned;                // symbol:(PIEOS,4) - received PIEOS token balance
-         asset rex_to_sell;                 // symbol:(REX,4) - REX amount to sell
-         asset rex_sold_core_token;         // symbol:(EOS,4) - core token proceeds from the REX to be sold
-      };
-      unstake_core_token_outcome unstake_core_token( const name& owner, const int64_t unstake_amount, const stake_pool_global::const_iterator& sp_itr );
+      stake_core_token_outcome stake_in_pool( const name& owner, const asset& amount, const campaign& cmp, stake_pool_global& stake_pool_db );
+      stake_core_token_outcome stake_core_token( const name& owner, const asset& stake, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
 
-      void stake_by_proxy_vote( const name& account, const int64_t stake_proxy_vote_amount, const stake_pool_global::const_iterator& sp_itr );
+      void add_stake_lot( const name& owner, const symbol_code& pool_id, const int64_t amount, const block_timestamp& stake_time );
+      void open_stake_lot_ledger( const name& owner, const stake_account& sa, const name& ram_payer );
+      int64_t get_matured_stake( const name& owner, const stake_account& sa, const time_point_sec& now );
 
-      struct unstake_by_proxy_outcome {
-         asset proxy_vote_profit_redeemed;  // symbol:(EOS,4) - original staked EOS + staking profits
-         asset token_earned;                // symbol:(PIEOS,4) - received PIEOS token balance
-      };
-      unstake_by_proxy_outcome unstake_by_proxy_vote( const name& account, const int64_t unstake_proxy_vote_amount, const stake_pool_global::const_iterator& sp_itr );
+      unstake_core_token_outcome unstake_from_pool( const name& owner, const asset& amount, const campaign& cmp, stake_pool_global& stake_pool_db );
+      unstake_core_token_outcome unstake_core_token( const name& owner, const int64_t unstake_amount, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
+
+      compound_core_token_outcome compound_core_token( const name& owner, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
+
+      unstake_by_proxy_outcome apply_proxy_vote( const name& account, const asset& proxy_vote );
+      unstake_by_proxy_outcome update_proxy_vote( const name& account, const asset& proxy_vote, const campaign& cmp, stake_pool_global& stake_pool_db );
+      void stake_by_proxy_vote( const name& account, const int64_t stake_proxy_vote_amount, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
+
+      unstake_by_proxy_outcome unstake_by_proxy_vote( const name& account, const int64_t unstake_proxy_vote_amount, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
+      unstake_by_proxy_outcome harvest_proxy_vote_profit( const name& account, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
+      void transfer_proxy_vote_outcome( const name& account, const unstake_by_proxy_outcome& outcome, const campaign& cmp );
+      void transfer_sco_token( const name& to, const asset& amount, const campaign& cmp, const name& ram_payer );
+
+      void issue_accrued_SCO_token( const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr );
 
-      void issue_accrued_SCO_token( const stake_pool_global::const_iterator& sp_itr );
+      void send_stake_receipt( const name& owner, const symbol_code& pool_id, const stake_balances& delta, const stake_account& sa, const stake_pool& sp );
+      void send_proxy_vote_receipt( const name& account, const symbol_code& pool_id, const proxy_vote_balances& delta, const stake_account& sa, const stake_pool& sp );
+      void send_settlement_receipt( const name& owner, const campaign& cmp, const asset& core_token, const asset& contract_fee, const asset& sco_token );
+      void send_balance_receipt( const name& owner, const asset& delta, const asset& balance );
    };
 
 }
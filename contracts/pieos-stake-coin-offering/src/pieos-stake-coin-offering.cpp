@@ -2,6 +2,8 @@
 
 #include <eosio-system-contracts-interface.hpp>
 
+#include <algorithm>
+
 using namespace eosio;
 
 namespace pieos {
@@ -14,8 +16,7 @@ namespace pieos {
    }
 
    // called when EOS tokens on eosio.token contract are transferred to this pieos-sco contract account
-   void pieos_sco::receive_token( const name &from, const name &to, const asset &quantity,
-                                  const std::string &memo ) {
+   void pieos_sco::receive_token( const name &from, const name &to, const asset &quantity ) {
       if ( quantity.symbol != CORE_TOKEN_SYMBOL || from == _self || to != _self || quantity.amount <= 0 ) {
          return;
       }
@@ -45,6 +46,22 @@ namespace pieos {
       }
    }
 
+   bool pieos_sco::read_transfer_notification( transfer_notification& notification ) {
+      // action data of `transfer`: from(8) to(8) quantity.amount(8) quantity.symbol(8) memo(varuint32 length + bytes)
+      constexpr uint32_t fixed_size = 4 * sizeof(uint64_t);
+      if ( action_data_size() < fixed_size ) {
+         return false;
+      }
+
+      uint64_t fields[4];
+      read_action_data( fields, fixed_size );
+
+      notification.from     = name( fields[0] );
+      notification.to       = name( fields[1] );
+      notification.quantity = asset( int64_t( fields[2] ), symbol( fields[3] ) );
+      return true;
+   }
+
    // [[eosio::action]]
    void pieos_sco::init() {
       check( !stake_pool_initialized(), "stake pool already initialized" );
@@ -65,6 +82,52 @@ namespace pieos {
       });
    }
 
+   // [[eosio::action]]
+   void pieos_sco::addcampaign( const extended_asset& total_dist, const block_timestamp& start_time, const block_timestamp& end_time, const int32_t proxy_vote_weight_percent ) {
+      require_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
+      check( stake_pool_initialized(), "stake pool not initialized" );
+
+      const symbol sco_symbol = total_dist.quantity.symbol;
+      const symbol_code pool_id = sco_symbol.code();
+      check( total_dist.quantity.is_valid() && total_dist.quantity.amount > 0, "invalid campaign distribution amount" );
+      check( !is_default_pool( pool_id ) && pool_id != CORE_TOKEN_SYMBOL.code(), "campaign token symbol not allowed" );
+      check( start_time.slot < end_time.slot, "campaign end time must be after start time" );
+      check( current_block_time().slot < end_time.slot, "campaign already ended" );
+      check( proxy_vote_weight_percent > 0 && proxy_vote_weight_percent <= 10000, "proxy vote weight out of range" );
+
+      stats_table stats_db( total_dist.contract, pool_id.raw() );
+      const auto& st = stats_db.get( pool_id.raw(), "campaign token not found" );
+      check( st.supply.symbol == sco_symbol, "campaign token symbol precision mismatch" );
+      check( st.issuer == get_self(), "SCO contract must be the issuer of the campaign token" );
+      check( total_dist.quantity.amount <= st.max_supply.amount - st.supply.amount, "campaign distribution exceeds unissued token supply" );
+
+      campaigns campaigns_db( get_self(), get_self().value );
+      check( campaigns_db.find( pool_id.raw() ) == campaigns_db.end(), "campaign already exists" );
+      campaigns_db.emplace( get_self(), [&]( auto& c ) {
+         c.total_dist                 = total_dist;
+         c.start_time                 = start_time;
+         c.end_time                   = end_time;
+         c.proxy_vote_weight_percent  = proxy_vote_weight_percent;
+         c.rex_balance                = asset( 0, REX_SYMBOL );
+         c.rex_queued                 = asset( 0, REX_SYMBOL );
+         c.rex_queued_order_time      = time_point();
+      });
+
+      stake_pool_global stake_pool_db( get_self(), stake_pool_scope( pool_id ) );
+      stake_pool_db.emplace( get_self(), [&]( auto& sp ) {
+         sp.total_staked               = asset( 0, CORE_TOKEN_SYMBOL );
+         sp.total_staked_share         = asset( 0, STAKED_SHARE_SYMBOL );
+         sp.core_token_for_staked      = asset( 0, CORE_TOKEN_SYMBOL );
+         sp.total_proxy_vote           = asset( 0, CORE_TOKEN_SYMBOL );
+         sp.total_proxy_vote_share     = asset( 0, PROXY_VOTE_SHARE_SYMBOL );
+         sp.core_token_for_proxy_vote  = asset( 0, CORE_TOKEN_SYMBOL );
+         sp.total_token_share          = asset( 0, CAMPAIGN_TOKEN_SHARE_SYMBOL );
+         sp.sco_token_unredeemed       = asset( 0, sco_symbol );
+         sp.last_total_issued          = asset( 0, sco_symbol );
+         sp.last_issue_time            = block_timestamp(0);
+      });
+   }
+
    // [[eosio::action]]
    void pieos_sco::open( const name& owner, const name& ram_payer ) {
       require_auth( ram_payer );
@@ -77,18 +140,24 @@ namespace pieos {
 
       if( sa_itr == stake_accounts_db.end() ) {
          stake_accounts_db.emplace( owner, [&]( auto& sa ){
-            sa.core_token_bal = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.sco_token_bal = asset( 0, PIEOS_SYMBOL );
-            sa.staked = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.staked_share = asset( 0, STAKED_SHARE_SYMBOL );
-            sa.proxy_vote = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.proxy_vote_share = asset( 0, PROXY_VOTE_SHARE_SYMBOL );
-            sa.token_share = asset( 0, TOKEN_SHARE_SYMBOL );
-            sa.last_stake_time = sa.last_stake_time = block_timestamp(0);;
+            set_zero_balances( sa, PIEOS_SYMBOL.code() );
+         });
+      }
+
+      deposits deposits_db( get_self(), owner.value );
+      if ( deposits_db.find( CORE_TOKEN_SYMBOL.code().raw() ) == deposits_db.end() ) {
+         deposits_db.emplace( owner, [&]( auto& dp ){
+            dp.balance = asset( 0, CORE_TOKEN_SYMBOL );
          });
       }
    }
 
+   // [[eosio::action]]
+   void pieos_sco::migrate( const name& owner ) {
+      const name ram_payer = has_auth( owner ) ? owner : get_self();
+      check( migrate_on_contract_token_balances( owner, ram_payer ), "no on-contract balances to migrate" );
+   }
+
    // [[eosio::action]]
    void pieos_sco::close( const name& owner ) {
       if ( !has_auth( owner ) ) {
@@ -96,200 +165,361 @@ namespace pieos {
       }
 
       stake_accounts stake_accounts_db( get_self(), owner.value );
-      auto sa_itr = stake_accounts_db.require_find( PIEOS_SYMBOL.code().raw(), "stake account record not found (close)" );
+      deposits deposits_db( get_self(), owner.value );
+      check( stake_accounts_db.begin() != stake_accounts_db.end() || deposits_db.begin() != deposits_db.end(), "stake account record not found (close)" );
 
-      check( sa_itr->core_token_bal.amount == 0
-           && sa_itr->sco_token_bal.amount == 0
-           && sa_itr->staked.amount == 0
-           && sa_itr->staked_share.amount == 0
-           && sa_itr->proxy_vote.amount == 0 && sa_itr->proxy_vote_share.amount == 0
-           && sa_itr->token_share.amount == 0, "stake account has non-zero balance(s)" );
+      // the PIEOS SCO record and the campaign records of `owner`
+      for ( auto sa_itr = stake_accounts_db.begin(); sa_itr != stake_accounts_db.end(); ) {
+         check( is_empty_stake_account( *sa_itr ), "stake account has non-zero balance(s)" );
+         sa_itr = stake_accounts_db.erase( sa_itr );
+      }
+
+      for ( auto dp_itr = deposits_db.begin(); dp_itr != deposits_db.end(); ) {
+         check( dp_itr->balance.amount == 0, "stake account has non-zero balance(s)" );
+         dp_itr = deposits_db.erase( dp_itr );
+      }
 
-      stake_accounts_db.erase( sa_itr );
+      untrack_contract_paid_rows( owner );
    }
 
    // [[eosio::action]]
-   void pieos_sco::stake( const name& owner, const asset& amount ) {
-      check( amount.symbol == CORE_TOKEN_SYMBOL, "stake amount symbol precision mismatch" );
-      check( amount.amount >= 1'0000, "invalid stake amount" );
-      check( stake_pool_initialized(), "stake pool not initialized" );
-      check_staking_allowed_account( owner );
+   pieos_sco::stake_core_token_outcome pieos_sco::stake( const name& owner, const asset& amount ) {
+      const auto stake_outcome = stake_in_pool( owner, amount, get_campaign( PIEOS_SYMBOL.code() ), _stake_pool_db );
 
-      require_auth(owner);
+      run_scheduled_maintenance();
+      return stake_outcome;
+   }
 
-      // subtract user's on-contract EOS balance which is being deposited to EOS REX fund.
-      sub_on_contract_token_balance( owner, amount );
+   // [[eosio::action]]
+   pieos_sco::unstake_core_token_outcome pieos_sco::unstake( const name& owner, const asset& amount ) {
+      const auto unstake_outcome = unstake_from_pool( owner, amount, get_campaign( PIEOS_SYMBOL.code() ), _stake_pool_db );
 
-      auto sp_itr = _stake_pool_db.begin();
-      // issue PIEOS accrued since last issuance time (send inline token issue action to PIEOS token contract)
-      issue_accrued_SCO_token( sp_itr );
+      run_scheduled_maintenance();
+      return unstake_outcome;
+   }
 
-      stake_core_token( owner, amount, sp_itr );
+   // [[eosio::action]]
+   pieos_sco::stake_core_token_outcome pieos_sco::stakecamp( const name& owner, const symbol_code& pool_id, const asset& amount ) {
+      check( !is_default_pool( pool_id ), "not a campaign pool" );
+      const campaign cmp = get_campaign( pool_id );
+      check( current_block_time().slot < cmp.end_time.slot, "campaign ended" );
 
-      // (inline actions) deposit rex-fund and buy rex from system contract to earn rex staking profit
-      eosio_system_deposit_action deposit_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
-      deposit_act.send( get_self(), amount );
+      stake_pool_global stake_pool_db( get_self(), stake_pool_scope( pool_id ) );
+      const auto stake_outcome = stake_in_pool( owner, amount, cmp, stake_pool_db );
 
-      eosio_system_buyrex_action buyrex_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
-      buyrex_act.send( get_self(), amount );
+      run_scheduled_maintenance();
+      return stake_outcome;
    }
 
    // [[eosio::action]]
-   void pieos_sco::unstake( const name& owner, const asset& amount ) {
-      check( amount.symbol == CORE_TOKEN_SYMBOL, "unstake amount symbol precision mismatch" );
-      check( amount.amount > 0, "invalid unstake amount" );
+   pieos_sco::unstake_core_token_outcome pieos_sco::unstakecamp( const name& owner, const symbol_code& pool_id, const asset& amount ) {
+      check( !is_default_pool( pool_id ), "not a campaign pool" );
+      const campaign cmp = get_campaign( pool_id );
+
+      stake_pool_global stake_pool_db( get_self(), stake_pool_scope( pool_id ) );
+      const auto unstake_outcome = unstake_from_pool( owner, amount, cmp, stake_pool_db );
+
+      run_scheduled_maintenance();
+      return unstake_outcome;
+   }
+
+   // [[eosio::action]]
+   pieos_sco::compound_core_token_outcome pieos_sco::compound( const name& owner ) {
       check( stake_pool_initialized(), "stake pool not initialized");
       check_staking_allowed_account( owner );
 
-      // before the end od SCO period, owner account auth is required,
-      // after end of SCO period, admin account can execute `unstake` on behalf of the stake `owner` account
-      require_auth_of_owner_or_admin_after_sco_period( owner );
+      require_auth( owner );
 
+      const campaign cmp = get_campaign( PIEOS_SYMBOL.code() );
       auto sp_itr = _stake_pool_db.begin();
 
       // issue PIEOS accrued since last issuance time (send inline token issue action to PIEOS token contract)
-      issue_accrued_SCO_token( sp_itr );
+      issue_accrued_SCO_token( cmp, _stake_pool_db, sp_itr );
 
-      const int64_t unstake_amount = amount.amount;
-      auto unstake_outcome = unstake_core_token( owner, unstake_amount, sp_itr );
+      auto compound_outcome = compound_core_token( owner, cmp, _stake_pool_db, sp_itr );
+      check( compound_outcome.compounded.amount > 0, "no staking profit to compound" );
 
-      if (unstake_outcome.rex_to_sell.amount > 0) {
-         // (inline action) sell rex to receive EOS
-         eosio_system_sellrex_action sellrex_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
-         sellrex_act.send( get_self(), unstake_outcome.rex_to_sell );
-
-         if ( unstake_outcome.rex_sold_core_token.amount > 0 ) {
-            // (inline action) withdraw EOS from rexfund of eosio system contract
-            eosio_system_withdraw_action withdraw_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
-            withdraw_act.send( get_self(), unstake_outcome.rex_sold_core_token );
-         }
+      if ( compound_outcome.contract_profit.amount > 0 ) {
+         send_settlement_receipt( owner, cmp, asset( 0, CORE_TOKEN_SYMBOL ), compound_outcome.contract_profit, asset( 0, cmp.total_dist.quantity.symbol ) );
       }
 
-      if ( unstake_outcome.token_earned.amount > 0 ) {
-         // transfer received PIEOS token ownership from contract to user
-         if ( is_token_account_open( PIEOS_TOKEN_CONTRACT, owner, PIEOS_SYMBOL ) ) {
-            token_transfer_action transfer_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-            transfer_act.send( get_self(), owner, unstake_outcome.token_earned, "PIEOS SCO" );
-         } else {
-            add_on_contract_token_balance( owner, unstake_outcome.token_earned, owner );
-         }
-      }
+      run_scheduled_maintenance();
+      return compound_outcome;
+   }
 
-      if ( unstake_outcome.staked_and_profit_redeemed.amount > 0 ) {
-         // redeemed EOS fund (original staked EOS + staking profits)
-         asset redeemed_to_unstaker = unstake_outcome.staked_and_profit_redeemed;
+   // [[eosio::action]]
+   pieos_sco::stake_core_token_outcome pieos_sco::movestake( const name& from, const name& to, const asset& amount ) {
+      check( amount.symbol == CORE_TOKEN_SYMBOL, "stake amount symbol precision mismatch" );
+      check( amount.amount > 0, "invalid move amount" );
+      check( from != to, "cannot move stake to self" );
+      check( stake_pool_initialized(), "stake pool not initialized");
+      check_staking_allowed_account( from );
+      check_staking_allowed_account( to );
 
-         const int64_t eos_staking_profit = unstake_outcome.staked_and_profit_redeemed.amount - unstake_amount;
-         if ( eos_staking_profit > 0 ) {
-            const int64_t contract_profit = eos_staking_profit * EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN / 10000;
-            if ( contract_profit > 0 ) {
-               redeemed_to_unstaker.amount -= contract_profit;
-               add_on_contract_token_balance( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, asset( contract_profit, CORE_TOKEN_SYMBOL ), get_self() );
-            }
-         }
+      require_auth( from );
+      check( is_account( to ), "to account does not exist" );
 
-         if ( redeemed_to_unstaker.amount > 0 ) {
-            asset contract_core_token_balance = get_token_balance_from_contract( EOSIO_TOKEN_CONTRACT, get_self(), CORE_TOKEN_SYMBOL );
-            if ( redeemed_to_unstaker.amount <= contract_core_token_balance.amount + unstake_outcome.rex_sold_core_token.amount ) {
-               token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-               transfer_act.send( get_self(), owner, redeemed_to_unstaker, "PIEOS SCO - UNSTAKE" );
-            } else {
-               // add user's on-contract EOS balance for later withdrawal
-               add_on_contract_token_balance( owner, redeemed_to_unstaker, owner );
-            }
-         }
+      const campaign cmp = get_campaign( PIEOS_SYMBOL.code() );
+
+      stake_accounts from_accounts_db( get_self(), from.value );
+      auto from_itr = from_accounts_db.require_find( cmp.pool_id().raw(), "stake account record not found (move stake)" );
+      check( amount.amount <= from_itr->staked.amount, "not enough staked balance" );
+      check( amount.amount <= get_matured_stake( from, *from_itr, time_point_sec( current_time_point() ) ), "cannot move stake until rex maturity time" );
+
+      // the same proportions as `unstake`, the moved shares keep the staking profits and the earned PIEOS tokens they hold
+      const int64_t staked_share_to_move = sco_math::mul_div( amount.amount, from_itr->staked_share.amount, from_itr->staked.amount );
+      const int64_t token_share_to_move = sco_math::mul_div( amount.amount, from_itr->token_share.amount,
+                                                             sco_math::weighted_staking_amount( from_itr->staked.amount, from_itr->proxy_vote.amount, cmp.proxy_vote_weight_percent ) );
+
+      from_accounts_db.modify( from_itr, same_payer, [&]( auto& sa ) {
+         sa.staked.amount       -= amount.amount;
+         sa.staked_share.amount -= staked_share_to_move;
+         sa.token_share.amount  -= token_share_to_move;
+      });
+
+      stake_accounts to_accounts_db( get_self(), to.value );
+      auto to_itr = to_accounts_db.find( cmp.pool_id().raw() );
+      if ( to_itr == to_accounts_db.end() ) {
+         to_itr = to_accounts_db.emplace( from, [&]( auto& sa ){
+            set_zero_balances( sa, cmp.pool_id() );
+         });
       }
+      // the moved stake is matured, `to`'s own unmatured stake keeps its lot
+      open_stake_lot_ledger( to, *to_itr, from );
+      to_accounts_db.modify( to_itr, same_payer, [&]( auto& sa ) {
+         sa.staked.amount       += amount.amount;
+         sa.staked_share.amount += staked_share_to_move;
+         sa.token_share.amount  += token_share_to_move;
+      });
+      track_staker( to );
+
+      // no inline actions (not even the `stakelog` receipts), the action return value records the moved balances
+      return stake_core_token_outcome{ amount, asset( staked_share_to_move, STAKED_SHARE_SYMBOL ), asset( token_share_to_move, TOKEN_SHARE_SYMBOL ) };
    }
 
    // [[eosio::action]]
-   void pieos_sco::proxyvoted( const name&  account,
-                               const asset& proxy_vote ) {
+   pieos_sco::unstake_by_proxy_outcome pieos_sco::proxyvoted( const name&  account,
+                                                              const asset& proxy_vote ) {
       check( proxy_vote.symbol == CORE_TOKEN_SYMBOL, "proxy vote symbol precision mismatch" );
-      check( proxy_vote.amount < 100000000'0000, "exceeds maximum proxy vote amount" );
+      check( proxy_vote.amount < MAX_PROXY_VOTE_AMOUNT, "exceeds maximum proxy vote amount" );
       check( stake_pool_initialized(), "stake pool not initialized");
       check_staking_allowed_account( account );
 
       require_auth( PIEOS_PROXY_VOTING_ACCOUNT );
       check( is_account( account ), "target account does not exist" );
 
+      const auto proxy_vote_outcome = apply_proxy_vote( account, proxy_vote );
+
+      run_scheduled_maintenance();
+      return proxy_vote_outcome;
+   }
+
+   // [[eosio::action]]
+   pieos_sco::sync_proxy_outcome pieos_sco::syncproxy( const std::vector<name>& voters ) {
+      check( stake_pool_initialized(), "stake pool not initialized");
+      check( !voters.empty(), "no voters to sync" );
+      check( voters.size() <= MAX_SYNC_PROXY_VOTERS, "too many voters to sync" );
+
+      sync_proxy_outcome outcome{ 0, 0 };
+
+      for ( const name& voter : voters ) {
+         if ( !is_account_type( voter, ACCOUNT_TYPE_NORMAL_USER_ACCOUNT ) || voter == get_self() ) {
+            ++outcome.skipped;
+            continue;
+         }
+
+         // (read-only) `staked` and `proxy` of the voter's `voters` row on the system contract
+         const int64_t proxied_vote_stake = get_proxied_vote_stake( voter, PIEOS_PROXY_VOTING_ACCOUNT );
+         if ( proxied_vote_stake >= MAX_PROXY_VOTE_AMOUNT ) {
+            // `proxyvoted` would reject it, skipped so that one voter does not fail the whole batch
+            ++outcome.skipped;
+            continue;
+         }
+
+         int64_t current_proxy_vote = 0;
+         {
+            stake_accounts stake_accounts_db( get_self(), voter.value );
+            auto sa_itr = stake_accounts_db.find( PIEOS_SYMBOL.code().raw() );
+            current_proxy_vote = ( sa_itr == stake_accounts_db.end() ) ? 0 : sa_itr->proxy_vote.amount;
+         }
+
+         // same minimum proxy vote change as `proxyvoted`, a zero change would not redeem anything
+         const int64_t proxy_vote_delta = proxied_vote_stake - current_proxy_vote;
+         if ( proxy_vote_delta == 0 || ( proxied_vote_stake != 0 && proxy_vote_delta < 1'0000 && proxy_vote_delta >= -1'0000 ) ) {
+            ++outcome.skipped;
+            continue;
+         }
+
+         apply_proxy_vote( voter, asset( proxied_vote_stake, CORE_TOKEN_SYMBOL ) );
+         ++outcome.synced;
+      }
+
+      run_scheduled_maintenance();
+      return outcome;
+   }
+
+   // [[eosio::action]]
+   pieos_sco::distribute_outcome pieos_sco::distribute( const uint32_t max_accounts ) {
+      check( max_accounts > 0 && max_accounts <= DISTRIBUTE_MAX_ACCOUNTS_PER_ACTION, "max_accounts out of range" );
+      check( stake_pool_initialized(), "stake pool not initialized");
+
+      stakers stakers_db( get_self(), get_self().value );
+      check( stakers_db.begin() != stakers_db.end(), "no stakers to distribute" );
+
+      const campaign cmp = get_campaign( PIEOS_SYMBOL.code() );
       auto sp_itr = _stake_pool_db.begin();
 
-      asset current_proxy_vote( 0, CORE_TOKEN_SYMBOL );
-      {
-         stake_accounts stake_accounts_db( get_self(), account.value );
-         auto sa_itr = stake_accounts_db.find( PIEOS_SYMBOL.code().raw() );
-         current_proxy_vote.amount = (sa_itr == stake_accounts_db.end()) ? 0 : sa_itr->proxy_vote.amount;
+      // issue PIEOS accrued since last issuance time, once for the whole batch
+      issue_accrued_SCO_token( cmp, _stake_pool_db, sp_itr );
+
+      distribute_state_table dist_state_db( get_self(), get_self().value );
+      auto ds_itr = dist_state_db.find( 0 );
+      if ( ds_itr == dist_state_db.end() ) {
+         ds_itr = dist_state_db.emplace( get_self(), [&]( auto& ds ) {
+            ds.cursor = name();
+            ds.distributed = asset( 0, cmp.total_dist.quantity.symbol );
+         });
       }
 
-      asset proxy_vote_delta = proxy_vote - current_proxy_vote;
-      check( proxy_vote.amount == 0 || proxy_vote_delta.amount >= 1'0000 || proxy_vote_delta.amount < -1'0000, "invalid proxy_vote_delta" );
+      // the staked EOS and proxy votes are not changed by the batch, only the token shares and the unredeemed PIEOS
+      const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( sp_itr->total_staked.amount, sp_itr->total_proxy_vote.amount, cmp.proxy_vote_weight_percent );
+      int64_t total_token_share_amount = sp_itr->total_token_share.amount;
+      int64_t total_unredeemed_sco_token_amount = sp_itr->sco_token_unredeemed.amount;
 
-      // issue PIEOS accrued since last issuance time (send inline token issue action to PIEOS token contract)
-      issue_accrued_SCO_token( sp_itr );
+      distribute_outcome outcome{ 0, asset( 0, cmp.total_dist.quantity.symbol ), {} };
+      std::vector<token_transfer_entry> transfers;
 
-      if ( proxy_vote_delta.amount > 0 ) {
-         stake_by_proxy_vote( account, proxy_vote_delta.amount, sp_itr );
-      } else {
-         const int64_t unstake_proxy_vote_amount = -proxy_vote_delta.amount;
-         auto unstake_by_proxy_outcome = unstake_by_proxy_vote( account, unstake_proxy_vote_amount, sp_itr );
+      auto st_itr = stakers_db.lower_bound( ds_itr->cursor.value );
+      if ( st_itr == stakers_db.end() ) {
+         st_itr = stakers_db.begin();
+      }
 
-         if ( unstake_by_proxy_outcome.token_earned.amount > 0 ) {
-            // transfer received PIEOS token ownership from contract to user
-            if ( is_token_account_open( PIEOS_TOKEN_CONTRACT, account, PIEOS_SYMBOL ) ) {
-               token_transfer_action transfer_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-               transfer_act.send( get_self(), account, unstake_by_proxy_outcome.token_earned, "PIEOS SCO" );
-            } else {
-               add_on_contract_token_balance( account, unstake_by_proxy_outcome.token_earned, get_self() );
-            }
-         }
+      while ( st_itr != stakers_db.end() && outcome.visited < max_accounts ) {
+         ++outcome.visited;
+         const name owner = st_itr->owner;
 
-         if ( unstake_by_proxy_outcome.proxy_vote_profit_redeemed.amount > 0 ) {
-            // redeemed proxy-vote profit
-            asset redeemed_to_unstaker = unstake_by_proxy_outcome.proxy_vote_profit_redeemed;
+         stake_accounts stake_accounts_db( get_self(), owner.value );
+         auto sa_itr = stake_accounts_db.find( cmp.pool_id().raw() );
+         if ( sa_itr == stake_accounts_db.end() || sa_itr->token_share.amount == 0 ) {
+            // closed, collected or fully unstaked position
+            st_itr = stakers_db.erase( st_itr );
+            continue;
+         }
+         ++st_itr;
 
-            const int64_t contract_profit = unstake_by_proxy_outcome.proxy_vote_profit_redeemed.amount * EOS_REX_BP_VOTING_PROFIT_PERCENT_FOR_CONTRACT_ADMIN / 10000;
-            if ( contract_profit > 0 ) {
-               redeemed_to_unstaker.amount -= contract_profit;
-               add_on_contract_token_balance( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, asset(contract_profit, CORE_TOKEN_SYMBOL), get_self() );
-            }
+         // every `bulktransfer` recipient is notified, a contract rejecting the notification would fail the whole batch;
+         // contract accounts and stakers without a PIEOS balance record are skipped, they redeem their earnings by `unstake` or `harvestproxy`
+         if ( has_contract_abi( owner ) || !is_token_account_open( cmp.total_dist.contract, owner, cmp.total_dist.quantity.symbol ) ) {
+            continue;
+         }
 
-            if ( redeemed_to_unstaker.amount > 0 ) {
-               asset contract_core_token_balance = get_token_balance_from_contract( EOSIO_TOKEN_CONTRACT, get_self(), CORE_TOKEN_SYMBOL );
-               if ( redeemed_to_unstaker.amount <= contract_core_token_balance.amount ) {
-                  token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-                  transfer_act.send( get_self(), account, redeemed_to_unstaker, "PIEOS SCO - Proxy Voting Profits" );
-               } else {
-                  // add user's on-contract EOS balance for later withdrawal
-                  add_on_contract_token_balance( account, redeemed_to_unstaker, get_self() );
-               }
-            }
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, total_unredeemed_sco_token_amount ); // weighted EOS amount + PIEOS amount
+         const int64_t TS0 = total_token_share_amount;
+         const int64_t token_share_to_redeem = sco_math::earned_token_share( sa_itr->token_share.amount,
+                                                                             sco_math::weighted_staking_amount( sa_itr->staked.amount, sa_itr->proxy_vote.amount, cmp.proxy_vote_weight_percent ),
+                                                                             EP0, TS0 );
+         const int64_t redeemed_token_amount = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
+         if ( redeemed_token_amount < DISTRIBUTE_MIN_TOKEN_AMOUNT ) {
+            continue;
          }
+
+         total_token_share_amount = TS0 - token_share_to_redeem;
+         total_unredeemed_sco_token_amount -= redeemed_token_amount;
+
+         stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
+            sa.token_share.amount -= token_share_to_redeem;
+         });
+
+         const asset token_earned( redeemed_token_amount, cmp.total_dist.quantity.symbol );
+         transfers.push_back( token_transfer_entry{ owner, token_earned } );
+
+         // no receipts per payout, the action return value lists them
+         outcome.distributed += token_earned;
+         outcome.payouts.push_back( distribute_payout{ owner, asset( token_share_to_redeem, TOKEN_SHARE_SYMBOL ), token_earned } );
+      }
+
+      if ( !outcome.payouts.empty() ) {
+         _stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+            sp.total_token_share.amount    = total_token_share_amount;
+            sp.sco_token_unredeemed.amount = std::max<int64_t>( total_unredeemed_sco_token_amount, 0 );
+         });
+      }
+
+      const name next_cursor = ( st_itr == stakers_db.end() ) ? name() : st_itr->owner;
+      dist_state_db.modify( ds_itr, same_payer, [&]( auto& ds ) {
+         ds.cursor = next_cursor;
+         ds.distributed += outcome.distributed;
+      });
+
+      if ( !transfers.empty() ) {
+         // (inline action) one transfer action of the PIEOS token contract for all paid stakers
+         token_bulktransfer_action bulktransfer_act{ cmp.total_dist.contract, { { get_self(), "active"_n } } };
+         bulktransfer_act.send( get_self(), transfers, "PIEOS SCO" );
+      }
+
+      return outcome;
+   }
+
+   // [[eosio::action]]
+   pieos_sco::unstake_by_proxy_outcome pieos_sco::harvestproxy( const name& account ) {
+      check( stake_pool_initialized(), "stake pool not initialized");
+      check_staking_allowed_account( account );
+
+      if ( !has_auth( account ) ) {
+         check( has_auth( PIEOS_PROXY_VOTING_ACCOUNT ), "require account or proxy voting account auth." );
       }
+
+      const campaign cmp = get_campaign( PIEOS_SYMBOL.code() );
+      auto sp_itr = _stake_pool_db.begin();
+
+      // issue PIEOS accrued since last issuance time (send inline token issue action to PIEOS token contract)
+      issue_accrued_SCO_token( cmp, _stake_pool_db, sp_itr );
+
+      auto harvest_outcome = harvest_proxy_vote_profit( account, cmp, _stake_pool_db, sp_itr );
+      check( harvest_outcome.proxy_vote_profit_redeemed.amount > 0 || harvest_outcome.token_earned.amount > 0, "no proxy vote profit to harvest" );
+
+      transfer_proxy_vote_outcome( account, harvest_outcome, cmp );
+
+      run_scheduled_maintenance();
+      return harvest_outcome;
    }
 
    // [[eosio::action]]
-   void pieos_sco::withdraw( const name& owner, const asset& amount ) {
-      check( amount.symbol == CORE_TOKEN_SYMBOL || amount.symbol == PIEOS_SYMBOL, "withdrawal amount symbol must be EOS or PIEOS" );
+   pieos_sco::withdraw_outcome pieos_sco::withdraw( const name& owner, const asset& amount ) {
+      check( amount.symbol == CORE_TOKEN_SYMBOL || ( has_campaign( amount.symbol.code() ) && amount.symbol == get_campaign( amount.symbol.code() ).total_dist.quantity.symbol ),
+             "withdrawal amount symbol must be EOS, PIEOS or a campaign token" );
       check( amount.amount > 0, "invalid withdrawal amount" );
       check_staking_allowed_account( owner );
 
       // before the end od SCO period, owner account auth is required,
       // after the end of SCO period, admin account can execute `withdraw` on behalf of the `owner` account
-      require_auth_of_owner_or_admin_after_sco_period( owner );
+      require_auth_of_owner_or_admin_after_sco_period( owner, get_campaign( PIEOS_SYMBOL.code() ) );
 
       // adjust token balance on PIEOS contract
-      sub_on_contract_token_balance( owner, amount );
+      const asset on_contract_balance = sub_on_contract_token_balance( owner, amount );
 
       if ( amount.symbol == CORE_TOKEN_SYMBOL ) {
          asset contract_core_token_balance = get_token_balance_from_contract( EOSIO_TOKEN_CONTRACT, get_self(), CORE_TOKEN_SYMBOL );
-         check(amount <= contract_core_token_balance, "not enough SCO contract's EOS balance because of pending REX sell orders" );
+         if ( amount > contract_core_token_balance ) {
+            // proceeds of the filled REX sell orders queued by `unstake` are paid to the contract's REX fund
+            const asset rex_fund_withdrawal = amount - contract_core_token_balance;
+            check( rex_fund_withdrawal <= get_rex_fund_balance( get_self() ), "not enough SCO contract's EOS balance because of pending REX sell orders" );
+
+            // (inline action) withdraw EOS from rexfund of eosio system contract
+            eosio_system_withdraw_action withdraw_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
+            withdraw_act.send( get_self(), rex_fund_withdrawal );
+         }
 
          token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
          transfer_act.send( get_self(), owner, amount, "PIEOS SCO" );
-      } else if ( amount.symbol == PIEOS_SYMBOL ) {
-         token_transfer_action transfer_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
+      } else {
+         // PIEOS or campaign token
+         token_transfer_action transfer_act{ get_campaign( amount.symbol.code() ).total_dist.contract, { { get_self(), "active"_n } } };
          transfer_act.send( get_self(), owner, amount, "PIEOS SCO" );
       }
+
+      run_scheduled_maintenance();
+      return withdraw_outcome{ amount, on_contract_balance };
    }
 
    // [[eosio::action]]
@@ -299,52 +529,99 @@ namespace pieos {
 
       require_auth( account );
 
-      const block_timestamp sco_start_block { time_point_sec(SCO_START_TIMESTAMP) };
-      const block_timestamp sco_end_block { time_point_sec(SCO_END_TIMESTAMP) };
-      const int64_t total_sco_time_period = sco_end_block.slot - sco_start_block.slot;
-      block_timestamp current_block = current_block_time();
+      const vesting_schedule vs = get_vesting_schedule( account );
+      const int64_t max_claimable = sco_math::scheduled_vested_amount( vs.total.amount, current_block_time().slot,
+                                                                       vs.start_time.slot, vs.cliff_time.slot, vs.end_time.slot );
+      const int64_t already_claimed = get_claimed_vested_amount( account );
 
-      check( current_block.slot > sco_start_block.slot, "claim not allowed before SCO start" );
+      check( already_claimed + amount.amount <= max_claimable, "exceeds max claimable token amount" );
 
-      reserved_vesting_accounts vesting_accounts_db( get_self(), account.value );
-      auto va_itr = vesting_accounts_db.find( amount.symbol.code().raw() );
-      int64_t already_claimed = (va_itr == vesting_accounts_db.end())? 0 : va_itr->issued.amount;
-
-      int64_t max_claimable = 0;
-
-      if ( account == PIEOS_MARKETING_OPERATION_ACCOUNT ) {
-         max_claimable = PIEOS_DIST_MARKETING_OPERATION_FUND;
-      } else if ( account == PIEOS_STABILITY_FUND_ACCOUNT ) {
-         max_claimable = PIEOS_DIST_STABILITY_FUND;
-         check( current_block.slot > sco_start_block.slot + uint32_t(total_sco_time_period) / 2, "PIEOS stability fund locked until the mid point of SCO period" );
-      } else if ( account == PIEOS_DEVELOPMENT_TEAM_ACCOUNT ) {
-         if ( current_block.slot > sco_end_block.slot ) {
-            current_block.slot = sco_end_block.slot;
-         }
-         const int64_t elapsed = current_block.slot - sco_start_block.slot;
-         max_claimable = (uint128_t(PIEOS_DIST_DEVELOPMENT_TEAM) * elapsed) / total_sco_time_period;
-      } else {
-         check( false, "not reserved vesting account" );
+      add_claimed_vested_amount( account, amount );
+
+      // (inline actions) issue and transfer PIEOS tokens
+      token_issue_action token_issue_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
+      token_issue_act.send(get_self(), amount, "issue vested PIEOS" );
+
+      token_transfer_action transfer_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
+      transfer_act.send( get_self(), account, amount, "claim vested PIEOS" );
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::setvesting( const name& beneficiary, const asset& total, const block_timestamp& start_time, const block_timestamp& cliff_time, const block_timestamp& end_time ) {
+      require_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
+
+      check( is_account( beneficiary ), "beneficiary account does not exist" );
+      check( total.symbol == PIEOS_SYMBOL, "vesting amount symbol precision mismatch" );
+      check( total.is_valid() && total.amount >= 0, "invalid vesting amount" );
+
+      vesting_schedules vesting_db( get_self(), get_self().value );
+      auto vs_itr = vesting_db.find( beneficiary.value );
+
+      if ( total.amount == 0 ) {
+         check( vs_itr != vesting_db.end(), "vesting schedule not found" );
+         vesting_db.erase( vs_itr );
+         return;
       }
 
-      check( already_claimed + amount.amount <= max_claimable, "exceeds max claimable token amount" );
+      check( start_time.slot <= cliff_time.slot && cliff_time.slot <= end_time.slot, "vesting times must be start <= cliff <= end" );
+      check( total.amount >= get_claimed_vested_amount( beneficiary ), "vesting amount less than already claimed amount" );
 
-      if ( va_itr == vesting_accounts_db.end() ) {
-         vesting_accounts_db.emplace( get_self(), [&]( auto& va ){
-            va.issued = amount;
-         });
+      auto set_schedule = [&]( auto& vs ) {
+         vs.beneficiary = beneficiary;
+         vs.total       = total;
+         vs.start_time  = start_time;
+         vs.cliff_time  = cliff_time;
+         vs.end_time    = end_time;
+      };
+
+      if ( vs_itr == vesting_db.end() ) {
+         vesting_db.emplace( get_self(), set_schedule );
       } else {
-         vesting_accounts_db.modify( va_itr, same_payer, [&]( auto& va ) {
-            va.issued += amount;
-         });
+         vesting_db.modify( vs_itr, same_payer, set_schedule );
       }
+   }
 
-      // (inline actions) issue and transfer PIEOS tokens
+   // [[eosio::action]]
+   void pieos_sco::claimall( const std::vector<name>& beneficiaries ) {
+      require_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
+
+      check( !beneficiaries.empty(), "no beneficiaries" );
+      check( beneficiaries.size() <= MAX_VESTING_CLAIMS_PER_ACTION, "too many beneficiaries" );
+      {
+         std::vector<name> sorted( beneficiaries );
+         std::sort( sorted.begin(), sorted.end() );
+         check( std::adjacent_find( sorted.begin(), sorted.end() ) == sorted.end(), "duplicate beneficiary" );
+      }
+
+      const uint32_t now = current_block_time().slot;
+
+      std::vector<std::pair<name, asset>> claims;
+      claims.reserve( beneficiaries.size() );
+      asset total_claimed( 0, PIEOS_SYMBOL );
+
+      for ( const auto& beneficiary : beneficiaries ) {
+         const vesting_schedule vs = get_vesting_schedule( beneficiary );
+         const int64_t vested = sco_math::scheduled_vested_amount( vs.total.amount, now, vs.start_time.slot, vs.cliff_time.slot, vs.end_time.slot );
+         const asset claimable( vested - get_claimed_vested_amount( beneficiary ), PIEOS_SYMBOL );
+         if ( claimable.amount <= 0 ) {
+            continue;
+         }
+
+         add_claimed_vested_amount( beneficiary, claimable );
+         claims.emplace_back( beneficiary, claimable );
+         total_claimed += claimable;
+      }
+
+      check( total_claimed.amount > 0, "no vested token to claim" );
+
+      // (inline actions) issue the claimed PIEOS tokens once, then transfer to each beneficiary
       token_issue_action token_issue_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-      token_issue_act.send(get_self(), amount, "issue vested PIEOS" );
+      token_issue_act.send(get_self(), total_claimed, "issue vested PIEOS" );
 
       token_transfer_action transfer_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-      transfer_act.send( get_self(), account, amount, "claim vested PIEOS" );
+      for ( const auto& [beneficiary, amount] : claims ) {
+         transfer_act.send( get_self(), beneficiary, amount, "claim vested PIEOS" );
+      }
    }
 
    // [[eosio::action]]
@@ -352,6 +629,66 @@ namespace pieos {
       require_auth( updater );
       eosio_system_updaterex_action updaterex_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
       updaterex_act.send( get_self() );
+
+      set_maintenance_task_run( MAINTENANCE_TASK_UPDATEREX );
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::setmaint( const name& task, const uint32_t interval_sec ) {
+      require_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
+      check( is_maintenance_task( task ), "unknown maintenance task" );
+
+      maintenance_tasks maintenance_db( get_self(), get_self().value );
+      auto mt_itr = maintenance_db.find( task.value );
+
+      if ( interval_sec == 0 ) {
+         check( mt_itr != maintenance_db.end(), "maintenance task not scheduled" );
+         maintenance_db.erase( mt_itr );
+      } else if ( mt_itr == maintenance_db.end() ) {
+         maintenance_db.emplace( get_self(), [&]( auto& mt ) {
+            mt.task = task;
+            mt.interval_sec = interval_sec;
+            mt.last_run = current_block_time();
+         });
+      } else {
+         maintenance_db.modify( mt_itr, same_payer, [&]( auto& mt ) {
+            mt.interval_sec = interval_sec;
+         });
+      }
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::setreserve( const symbol_code& pool_id, const uint32_t target_percent ) {
+      require_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
+      check( target_percent <= MAX_LIQUID_RESERVE_PERCENT, "target_percent out of range" );
+      check( has_campaign( pool_id ), "unknown pool" );
+
+      liquid_reserves reserves_db( get_self(), get_self().value );
+      auto lr_itr = reserves_db.find( pool_id.raw() );
+
+      if ( lr_itr == reserves_db.end() ) {
+         check( target_percent > 0, "liquid reserve not set" );
+         reserves_db.emplace( get_self(), [&]( auto& lr ) {
+            lr.pool_id = pool_id;
+            lr.target_percent = target_percent;
+            lr.balance = asset( 0, CORE_TOKEN_SYMBOL );
+         });
+      } else if ( target_percent == 0 && lr_itr->balance.amount == 0 ) {
+         reserves_db.erase( lr_itr );
+      } else {
+         // the reserve balance above a lowered target is paid out by the following unstakes
+         reserves_db.modify( lr_itr, same_payer, [&]( auto& lr ) {
+            lr.target_percent = target_percent;
+         });
+      }
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::gc( const uint32_t max_rows ) {
+      check( max_rows > 0 && max_rows <= GC_MAX_ROWS_PER_ACTION, "max_rows out of range" );
+
+      const auto outcome = collect_contract_paid_rows( max_rows );
+      check( outcome.rows_visited > 0, "no contract-paid stake account or deposit records" );
    }
 
    // [[eosio::action]]
@@ -365,6 +702,15 @@ namespace pieos {
       require_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
       eosio_system_sellram_action sellram_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
       sellram_act.send( get_self(), bytes );
+
+      // RAM freed by `gc` is reclaimed first
+      gc_state_table gc_state_db( get_self(), get_self().value );
+      auto gs_itr = gc_state_db.find( 0 );
+      if ( gs_itr != gc_state_db.end() && gs_itr->bytes_unsold > 0 ) {
+         gc_state_db.modify( gs_itr, same_payer, [&]( auto& gs ) {
+            gs.bytes_unsold = ( bytes >= gs.bytes_unsold ) ? 0 : gs.bytes_unsold - bytes;
+         });
+      }
    }
 
    // [[eosio::action]]
@@ -374,79 +720,105 @@ namespace pieos {
       voteproducer_act.send( get_self(), proxy, producers );
    }
 
+   // [[eosio::action]]
+   void pieos_sco::stakelog( const name& owner, const symbol_code& pool_id, const stake_balances& delta, const stake_balances& account, const stake_balances& pool ) {
+      require_auth( get_self() );
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::proxylog( const name& account, const symbol_code& pool_id, const proxy_vote_balances& delta, const proxy_vote_balances& balances, const proxy_vote_balances& pool ) {
+      require_auth( get_self() );
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::issuelog( const symbol_code& pool_id, const asset& issued, const asset& sco_token_unredeemed, const asset& last_total_issued ) {
+      require_auth( get_self() );
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::settlelog( const name& owner, const symbol_code& pool_id, const asset& core_token, const asset& contract_fee, const asset& sco_token ) {
+      require_auth( get_self() );
+   }
+
+   // [[eosio::action]]
+   void pieos_sco::balancelog( const name& owner, const asset& delta, const asset& balance ) {
+      require_auth( get_self() );
+   }
+
 
    /////////////////////////////////////////////////////////////////////////
 
    void pieos_sco::add_on_contract_token_balance( const name& owner, const asset& value, const name& ram_payer ) {
-      check( value.symbol == CORE_TOKEN_SYMBOL || value.symbol == PIEOS_SYMBOL, "not supported on-contract token symbol (add)" );
+      check( value.symbol == CORE_TOKEN_SYMBOL || value.symbol == get_campaign( value.symbol.code() ).total_dist.quantity.symbol, "not supported on-contract token symbol (add)" );
 
-      stake_accounts stake_accounts_db( get_self(), owner.value );
-      auto sa_itr = stake_accounts_db.find( PIEOS_SYMBOL.code().raw() );
+      deposits deposits_db( get_self(), owner.value );
+      auto dp_itr = deposits_db.find( value.symbol.code().raw() );
 
-      if ( sa_itr == stake_accounts_db.end() ) {
-         stake_accounts_db.emplace( ram_payer, [&]( auto& sa ){
-            if ( value.symbol == CORE_TOKEN_SYMBOL ) {
-               sa.core_token_bal = value;
-            } else {
-               sa.core_token_bal = asset( 0, CORE_TOKEN_SYMBOL );
-            }
-            if ( value.symbol == PIEOS_SYMBOL ) {
-               sa.sco_token_bal = value;
-            } else {
-               sa.sco_token_bal = asset( 0, PIEOS_SYMBOL );
-            }
-            sa.staked = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.staked_share = asset( 0, STAKED_SHARE_SYMBOL );
-            sa.proxy_vote = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.proxy_vote_share = asset( 0, PROXY_VOTE_SHARE_SYMBOL );
-            sa.token_share = asset( 0, TOKEN_SHARE_SYMBOL );
-            sa.last_stake_time = block_timestamp(0);
+      if ( dp_itr == deposits_db.end() ) {
+         dp_itr = deposits_db.emplace( ram_payer, [&]( auto& dp ){
+            dp.balance = value;
          });
+         if ( ram_payer == get_self() ) {
+            track_contract_paid_row( owner, DEPOSIT_TABLE, value.symbol.code().raw() );
+         }
       } else {
-         stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
-            if ( value.symbol == CORE_TOKEN_SYMBOL ) {
-               sa.core_token_bal.amount += value.amount;
-            }
-            if ( value.symbol == PIEOS_SYMBOL ) {
-               sa.sco_token_bal.amount += value.amount;
-            }
+         deposits_db.modify( dp_itr, same_payer, [&]( auto& dp ) {
+            dp.balance += value;
          });
       }
+
+      send_balance_receipt( owner, value, dp_itr->balance );
+   }
+
+   asset pieos_sco::sub_on_contract_token_balance( const name& owner, const asset& value ) {
+      // balances of earlier contract versions are moved to `deposits` before the first withdrawal or stake
+      migrate_on_contract_token_balances( owner, has_auth( owner ) ? owner : get_self() );
+
+      deposits deposits_db( get_self(), owner.value );
+      const auto& dp = deposits_db.get( value.symbol.code().raw(), "deposit record not found" );
+      check( dp.balance.symbol == value.symbol, "not supported on-contract token symbol (sub)" );
+      check( dp.balance.amount >= value.amount, ( value.symbol == CORE_TOKEN_SYMBOL ) ? "overdrawn core token balance" : "overdrawn sco token balance" );
+
+      deposits_db.modify( dp, same_payer, [&]( auto& d ) {
+         d.balance -= value;
+      });
+      send_balance_receipt( owner, -value, dp.balance );
+      return dp.balance;
    }
 
-   void pieos_sco::sub_on_contract_token_balance( const name& owner, const asset& value ) {
+   /**
+    * @brief moves the `core_token_bal` and `sco_token_bal` balances of the PIEOS SCO `stakeaccount` record of `owner`,
+    * kept there by earlier contract versions, to the `deposits` records of `owner`
+    *
+    * @return false if the record holds no such balance
+    */
+   bool pieos_sco::migrate_on_contract_token_balances( const name& owner, const name& ram_payer ) {
       stake_accounts stake_accounts_db( get_self(), owner.value );
-      const auto& sa = stake_accounts_db.get( PIEOS_SYMBOL.code().raw(), "stake account record not found while sub-token" );
-      if ( value.symbol == CORE_TOKEN_SYMBOL ) {
-         check( sa.core_token_bal.amount >= value.amount, "overdrawn core token balance" );
-         stake_accounts_db.modify( sa, same_payer, [&]( auto& a ) {
-            a.core_token_bal -= value;
-         });
-      } else if ( value.symbol == PIEOS_SYMBOL ) {
-         check( sa.sco_token_bal.amount >= value.amount, "overdrawn sco token balance" );
-         stake_accounts_db.modify( sa, same_payer, [&]( auto& a ) {
-            a.sco_token_bal -= value;
-         });
-      } else {
-         check( false, "not supported on-contract token symbol (sub)" );
+      auto sa_itr = stake_accounts_db.find( PIEOS_SYMBOL.code().raw() );
+      if ( sa_itr == stake_accounts_db.end() || ( sa_itr->core_token_bal.amount == 0 && sa_itr->sco_token_bal.amount == 0 ) ) {
+         return false;
       }
+
+      const asset core_token_bal = sa_itr->core_token_bal;
+      const asset sco_token_bal = sa_itr->sco_token_bal;
+      stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
+         sa.core_token_bal.amount = 0;
+         sa.sco_token_bal.amount = 0;
+      });
+
+      if ( core_token_bal.amount > 0 ) {
+         add_on_contract_token_balance( owner, core_token_bal, ram_payer );
+      }
+      if ( sco_token_bal.amount > 0 ) {
+         add_on_contract_token_balance( owner, sco_token_bal, ram_payer );
+      }
+      return true;
    }
 
 //   asset pieos_sco::get_on_contract_token_balance( const name& account, const symbol& symbol ) const {
-//      check( symbol == CORE_TOKEN_SYMBOL || symbol == PIEOS_SYMBOL, "not supported on-contract token symbol (get)" );
-//
-//      stake_accounts stake_accounts_db( get_self(), account.value );
-//      auto itr = stake_accounts_db.find( PIEOS_SYMBOL.code().raw() );
-//      if ( itr == stake_accounts_db.end() ) {
-//         return asset( 0, symbol );
-//      }
-//
-//      if ( symbol == CORE_TOKEN_SYMBOL ) {
-//         return itr->core_token_bal;
-//      } else {
-//         // symbol == PIEOS_SYMBOL
-//         return itr->sco_token_bal;
-//      }
+//      deposits deposits_db( get_self(), account.value );
+//      auto itr = deposits_db.find( symbol.code().raw() );
+//      return ( itr == deposits_db.end() ) ? asset( 0, symbol ) : itr->balance;
 //   }
 
    void pieos_sco::set_account_type( const name& account, const uint32_t account_type ) {
@@ -475,31 +847,511 @@ namespace pieos {
       if ( itr == account_type_db.end() ) {
          return account_type == ACCOUNT_TYPE_NORMAL_USER_ACCOUNT;
       }
-      return itr->acc_type == account_type;
-   }
+      return itr->acc_type == account_type;
+   }
+
+   void pieos_sco::check_staking_allowed_account( const name& account ) const {
+      check( is_account_type(account, ACCOUNT_TYPE_NORMAL_USER_ACCOUNT) && account != get_self(), "staking not allowed for this account" );
+   }
+
+   void pieos_sco::set_zero_balances( stake_account& sa, const symbol_code& pool_id ) {
+      sa.core_token_bal = asset( 0, CORE_TOKEN_SYMBOL );
+      sa.sco_token_bal = asset( 0, PIEOS_SYMBOL );
+      sa.staked = asset( 0, CORE_TOKEN_SYMBOL );
+      sa.staked_share = asset( 0, STAKED_SHARE_SYMBOL );
+      sa.proxy_vote = asset( 0, CORE_TOKEN_SYMBOL );
+      sa.proxy_vote_share = asset( 0, PROXY_VOTE_SHARE_SYMBOL );
+      sa.token_share = asset( 0, token_share_symbol( pool_id ) );
+      sa.last_stake_time = block_timestamp(0);
+      sa.pool_id.emplace( pool_id );
+   }
+
+   pieos_sco::campaign pieos_sco::get_campaign( const symbol_code& pool_id ) const {
+      if ( is_default_pool( pool_id ) ) {
+         // the PIEOS SCO campaign, its REX balance is computed by `get_pool_rex_balance`
+         return campaign { extended_asset( PIEOS_DIST_STAKE_COIN_OFFERING, extended_symbol( PIEOS_SYMBOL, PIEOS_TOKEN_CONTRACT ) ),
+                           block_timestamp( time_point_sec(SCO_START_TIMESTAMP) ), block_timestamp( time_point_sec(SCO_END_TIMESTAMP) ),
+                           PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT, asset( 0, REX_SYMBOL ), asset( 0, REX_SYMBOL ), time_point() };
+      }
+
+      campaigns campaigns_db( get_self(), get_self().value );
+      return campaigns_db.get( pool_id.raw(), "campaign not found" );
+   }
+
+   bool pieos_sco::has_campaign( const symbol_code& pool_id ) const {
+      if ( is_default_pool( pool_id ) ) {
+         return true;
+      }
+      campaigns campaigns_db( get_self(), get_self().value );
+      return campaigns_db.find( pool_id.raw() ) != campaigns_db.end();
+   }
+
+   // REX balance of a pool on the contract's single REX position
+   asset pieos_sco::get_pool_rex_balance( const campaign& cmp ) const {
+      if ( !is_default_pool( cmp.pool_id() ) ) {
+         return cmp.rex_balance;
+      }
+
+      // the contract's REX less the campaigns' REX, both held and queued for sale in the open sell order
+      const auto open_order = get_open_rex_order( get_self() );
+      asset rex_balance = get_rex_balance( get_self() );
+      int64_t campaigns_queued = 0;
+      campaigns campaigns_db( get_self(), get_self().value );
+      for ( const auto& c : campaigns_db ) {
+         rex_balance -= c.rex_balance;
+         campaigns_queued += get_pool_rex_queued( c, open_order.rex_requested, open_order.order_time );
+      }
+      rex_balance.amount -= campaigns_queued;
+
+      // the rest of the open sell order was queued by PIEOS pool unstakes, its REX is already redeemed by the unstaking accounts
+      const int64_t pieos_queued = open_order.rex_requested.amount - campaigns_queued;
+      if ( pieos_queued > 0 ) rex_balance.amount -= pieos_queued;
+      if ( rex_balance.amount < 0 ) rex_balance.amount = 0;
+      return rex_balance;
+   }
+
+   // REX of a campaign's unstakes still waiting in the contract's open sell order, zero once that order is filled
+   int64_t pieos_sco::get_pool_rex_queued( const campaign& cmp, const asset& open_order_rex, const time_point& open_order_time ) {
+      if ( open_order_rex.amount <= 0 || cmp.rex_queued_order_time != open_order_time ) {
+         return 0;
+      }
+      return cmp.rex_queued.amount;
+   }
+
+   void pieos_sco::add_pool_rex_queued( const symbol_code& pool_id, const int64_t rex_amount ) {
+      if ( is_default_pool( pool_id ) || rex_amount == 0 ) {
+         return;
+      }
+
+      // the sale joins the open sell order, or opens a new one at the current time (inline `sellrex` of this transaction)
+      const auto open_order = get_open_rex_order( get_self() );
+      const time_point order_time = open_order.rex_requested.amount > 0 ? open_order.order_time : current_time_point();
+
+      campaigns campaigns_db( get_self(), get_self().value );
+      auto c_itr = campaigns_db.require_find( pool_id.raw(), "campaign not found" );
+      campaigns_db.modify( c_itr, same_payer, [&]( auto& c ) {
+         c.rex_queued.amount = get_pool_rex_queued( c, open_order.rex_requested, open_order.order_time ) + rex_amount;
+         c.rex_queued_order_time = order_time;
+      });
+   }
+
+   void pieos_sco::add_pool_rex_balance( const symbol_code& pool_id, const int64_t rex_amount ) {
+      if ( is_default_pool( pool_id ) || rex_amount == 0 ) {
+         return;
+      }
+
+      campaigns campaigns_db( get_self(), get_self().value );
+      auto c_itr = campaigns_db.require_find( pool_id.raw(), "campaign not found" );
+      campaigns_db.modify( c_itr, same_payer, [&]( auto& c ) {
+         c.rex_balance.amount += rex_amount;
+         if ( c.rex_balance.amount < 0 ) c.rex_balance.amount = 0;
+      });
+   }
+
+   // liquid EOS reserve of a pool, zero if the pool has no reserve record
+   pieos_sco::liquid_reserve pieos_sco::get_liquid_reserve( const symbol_code& pool_id ) const {
+      liquid_reserves reserves_db( get_self(), get_self().value );
+      auto lr_itr = reserves_db.find( pool_id.raw() );
+      if ( lr_itr == reserves_db.end() ) {
+         return liquid_reserve{ pool_id, 0, asset( 0, CORE_TOKEN_SYMBOL ) };
+      }
+      return *lr_itr;
+   }
+
+   void pieos_sco::add_liquid_reserve_balance( const symbol_code& pool_id, const int64_t amount ) {
+      if ( amount == 0 ) {
+         return;
+      }
+      liquid_reserves reserves_db( get_self(), get_self().value );
+      auto lr_itr = reserves_db.require_find( pool_id.raw(), "liquid reserve not set" );
+      check( lr_itr->balance.amount + amount >= 0, "liquid reserve overdrawn" );
+      reserves_db.modify( lr_itr, same_payer, [&]( auto& lr ) {
+         lr.balance.amount += amount;
+      });
+   }
+
+   asset pieos_sco::get_total_core_token_amount_for_staked( const campaign& cmp, const stake_pool_global::const_iterator& sp_itr ) const {
+      asset rex_balance = get_pool_rex_balance( cmp );
+      asset total_rex_to_core_token_balance = ( rex_balance.amount > 0 ) ? rex_to_core_token_balance( rex_balance ) : asset( 0, CORE_TOKEN_SYMBOL );
+      asset total_core_token_balance_for_staked = total_rex_to_core_token_balance + sp_itr->core_token_for_staked + get_liquid_reserve( cmp.pool_id() ).balance;
+      return total_core_token_balance_for_staked;
+   }
+
+   void pieos_sco::require_auth_of_owner_or_admin_after_sco_period( const name& owner, const campaign& cmp ) {
+      block_timestamp current_block = current_block_time();
+      const block_timestamp sco_end_block = cmp.end_time;
+
+      if ( current_block.slot <= sco_end_block.slot ) {
+         require_auth(owner);
+      } else {
+         // after the end of SCO period, admin account can execute an action on behalf of the `owner` account
+         if ( !has_auth( owner ) ) {
+            check( has_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT ), "owner or admin account auth. required after the end of SCO period" );
+         }
+      }
+   }
+
+   /**
+    * @brief vesting schedule of `beneficiary` from the `vesting` table. The reserved fund accounts have built-in schedules
+    * until the admin sets one: marketing/operation fund unlocked at the SCO start, stability fund unlocked at the mid point
+    * of the SCO period, development team fund vesting linearly over the SCO period
+    */
+   pieos_sco::vesting_schedule pieos_sco::get_vesting_schedule( const name& beneficiary ) const {
+      vesting_schedules vesting_db( get_self(), get_self().value );
+      auto vs_itr = vesting_db.find( beneficiary.value );
+      if ( vs_itr != vesting_db.end() ) {
+         return *vs_itr;
+      }
+
+      const block_timestamp sco_start_block { time_point_sec(SCO_START_TIMESTAMP) };
+      const block_timestamp sco_end_block { time_point_sec(SCO_END_TIMESTAMP) };
+      const block_timestamp sco_mid_block { time_point_sec(SCO_START_TIMESTAMP + (SCO_END_TIMESTAMP - SCO_START_TIMESTAMP) / 2) };
+
+      if ( beneficiary == PIEOS_MARKETING_OPERATION_ACCOUNT ) {
+         return vesting_schedule { beneficiary, asset( PIEOS_DIST_MARKETING_OPERATION_FUND, PIEOS_SYMBOL ), sco_start_block, sco_start_block, sco_start_block };
+      } else if ( beneficiary == PIEOS_STABILITY_FUND_ACCOUNT ) {
+         return vesting_schedule { beneficiary, asset( PIEOS_DIST_STABILITY_FUND, PIEOS_SYMBOL ), sco_mid_block, sco_mid_block, sco_mid_block };
+      } else if ( beneficiary == PIEOS_DEVELOPMENT_TEAM_ACCOUNT ) {
+         return vesting_schedule { beneficiary, asset( PIEOS_DIST_DEVELOPMENT_TEAM, PIEOS_SYMBOL ), sco_start_block, sco_start_block, sco_end_block };
+      }
+      check( false, "not reserved vesting account" );
+      return vesting_schedule{};
+   }
+
+   int64_t pieos_sco::get_claimed_vested_amount( const name& beneficiary ) const {
+      reserved_vesting_accounts vesting_accounts_db( get_self(), beneficiary.value );
+      auto va_itr = vesting_accounts_db.find( PIEOS_SYMBOL.code().raw() );
+      return (va_itr == vesting_accounts_db.end())? 0 : va_itr->issued.amount;
+   }
+
+   void pieos_sco::add_claimed_vested_amount( const name& beneficiary, const asset& amount ) {
+      reserved_vesting_accounts vesting_accounts_db( get_self(), beneficiary.value );
+      auto va_itr = vesting_accounts_db.find( amount.symbol.code().raw() );
+      if ( va_itr == vesting_accounts_db.end() ) {
+         vesting_accounts_db.emplace( get_self(), [&]( auto& va ){
+            va.issued = amount;
+         });
+      } else {
+         vesting_accounts_db.modify( va_itr, same_payer, [&]( auto& va ) {
+            va.issued += amount;
+         });
+      }
+   }
+
+   bool pieos_sco::is_empty_stake_account( const stake_account& sa ) {
+      return sa.core_token_bal.amount == 0 && sa.sco_token_bal.amount == 0
+           && sa.staked.amount == 0
+           && sa.staked_share.amount == 0
+           && sa.proxy_vote.amount == 0 && sa.proxy_vote_share.amount == 0
+           && sa.token_share.amount == 0;
+   }
+
+   // registers a `stakeaccount` or `deposits` record created with the contract as RAM payer, so that `gc` can find it
+   void pieos_sco::track_contract_paid_row( const name& owner, const name& table, const uint64_t key ) {
+      contract_paid_rows paid_rows_db( get_self(), get_self().value );
+      paid_rows_db.emplace( get_self(), [&]( auto& pr ) {
+         pr.id = paid_rows_db.available_primary_key();
+         pr.owner = owner;
+         pr.table = table;
+         pr.key = key;
+      });
+   }
+
+   // drops the `paidrows` entries of `owner`, whose records are erased by `close`, so that a record created later is not taken for one paid by the contract
+   void pieos_sco::untrack_contract_paid_rows( const name& owner ) {
+      contract_paid_rows paid_rows_db( get_self(), get_self().value );
+      auto by_row_idx = paid_rows_db.get_index<"byrow"_n>();
+      for ( auto pr_itr = by_row_idx.lower_bound( static_cast<uint128_t>( owner.value ) << 64 ); pr_itr != by_row_idx.end() && pr_itr->owner == owner; ) {
+         pr_itr = by_row_idx.erase( pr_itr );
+      }
+   }
+
+   // registers an account holding PIEOS-token shares of the PIEOS SCO pool, so that `distribute` can find it
+   void pieos_sco::track_staker( const name& owner ) {
+      stakers stakers_db( get_self(), get_self().value );
+      if ( stakers_db.find( owner.value ) == stakers_db.end() ) {
+         stakers_db.emplace( get_self(), [&]( auto& st ) {
+            st.owner = owner;
+         });
+      }
+   }
+
+   /**
+    * @brief visits up to `max_rows` contract-paid `stakeaccount` and `deposits` records from the `gc` cursor,
+    * erases the records having all-zero balances and records the freed RAM bytes
+    *
+    * Records paid by their owner are not registered in `paidrows` and are left to `close`.
+    * A table is emptied here only by erasing contract-paid records (`close` erases all records of the scope),
+    * so its first record was paid by the contract and the table RAM is freed to the contract too.
+    *
+    * @param max_rows - maximum number of `paidrows` entries to visit
+    * @return gc_outcome
+    *   : rows_visited - number of `paidrows` entries visited
+    *   : rows_erased - number of `stakeaccount` and `deposits` records erased
+    *   : bytes_freed - RAM bytes freed
+    */
+   pieos_sco::gc_outcome pieos_sco::collect_contract_paid_rows( const uint32_t max_rows ) {
+      gc_outcome outcome { 0, 0, 0 };
+
+      contract_paid_rows paid_rows_db( get_self(), get_self().value );
+      if ( paid_rows_db.begin() == paid_rows_db.end() ) {
+         return outcome;
+      }
+
+      gc_state_table gc_state_db( get_self(), get_self().value );
+      auto gs_itr = gc_state_db.find( 0 );
+      if ( gs_itr == gc_state_db.end() ) {
+         gs_itr = gc_state_db.emplace( get_self(), [&]( auto& gs ) {
+            gs.cursor = 0;
+            gs.rows_erased = 0;
+            gs.bytes_freed = 0;
+            gs.bytes_unsold = 0;
+         });
+      }
+
+      auto pr_itr = paid_rows_db.lower_bound( gs_itr->cursor );
+      if ( pr_itr == paid_rows_db.end() ) {
+         pr_itr = paid_rows_db.begin();
+      }
+
+      while ( pr_itr != paid_rows_db.end() && outcome.rows_visited < max_rows ) {
+         ++outcome.rows_visited;
+
+         if ( pr_itr->table == STAKE_ACCOUNT_TABLE ) {
+            stake_accounts stake_accounts_db( get_self(), pr_itr->owner.value );
+            auto sa_itr = stake_accounts_db.find( pr_itr->key );
+            if ( sa_itr != stake_accounts_db.end() ) {
+               if ( !is_empty_stake_account( *sa_itr ) ) {
+                  ++pr_itr;
+                  continue;
+               }
+               stake_accounts_db.erase( sa_itr );
+               ++outcome.rows_erased;
+               outcome.bytes_freed += STAKE_ACCOUNT_ROW_RAM_BYTES;
+               if ( stake_accounts_db.begin() == stake_accounts_db.end() ) {
+                  outcome.bytes_freed += TABLE_RAM_BYTES;
+               }
+            }
+         } else {
+            deposits deposits_db( get_self(), pr_itr->owner.value );
+            auto dp_itr = deposits_db.find( pr_itr->key );
+            if ( dp_itr != deposits_db.end() ) {
+               if ( dp_itr->balance.amount != 0 ) {
+                  ++pr_itr;
+                  continue;
+               }
+               deposits_db.erase( dp_itr );
+               ++outcome.rows_erased;
+               outcome.bytes_freed += DEPOSIT_ROW_RAM_BYTES;
+               if ( deposits_db.begin() == deposits_db.end() ) {
+                  outcome.bytes_freed += TABLE_RAM_BYTES;
+               }
+            }
+         }
+
+         // the record is erased, an entry whose record is gone is dropped too
+         pr_itr = paid_rows_db.erase( pr_itr );
+         outcome.bytes_freed += CONTRACT_PAID_ROW_RAM_BYTES;
+      }
+
+      const uint64_t next_cursor = ( pr_itr == paid_rows_db.end() ) ? 0 : pr_itr->id;
+      gc_state_db.modify( gs_itr, same_payer, [&]( auto& gs ) {
+         gs.cursor = next_cursor;
+         gs.rows_erased += outcome.rows_erased;
+         gs.bytes_freed += outcome.bytes_freed;
+         gs.bytes_unsold += outcome.bytes_freed;
+      });
+
+      return outcome;
+   }
+
+   bool pieos_sco::is_maintenance_task( const name& task ) const {
+      return task == MAINTENANCE_TASK_UPDATEREX || task == MAINTENANCE_TASK_GC;
+   }
+
+   /**
+    * @brief runs the most overdue scheduled housekeeping tasks inline, at most `MAINTENANCE_TASKS_PER_ACTION` tasks,
+    * called at the end of user actions
+    */
+   void pieos_sco::run_scheduled_maintenance() {
+      maintenance_tasks maintenance_db( get_self(), get_self().value );
+      const block_timestamp now = current_block_time();
+
+      for ( uint32_t run = 0; run < MAINTENANCE_TASKS_PER_ACTION; ++run ) {
+         auto overdue_itr = maintenance_db.end();
+         uint64_t max_overdue_slots = 0;
+         for ( auto mt_itr = maintenance_db.begin(); mt_itr != maintenance_db.end(); ++mt_itr ) {
+            const uint64_t due_slot = uint64_t(mt_itr->last_run.slot) + uint64_t(mt_itr->interval_sec) * 2; // 2 block slots per second
+            if ( now.slot >= due_slot && ( overdue_itr == maintenance_db.end() || now.slot - due_slot > max_overdue_slots ) ) {
+               overdue_itr = mt_itr;
+               max_overdue_slots = now.slot - due_slot;
+            }
+         }
+
+         if ( overdue_itr == maintenance_db.end() ) {
+            return;
+         }
+
+         run_maintenance_task( overdue_itr->task );
+
+         maintenance_db.modify( overdue_itr, same_payer, [&]( auto& mt ) {
+            mt.last_run = now;
+         });
+      }
+   }
+
+   void pieos_sco::run_maintenance_task( const name& task ) {
+      if ( task == MAINTENANCE_TASK_UPDATEREX ) {
+         // system contract `updaterex` fails for an account without REX balance
+         if ( get_rex_balance( get_self() ).amount > 0 ) {
+            eosio_system_updaterex_action updaterex_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
+            updaterex_act.send( get_self() );
+         }
+      } else if ( task == MAINTENANCE_TASK_GC ) {
+         collect_contract_paid_rows( GC_ROWS_PER_MAINTENANCE_RUN );
+      }
+   }
+
+   // records a run of a scheduled task executed outside of the scheduler
+   void pieos_sco::set_maintenance_task_run( const name& task ) {
+      maintenance_tasks maintenance_db( get_self(), get_self().value );
+      auto mt_itr = maintenance_db.find( task.value );
+      if ( mt_itr != maintenance_db.end() ) {
+         maintenance_db.modify( mt_itr, same_payer, [&]( auto& mt ) {
+            mt.last_run = current_block_time();
+         });
+      }
+   }
+
+   /**
+    * @brief stakes the deposited EOS of `owner` on the pool of campaign `cmp`,
+    * the EOS is deposited to the contract's single REX position, less the refill of the pool's liquid reserve
+    *
+    * @param owner - staking account name
+    * @param amount - amount of EOS tokens to be staked
+    * @param cmp - campaign of the pool
+    * @param stake_pool_db - `stakepool` table of the pool
+    * @return staked EOS and received shares, returned by the `stake` and `stakecamp` actions
+    */
+   pieos_sco::stake_core_token_outcome pieos_sco::stake_in_pool( const name& owner, const asset& amount, const campaign& cmp, stake_pool_global& stake_pool_db ) {
+      check( amount.symbol == CORE_TOKEN_SYMBOL, "stake amount symbol precision mismatch" );
+      check( amount.amount >= 1'0000, "invalid stake amount" );
+      check( stake_pool_db.begin() != stake_pool_db.end(), "stake pool not initialized" );
+      check_staking_allowed_account( owner );
+
+      require_auth(owner);
+
+      // subtract user's on-contract EOS balance which is being deposited to EOS REX fund.
+      sub_on_contract_token_balance( owner, amount );
+
+      auto sp_itr = stake_pool_db.begin();
+      // issue SCO tokens accrued since last issuance time (send inline token issue action to the campaign token contract)
+      issue_accrued_SCO_token( cmp, stake_pool_db, sp_itr );
+
+      const auto stake_outcome = stake_core_token( owner, amount, cmp, stake_pool_db, sp_itr );
+
+      // refill the pool's liquid reserve from the staked EOS before the rest is deposited to REX
+      asset rex_purchase = amount;
+      const liquid_reserve reserve = get_liquid_reserve( cmp.pool_id() );
+      if ( reserve.target_percent > 0 ) {
+         const int64_t pool_value = get_total_core_token_amount_for_staked( cmp, sp_itr ).amount + amount.amount;
+         const int64_t reserve_refill = sco_math::liquid_reserve_refill( pool_value, reserve.target_percent, reserve.balance.amount, amount.amount );
+         add_liquid_reserve_balance( cmp.pool_id(), reserve_refill );
+         rex_purchase.amount -= reserve_refill;
+      }
+
+      if ( rex_purchase.amount > 0 ) {
+         // REX bought for a campaign pool is accounted to the campaign, at the REX price `buyrex` will be executed at
+         add_pool_rex_balance( cmp.pool_id(), core_token_to_rex_balance( rex_purchase, calc_rex_pool_lendable_change_amount() ).amount );
+
+         // (inline actions) deposit rex-fund and buy rex from system contract to earn rex staking profit
+         eosio_system_deposit_action deposit_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
+         deposit_act.send( get_self(), rex_purchase );
+
+         eosio_system_buyrex_action buyrex_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
+         buyrex_act.send( get_self(), rex_purchase );
+      }
+
+      return stake_outcome;
+   }
+
+   /**
+    * @brief unstakes EOS of `owner` from the pool of campaign `cmp`, and pays out the redeemed EOS and the earned campaign tokens
+    *
+    * @param owner - account unstaking its staked EOS fund
+    * @param amount - unstaking EOS balance
+    * @param cmp - campaign of the pool
+    * @param stake_pool_db - `stakepool` table of the pool
+    * @return unstake outcome, returned by the `unstake` and `unstakecamp` actions
+    */
+   pieos_sco::unstake_core_token_outcome pieos_sco::unstake_from_pool( const name& owner, const asset& amount, const campaign& cmp, stake_pool_global& stake_pool_db ) {
+      check( amount.symbol == CORE_TOKEN_SYMBOL, "unstake amount symbol precision mismatch" );
+      check( amount.amount > 0, "invalid unstake amount" );
+      check( stake_pool_db.begin() != stake_pool_db.end(), "stake pool not initialized");
+      check_staking_allowed_account( owner );
+
+      // before the end od SCO period, owner account auth is required,
+      // after end of SCO period, admin account can execute `unstake` on behalf of the stake `owner` account
+      require_auth_of_owner_or_admin_after_sco_period( owner, cmp );
+
+      auto sp_itr = stake_pool_db.begin();
+
+      // issue SCO tokens accrued since last issuance time (send inline token issue action to the campaign token contract)
+      issue_accrued_SCO_token( cmp, stake_pool_db, sp_itr );
+
+      const int64_t unstake_amount = amount.amount;
+      auto unstake_outcome = unstake_core_token( owner, unstake_amount, cmp, stake_pool_db, sp_itr );
+
+      if (unstake_outcome.rex_to_sell.amount > 0) {
+         add_pool_rex_balance( cmp.pool_id(), -unstake_outcome.rex_to_sell.amount );
+         if ( unstake_outcome.settlement == UNSTAKE_SETTLEMENT_QUEUED ) {
+            add_pool_rex_queued( cmp.pool_id(), unstake_outcome.rex_to_sell.amount );
+         }
+
+         // (inline action) sell rex to receive EOS, a queued order is filled later into the contract's REX fund
+         eosio_system_sellrex_action sellrex_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
+         sellrex_act.send( get_self(), unstake_outcome.rex_to_sell );
+
+         if ( unstake_outcome.settlement == UNSTAKE_SETTLEMENT_SELLREX ) {
+            // (inline action) withdraw EOS from rexfund of eosio system contract
+            eosio_system_withdraw_action withdraw_act{ EOSIO_SYSTEM_CONTRACT, { { get_self(), "active"_n } } };
+            withdraw_act.send( get_self(), unstake_outcome.rex_sold_core_token );
+         }
+      }
 
-   void pieos_sco::check_staking_allowed_account( const name& account ) const {
-      check( is_account_type(account, ACCOUNT_TYPE_NORMAL_USER_ACCOUNT) && account != get_self(), "staking not allowed for this account" );
-   }
+      if ( unstake_outcome.token_earned.amount > 0 ) {
+         // transfer received SCO token ownership from contract to user
+         transfer_sco_token( owner, unstake_outcome.token_earned, cmp, owner );
+      }
 
-   asset pieos_sco::get_total_core_token_amount_for_staked( const stake_pool_global::const_iterator& sp_itr ) const {
-      asset total_rex_to_core_token_balance = get_total_rex_to_core_token_balance(get_self() );
-      asset total_core_token_balance_for_staked = total_rex_to_core_token_balance + sp_itr->core_token_for_staked;
-      return total_core_token_balance_for_staked;
-   }
+      // redeemed EOS fund (original staked EOS + staking profits)
+      asset redeemed_to_unstaker = unstake_outcome.staked_and_profit_redeemed;
+      asset contract_fee( 0, CORE_TOKEN_SYMBOL );
 
-   void pieos_sco::require_auth_of_owner_or_admin_after_sco_period( const name& owner ) {
-      block_timestamp current_block = current_block_time();
-      const block_timestamp sco_end_block { time_point_sec(SCO_END_TIMESTAMP) };
+      if ( unstake_outcome.staked_and_profit_redeemed.amount > 0 ) {
+         const int64_t eos_staking_profit = unstake_outcome.staked_and_profit_redeemed.amount - unstake_amount;
+         if ( eos_staking_profit > 0 ) {
+            contract_fee.amount = sco_math::contract_profit_share( eos_staking_profit );
+            if ( contract_fee.amount > 0 ) {
+               redeemed_to_unstaker -= contract_fee;
+               add_on_contract_token_balance( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, contract_fee, get_self() );
+            }
+         }
 
-      if ( current_block.slot <= sco_end_block.slot ) {
-         require_auth(owner);
-      } else {
-         // after the end of SCO period, admin account can execute an action on behalf of the `owner` account
-         if ( !has_auth( owner ) ) {
-            check( has_auth( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT ), "owner or admin account auth. required after the end of SCO period" );
+         if ( redeemed_to_unstaker.amount > 0 ) {
+            if ( unstake_outcome.settlement == UNSTAKE_SETTLEMENT_QUEUED ) {
+               // add user's on-contract EOS balance for withdrawal after the REX sell order is filled
+               add_on_contract_token_balance( owner, redeemed_to_unstaker, owner );
+            } else {
+               token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
+               transfer_act.send( get_self(), owner, redeemed_to_unstaker, "PIEOS SCO - UNSTAKE" );
+            }
          }
       }
+
+      send_settlement_receipt( owner, cmp, redeemed_to_unstaker, contract_fee, unstake_outcome.token_earned );
+
+      return unstake_outcome;
    }
 
    /**
@@ -507,15 +1359,11 @@ namespace pieos {
     *
     * @param owner - staking account name
     * @param stake - amount of EOS tokens staked
+    * @param cmp - campaign of the pool
+    * @return staked EOS, received EOS-share(SEOS) and token share amounts
     */
-   void pieos_sco::stake_core_token( const name& owner, const asset& stake, const stake_pool_global::const_iterator& sp_itr ) {
-      /**
-       * The maximum supply of core token (EOS,4) is 10^10 tokens (10 billion tokens), i.e., maximum amount
-       * of indivisible units is 10^14. share_ratio = 10^4 sets the upper bound on (SEOS,4) indivisible units to
-       * 10^18 and that is within the maximum allowable amount field of asset type which is set to 2^62
-       * (approximately 4.6 * 10^18)
-       */
-      const int64_t share_ratio = 10000;
+   pieos_sco::stake_core_token_outcome pieos_sco::stake_core_token( const name& owner, const asset& stake, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
+      const int64_t share_ratio = sco_math::SHARE_RATIO;
 
       int64_t received_staked_share_amount = 0; // amount of received SEOS share tokens
       int64_t received_token_share_amount = 0; // amount of received SPIEOS share tokens
@@ -529,12 +1377,12 @@ namespace pieos {
          received_staked_share_amount = share_ratio * stake.amount;
          total_staked_share_amount = received_staked_share_amount;
       } else {
-         asset total_core_token_balance_for_staked = get_total_core_token_amount_for_staked( sp_itr );
+         asset total_core_token_balance_for_staked = get_total_core_token_amount_for_staked( cmp, sp_itr );
 
          const int64_t E0 = total_core_token_balance_for_staked.amount;
          const int64_t E1 = E0 + stake.amount;
          const int64_t SS0 = total_staked_share_amount;
-         const int64_t SS1 = (uint128_t(E1) * SS0) / E0;
+         const int64_t SS1 = sco_math::mul_div( E1, SS0, E0 );
 
          received_staked_share_amount = SS1 - SS0;
          total_staked_share_amount = SS1;
@@ -544,11 +1392,11 @@ namespace pieos {
          received_token_share_amount = stake.amount * share_ratio;
          total_token_share_amount = received_token_share_amount;
       } else {
-         const int64_t total_weighted_staking_amount = total_staked_amount + (total_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000);
-         const int64_t EP0 = (total_weighted_staking_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT) + sp_itr->sco_token_unredeemed.amount; // weighted EOS amount + PIEOS amount
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount, cmp.proxy_vote_weight_percent );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp_itr->sco_token_unredeemed.amount ); // weighted EOS amount + PIEOS amount
          const int64_t EP1 = EP0 + (stake.amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT);
          const int64_t TS0 = total_token_share_amount;
-         const int64_t TS1 = (uint128_t(EP1) * TS0) / EP0;
+         const int64_t TS1 = sco_math::mul_div( EP1, TS0, EP0 );
 
          received_token_share_amount = TS1 - TS0;
          total_token_share_amount = TS1;
@@ -556,7 +1404,7 @@ namespace pieos {
 
       total_staked_amount += stake.amount;
 
-      _stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
          sp.total_staked.amount       = total_staked_amount;
          sp.total_staked_share.amount = total_staked_share_amount;
          sp.total_token_share.amount  = total_token_share_amount;
@@ -565,13 +1413,96 @@ namespace pieos {
       const block_timestamp now = current_block_time();
 
       stake_accounts stake_accounts_db( get_self(), owner.value );
-      auto sa_itr = stake_accounts_db.require_find( PIEOS_SYMBOL.code().raw(), "stake account record not found (add to stake balance)" );
+      auto sa_itr = stake_accounts_db.find( cmp.pool_id().raw() );
+      if ( sa_itr == stake_accounts_db.end() ) {
+         // the position record of a pool is opened on the first stake, the deposited EOS is kept on the `deposits` record
+         sa_itr = stake_accounts_db.emplace( owner, [&]( auto& sa ){
+            set_zero_balances( sa, cmp.pool_id() );
+         });
+      }
+      open_stake_lot_ledger( owner, *sa_itr, owner );
       stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
          sa.staked.amount += stake.amount;
          sa.staked_share.amount += received_staked_share_amount;
          sa.token_share.amount += received_token_share_amount;
          sa.last_stake_time = now;
       });
+
+      add_stake_lot( owner, cmp.pool_id(), stake.amount, now );
+      if ( is_default_pool( cmp.pool_id() ) ) {
+         track_staker( owner );
+      }
+
+      const stake_core_token_outcome outcome{ stake, asset( received_staked_share_amount, STAKED_SHARE_SYMBOL ),
+                                              asset( received_token_share_amount, token_share_symbol( cmp.pool_id() ) ) };
+      send_stake_receipt( owner, cmp.pool_id(), stake_balances{ outcome.staked, outcome.staked_share, outcome.token_share }, *sa_itr, *sp_itr );
+
+      return outcome;
+   }
+
+   void pieos_sco::add_stake_lot( const name& owner, const symbol_code& pool_id, const int64_t amount, const block_timestamp& stake_time ) {
+      const uint32_t stake_time_sec = stake_time.to_time_point().sec_since_epoch();
+
+      stake_lot_ledgers ledgers_db( get_self(), owner.value );
+      auto ledger_itr = ledgers_db.find( pool_id.raw() );
+      if ( ledger_itr == ledgers_db.end() ) {
+         ledgers_db.emplace( owner, [&]( auto& l ) {
+            l.pool_id = pool_id;
+            sco_math::add_stake_lot( l.lots, sco_math::rex_maturity_sec( stake_time_sec ), amount );
+         });
+      } else {
+         ledgers_db.modify( ledger_itr, same_payer, [&]( auto& l ) {
+            sco_math::prune_matured_stake_lots( l.lots, stake_time_sec );
+            sco_math::add_stake_lot( l.lots, sco_math::rex_maturity_sec( stake_time_sec ), amount );
+         });
+      }
+   }
+
+   /**
+    * @brief opens the lot ledger of `sa` staked before the ledger existed, with its whole stake as one lot maturing with
+    * `last_stake_time`, so that the stake stays unmatured when another lot or a matured stake is added to the account
+    */
+   void pieos_sco::open_stake_lot_ledger( const name& owner, const stake_account& sa, const name& ram_payer ) {
+      if ( sa.staked.amount <= 0 ) {
+         return;
+      }
+      const time_point_sec maturity = get_rex_maturity( sa.last_stake_time );
+      if ( time_point_sec( current_time_point() ) > maturity ) {
+         return;
+      }
+
+      stake_lot_ledgers ledgers_db( get_self(), owner.value );
+      if ( ledgers_db.find( sa.pool().raw() ) != ledgers_db.end() ) {
+         return;
+      }
+      ledgers_db.emplace( ram_payer, [&]( auto& l ) {
+         l.pool_id = sa.pool();
+         sco_math::add_stake_lot( l.lots, maturity.sec_since_epoch(), sa.staked.amount );
+      });
+   }
+
+   /**
+    * @brief staked EOS of `sa` whose REX is matured at `now`, the stake minus the unmatured lots of the account's lot ledger.
+    * Matured lots are dropped from the ledger.
+    */
+   int64_t pieos_sco::get_matured_stake( const name& owner, const stake_account& sa, const time_point_sec& now ) {
+      stake_lot_ledgers ledgers_db( get_self(), owner.value );
+      auto ledger_itr = ledgers_db.find( sa.pool().raw() );
+      if ( ledger_itr == ledgers_db.end() ) {
+         // stakes made before the lot ledger mature all together with the last stake
+         return now > get_rex_maturity( sa.last_stake_time ) ? sa.staked.amount : 0;
+      }
+
+      auto lots = ledger_itr->lots;
+      const int64_t unmatured = sco_math::prune_matured_stake_lots( lots, now.sec_since_epoch() );
+      if ( lots.empty() ) {
+         ledgers_db.erase( ledger_itr );
+      } else if ( lots.size() != ledger_itr->lots.size() ) {
+         ledgers_db.modify( ledger_itr, same_payer, [&]( auto& l ) {
+            l.lots = lots;
+         });
+      }
+      return std::max<int64_t>( sa.staked.amount - unmatured, 0 );
    }
 
    /**
@@ -587,12 +1518,15 @@ namespace pieos {
     *   : token_earned - symbol:(PIEOS,4) - received PIEOS token balance
     *   : rex_to_sell - symbol:(REX,4) - REX amount to sell
     *   : rex_sold_core_token - symbol:(EOS,4) - core token proceeds from the REX to be sold
+    *   : settlement - `liquid`, `sellrex` or `queued` settlement of the redeemed EOS
+    *   : reserve_refill - symbol:(EOS,4) - proceeds of the REX sold to refill the pool's liquid reserve
+    *   : settlement_time - expected time the redeemed EOS is payable
     *
     * @pre unstake_amount must be equal or less than the owner's staked amount(EOS)
     */
-   pieos_sco::unstake_core_token_outcome pieos_sco::unstake_core_token( const name& owner, const int64_t unstake_amount, const stake_pool_global::const_iterator& sp_itr ) {
+   pieos_sco::unstake_core_token_outcome pieos_sco::unstake_core_token( const name& owner, const int64_t unstake_amount, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
       stake_accounts stake_accounts_db( get_self(), owner.value );
-      auto sa_itr = stake_accounts_db.require_find( PIEOS_SYMBOL.code().raw(), "stake account record not found (unstake from stake pool)" );
+      auto sa_itr = stake_accounts_db.require_find( cmp.pool_id().raw(), "stake account record not found (unstake from stake pool)" );
 
       int64_t stake_account_staked_amount = sa_itr->staked.amount;
       int64_t stake_account_staked_share_amount = sa_itr->staked_share.amount;
@@ -601,55 +1535,96 @@ namespace pieos {
 
       check( unstake_amount <= stake_account_staked_amount, "not enough staked balance" );
 
+      // only the stake lots whose REX is matured can be unstaked, a newer stake does not lock the older ones
       time_point_sec ct_sec(current_time_point());
-      time_point_sec rex_maturity_last_buyrex = get_rex_maturity( sa_itr->last_stake_time );
-
-      check( ct_sec > rex_maturity_last_buyrex, "cannot run unstake until rex maturity time" );
+      check( unstake_amount <= get_matured_stake( owner, *sa_itr, ct_sec ), "cannot run unstake until rex maturity time" );
 
       int64_t total_staked_amount = sp_itr->total_staked.amount;
       int64_t total_proxy_vote_amount = sp_itr->total_proxy_vote.amount;
       int64_t total_staked_share_amount = sp_itr->total_staked_share.amount;
       int64_t total_token_share_amount = sp_itr->total_token_share.amount;
 
-      const int64_t staked_share_to_redeem = (uint128_t(unstake_amount) * stake_account_staked_share_amount) / stake_account_staked_amount;
-      const int64_t token_share_to_redeem = (uint128_t(unstake_amount) * stake_account_token_share_amount) / (stake_account_staked_amount + (stake_account_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000));
+      const int64_t staked_share_to_redeem = sco_math::mul_div( unstake_amount, stake_account_staked_share_amount, stake_account_staked_amount );
+      const int64_t token_share_to_redeem = sco_math::mul_div( unstake_amount, stake_account_token_share_amount, sco_math::weighted_staking_amount( stake_account_staked_amount, stake_account_proxy_vote_amount, cmp.proxy_vote_weight_percent ) );
 
-      unstake_core_token_outcome outcome { asset( 0, CORE_TOKEN_SYMBOL ), asset ( 0, PIEOS_SYMBOL ), asset( 0, REX_SYMBOL ), asset( 0, CORE_TOKEN_SYMBOL ) };
+      unstake_core_token_outcome outcome { asset( 0, CORE_TOKEN_SYMBOL ), asset ( 0, cmp.total_dist.quantity.symbol ), asset( 0, REX_SYMBOL ), asset( 0, CORE_TOKEN_SYMBOL ),
+                                           UNSTAKE_SETTLEMENT_LIQUID, asset( 0, CORE_TOKEN_SYMBOL ), ct_sec };
 
       int64_t eos_proceeds_excluding_rex_selling = 0;
+      int64_t reserve_balance_change = 0;
 
       if ( staked_share_to_redeem > 0 ) {
-         asset rex_balance = get_rex_balance( get_self() );
+         const liquid_reserve reserve = get_liquid_reserve( cmp.pool_id() );
+         asset rex_balance = get_pool_rex_balance( cmp );
          const int64_t rex_pool_lendable_change_amount = calc_rex_pool_lendable_change_amount();
          asset rex_core_token_balance = rex_to_core_token_balance( rex_balance, rex_pool_lendable_change_amount );
-         asset total_core_token_balance_for_staked = rex_core_token_balance + sp_itr->core_token_for_staked;
+         asset total_core_token_balance_for_staked = rex_core_token_balance + sp_itr->core_token_for_staked + reserve.balance;
 
          const int64_t E0 = total_core_token_balance_for_staked.amount;
          const int64_t SS0 = total_staked_share_amount;
-         const int64_t eos_proceeds  = (uint128_t(staked_share_to_redeem) * E0) / SS0;
+         const int64_t eos_proceeds  = sco_math::mul_div( staked_share_to_redeem, E0, SS0 );
          const int64_t SS1 = SS0 - staked_share_to_redeem;
          //const int64_t E1 = E0 - eos_proceeds;
 
          outcome.staked_and_profit_redeemed.amount = eos_proceeds;
 
-         const int64_t rex_amount_to_sell = (uint128_t(staked_share_to_redeem) * rex_balance.amount) / total_staked_share_amount;
-         outcome.rex_to_sell.amount = rex_amount_to_sell;
+         const int64_t rex_amount_to_sell = sco_math::mul_div( staked_share_to_redeem, rex_balance.amount, total_staked_share_amount );
+         const int64_t rex_sold_core_token_amount = rex_to_core_token_balance( asset( rex_amount_to_sell, REX_SYMBOL ), rex_pool_lendable_change_amount ).amount;
 
-         int64_t rex_sold_core_token_amount = rex_to_core_token_balance( outcome.rex_to_sell, rex_pool_lendable_change_amount ).amount;
-         outcome.rex_sold_core_token.amount = rex_sold_core_token_amount;
-         eos_proceeds_excluding_rex_selling = eos_proceeds - rex_sold_core_token_amount;
+         // settle from the pool's liquid EOS, by an immediately filled REX sale, or by a queued REX sell order
+         const int64_t liquid_core_token_amount = sp_itr->core_token_for_staked.amount + reserve.balance.amount;
+         const int64_t rex_available_unlent = get_rex_available_unlent( rex_pool_lendable_change_amount );
+         const bool has_open_rex_order = get_open_rex_order_amount( get_self() ).amount > 0;
+         const auto settlement = sco_math::plan_unstake_settlement( eos_proceeds, liquid_core_token_amount, rex_sold_core_token_amount,
+                                                                    rex_available_unlent, has_open_rex_order );
+
+         if ( settlement == sco_math::unstake_settlement::liquid ) {
+            // the liquid reserve pays first, the BP voting rewards the rest
+            reserve_balance_change = -std::min( eos_proceeds, reserve.balance.amount );
+            eos_proceeds_excluding_rex_selling = eos_proceeds + reserve_balance_change;
+         } else {
+            outcome.rex_to_sell.amount = rex_amount_to_sell;
+            outcome.rex_sold_core_token.amount = rex_sold_core_token_amount;
+
+            // the liquid part of the redemption is paid from the BP voting rewards first, keeping the liquid reserve for small unstakes
+            const int64_t liquid_part = eos_proceeds - rex_sold_core_token_amount;
+            eos_proceeds_excluding_rex_selling = std::min( liquid_part, sp_itr->core_token_for_staked.amount );
+            reserve_balance_change = -std::min( liquid_part - eos_proceeds_excluding_rex_selling, reserve.balance.amount );
+
+            if ( settlement == sco_math::unstake_settlement::sellrex ) {
+               outcome.settlement = UNSTAKE_SETTLEMENT_SELLREX;
+
+               // refill the liquid reserve with the same REX sale, as far as the REX pool can fill it
+               const int64_t reserve_refill = sco_math::liquid_reserve_refill( E0 - eos_proceeds, reserve.target_percent, reserve.balance.amount + reserve_balance_change,
+                                                                               std::min( rex_available_unlent - rex_sold_core_token_amount, rex_core_token_balance.amount - rex_sold_core_token_amount ) );
+               if ( reserve_refill > 0 ) {
+                  const int64_t refill_rex = std::min( core_token_to_rex_balance( asset( reserve_refill, CORE_TOKEN_SYMBOL ), rex_pool_lendable_change_amount ).amount,
+                                                       rex_balance.amount - rex_amount_to_sell );
+                  const int64_t refill_core_token = rex_to_core_token_balance( asset( refill_rex, REX_SYMBOL ), rex_pool_lendable_change_amount ).amount;
+                  if ( refill_core_token > 0 ) {
+                     outcome.rex_to_sell.amount += refill_rex;
+                     outcome.rex_sold_core_token.amount += refill_core_token;
+                     outcome.reserve_refill.amount = refill_core_token;
+                     reserve_balance_change += refill_core_token;
+                  }
+               }
+            } else {
+               outcome.settlement = UNSTAKE_SETTLEMENT_QUEUED;
+               outcome.settlement_time = estimate_rex_order_fill_time( rex_sold_core_token_amount, rex_pool_lendable_change_amount );
+            }
+         }
 
          stake_account_staked_share_amount -= staked_share_to_redeem;
          total_staked_share_amount = SS1;
       }
 
       if ( token_share_to_redeem > 0 ) {
-         const int64_t total_weighted_staking_amount = total_staked_amount + (total_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000);
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount, cmp.proxy_vote_weight_percent );
          const int64_t total_unredeemed_sco_token_amount = sp_itr->sco_token_unredeemed.amount;
 
-         const int64_t EP0 = (total_weighted_staking_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT) + total_unredeemed_sco_token_amount; // weighted EOS amount + PIEOS amount
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, total_unredeemed_sco_token_amount ); // weighted EOS amount + PIEOS amount
          const int64_t TS0 = total_token_share_amount;
-         const int64_t p  = (uint128_t(token_share_to_redeem) * EP0) / TS0;
+         const int64_t p  = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
          const int64_t redeemed_token_amount  = p - (unstake_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT); // newly issued tokens since staked
          const int64_t TS1 = TS0 - token_share_to_redeem;
          //const int64_t EP1 = EP0 - p;
@@ -663,7 +1638,7 @@ namespace pieos {
       stake_account_staked_amount -= unstake_amount;
       total_staked_amount -= unstake_amount;
 
-      _stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
          sp.total_staked.amount           = total_staked_amount;
          sp.total_staked_share.amount     = total_staked_share_amount;
          sp.core_token_for_staked.amount -= eos_proceeds_excluding_rex_selling;
@@ -673,12 +1648,196 @@ namespace pieos {
          if( sp.sco_token_unredeemed.amount < 0 ) sp.sco_token_unredeemed.amount = 0;
       });
 
+      add_liquid_reserve_balance( cmp.pool_id(), reserve_balance_change );
+
       stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
          sa.staked.amount        = stake_account_staked_amount;
          sa.staked_share.amount  = stake_account_staked_share_amount;
          sa.token_share.amount   = stake_account_token_share_amount;
       });
 
+      send_stake_receipt( owner, cmp.pool_id(), stake_balances{ asset( -unstake_amount, CORE_TOKEN_SYMBOL ),
+                                                                asset( -staked_share_to_redeem, STAKED_SHARE_SYMBOL ),
+                                                                asset( -token_share_to_redeem, token_share_symbol( cmp.pool_id() ) ) },
+                          *sa_itr, *sp_itr );
+
+      return outcome;
+   }
+
+   /**
+    * @brief processes compounding of EOS staking profits.
+    * The EOS value of the owner's staked shares above the owner's staked EOS amount is the staking profit.
+    * The contract admin's profit share is redeemed from the staked shares and paid from the on-contract BP voting rewards,
+    * or, when those rewards do not cover it, it is staked for the contract admin with its staked shares, which stay in REX.
+    * The rest of the profit is added to the staked EOS amount and the corresponding token shares(SPIEOS) are issued.
+    * The contract admin's own profit is compounded whole. The contract's REX balance is left unchanged.
+    *
+    * @param owner - account compounding its staking profits
+    * @return compound_outcome
+    *   : staking_profit - symbol:(EOS,4) - EOS staking profits above the staked EOS amount
+    *   : contract_profit - symbol:(EOS,4) - contract admin's share of the staking profits
+    *   : compounded - symbol:(EOS,4) - EOS amount added to the staked EOS balance
+    */
+   pieos_sco::compound_core_token_outcome pieos_sco::compound_core_token( const name& owner, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
+      stake_accounts stake_accounts_db( get_self(), owner.value );
+      auto sa_itr = stake_accounts_db.require_find( cmp.pool_id().raw(), "stake account record not found (compound)" );
+
+      compound_core_token_outcome outcome { asset( 0, CORE_TOKEN_SYMBOL ), asset( 0, CORE_TOKEN_SYMBOL ), asset( 0, CORE_TOKEN_SYMBOL ) };
+
+      const int64_t stake_account_staked_share_amount = sa_itr->staked_share.amount;
+      if ( stake_account_staked_share_amount <= 0 ) {
+         return outcome;
+      }
+
+      int64_t total_staked_amount = sp_itr->total_staked.amount;
+      const int64_t total_proxy_vote_amount = sp_itr->total_proxy_vote.amount;
+      int64_t total_staked_share_amount = sp_itr->total_staked_share.amount;
+      int64_t total_token_share_amount = sp_itr->total_token_share.amount;
+
+      asset total_core_token_balance_for_staked = get_total_core_token_amount_for_staked( cmp, sp_itr );
+
+      const int64_t E0 = total_core_token_balance_for_staked.amount;
+      const int64_t SS0 = total_staked_share_amount;
+      const int64_t stake_account_core_token_amount = sco_math::mul_div( stake_account_staked_share_amount, E0, SS0 );
+      const int64_t staking_profit = stake_account_core_token_amount - sa_itr->staked.amount;
+      if ( staking_profit <= 0 ) {
+         return outcome;
+      }
+
+      const int64_t contract_profit = ( owner == PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT ) ? 0 : sco_math::contract_profit_share( staking_profit );
+      // staked shares of the contract profit share (rounded up in favor of the stake pool)
+      const int64_t contract_staked_share = ( contract_profit > 0 ) ? sco_math::mul_div( contract_profit, SS0, E0 ) + 1 : 0;
+      // redeemed and paid from the on-contract BP voting rewards if they cover it, otherwise staked for the contract admin
+      const bool contract_profit_paid = contract_profit <= sp_itr->core_token_for_staked.amount;
+      const int64_t staked_share_to_redeem = contract_profit_paid ? contract_staked_share : 0;
+      const int64_t contract_staked_amount = contract_profit_paid ? 0 : contract_profit;
+      const int64_t compounded_amount = staking_profit - contract_profit;
+
+      outcome.staking_profit.amount = staking_profit;
+      outcome.contract_profit.amount = contract_profit;
+      outcome.compounded.amount = compounded_amount;
+
+      int64_t received_token_share_amount = 0;
+      int64_t contract_token_share_amount = 0;
+      if ( compounded_amount + contract_staked_amount > 0 ) {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount, cmp.proxy_vote_weight_percent );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp_itr->sco_token_unredeemed.amount ); // weighted EOS amount + PIEOS amount
+         const int64_t EP1 = EP0 + ((compounded_amount + contract_staked_amount) * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT);
+         const int64_t TS0 = total_token_share_amount;
+         const int64_t TS1 = sco_math::mul_div( EP1, TS0, EP0 );
+
+         received_token_share_amount = sco_math::mul_div( TS1 - TS0, compounded_amount, compounded_amount + contract_staked_amount );
+         contract_token_share_amount = TS1 - TS0 - received_token_share_amount;
+         total_token_share_amount = TS1;
+      }
+
+      total_staked_amount += compounded_amount + contract_staked_amount;
+      total_staked_share_amount -= staked_share_to_redeem;
+
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+         sp.total_staked.amount           = total_staked_amount;
+         sp.total_staked_share.amount     = total_staked_share_amount;
+         if ( contract_profit_paid ) {
+            sp.core_token_for_staked.amount -= contract_profit;
+         }
+         sp.total_token_share.amount      = total_token_share_amount;
+      });
+
+      stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
+         sa.staked.amount       += compounded_amount;
+         sa.staked_share.amount -= contract_staked_share;
+         sa.token_share.amount  += received_token_share_amount;
+      });
+
+      send_stake_receipt( owner, cmp.pool_id(), stake_balances{ outcome.compounded, asset( -contract_staked_share, STAKED_SHARE_SYMBOL ),
+                                                                asset( received_token_share_amount, token_share_symbol( cmp.pool_id() ) ) },
+                          *sa_itr, *sp_itr );
+
+      if ( contract_profit_paid && contract_profit > 0 ) {
+         // contract admin's profit share is paid from the on-contract BP voting reward balance (already liquid EOS)
+         add_on_contract_token_balance( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, outcome.contract_profit, get_self() );
+      } else if ( contract_staked_amount > 0 ) {
+         // the contract profit share's staked shares stay in REX as a matured stake of the contract admin
+         stake_accounts admin_accounts_db( get_self(), PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT.value );
+         auto admin_itr = admin_accounts_db.find( cmp.pool_id().raw() );
+         if ( admin_itr == admin_accounts_db.end() ) {
+            admin_itr = admin_accounts_db.emplace( get_self(), [&]( auto& sa ){
+               set_zero_balances( sa, cmp.pool_id() );
+            });
+            track_contract_paid_row( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, STAKE_ACCOUNT_TABLE, cmp.pool_id().raw() );
+         }
+         admin_accounts_db.modify( admin_itr, same_payer, [&]( auto& sa ) {
+            sa.staked.amount       += contract_staked_amount;
+            sa.staked_share.amount += contract_staked_share;
+            sa.token_share.amount  += contract_token_share_amount;
+         });
+         if ( is_default_pool( cmp.pool_id() ) ) {
+            track_staker( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT );
+         }
+
+         send_stake_receipt( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, cmp.pool_id(),
+                             stake_balances{ asset( contract_staked_amount, CORE_TOKEN_SYMBOL ), asset( contract_staked_share, STAKED_SHARE_SYMBOL ),
+                                             asset( contract_token_share_amount, token_share_symbol( cmp.pool_id() ) ) },
+                             *admin_itr, *sp_itr );
+      }
+
+      return outcome;
+   }
+
+   /**
+    * @brief applies the proxy voting amount of `account` to the pool of campaign `cmp`
+    *
+    * @param account - proxy-voted account
+    * @param proxy_vote - current proxy voting amount of `account`
+    * @param cmp - campaign of the pool
+    * @param stake_pool_db - `stakepool` table of the pool
+    * @return redeemed proxy-vote profits and earned tokens, zero amounts if the proxy voting amount is increased
+    */
+   pieos_sco::unstake_by_proxy_outcome pieos_sco::apply_proxy_vote( const name& account, const asset& proxy_vote ) {
+      const auto proxy_vote_outcome = update_proxy_vote( account, proxy_vote, get_campaign( PIEOS_SYMBOL.code() ), _stake_pool_db );
+
+      // proxy voters take part in every campaign pool as well
+      campaigns campaigns_db( get_self(), get_self().value );
+      for ( const auto& cmp : campaigns_db ) {
+         stake_pool_global stake_pool_db( get_self(), stake_pool_scope( cmp.pool_id() ) );
+         update_proxy_vote( account, proxy_vote, cmp, stake_pool_db );
+      }
+
+      return proxy_vote_outcome;
+   }
+
+   pieos_sco::unstake_by_proxy_outcome pieos_sco::update_proxy_vote( const name& account, const asset& proxy_vote, const campaign& cmp, stake_pool_global& stake_pool_db ) {
+      asset current_proxy_vote( 0, CORE_TOKEN_SYMBOL );
+      {
+         stake_accounts stake_accounts_db( get_self(), account.value );
+         auto sa_itr = stake_accounts_db.find( cmp.pool_id().raw() );
+         current_proxy_vote.amount = (sa_itr == stake_accounts_db.end()) ? 0 : sa_itr->proxy_vote.amount;
+      }
+
+      unstake_by_proxy_outcome outcome{ asset( 0, CORE_TOKEN_SYMBOL ), asset( 0, cmp.total_dist.quantity.symbol ) };
+
+      asset proxy_vote_delta = proxy_vote - current_proxy_vote;
+      if ( is_default_pool( cmp.pool_id() ) ) {
+         check( proxy_vote.amount == 0 || proxy_vote_delta.amount >= 1'0000 || proxy_vote_delta.amount < -1'0000, "invalid proxy_vote_delta" );
+      } else if ( proxy_vote_delta.amount == 0 || ( proxy_vote_delta.amount > 0 && current_block_time().slot >= cmp.end_time.slot ) ) {
+         // campaign pools follow the proxy voting amount of the PIEOS SCO pool, no proxy vote is added to an ended campaign
+         return outcome;
+      }
+
+      auto sp_itr = stake_pool_db.begin();
+
+      // issue SCO tokens accrued since last issuance time (send inline token issue action to the campaign token contract)
+      issue_accrued_SCO_token( cmp, stake_pool_db, sp_itr );
+
+      if ( proxy_vote_delta.amount > 0 ) {
+         stake_by_proxy_vote( account, proxy_vote_delta.amount, cmp, stake_pool_db, sp_itr );
+      } else {
+         const int64_t unstake_proxy_vote_amount = -proxy_vote_delta.amount;
+         outcome = unstake_by_proxy_vote( account, unstake_proxy_vote_amount, cmp, stake_pool_db, sp_itr );
+
+         transfer_proxy_vote_outcome( account, outcome, cmp );
+      }
+
       return outcome;
    }
 
@@ -689,27 +1848,27 @@ namespace pieos {
     * @param account - proxy-voted account
     * @param stake_proxy_vote_amount - added proxy-voting amount
     */
-   void pieos_sco::stake_by_proxy_vote( const name& account, const int64_t stake_proxy_vote_amount, const stake_pool_global::const_iterator& sp_itr ) {
-      const int64_t share_ratio = 10000;
+   void pieos_sco::stake_by_proxy_vote( const name& account, const int64_t stake_proxy_vote_amount, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
+      const int64_t share_ratio = sco_math::SHARE_RATIO;
 
       const int64_t total_staked_amount = sp_itr->total_staked.amount;
       int64_t total_proxy_vote_amount = sp_itr->total_proxy_vote.amount;
       int64_t total_proxy_vote_share_amount = sp_itr->total_proxy_vote_share.amount;
       int64_t total_token_share_amount = sp_itr->total_token_share.amount;
 
-      const int64_t stake_proxy_vote_weighted = stake_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000;
+      const int64_t stake_proxy_vote_weighted = sco_math::weighted_proxy_vote( stake_proxy_vote_amount, cmp.proxy_vote_weight_percent );
 
       int64_t received_token_share_amount = 0;
       if ( total_token_share_amount == 0 ) {
          received_token_share_amount = share_ratio * stake_proxy_vote_weighted;
          total_token_share_amount = received_token_share_amount;
       } else {
-         const int64_t total_weighted_staking_amount = total_staked_amount + (total_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000);
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount, cmp.proxy_vote_weight_percent );
 
-         const int64_t EP0 = (total_weighted_staking_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT) + sp_itr->sco_token_unredeemed.amount; // weighted EOS amount + PIEOS amount
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp_itr->sco_token_unredeemed.amount ); // weighted EOS amount + PIEOS amount
          const int64_t EP1 = EP0 + (stake_proxy_vote_weighted * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT);
          const int64_t TS0 = total_token_share_amount;
-         const int64_t TS1 = (uint128_t(EP1) * TS0) / EP0;
+         const int64_t TS1 = sco_math::mul_div( EP1, TS0, EP0 );
 
          received_token_share_amount = TS1 - TS0;
          total_token_share_amount = TS1;
@@ -725,7 +1884,7 @@ namespace pieos {
          const int64_t E0 = total_proxy_vote_amount + total_unredeemed_proxy_vote_profit_amount;
          const int64_t E1 = E0 + stake_proxy_vote_amount;
          const int64_t PVS0 = total_proxy_vote_share_amount;
-         const int64_t PVS1 = (uint128_t(E1) * PVS0) / E0;
+         const int64_t PVS1 = sco_math::mul_div( E1, PVS0, E0 );
 
          received_proxy_vote_share_amount = PVS1 - PVS0;
          total_proxy_vote_share_amount = PVS1;
@@ -733,34 +1892,40 @@ namespace pieos {
 
       total_proxy_vote_amount += stake_proxy_vote_amount;
 
-      _stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
          sp.total_proxy_vote.amount  = total_proxy_vote_amount;
          sp.total_proxy_vote_share.amount  = total_proxy_vote_share_amount;
          sp.total_token_share.amount = total_token_share_amount;
       });
 
       stake_accounts stake_accounts_db( get_self(), account.value );
-      auto sa_itr = stake_accounts_db.find( PIEOS_SYMBOL.code().raw() );
+      auto sa_itr = stake_accounts_db.find( cmp.pool_id().raw() );
+      const int64_t prev_proxy_vote_share_amount = ( sa_itr == stake_accounts_db.end() ) ? 0 : sa_itr->proxy_vote_share.amount;
 
       // update stake account balances
       if ( sa_itr == stake_accounts_db.end() ) {
-         stake_accounts_db.emplace( get_self(), [&]( auto& sa ){
-            sa.core_token_bal = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.sco_token_bal = asset( 0, PIEOS_SYMBOL );
-            sa.staked = asset( 0, CORE_TOKEN_SYMBOL );
-            sa.staked_share = asset( 0, STAKED_SHARE_SYMBOL );
-            sa.proxy_vote = asset( stake_proxy_vote_amount, CORE_TOKEN_SYMBOL );
-            sa.proxy_vote_share = asset( received_proxy_vote_share_amount, PROXY_VOTE_SHARE_SYMBOL );
-            sa.token_share = asset( received_token_share_amount, TOKEN_SHARE_SYMBOL );
-            sa.last_stake_time = block_timestamp(0);
+         sa_itr = stake_accounts_db.emplace( get_self(), [&]( auto& sa ){
+            set_zero_balances( sa, cmp.pool_id() );
+            sa.proxy_vote.amount = stake_proxy_vote_amount;
+            sa.proxy_vote_share.amount = received_proxy_vote_share_amount;
+            sa.token_share.amount = received_token_share_amount;
          });
+         track_contract_paid_row( account, STAKE_ACCOUNT_TABLE, cmp.pool_id().raw() );
       } else {
          stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
             sa.proxy_vote.amount += stake_proxy_vote_amount;
-            sa.proxy_vote_share.amount = received_proxy_vote_share_amount;
+            sa.proxy_vote_share.amount += received_proxy_vote_share_amount;
             sa.token_share.amount += received_token_share_amount;
          });
       }
+      if ( is_default_pool( cmp.pool_id() ) ) {
+         track_staker( account );
+      }
+
+      send_proxy_vote_receipt( account, cmp.pool_id(), proxy_vote_balances{ asset( stake_proxy_vote_amount, CORE_TOKEN_SYMBOL ),
+                                                                            asset( sa_itr->proxy_vote_share.amount - prev_proxy_vote_share_amount, PROXY_VOTE_SHARE_SYMBOL ),
+                                                                            asset( received_token_share_amount, token_share_symbol( cmp.pool_id() ) ) },
+                               *sa_itr, *sp_itr );
    }
 
    /**
@@ -774,9 +1939,9 @@ namespace pieos {
     *    proxy_vote_profit_redeemed - symbol:(EOS,4), original staked EOS + staking profits
     *    token_earned - symbol:(PIEOS,4), received PIEOS token balance
     */
-   pieos_sco::unstake_by_proxy_outcome pieos_sco::unstake_by_proxy_vote( const name& account, const int64_t unstake_proxy_vote_amount, const stake_pool_global::const_iterator& sp_itr ) {
+   pieos_sco::unstake_by_proxy_outcome pieos_sco::unstake_by_proxy_vote( const name& account, const int64_t unstake_proxy_vote_amount, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
       stake_accounts stake_accounts_db( get_self(), account.value );
-      auto sa_itr = stake_accounts_db.require_find( PIEOS_SYMBOL.code().raw(), "stake account record not found (unstake by proxy vote)" );
+      auto sa_itr = stake_accounts_db.require_find( cmp.pool_id().raw(), "stake account record not found (unstake by proxy vote)" );
 
       const int64_t stake_account_staked_amount = sa_itr->staked.amount;
       const int64_t stake_account_staked_share_amount = sa_itr->staked_share.amount;
@@ -786,24 +1951,24 @@ namespace pieos {
 
       check( unstake_proxy_vote_amount <= stake_account_proxy_vote_amount, "not enough staked proxy vote balance" );
 
-      unstake_by_proxy_outcome outcome { asset( 0, CORE_TOKEN_SYMBOL ), asset ( 0, PIEOS_SYMBOL ) };
+      unstake_by_proxy_outcome outcome { asset( 0, CORE_TOKEN_SYMBOL ), asset ( 0, cmp.total_dist.quantity.symbol ) };
 
       const int64_t total_staked_amount = sp_itr->total_staked.amount;
       int64_t total_proxy_vote_amount = sp_itr->total_proxy_vote.amount;
       int64_t total_proxy_vote_share_amount = sp_itr->total_proxy_vote_share.amount;
       int64_t total_token_share_amount = sp_itr->total_token_share.amount;
 
-      const int64_t unstake_proxy_vote_weighted = unstake_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000;
+      const int64_t unstake_proxy_vote_weighted = sco_math::weighted_proxy_vote( unstake_proxy_vote_amount, cmp.proxy_vote_weight_percent );
 
-      const int64_t token_share_to_redeem = (uint128_t(unstake_proxy_vote_weighted) * stake_account_token_share_amount) / (stake_account_staked_amount + (stake_account_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000));
-      const int64_t proxy_vote_share_to_redeem = (uint128_t(unstake_proxy_vote_amount) * stake_account_proxy_vote_share_amount) / stake_account_proxy_vote_amount;
+      const int64_t token_share_to_redeem = sco_math::mul_div( unstake_proxy_vote_weighted, stake_account_token_share_amount, sco_math::weighted_staking_amount( stake_account_staked_amount, stake_account_proxy_vote_amount, cmp.proxy_vote_weight_percent ) );
+      const int64_t proxy_vote_share_to_redeem = sco_math::mul_div( unstake_proxy_vote_amount, stake_account_proxy_vote_share_amount, stake_account_proxy_vote_amount );
 
       if ( token_share_to_redeem > 0 ) {
-         const int64_t total_weighted_staking_amount = total_staked_amount + (total_proxy_vote_amount * PROXY_VOTE_TOKEN_SHARE_REDUCE_PERCENT / 10000);
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount, cmp.proxy_vote_weight_percent );
 
-         const int64_t EP0 = (total_weighted_staking_amount * STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT) + sp_itr->sco_token_unredeemed.amount; // weighted EOS amount + PIEOS amount
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp_itr->sco_token_unredeemed.amount ); // weighted EOS amount + PIEOS amount
          const int64_t TS0 = total_token_share_amount;
-         const int64_t p  = (uint128_t(token_share_to_redeem) * EP0) / TS0;
+         const int64_t p  = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
          const int64_t TS1 = TS0 - token_share_to_redeem;
          //const int64_t EP1 = EP0 - p;
 
@@ -819,7 +1984,7 @@ namespace pieos {
 
          const int64_t E0 = total_proxy_vote_amount + total_unredeemed_proxy_vote_profit_amount;
          const int64_t PVS0 = total_proxy_vote_share_amount;
-         const int64_t p  = (uint128_t(proxy_vote_share_to_redeem) * E0) / PVS0;
+         const int64_t p  = sco_math::mul_div( proxy_vote_share_to_redeem, E0, PVS0 );
          const int64_t PVS1 = PVS0 - proxy_vote_share_to_redeem;
          //const int64_t E1 = E0 - p;
 
@@ -833,7 +1998,7 @@ namespace pieos {
       stake_account_proxy_vote_amount -= unstake_proxy_vote_amount;
       total_proxy_vote_amount -= unstake_proxy_vote_amount;
 
-      _stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
          sp.total_proxy_vote.amount          = total_proxy_vote_amount;
          sp.total_proxy_vote_share.amount    = total_proxy_vote_share_amount;
          sp.core_token_for_proxy_vote.amount -= outcome.proxy_vote_profit_redeemed.amount;
@@ -849,17 +2014,205 @@ namespace pieos {
          sa.token_share.amount       = stake_account_token_share_amount;
       });
 
+      send_proxy_vote_receipt( account, cmp.pool_id(), proxy_vote_balances{ asset( -unstake_proxy_vote_amount, CORE_TOKEN_SYMBOL ),
+                                                                            asset( -proxy_vote_share_to_redeem, PROXY_VOTE_SHARE_SYMBOL ),
+                                                                            asset( -token_share_to_redeem, token_share_symbol( cmp.pool_id() ) ) },
+                               *sa_itr, *sp_itr );
+
       return outcome;
    }
 
    /**
-    * @brief Issue new PIEOS allocated to PIEOS SCO distribution, accrued since last issuance time
+    * @brief update stake pool, stake account balances for harvesting proxy-vote profits
+    * the proxy-voted account redeems only the proxy-vote profits(EOS) above its proxy-vote amount from its proxy-vote shares(SPROXY)
+    * and the earned PIEOS tokens above its weighted staking amount from its token shares(SPIEOS),
+    * the proxy-vote amount and the token share weight of the account are not changed
+    *
+    * @param account - proxy-voted account
+    * @return unstake_by_proxy_outcome
+    *    proxy_vote_profit_redeemed - symbol:(EOS,4), proxy-vote profits redeemed
+    *    token_earned - symbol:(PIEOS,4), received PIEOS token balance
     */
-   void pieos_sco::issue_accrued_SCO_token( const stake_pool_global::const_iterator& sp_itr ) {
-      check( stake_pool_initialized(), "stake pool not initialized");
+   pieos_sco::unstake_by_proxy_outcome pieos_sco::harvest_proxy_vote_profit( const name& account, const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
+      stake_accounts stake_accounts_db( get_self(), account.value );
+      auto sa_itr = stake_accounts_db.require_find( cmp.pool_id().raw(), "stake account record not found (harvest proxy vote profit)" );
 
-      const block_timestamp sco_start_block { time_point_sec(SCO_START_TIMESTAMP) };
-      const block_timestamp sco_end_block { time_point_sec(SCO_END_TIMESTAMP) };
+      const int64_t stake_account_staked_amount = sa_itr->staked.amount;
+      const int64_t stake_account_proxy_vote_amount = sa_itr->proxy_vote.amount;
+      int64_t stake_account_proxy_vote_share_amount = sa_itr->proxy_vote_share.amount;
+      int64_t stake_account_token_share_amount = sa_itr->token_share.amount;
+
+      unstake_by_proxy_outcome outcome { asset( 0, CORE_TOKEN_SYMBOL ), asset ( 0, cmp.total_dist.quantity.symbol ) };
+
+      const int64_t total_staked_amount = sp_itr->total_staked.amount;
+      const int64_t total_proxy_vote_amount = sp_itr->total_proxy_vote.amount;
+      int64_t total_proxy_vote_share_amount = sp_itr->total_proxy_vote_share.amount;
+      int64_t total_token_share_amount = sp_itr->total_token_share.amount;
+
+      if ( stake_account_token_share_amount > 0 ) {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount, cmp.proxy_vote_weight_percent );
+         const int64_t stake_account_weighted_staking_amount = sco_math::weighted_staking_amount( stake_account_staked_amount, stake_account_proxy_vote_amount, cmp.proxy_vote_weight_percent );
+
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp_itr->sco_token_unredeemed.amount ); // weighted EOS amount + PIEOS amount
+         const int64_t TS0 = total_token_share_amount;
+         // token shares worth the newly issued tokens since staked
+         const int64_t token_share_to_redeem = sco_math::earned_token_share( stake_account_token_share_amount, stake_account_weighted_staking_amount, EP0, TS0 );
+
+         if ( token_share_to_redeem > 0 ) {
+            const int64_t redeemed_token_amount = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
+
+            outcome.token_earned.amount = redeemed_token_amount;
+
+            stake_account_token_share_amount -= token_share_to_redeem;
+            total_token_share_amount = TS0 - token_share_to_redeem;
+         }
+      }
+
+      if ( stake_account_proxy_vote_share_amount > 0 ) {
+         const int64_t total_unredeemed_proxy_vote_profit_amount = sp_itr->core_token_for_proxy_vote.amount;
+
+         const int64_t E0 = total_proxy_vote_amount + total_unredeemed_proxy_vote_profit_amount;
+         const int64_t PVS0 = total_proxy_vote_share_amount;
+         const int64_t p  = sco_math::mul_div( stake_account_proxy_vote_share_amount, E0, PVS0 );
+         const int64_t proxy_vote_profit_amount = p - stake_account_proxy_vote_amount; // newly added proxy-vote profits since proxy-vote staked
+
+         if ( proxy_vote_profit_amount > 0 ) {
+            const int64_t proxy_vote_share_to_redeem = sco_math::mul_div( proxy_vote_profit_amount, PVS0, E0 );
+            const int64_t redeemed_proxy_vote_profit_amount = sco_math::mul_div( proxy_vote_share_to_redeem, E0, PVS0 );
+
+            outcome.proxy_vote_profit_redeemed.amount = redeemed_proxy_vote_profit_amount;
+
+            stake_account_proxy_vote_share_amount -= proxy_vote_share_to_redeem;
+            total_proxy_vote_share_amount = PVS0 - proxy_vote_share_to_redeem;
+         }
+      }
+
+      if ( outcome.proxy_vote_profit_redeemed.amount == 0 && outcome.token_earned.amount == 0 ) {
+         return outcome;
+      }
+
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+         sp.total_proxy_vote_share.amount    = total_proxy_vote_share_amount;
+         sp.core_token_for_proxy_vote.amount -= outcome.proxy_vote_profit_redeemed.amount;
+         if ( sp.core_token_for_proxy_vote.amount < 0 ) sp.core_token_for_proxy_vote.amount = 0;
+         sp.total_token_share.amount         = total_token_share_amount;
+         sp.sco_token_unredeemed.amount      -= outcome.token_earned.amount;
+         if ( sp.sco_token_unredeemed.amount < 0 ) sp.sco_token_unredeemed.amount = 0;
+      });
+
+      const int64_t proxy_vote_share_redeemed = sa_itr->proxy_vote_share.amount - stake_account_proxy_vote_share_amount;
+      const int64_t token_share_redeemed = sa_itr->token_share.amount - stake_account_token_share_amount;
+
+      stake_accounts_db.modify( sa_itr, same_payer, [&]( auto& sa ) {
+         sa.proxy_vote_share.amount  = stake_account_proxy_vote_share_amount;
+         sa.token_share.amount       = stake_account_token_share_amount;
+      });
+
+      send_proxy_vote_receipt( account, cmp.pool_id(), proxy_vote_balances{ asset( 0, CORE_TOKEN_SYMBOL ),
+                                                                            asset( -proxy_vote_share_redeemed, PROXY_VOTE_SHARE_SYMBOL ),
+                                                                            asset( -token_share_redeemed, token_share_symbol( cmp.pool_id() ) ) },
+                               *sa_itr, *sp_itr );
+
+      return outcome;
+   }
+
+   /**
+    * @brief pays out the proxy-vote profits and the earned PIEOS tokens redeemed for a proxy-voted account.
+    * The contract admin's share of the proxy-vote profits is added to the admin's on-contract balance,
+    * tokens that cannot be transferred right away are added to the account's on-contract balance for later withdrawal.
+    *
+    * @param account - proxy-voted account
+    * @param outcome - redeemed proxy-vote profits and earned PIEOS tokens
+    * @param cmp - campaign of the pool
+    */
+   void pieos_sco::transfer_proxy_vote_outcome( const name& account, const unstake_by_proxy_outcome& outcome, const campaign& cmp ) {
+      if ( outcome.token_earned.amount > 0 ) {
+         // transfer received SCO token ownership from contract to user
+         transfer_sco_token( account, outcome.token_earned, cmp, get_self() );
+      }
+
+      // redeemed proxy-vote profit
+      asset redeemed_to_unstaker = outcome.proxy_vote_profit_redeemed;
+      asset contract_fee( 0, CORE_TOKEN_SYMBOL );
+
+      if ( outcome.proxy_vote_profit_redeemed.amount > 0 ) {
+         contract_fee.amount = sco_math::contract_profit_share( outcome.proxy_vote_profit_redeemed.amount );
+         if ( contract_fee.amount > 0 ) {
+            redeemed_to_unstaker -= contract_fee;
+            add_on_contract_token_balance( PIEOS_SCO_CONTRACT_ADMIN_ACCOUNT, contract_fee, get_self() );
+         }
+
+         if ( redeemed_to_unstaker.amount > 0 ) {
+            asset contract_core_token_balance = get_token_balance_from_contract( EOSIO_TOKEN_CONTRACT, get_self(), CORE_TOKEN_SYMBOL );
+            if ( redeemed_to_unstaker.amount <= contract_core_token_balance.amount ) {
+               token_transfer_action transfer_act{ EOSIO_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
+               transfer_act.send( get_self(), account, redeemed_to_unstaker, "PIEOS SCO - Proxy Voting Profits" );
+            } else {
+               // add user's on-contract EOS balance for later withdrawal
+               add_on_contract_token_balance( account, redeemed_to_unstaker, get_self() );
+            }
+         }
+      }
+
+      if ( outcome.proxy_vote_profit_redeemed.amount > 0 || outcome.token_earned.amount > 0 ) {
+         send_settlement_receipt( account, cmp, redeemed_to_unstaker, contract_fee, outcome.token_earned );
+      }
+   }
+
+   /**
+    * @brief transfers SCO tokens earned by `to`, or adds them to the on-contract balance of `to`
+    * if `to` has no balance record on the campaign token contract
+    *
+    * @param to - account receiving the tokens
+    * @param amount - PIEOS or campaign token amount
+    * @param cmp - campaign of the token
+    * @param ram_payer - RAM payer of a new on-contract balance record
+    */
+   void pieos_sco::transfer_sco_token( const name& to, const asset& amount, const campaign& cmp, const name& ram_payer ) {
+      if ( is_token_account_open( cmp.total_dist.contract, to, amount.symbol ) ) {
+         token_transfer_action transfer_act{ cmp.total_dist.contract, { { get_self(), "active"_n } } };
+         transfer_act.send( get_self(), to, amount, "PIEOS SCO" );
+      } else {
+         add_on_contract_token_balance( to, amount, ram_payer );
+      }
+   }
+
+   /**
+    * @brief sends the `stakelog` receipt of a stake balance change of `owner`, with the resulting account balances and pool totals
+    */
+   void pieos_sco::send_stake_receipt( const name& owner, const symbol_code& pool_id, const stake_balances& delta, const stake_account& sa, const stake_pool& sp ) {
+      stakelog_action stakelog_act{ get_self(), { { get_self(), "active"_n } } };
+      stakelog_act.send( owner, pool_id, delta, stake_balances{ sa.staked, sa.staked_share, sa.token_share },
+                         stake_balances{ sp.total_staked, sp.total_staked_share, sp.total_token_share } );
+   }
+
+   /**
+    * @brief sends the `proxylog` receipt of a proxy vote balance change of `account`, with the resulting account balances and pool totals
+    */
+   void pieos_sco::send_proxy_vote_receipt( const name& account, const symbol_code& pool_id, const proxy_vote_balances& delta, const stake_account& sa, const stake_pool& sp ) {
+      proxylog_action proxylog_act{ get_self(), { { get_self(), "active"_n } } };
+      proxylog_act.send( account, pool_id, delta, proxy_vote_balances{ sa.proxy_vote, sa.proxy_vote_share, sa.token_share },
+                         proxy_vote_balances{ sp.total_proxy_vote, sp.total_proxy_vote_share, sp.total_token_share } );
+   }
+
+   void pieos_sco::send_settlement_receipt( const name& owner, const campaign& cmp, const asset& core_token, const asset& contract_fee, const asset& sco_token ) {
+      settlelog_action settlelog_act{ get_self(), { { get_self(), "active"_n } } };
+      settlelog_act.send( owner, cmp.pool_id(), core_token, contract_fee, sco_token );
+   }
+
+   void pieos_sco::send_balance_receipt( const name& owner, const asset& delta, const asset& balance ) {
+      balancelog_action balancelog_act{ get_self(), { { get_self(), "active"_n } } };
+      balancelog_act.send( owner, delta, balance );
+   }
+
+   /**
+    * @brief Issue new SCO tokens allocated to the campaign distribution, accrued since last issuance time
+    */
+   void pieos_sco::issue_accrued_SCO_token( const campaign& cmp, stake_pool_global& stake_pool_db, const stake_pool_global::const_iterator& sp_itr ) {
+      check( sp_itr != stake_pool_db.end(), "stake pool not initialized");
+
+      const block_timestamp sco_start_block = cmp.start_time;
+      const block_timestamp sco_end_block = cmp.end_time;
 
       block_timestamp last_issue_block = sp_itr->last_issue_time;
       block_timestamp current_block = current_block_time();
@@ -878,20 +2231,26 @@ namespace pieos {
          last_issue_block.slot = sco_start_block.slot;
       }
 
-      const int64_t elapsed = current_block.slot - last_issue_block.slot;
       const int64_t total_sco_time_period = sco_end_block.slot - sco_start_block.slot;
-      const int64_t token_issue_amount = (uint128_t(PIEOS_DIST_STAKE_COIN_OFFERING) * elapsed) / total_sco_time_period;
+      const int64_t token_issue_amount = sco_math::accrued_emission( SCO_EMISSION_CURVE, cmp.total_dist.quantity.amount,
+                                                                     last_issue_block.slot - sco_start_block.slot,
+                                                                     current_block.slot - sco_start_block.slot, total_sco_time_period );
 
       if ( token_issue_amount > 0 ) {
-         token_issue_action token_issue_act{ PIEOS_TOKEN_CONTRACT, { { get_self(), "active"_n } } };
-         token_issue_act.send(get_self(), asset(token_issue_amount, PIEOS_SYMBOL ), "PIEOS SCO" );
+         token_issue_action token_issue_act{ cmp.total_dist.contract, { { get_self(), "active"_n } } };
+         token_issue_act.send(get_self(), asset(token_issue_amount, cmp.total_dist.quantity.symbol ), "PIEOS SCO" );
       }
 
-      _stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
+      stake_pool_db.modify( sp_itr, same_payer, [&]( auto& sp ) {
          sp.sco_token_unredeemed.amount += token_issue_amount; // add unredeemed(unclaimed) PIEOS SCO token balance
          sp.last_total_issued.amount += token_issue_amount;
          sp.last_issue_time = current_block;
       });
+
+      if ( token_issue_amount > 0 ) {
+         issuelog_action issuelog_act{ get_self(), { { get_self(), "active"_n } } };
+         issuelog_act.send( cmp.pool_id(), asset( token_issue_amount, cmp.total_dist.quantity.symbol ), sp_itr->sco_token_unredeemed, sp_itr->last_total_issued );
+      }
    }
 
 } /// namespace pieos
@@ -899,11 +2258,19 @@ namespace pieos {
 extern "C" {
    void apply(uint64_t receiver, uint64_t code, uint64_t action) {
       if ( code == EOSIO_TOKEN_CONTRACT.value && action == "transfer"_n.value ) {
-         eosio::execute_action( name(receiver), name(code), &pieos::pieos_sco::receive_token );
+         // pre-filter on the fixed-size fields, so that the notifications of the contract's own payouts,
+         // other tokens and transfers between other accounts exit before the contract is instantiated
+         pieos::pieos_sco::transfer_notification n;
+         if ( pieos::pieos_sco::read_transfer_notification( n )
+              && n.to.value == receiver && n.from.value != receiver
+              && n.quantity.symbol == CORE_TOKEN_SYMBOL && n.quantity.amount > 0 ) {
+            pieos::pieos_sco sco( name(receiver), name(code), datastream<const char*>( nullptr, 0 ) );
+            sco.receive_token( n.from, n.to, n.quantity );
+         }
       }
       if ( code == receiver ) {
          switch (action) {
-            EOSIO_DISPATCH_HELPER(pieos::pieos_sco, (init)(open)(close)(stake)(unstake)(proxyvoted)(withdraw)(claimvested)(updaterex)(setacctype)(sellram)(voteproducer) )
+            EOSIO_DISPATCH_HELPER(pieos::pieos_sco, (init)(addcampaign)(open)(migrate)(close)(stake)(unstake)(stakecamp)(unstakecamp)(compound)(movestake)(proxyvoted)(harvestproxy)(syncproxy)(distribute)(withdraw)(claimvested)(setvesting)(claimall)(updaterex)(setmaint)(setreserve)(gc)(setacctype)(sellram)(voteproducer)(stakelog)(proxylog)(issuelog)(settlelog)(balancelog) )
          }
       }
       eosio_exit(0);
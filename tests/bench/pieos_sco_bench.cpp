@@ -0,0 +1,300 @@
+#include <boost/test/unit_test.hpp>
+
+#include "pieos_tester.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace pieos_testing;
+
+/**
+ * Billed CPU/NET/RAM of the pieosdistsco actions on a local test chain, not run by CTest.
+ *
+ * Scripted workloads run at every account count and REX return bucket depth, one JSON line is written per action and run:
+ * billed CPU (p50/p99, objective billing), billed NET (p50), inline actions sent and RAM billed to the contract,
+ * to the user and to other accounts, per action. The run fails if any action fails, with the first error of each action.
+ *
+ *    pieos_sco_bench -- [--accounts N,N,...] [--buckets N,N,...] [--output FILE]
+ */
+namespace {
+
+   struct action_report {
+      std::string           action;
+      std::vector<uint32_t> cpu_us;
+      std::vector<uint32_t> net_bytes;
+      uint64_t              failed = 0;
+      std::string           first_error; // message of the first failed action
+      uint64_t              inline_actions = 0;
+      int64_t               ram_contract = 0;
+      int64_t               ram_user = 0;
+      int64_t               ram_other = 0;
+   };
+
+   struct bench_options {
+      std::vector<uint32_t> account_counts = { 10, 100, 1000 };
+      std::vector<uint32_t> bucket_depths = { 0, 12, 62 };   // 12 hour return buckets, 62 fill the 30 day window
+      std::string           output_path;
+   };
+
+   bool parse_counts( const std::string& arg, std::vector<uint32_t>& counts, const unsigned long min, const unsigned long max ) {
+      counts.clear();
+      size_t pos = 0;
+      while ( pos <= arg.size() ) {
+         const size_t end = std::min( arg.find( ',', pos ), arg.size() );
+         const std::string item = arg.substr( pos, end - pos );
+         char* parse_end = nullptr;
+         const unsigned long n = std::strtoul( item.c_str(), &parse_end, 10 );
+         if ( item.empty() || *parse_end != '\0' || n < min || n > max ) {
+            return false;
+         }
+         counts.push_back( uint32_t( n ) );
+         pos = end + 1;
+      }
+      return !counts.empty();
+   }
+
+   bench_options parse_options() {
+      const auto& suite = boost::unit_test::framework::master_test_suite();
+      bench_options options;
+      for ( int i = 1; i < suite.argc; ++i ) {
+         const std::string arg = suite.argv[i];
+         if ( arg == "--accounts" && i + 1 < suite.argc ) {
+            BOOST_REQUIRE_MESSAGE( parse_counts( suite.argv[++i], options.account_counts, 1, 100'000 ), "invalid --accounts" );
+         } else if ( arg == "--buckets" && i + 1 < suite.argc ) {
+            BOOST_REQUIRE_MESSAGE( parse_counts( suite.argv[++i], options.bucket_depths, 0, 1'000 ), "invalid --buckets" );
+         } else if ( arg == "--output" && i + 1 < suite.argc ) {
+            options.output_path = suite.argv[++i];
+         }
+      }
+      return options;
+   }
+
+   account_name bench_account( uint32_t i ) {
+      static const char* charmap = "abcdefghijklmnopqrstuvwxyz12345";
+      std::string name = "bench";
+      do {
+         name.push_back( charmap[i % 31] );
+         i /= 31;
+      } while ( i > 0 );
+      return account_name( name );
+   }
+
+   std::vector<account_name> bench_accounts( const uint32_t accounts ) {
+      std::vector<account_name> names;
+      names.reserve( accounts );
+      for ( uint32_t i = 0; i < accounts; ++i ) {
+         names.push_back( bench_account( i ) );
+      }
+      return names;
+   }
+
+   asset eos( const int64_t amount ) {
+      return asset( amount * 1'0000, symbol( 4, "EOS" ) );
+   }
+
+   template<typename T>
+   T percentile( std::vector<T> values, const double p ) {
+      if ( values.empty() ) {
+         return 0;
+      }
+      std::sort( values.begin(), values.end() );
+      return values[ std::min( values.size() - 1, size_t( p * double( values.size() ) ) ) ];
+   }
+
+   class bench_chain : public pieos_tester {
+   public:
+      static constexpr uint32_t TRXS_PER_BLOCK = 20;
+
+      explicit bench_chain( const std::vector<account_name>& accounts )
+      : pieos_tester( with_reward_accounts( accounts ) ), _accounts( accounts ) {
+         deploy_sco();
+
+         const asset supply = eos( 1100 * int64_t( _accounts.size() ) );
+         BOOST_REQUIRE_EQUAL( success(), push( N(eosio.token), N(issue), N(eosio.token), mvo()
+                                                ( "to", "eosio.token" )
+                                                ( "quantity", supply )
+                                                ( "memo", "" ) ) );
+         for ( const auto& a : _accounts ) {
+            BOOST_REQUIRE_EQUAL( success(), transfer( N(eosio.token), a, core( "1000.0000" ) ) );
+         }
+         for ( const auto& a : { N(benchrwstake), N(benchrwproxy) } ) {
+            BOOST_REQUIRE_EQUAL( success(), transfer( N(eosio.token), a, eos( 10 * int64_t( _accounts.size() ) ) ) );
+         }
+
+         BOOST_REQUIRE_EQUAL( success(), push( N(pieosdistsco), N(setacctype), N(pieosadminac), mvo()( "account", "benchrwstake" )( "type", 1 ) ) );
+         BOOST_REQUIRE_EQUAL( success(), push( N(pieosdistsco), N(setacctype), N(pieosadminac), mvo()( "account", "benchrwproxy" )( "type", 2 ) ) );
+
+         // into the SCO period, so that every action issues the accrued PIEOS
+         produce_block( fc::days(200) );
+
+         const block_timestamp_type now( control->head_block_time() );
+         BOOST_REQUIRE_EQUAL( success(), push( N(pieosdistsco), N(setvesting), N(pieosadminac), mvo()
+                                                ( "beneficiary", "carol" )
+                                                ( "total", asset::from_string( "1000000.0000 PIEOS" ) )
+                                                ( "start_time", now )
+                                                ( "cliff_time", now )
+                                                ( "end_time", now ) ) );
+      }
+
+      std::vector<action_report> run( const uint32_t return_buckets ) {
+         std::vector<action_report> reports;
+
+         reports.push_back( run_action( "transfer", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(eosio.token), N(transfer), a, a, mvo()( "from", a )( "to", "pieosdistsco" )( "quantity", core( "1000.0000" ) )( "memo", "" ) );
+         } ) );
+         reports.push_back( run_action( "stake", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(pieosdistsco), N(stake), a, a, mvo()( "owner", a )( "amount", core( "500.0000" ) ) );
+         } ) );
+         reports.push_back( run_action( "proxyvoted", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(pieosdistsco), N(proxyvoted), N(pieosproxy11), a, mvo()( "account", a )( "proxy_vote", core( "200.0000" ) ) );
+         } ) );
+
+         // REX maturity, then REX fees filling `return_buckets` 12 hour return buckets,
+         // so that the REX valuation of the following actions walks a `retbuckets` row of that depth
+         produce_block( fc::days(5) );
+         const auto pool = get_rex_pool();
+         const int64_t rex_fee = std::max<int64_t>( pool ? pool->total_lendable.get_amount() / 100 / 62 : 0, 1 );
+         for ( uint32_t bucket = 0; bucket < return_buckets; ++bucket ) {
+            produce_block( fc::hours(12) );
+            BOOST_REQUIRE_EQUAL( success(), push( N(eosio), N(donatetorex), N(carol), mvo()
+                                                   ( "payer", "carol" )
+                                                   ( "quantity", asset( rex_fee, symbol( 4, "EOS" ) ) )
+                                                   ( "memo", "" ) ) );
+         }
+
+         // BP voting rewards for the staked and proxy-voted EOS
+         BOOST_REQUIRE_EQUAL( success(), transfer( N(benchrwstake), N(pieosdistsco), eos( 5 * int64_t( _accounts.size() ) ) ) );
+         BOOST_REQUIRE_EQUAL( success(), transfer( N(benchrwproxy), N(pieosdistsco), eos( 2 * int64_t( _accounts.size() ) ) ) );
+
+         reports.push_back( run_action( "compound", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(pieosdistsco), N(compound), a, a, mvo()( "owner", a ) );
+         } ) );
+         reports.push_back( run_action( "harvestproxy", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(pieosdistsco), N(harvestproxy), a, a, mvo()( "account", a ) );
+         } ) );
+         reports.push_back( run_action( "unstake", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(pieosdistsco), N(unstake), a, a, mvo()( "owner", a )( "amount", core( "250.0000" ) ) );
+         } ) );
+         reports.push_back( run_action( "withdraw", [&]( const account_name& a, action_report& r ) {
+            measure( r, N(pieosdistsco), N(withdraw), a, a, mvo()( "owner", a )( "amount", get_sco_deposit( a ) ) );
+         } ) );
+         reports.push_back( run_action( "claimvested", [&]( const account_name&, action_report& r ) {
+            measure( r, N(pieosdistsco), N(claimvested), N(carol), N(carol), mvo()( "account", "carol" )( "amount", asset::from_string( "1.0000 PIEOS" ) ) );
+         } ) );
+
+         return reports;
+      }
+
+   private:
+      static std::vector<account_name> with_reward_accounts( std::vector<account_name> accounts ) {
+         accounts.push_back( N(benchrwstake) );
+         accounts.push_back( N(benchrwproxy) );
+         return accounts;
+      }
+
+      template<typename Act>
+      action_report run_action( const char* action, Act&& act ) {
+         action_report report;
+         report.action = action;
+         for ( const auto& a : _accounts ) {
+            act( a, report );
+         }
+         produce_block();
+         _pending_trxs = 0;
+         return report;
+      }
+
+      /**
+       * @brief pushes one action with objective CPU billing and adds its billed CPU, NET and RAM to `report`,
+       * RAM billed to `user` is the user's, to pieosdistsco the contract's
+       */
+      void measure( action_report& report, const account_name& code, const action_name& act, const account_name& actor,
+                    const account_name& user, const variant_object& data ) {
+         signed_transaction trx;
+         trx.actions.emplace_back( get_action( code, act, { permission_level{ actor, config::active_name } }, data ) );
+         // the expiration tells apart the same action pushed again in one block (`claimvested`)
+         set_transaction_headers( trx, DEFAULT_EXPIRATION_DELTA + _pending_trxs );
+         trx.sign( get_private_key( actor, "active" ), control->get_chain_id() );
+
+         transaction_trace_ptr trace;
+         try {
+            // billed_cpu_time_us = 0 bills the measured CPU time instead of the tester's fixed default
+            trace = push_transaction( trx, fc::time_point::maximum(), 0 );
+         } catch ( const fc::exception& ex ) {
+            if ( report.failed++ == 0 ) {
+               report.first_error = user.to_string() + ": " + ex.top_message();
+            }
+            return;
+         }
+
+         report.cpu_us.push_back( trace->receipt->cpu_usage_us );
+         report.net_bytes.push_back( trace->receipt->net_usage_words.value * 8 );
+         for ( const auto& at : trace->action_traces ) {
+            if ( at.creator_action_ordinal.value > 0 && at.receiver == at.act.account ) {
+               ++report.inline_actions;
+            }
+            for ( const auto& d : at.account_ram_deltas ) {
+               ( d.account == N(pieosdistsco) ? report.ram_contract : d.account == user ? report.ram_user : report.ram_other ) += d.delta;
+            }
+         }
+
+         if ( ++_pending_trxs == TRXS_PER_BLOCK ) {
+            produce_block();
+            _pending_trxs = 0;
+         }
+      }
+
+      std::vector<account_name> _accounts;
+      uint32_t                  _pending_trxs = 0;
+   };
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(pieos_sco_bench)
+
+BOOST_AUTO_TEST_CASE( action_costs ) try {
+   const bench_options options = parse_options();
+
+   std::FILE* out = stdout;
+   if ( !options.output_path.empty() ) {
+      out = std::fopen( options.output_path.c_str(), "w" );
+      BOOST_REQUIRE_MESSAGE( out, "cannot open output file " + options.output_path );
+   }
+
+   for ( const uint32_t accounts : options.account_counts ) {
+      for ( const uint32_t buckets : options.bucket_depths ) {
+         bench_chain chain( bench_accounts( accounts ) );
+         for ( const auto& r : chain.run( buckets ) ) {
+            const uint64_t ok = r.cpu_us.size();
+            const double per_action = ok ? 1.0 / double( ok ) : 0.0;
+
+            std::fprintf( out, "{\"accounts\":%u,\"return_buckets\":%u,\"action\":\"%s\",\"count\":%llu,\"failed\":%llu,"
+                               "\"cpu_us_p50\":%u,\"cpu_us_p99\":%u,\"net_bytes_p50\":%u,\"inline_actions\":%.3f,"
+                               "\"ram_contract_bytes\":%.3f,\"ram_user_bytes\":%.3f,\"ram_other_bytes\":%.3f}\n",
+                          accounts, buckets, r.action.c_str(), (unsigned long long)ok, (unsigned long long)r.failed,
+                          percentile( r.cpu_us, 0.50 ), percentile( r.cpu_us, 0.99 ), percentile( r.net_bytes, 0.50 ),
+                          double( r.inline_actions ) * per_action, double( r.ram_contract ) * per_action,
+                          double( r.ram_user ) * per_action, double( r.ram_other ) * per_action );
+            std::fflush( out );
+
+            std::fprintf( stderr, "%8u accounts %4u buckets  %-12s %8llu ok %6llu failed  cpu p50 %6u us  p99 %6u us  net %5u bytes\n",
+                          accounts, buckets, r.action.c_str(), (unsigned long long)ok, (unsigned long long)r.failed,
+                          percentile( r.cpu_us, 0.50 ), percentile( r.cpu_us, 0.99 ), percentile( r.net_bytes, 0.50 ) );
+
+            // the costs of a failed workload do not describe the action, the run fails after all reports are written
+            BOOST_CHECK_MESSAGE( r.failed == 0, r.action + " failed " + std::to_string( r.failed ) + " times at "
+                                                + std::to_string( accounts ) + " accounts, " + std::to_string( buckets )
+                                                + " buckets, first error: " + r.first_error );
+         }
+      }
+   }
+
+   if ( out != stdout ) {
+      std::fclose( out );
+   }
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+#include <boost/test/unit_test.hpp>
+
+#include "pieos_tester.hpp"
+
+using namespace pieos_testing;
+
+BOOST_AUTO_TEST_SUITE(pieos_rex_emulator_tests)
+
+BOOST_FIXTURE_TEST_CASE( sellrex_after_maturity, pieos_tester ) try {
+   BOOST_REQUIRE_EQUAL( success(), deposit( N(alice), core( "1000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( N(alice), core( "1000.0000" ) ) );
+
+   auto rb = get_rex_balance( N(alice) );
+   BOOST_REQUIRE( rb );
+   BOOST_REQUIRE_EQUAL( rex( "10000000.0000" ), rb->rex_balance );
+   BOOST_REQUIRE_EQUAL( 0, rb->matured_rex );
+   BOOST_REQUIRE_EQUAL( 1u, rb->rex_maturities.size() );
+   BOOST_REQUIRE_EQUAL( core( "0.0000" ), get_rex_fund( N(alice) ) );
+
+   // bought on 2020-01-01, matures at the start of 2020-01-06
+   produce_block( fc::days(4) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "insufficient available rex" ), sellrex( N(alice), rex( "10000.0000" ) ) );
+
+   produce_block( fc::days(1) );
+   BOOST_REQUIRE_EQUAL( success(), sellrex( N(alice), rex( "10000.0000" ) ) );
+   BOOST_REQUIRE( !get_rex_order( N(alice) ) );
+   BOOST_REQUIRE_EQUAL( core( "1.0000" ), get_rex_fund( N(alice) ) );
+
+   rb = get_rex_balance( N(alice) );
+   BOOST_REQUIRE_EQUAL( rex( "9990000.0000" ), rb->rex_balance );
+   BOOST_REQUIRE_EQUAL( rex( "9990000.0000" ).get_amount(), rb->matured_rex );
+
+   const asset liquid = get_core_token_balance( N(alice) );
+   BOOST_REQUIRE_EQUAL( success(), withdraw( N(alice), core( "1.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( liquid + core( "1.0000" ), get_core_token_balance( N(alice) ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( sellrex_queued_until_loans_return, pieos_tester ) try {
+   BOOST_REQUIRE_EQUAL( success(), deposit( N(alice), core( "100000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( success(), buyrex( N(alice), core( "100000.0000" ) ) );
+   produce_block( fc::days(5) );
+
+   // 66666 EOS of the 100000 EOS pool are lent, about 20000 EOS are available to sell orders
+   BOOST_REQUIRE_EQUAL( success(), deposit( N(bob), core( "80000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( N(bob), N(bob), core( "40000.0000" ) ) );
+   auto pool = get_rex_pool();
+   BOOST_REQUIRE( pool );
+   BOOST_REQUIRE_EQUAL( core( "66666.6666" ), pool->total_lent );
+
+   // an order worth 30000 EOS is queued, the REX stays in the balance until the order is filled
+   BOOST_REQUIRE_EQUAL( success(), sellrex( N(alice), rex( "300000000.0000" ) ) );
+   auto order = get_rex_order( N(alice) );
+   BOOST_REQUIRE( order );
+   BOOST_REQUIRE( order->is_open );
+   BOOST_REQUIRE_EQUAL( rex( "300000000.0000" ), order->rex_requested );
+   BOOST_REQUIRE_EQUAL( core( "0.0000" ), order->proceeds );
+   BOOST_REQUIRE_EQUAL( rex( "1000000000.0000" ), get_rex_balance( N(alice) )->rex_balance );
+   BOOST_REQUIRE_EQUAL( core( "0.0000" ), get_rex_fund( N(alice) ) );
+
+   // a second order the pool cannot fill is added to the open one
+   BOOST_REQUIRE_EQUAL( success(), sellrex( N(alice), rex( "250000000.0000" ) ) );
+   order = get_rex_order( N(alice) );
+   BOOST_REQUIRE( order->is_open );
+   BOOST_REQUIRE_EQUAL( rex( "550000000.0000" ), order->rex_requested );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "insufficient funds for current and scheduled orders" ),
+                        sellrex( N(alice), rex( "460000000.0000" ) ) );
+
+   // no new loans while a sell order is queued
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "rex loans are currently not available" ), rentcpu( N(bob), N(bob), core( "100.0000" ) ) );
+
+   // the expired loan is returned and the order filled by any REX action
+   produce_block( fc::days(30) );
+   BOOST_REQUIRE_EQUAL( success(), runrex( N(carol), 2 ) );
+   pool = get_rex_pool();
+   BOOST_REQUIRE_EQUAL( core( "0.0000" ), pool->total_lent );
+
+   order = get_rex_order( N(alice) );
+   BOOST_REQUIRE( order );
+   BOOST_REQUIRE( !order->is_open );
+   // the order is filled at the price raised by the rent paid
+   BOOST_REQUIRE( order->proceeds > core( "55000.0000" ) );
+   BOOST_REQUIRE_EQUAL( rex( "450000000.0000" ), get_rex_balance( N(alice) )->rex_balance );
+
+   // the proceeds move to the REX fund on the owner's next REX action
+   const asset proceeds = order->proceeds;
+   BOOST_REQUIRE_EQUAL( success(), updaterex( N(alice) ) );
+   BOOST_REQUIRE( !get_rex_order( N(alice) ) );
+   BOOST_REQUIRE_EQUAL( proceeds, get_rex_fund( N(alice) ) );
+
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( N(bob), N(bob), core( "100.0000" ) ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+#include <boost/test/unit_test.hpp>
+
+#include "pieos_tester.hpp"
+
+using namespace pieos_testing;
+
+namespace {
+
+   /// the SCO share and REX conversions round down
+   bool near( const asset& a, const asset& b, const int64_t tolerance = 10 ) {
+      return a.get_symbol() == b.get_symbol() && std::llabs( a.get_amount() - b.get_amount() ) <= tolerance;
+   }
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(pieos_sco_unstake_tests)
+
+BOOST_FIXTURE_TEST_CASE( unstake_settlement, pieos_tester ) try {
+   deploy_sco();
+
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(pieosdistsco), core( "100000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( core( "100000.0000" ), get_sco_deposit( N(alice) ) );
+   BOOST_REQUIRE_EQUAL( success(), sco_stake( N(alice), core( "100000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( core( "0.0000" ), get_sco_deposit( N(alice) ) );
+   BOOST_REQUIRE_EQUAL( rex( "1000000000.0000" ), get_rex_balance( N(pieosdistsco) )->rex_balance );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "cannot run unstake until rex maturity time" ), sco_unstake( N(alice), core( "10000.0000" ) ) );
+   produce_block( fc::days(5) );
+
+   // sellrex: the REX pool fills the sale, the redeemed EOS is paid out in the same transaction
+   asset liquid = get_core_token_balance( N(alice) );
+   BOOST_REQUIRE_EQUAL( success(), sco_unstake( N(alice), core( "10000.0000" ) ) );
+   BOOST_REQUIRE( !get_rex_order( N(pieosdistsco) ) );
+   BOOST_REQUIRE( near( liquid + core( "10000.0000" ), get_core_token_balance( N(alice) ) ) );
+   BOOST_REQUIRE_EQUAL( core( "0.0000" ), get_sco_deposit( N(alice) ) );
+
+   // 60000 EOS of the 90000 EOS pool are lent, about 18000 EOS are available to sell orders
+   BOOST_REQUIRE_EQUAL( success(), deposit( N(bob), core( "40000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( success(), rentcpu( N(bob), N(bob), core( "40000.0000" ) ) );
+
+   // queued: the sale exceeds the available EOS, the redeemed EOS is credited on-contract
+   liquid = get_core_token_balance( N(alice) );
+   BOOST_REQUIRE_EQUAL( success(), sco_unstake( N(alice), core( "50000.0000" ) ) );
+   auto order = get_rex_order( N(pieosdistsco) );
+   BOOST_REQUIRE( order );
+   BOOST_REQUIRE( order->is_open );
+   BOOST_REQUIRE_EQUAL( liquid, get_core_token_balance( N(alice) ) );
+   BOOST_REQUIRE( near( core( "50000.0000" ), get_sco_deposit( N(alice) ) ) );
+
+   // queued behind the contract's own open order, even though the pool could fill a sale this small
+   BOOST_REQUIRE_EQUAL( success(), sco_unstake( N(alice), core( "100.0000" ) ) );
+   BOOST_REQUIRE( get_rex_order( N(pieosdistsco) )->is_open );
+   BOOST_REQUIRE_EQUAL( liquid, get_core_token_balance( N(alice) ) );
+   BOOST_REQUIRE( near( core( "50100.0000" ), get_sco_deposit( N(alice) ) ) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "not enough SCO contract's EOS balance because of pending REX sell orders" ),
+                        sco_withdraw( N(alice), core( "50000.0000" ) ) );
+
+   // the expired loan is returned and the order filled, its proceeds reach the contract's REX fund on `updaterex`
+   produce_block( fc::days(30) );
+   BOOST_REQUIRE_EQUAL( success(), runrex( N(carol), 2 ) );
+   order = get_rex_order( N(pieosdistsco) );
+   BOOST_REQUIRE( order );
+   BOOST_REQUIRE( !order->is_open );
+
+   BOOST_REQUIRE_EQUAL( success(), sco_updaterex( N(carol) ) );
+   BOOST_REQUIRE( !get_rex_order( N(pieosdistsco) ) );
+
+   BOOST_REQUIRE_EQUAL( success(), sco_withdraw( N(alice), core( "50000.0000" ) ) );
+   BOOST_REQUIRE_EQUAL( liquid + core( "50000.0000" ), get_core_token_balance( N(alice) ) );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
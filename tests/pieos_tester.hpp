@@ -0,0 +1,247 @@
+#pragma once
+
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <fc/variant_object.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <optional>
+
+#include "contracts.hpp"
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+using namespace fc;
+
+using mvo = fc::mutable_variant_object;
+
+namespace pieos_testing {
+
+   /// `eosio` REX table rows in the system contract's layout, read raw since the emulator ABI has no tables
+   struct rex_pool_row {
+      uint8_t  version = 0;
+      asset    total_lent;
+      asset    total_unlent;
+      asset    total_rent;
+      asset    total_lendable;
+      asset    total_rex;
+      asset    namebid_proceeds;
+      uint64_t loan_num = 0;
+   };
+
+   struct rex_balance_row {
+      uint8_t      version = 0;
+      account_name owner;
+      asset        vote_stake;
+      asset        rex_balance;
+      int64_t      matured_rex = 0;
+      std::deque<std::pair<time_point_sec, int64_t>> rex_maturities;
+   };
+
+   struct rex_fund_row {
+      uint8_t      version = 0;
+      account_name owner;
+      asset        balance;
+   };
+
+   struct rex_order_row {
+      uint8_t      version = 0;
+      account_name owner;
+      asset        rex_requested;
+      asset        proceeds;
+      asset        stake_change;
+      time_point   order_time;
+      bool         is_open = true;
+   };
+
+} // namespace pieos_testing
+
+FC_REFLECT( pieos_testing::rex_pool_row, (version)(total_lent)(total_unlent)(total_rent)(total_lendable)(total_rex)(namebid_proceeds)(loan_num) )
+FC_REFLECT( pieos_testing::rex_balance_row, (version)(owner)(vote_stake)(rex_balance)(matured_rex)(rex_maturities) )
+FC_REFLECT( pieos_testing::rex_fund_row, (version)(owner)(balance) )
+FC_REFLECT( pieos_testing::rex_order_row, (version)(owner)(rex_requested)(proceeds)(stake_change)(order_time)(is_open) )
+
+namespace pieos_testing {
+
+   inline asset core( const std::string& amount ) {
+      return asset::from_string( amount + " EOS" );
+   }
+
+   inline asset rex( const std::string& amount ) {
+      return asset::from_string( amount + " REX" );
+   }
+
+   /**
+    * @brief test chain with the PIEOS governance token deployed as `eosio.token` (EOS) and the REX emulator
+    * deployed to `eosio`, the SCO contract is deployed by `deploy_sco`
+    *
+    * The chain starts on 2020-01-01, before the SCO period, so the SCO contract issues no PIEOS.
+    */
+   class pieos_tester : public tester {
+   public:
+      static constexpr int64_t INITIAL_CORE_TOKEN_BALANCE = 1'000'000'0000;
+
+      explicit pieos_tester( const std::vector<account_name>& extra_accounts = {} ) {
+         produce_blocks( 2 );
+
+         // all accounts are created before the emulator is set to `eosio`, which does not serve the native actions,
+         // a block holds 50 account creations at the tester's default billed CPU time
+         std::vector<account_name> accounts = { N(eosio.token), N(eosio.rex), N(eosio.ram), N(pieostokenct), N(pieosdistsco),
+                                                N(pieosadminac), N(pieosproxy11), N(alice), N(bob), N(carol) };
+         accounts.insert( accounts.end(), extra_accounts.begin(), extra_accounts.end() );
+         for ( size_t i = 0; i < accounts.size(); i += 50 ) {
+            create_accounts( std::vector<account_name>( accounts.begin() + i, accounts.begin() + std::min( i + 50, accounts.size() ) ) );
+            produce_block();
+         }
+         produce_block();
+
+         set_contract( N(eosio.token), contracts::token_wasm(), contracts::token_abi() );
+         set_contract( N(eosio), contracts::rex_emulator_wasm(), contracts::rex_emulator_abi() );
+         produce_blocks();
+
+         BOOST_REQUIRE_EQUAL( success(), push( N(eosio.token), N(create), N(eosio.token), mvo()
+                                                ( "issuer", "eosio.token" )
+                                                ( "maximum_supply", core( "10000000000.0000" ) ) ) );
+         BOOST_REQUIRE_EQUAL( success(), push( N(eosio.token), N(issue), N(eosio.token), mvo()
+                                                ( "to", "eosio.token" )
+                                                ( "quantity", core( "3000000.0000" ) )
+                                                ( "memo", "" ) ) );
+         for ( const auto& a : { N(alice), N(bob), N(carol) } ) {
+            BOOST_REQUIRE_EQUAL( success(), transfer( N(eosio.token), a, asset( INITIAL_CORE_TOKEN_BALANCE, symbol( 4, "EOS" ) ) ) );
+         }
+      }
+
+      void set_contract( const account_name& account, const std::vector<uint8_t>& wasm, const std::vector<char>& abi ) {
+         set_code( account, wasm );
+         set_abi( account, abi.data() );
+      }
+
+      /// deploys the PIEOS token and the SCO contract and initializes the stake pool
+      void deploy_sco() {
+         set_contract( N(pieostokenct), contracts::token_wasm(), contracts::token_abi() );
+         set_contract( N(pieosdistsco), contracts::sco_wasm(), contracts::sco_abi() );
+         // the SCO contract sends its REX, token and receipt actions inline
+         set_authority( N(pieosdistsco), config::active_name,
+                        authority( 1, { key_weight{ get_public_key( N(pieosdistsco), "active" ), 1 } },
+                                   { permission_level_weight{ { N(pieosdistsco), config::eosio_code_name }, 1 } } ),
+                        config::owner_name );
+         produce_blocks();
+
+         BOOST_REQUIRE_EQUAL( success(), push( N(pieostokenct), N(create), N(pieostokenct), mvo()
+                                                ( "issuer", "pieosdistsco" )
+                                                ( "maximum_supply", asset::from_string( "1000000000.0000 PIEOS" ) ) ) );
+         BOOST_REQUIRE_EQUAL( success(), push( N(pieosdistsco), N(init), N(pieosdistsco), mvo() ) );
+      }
+
+      /// pushes an action signed by `actor` and produces a block, so that the same action can be pushed again
+      action_result push( const account_name& code, const action_name& act, const account_name& actor, const variant_object& data ) {
+         try {
+            base_tester::push_action( code, act, actor, data );
+         } catch ( const fc::exception& ex ) {
+            return error( ex.top_message() );
+         }
+         produce_block();
+         return success();
+      }
+
+      action_result transfer( const account_name& from, const account_name& to, const asset& quantity, const std::string& memo = "" ) {
+         return push( N(eosio.token), N(transfer), from, mvo()
+                      ( "from", from )
+                      ( "to", to )
+                      ( "quantity", quantity )
+                      ( "memo", memo ) );
+      }
+
+      asset get_core_token_balance( const account_name& account ) {
+         return get_currency_balance( N(eosio.token), symbol( 4, "EOS" ), account );
+      }
+
+      ////////////////////////////////
+      /// REX emulator
+
+      action_result deposit( const account_name& owner, const asset& amount ) {
+         return push( N(eosio), N(deposit), owner, mvo()( "owner", owner )( "amount", amount ) );
+      }
+
+      action_result withdraw( const account_name& owner, const asset& amount ) {
+         return push( N(eosio), N(withdraw), owner, mvo()( "owner", owner )( "amount", amount ) );
+      }
+
+      action_result buyrex( const account_name& from, const asset& amount ) {
+         return push( N(eosio), N(buyrex), from, mvo()( "from", from )( "amount", amount ) );
+      }
+
+      action_result sellrex( const account_name& from, const asset& rex ) {
+         return push( N(eosio), N(sellrex), from, mvo()( "from", from )( "rex", rex ) );
+      }
+
+      action_result updaterex( const account_name& owner ) {
+         return push( N(eosio), N(updaterex), owner, mvo()( "owner", owner ) );
+      }
+
+      action_result runrex( const account_name& user, uint16_t max ) {
+         return push( N(eosio), N(runrex), user, mvo()( "user", user )( "max", max ) );
+      }
+
+      action_result rentcpu( const account_name& from, const account_name& receiver, const asset& loan_payment ) {
+         return push( N(eosio), N(rentcpu), from, mvo()
+                      ( "from", from )
+                      ( "receiver", receiver )
+                      ( "loan_payment", loan_payment )
+                      ( "loan_fund", core( "0.0000" ) ) );
+      }
+
+      template<typename T>
+      std::optional<T> get_row( const account_name& code, const account_name& scope, const table_name& table, const uint64_t key ) {
+         const std::vector<char> data = get_row_by_account( code, scope, table, account_name( key ) );
+         if ( data.empty() ) {
+            return {};
+         }
+         return fc::raw::unpack<T>( data );
+      }
+
+      std::optional<rex_pool_row> get_rex_pool() {
+         return get_row<rex_pool_row>( N(eosio), N(eosio), N(rexpool), 0 );
+      }
+
+      std::optional<rex_balance_row> get_rex_balance( const account_name& owner ) {
+         return get_row<rex_balance_row>( N(eosio), N(eosio), N(rexbal), owner.to_uint64_t() );
+      }
+
+      asset get_rex_fund( const account_name& owner ) {
+         const auto fund = get_row<rex_fund_row>( N(eosio), N(eosio), N(rexfund), owner.to_uint64_t() );
+         return fund ? fund->balance : core( "0.0000" );
+      }
+
+      std::optional<rex_order_row> get_rex_order( const account_name& owner ) {
+         return get_row<rex_order_row>( N(eosio), N(eosio), N(rexqueue), owner.to_uint64_t() );
+      }
+
+      ////////////////////////////////
+      /// PIEOS SCO
+
+      action_result sco_stake( const account_name& owner, const asset& amount ) {
+         return push( N(pieosdistsco), N(stake), owner, mvo()( "owner", owner )( "amount", amount ) );
+      }
+
+      action_result sco_unstake( const account_name& owner, const asset& amount ) {
+         return push( N(pieosdistsco), N(unstake), owner, mvo()( "owner", owner )( "amount", amount ) );
+      }
+
+      action_result sco_withdraw( const account_name& owner, const asset& amount ) {
+         return push( N(pieosdistsco), N(withdraw), owner, mvo()( "owner", owner )( "amount", amount ) );
+      }
+
+      action_result sco_updaterex( const account_name& updater ) {
+         return push( N(pieosdistsco), N(updaterex), updater, mvo()( "updater", updater ) );
+      }
+
+      /// on-contract EOS balance of `owner` (`deposits` table)
+      asset get_sco_deposit( const account_name& owner ) {
+         const auto balance = get_row<asset>( N(pieosdistsco), owner, N(deposits), symbol( 4, "EOS" ).to_symbol_code().value );
+         return balance ? *balance : core( "0.0000" );
+      }
+   };
+
+} // namespace pieos_testing
@@ -0,0 +1,449 @@
+#include <scenario-rng.hpp>
+#include <sco-engine.hpp>
+#include <work-stealing-pool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace pieos::sim;
+
+namespace {
+
+   void usage( const char* prog ) {
+      std::fprintf( stderr,
+         "Usage: %s [OPTION...]\n"
+         "Runs randomized stake, unstake and proxy-vote timelines of the whole PIEOS SCO period through the native\n"
+         "pieosdistsco state machine in parallel, and reports the distribution of the outcomes over all scenarios\n"
+         "as JSON lines (one line per metric: mean, standard deviation and percentiles).\n\n"
+         "  --scenarios N           number of randomized timelines (default 1000)\n"
+         "  --participants N        mean number of stakers and proxy voters of a timeline (default 200)\n"
+         "  --proxy-percent P       share of the participants voting through the proxy, in percent (default 30)\n"
+         "  --rex-apr P             mean REX lending yield, in percent per year (default 4)\n"
+         "  --bp-reward-apr P       mean BP voting rewards paid for the staked and proxy-voted EOS, in percent per year (default 2)\n"
+         "  --reserve P             liquid EOS reserve target (`setreserve`), in percent of the pool value (default 0)\n"
+         "  --seed S                seed of the scenario generator (default 1)\n"
+         "  --threads N             worker threads (default: all cores)\n"
+         "  --scenario-output FILE  also write the outcome of every scenario to FILE\n"
+         "  --output FILE           write the report to FILE instead of stdout\n"
+         "  -h, --help              print this help\n", prog );
+   }
+
+   constexpr int64_t EOS = 1'0000;
+   constexpr uint32_t BLOCKS_PER_DAY = SECONDS_PER_DAY * 1000 / BLOCK_INTERVAL_MS;
+
+   struct projection_params {
+      uint32_t participants          = 200;
+      double   proxy_percent         = 30;
+      double   rex_apr_percent       = 4;
+      double   bp_reward_apr_percent = 2;
+      uint32_t reserve_percent       = 0; // 0.01%
+   };
+
+   /**
+    * @brief outcome metrics of one scenario, EOS and PIEOS amounts in whole tokens
+    */
+   struct scenario_outcome {
+      double pieos_issued               = 0;
+      double pieos_to_stakers           = 0;
+      double pieos_to_proxy_voters      = 0;
+      double pieos_unredeemed           = 0;
+      double staker_eos_profit          = 0;
+      double staker_apr_percent         = 0;
+      double proxy_voter_eos_reward     = 0;
+      double admin_fee                  = 0;
+      double pieos_per_1000_eos_day_staked = 0;
+      double pieos_per_1000_eos_day_proxy  = 0;
+      double failed_actions             = 0;
+   };
+
+   struct metric_field {
+      const char* name;
+      double scenario_outcome::* field;
+   };
+
+   const metric_field metric_fields[] = {
+      { "pieos_issued",                  &scenario_outcome::pieos_issued },
+      { "pieos_to_stakers",              &scenario_outcome::pieos_to_stakers },
+      { "pieos_to_proxy_voters",         &scenario_outcome::pieos_to_proxy_voters },
+      { "pieos_unredeemed",              &scenario_outcome::pieos_unredeemed },
+      { "staker_eos_profit",             &scenario_outcome::staker_eos_profit },
+      { "staker_apr_percent",            &scenario_outcome::staker_apr_percent },
+      { "proxy_voter_eos_reward",        &scenario_outcome::proxy_voter_eos_reward },
+      { "admin_fee",                     &scenario_outcome::admin_fee },
+      { "pieos_per_1000_eos_day_staked", &scenario_outcome::pieos_per_1000_eos_day_staked },
+      { "pieos_per_1000_eos_day_proxy",  &scenario_outcome::pieos_per_1000_eos_day_proxy },
+      { "failed_actions",                &scenario_outcome::failed_actions },
+   };
+
+   /**
+    * @brief one randomized timeline: participants join at a random day with a log-uniformly distributed amount,
+    * add to or reduce their stake (or proxy vote) now and then, compound or harvest their profits, and leave
+    * before or after the end of the SCO period. REX income and BP voting rewards are paid daily.
+    */
+   class scenario {
+   public:
+      scenario( const projection_params& params, const uint64_t seed ) : _params( params ), _rng( seed ) {}
+
+      scenario_outcome run() {
+         const auto& config = _engine.config();
+         const uint32_t sco_days = ( config.sco_end_slot - config.sco_start_slot ) / BLOCKS_PER_DAY;
+
+         // scenario-wide parameters drawn around the requested means
+         const double rex_apr = _params.rex_apr_percent / 100 * _rng.uniform( 0.5, 1.5 );
+         const double bp_reward_apr = _params.bp_reward_apr_percent / 100 * _rng.uniform( 0.5, 1.5 );
+         const uint32_t participant_count = std::max( 1u, uint32_t( _params.participants * _rng.uniform( 0.5, 1.5 ) ) );
+
+         _participants.resize( participant_count );
+         for ( uint32_t i = 0; i < participant_count; ++i ) {
+            auto& p = _participants[i];
+            p.account = account_name( i );
+            p.proxy_voter = _rng.chance( _params.proxy_percent / 100 );
+            p.join_day = _rng.uniform_int( 0, sco_days - 1 );
+            p.leave_day = _rng.chance( 0.5 ) ? _rng.uniform_int( p.join_day + 7, sco_days + 7 ) : sco_days + 7;
+         }
+
+         _engine.set_block_slot( config.sco_start_slot + 2 );
+         _engine.init();
+         const int64_t rex_lendable = int64_t( _rng.uniform( 50'000'000, 150'000'000 ) ) * EOS;
+         _engine.rex().set_pool( rex_lendable, rex_lendable * 10000 );
+         _engine.setacctype( staked_reward_account, ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_EOS_STAKED_SCO );
+         _engine.setacctype( proxy_reward_account, ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_PROXY_VOTE_SCO );
+         if ( _params.reserve_percent > 0 ) {
+            _engine.setreserve( _params.reserve_percent );
+         }
+
+         double staked_eos_days = 0, proxy_eos_days = 0;
+         for ( uint32_t day = 0; day <= sco_days + 7; ++day ) {
+            _slot = config.sco_start_slot + day * BLOCKS_PER_DAY + 2;
+
+            // daily REX income of the whole pool and BP voting rewards of the contract's vote
+            _engine.rex().add_proceeds( int64_t( double( _engine.rex().get_pool().total_lendable ) * rex_apr / 365 ) );
+            const auto& sp = _engine.state().pool;
+            act( [&] { _engine.receive_token( staked_reward_account, config.contract, int64_t( double( sp.total_staked ) * bp_reward_apr / 365 ) ); } );
+            act( [&] { _engine.receive_token( proxy_reward_account, config.contract, int64_t( double( sp.total_proxy_vote ) * bp_reward_apr / 365 ) ); } );
+
+            for ( auto& p : _participants ) {
+               if ( day < p.join_day || p.left ) {
+                  continue;
+               }
+               if ( day == p.join_day ) {
+                  join( p, day );
+               } else if ( day >= p.leave_day ) {
+                  leave( p, day );
+               } else if ( _rng.chance( 0.02 ) ) {
+                  change( p, day );
+               }
+            }
+
+            staked_eos_days += double( sp.total_staked ) / EOS;
+            proxy_eos_days += double( sp.total_proxy_vote ) / EOS;
+         }
+
+         return outcome( staked_eos_days, proxy_eos_days );
+      }
+
+   private:
+      struct participant {
+         uint64_t account     = 0;
+         bool     proxy_voter = false;
+         uint32_t join_day    = 0;
+         uint32_t leave_day   = 0;
+         uint32_t last_stake_day = 0;
+         int64_t  deposited   = 0;
+         bool     left        = false;
+      };
+
+      static constexpr uint64_t staked_reward_account = "prjrwstake"_nv;
+      static constexpr uint64_t proxy_reward_account  = "prjrwproxy"_nv;
+
+      static uint64_t account_name( uint32_t i ) {
+         static const char* charmap = "abcdefghijklmnopqrstuvwxyz12345";
+         std::string name = "prj";
+         do {
+            name.push_back( charmap[i % 31] );
+            i /= 31;
+         } while ( i > 0 );
+         return name_value( name );
+      }
+
+      /// 10 to 100000 EOS, log-uniform
+      int64_t random_amount() {
+         return int64_t( std::pow( 10.0, _rng.uniform( 1.0, 5.0 ) ) ) * EOS;
+      }
+
+      /// runs one action in its own block, a failed `check()` is counted and the timeline goes on
+      template<typename Action>
+      void act( Action&& action ) {
+         _engine.set_block_slot( _slot++ );
+         try {
+            action();
+         } catch ( const check_failure& ) {
+            ++_failed_actions;
+         }
+      }
+
+      const stake_account* account_row( const participant& p ) const {
+         auto itr = _engine.state().accounts.find( p.account );
+         return itr == _engine.state().accounts.end() ? nullptr : &itr->second;
+      }
+
+      void add_stake( participant& p, const uint32_t day, const int64_t amount ) {
+         const uint64_t contract = _engine.config().contract;
+         act( [&] {
+            _engine.receive_token( p.account, contract, amount );
+            _engine.stake( p.account, amount );
+         } );
+         p.deposited += amount;
+         p.last_stake_day = day;
+      }
+
+      /// REX bought by the last stake is mature after the 5 day maturity rounded up to a whole day
+      bool rex_matured( const participant& p, const uint32_t day ) const {
+         return day > p.last_stake_day + _engine.config().rex_maturity_days;
+      }
+
+      void join( participant& p, const uint32_t day ) {
+         if ( p.proxy_voter ) {
+            act( [&] { _engine.proxyvoted( p.account, random_amount() ); } );
+         } else {
+            add_stake( p, day, random_amount() );
+         }
+      }
+
+      void change( participant& p, const uint32_t day ) {
+         const auto* sa = account_row( p );
+         if ( !sa ) {
+            return;
+         }
+         const double r = _rng.uniform();
+         if ( p.proxy_voter ) {
+            if ( r < 0.5 ) {
+               act( [&] { _engine.harvestproxy( p.account ); } );
+            } else if ( sa->proxy_vote > 0 ) {
+               // a proxy vote change of less than 1 EOS is rejected by the contract
+               const int64_t proxy_vote = int64_t( double( sa->proxy_vote ) * _rng.uniform( 0.2, 2.0 ) ) / EOS * EOS;
+               if ( std::abs( proxy_vote - sa->proxy_vote ) > 1'0000 ) {
+                  act( [&] { _engine.proxyvoted( p.account, proxy_vote ); } );
+               }
+            }
+         } else if ( r < 0.4 ) {
+            // no stake the REX maturity would keep from being unstaked on the leave day
+            if ( day + _engine.config().rex_maturity_days < p.leave_day ) {
+               add_stake( p, day, random_amount() );
+            }
+         } else if ( r < 0.7 ) {
+            act( [&] { _engine.compound( p.account ); } );
+         } else if ( rex_matured( p, day ) && sa->staked > 0 ) {
+            const int64_t amount = std::max<int64_t>( 1, int64_t( double( sa->staked ) * _rng.uniform( 0.1, 0.9 ) ) );
+            act( [&] { _engine.unstake( p.account, amount ); } );
+         }
+      }
+
+      void leave( participant& p, const uint32_t day ) {
+         const auto* sa = account_row( p );
+         if ( p.proxy_voter ) {
+            if ( sa && sa->proxy_vote > 0 ) {
+               act( [&] { _engine.proxyvoted( p.account, 0 ); } );
+            }
+         } else if ( sa && sa->staked > 0 ) {
+            if ( !rex_matured( p, day ) ) {
+               return;
+            }
+            const int64_t staked = sa->staked;
+            act( [&] { _engine.unstake( p.account, staked ); } );
+         }
+         p.left = true;
+      }
+
+      scenario_outcome outcome( const double staked_eos_days, const double proxy_eos_days ) const {
+         const auto& st = _engine.state();
+         scenario_outcome o;
+
+         int64_t staker_pieos = 0, proxy_pieos = 0, staker_eos_out = 0, staker_eos_in = 0, proxy_eos_out = 0;
+         for ( const auto& p : _participants ) {
+            int64_t pieos = 0, eos = 0;
+            if ( const auto* sa = account_row( p ) ) {
+               pieos += sa->sco_token_bal;
+               eos += sa->core_token_bal;
+            }
+            if ( auto itr = st.sco_token_accounts.find( p.account ); itr != st.sco_token_accounts.end() ) {
+               pieos += itr->second;
+            }
+            if ( auto itr = st.core_token_received.find( p.account ); itr != st.core_token_received.end() ) {
+               eos += itr->second;
+            }
+            if ( p.proxy_voter ) {
+               proxy_pieos += pieos;
+               proxy_eos_out += eos;
+            } else {
+               staker_pieos += pieos;
+               staker_eos_out += eos;
+               staker_eos_in += p.deposited;
+            }
+         }
+
+         const auto admin_itr = st.accounts.find( _engine.config().admin_account );
+
+         o.pieos_issued           = double( st.pool.last_total_issued ) / EOS;
+         o.pieos_to_stakers       = double( staker_pieos ) / EOS;
+         o.pieos_to_proxy_voters  = double( proxy_pieos ) / EOS;
+         o.pieos_unredeemed       = double( st.pool.sco_token_unredeemed ) / EOS;
+         o.staker_eos_profit      = double( staker_eos_out - staker_eos_in ) / EOS;
+         o.staker_apr_percent     = staked_eos_days > 0 ? o.staker_eos_profit / staked_eos_days * 365 * 100 : 0;
+         o.proxy_voter_eos_reward = double( proxy_eos_out ) / EOS;
+         o.admin_fee              = admin_itr == st.accounts.end() ? 0 : double( admin_itr->second.core_token_bal ) / EOS;
+         o.pieos_per_1000_eos_day_staked = staked_eos_days > 0 ? o.pieos_to_stakers / staked_eos_days * 1000 : 0;
+         o.pieos_per_1000_eos_day_proxy  = proxy_eos_days > 0 ? o.pieos_to_proxy_voters / proxy_eos_days * 1000 : 0;
+         o.failed_actions         = double( _failed_actions );
+         return o;
+      }
+
+      const projection_params& _params;
+      scenario_rng             _rng;
+      sco_engine               _engine;
+      std::vector<participant> _participants;
+      uint32_t                 _slot = 0;
+      uint64_t                 _failed_actions = 0;
+   };
+
+   double percentile( const std::vector<double>& sorted, const double p ) {
+      if ( sorted.empty() ) {
+         return 0;
+      }
+      return sorted[ std::min( sorted.size() - 1, size_t( p * double( sorted.size() ) ) ) ];
+   }
+
+   bool parse_uint( const char* arg, const unsigned long max, uint32_t& value ) {
+      char* end = nullptr;
+      const unsigned long n = std::strtoul( arg, &end, 10 );
+      if ( *arg == '\0' || *end != '\0' || n > max ) {
+         return false;
+      }
+      value = uint32_t( n );
+      return true;
+   }
+
+   bool parse_percent( const char* arg, const double max, double& value ) {
+      char* end = nullptr;
+      const double v = std::strtod( arg, &end );
+      if ( *arg == '\0' || *end != '\0' || !( v >= 0 && v <= max ) ) {
+         return false;
+      }
+      value = v;
+      return true;
+   }
+
+}
+
+int main( int argc, char** argv ) {
+   projection_params params;
+   uint32_t scenario_count = 1000, threads = 0;
+   uint64_t seed = 1;
+   std::string output_path, scenario_output_path;
+
+   for ( int i = 1; i < argc; ++i ) {
+      const std::string arg = argv[i];
+      bool ok = true;
+      if ( arg == "-h" || arg == "--help" ) {
+         usage( argv[0] );
+         return 0;
+      } else if ( i + 1 >= argc ) {
+         ok = false;
+      } else if ( arg == "--scenarios" ) {
+         ok = parse_uint( argv[++i], 10'000'000, scenario_count ) && scenario_count > 0;
+      } else if ( arg == "--participants" ) {
+         ok = parse_uint( argv[++i], 100'000, params.participants ) && params.participants > 0;
+      } else if ( arg == "--proxy-percent" ) {
+         ok = parse_percent( argv[++i], 100, params.proxy_percent );
+      } else if ( arg == "--rex-apr" ) {
+         ok = parse_percent( argv[++i], 100, params.rex_apr_percent );
+      } else if ( arg == "--bp-reward-apr" ) {
+         ok = parse_percent( argv[++i], 100, params.bp_reward_apr_percent );
+      } else if ( arg == "--reserve" ) {
+         double reserve = 0;
+         ok = parse_percent( argv[++i], MAX_LIQUID_RESERVE_PERCENT / 100.0, reserve );
+         params.reserve_percent = uint32_t( std::lround( reserve * 100 ) );
+      } else if ( arg == "--seed" ) {
+         char* end = nullptr;
+         seed = std::strtoull( argv[++i], &end, 10 );
+         ok = *end == '\0';
+      } else if ( arg == "--threads" ) {
+         ok = parse_uint( argv[++i], 1024, threads );
+      } else if ( arg == "--scenario-output" ) {
+         scenario_output_path = argv[++i];
+      } else if ( arg == "--output" ) {
+         output_path = argv[++i];
+      } else {
+         ok = false;
+      }
+      if ( !ok ) {
+         usage( argv[0] );
+         return 1;
+      }
+   }
+
+   std::FILE* out = stdout;
+   if ( !output_path.empty() && !( out = std::fopen( output_path.c_str(), "w" ) ) ) {
+      std::fprintf( stderr, "cannot open output file %s\n", output_path.c_str() );
+      return 1;
+   }
+   std::FILE* scenario_out = nullptr;
+   if ( !scenario_output_path.empty() && !( scenario_out = std::fopen( scenario_output_path.c_str(), "w" ) ) ) {
+      std::fprintf( stderr, "cannot open output file %s\n", scenario_output_path.c_str() );
+      return 1;
+   }
+
+   work_stealing_pool pool( threads );
+   std::vector<scenario_outcome> outcomes( scenario_count );
+
+   const auto start = std::chrono::steady_clock::now();
+   pool.run( scenario_count, [&]( const size_t index, unsigned ) {
+      scenario s( params, scenario_seed( seed, index ) );
+      outcomes[index] = s.run();
+   } );
+   const double elapsed_sec = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+   if ( scenario_out ) {
+      for ( size_t i = 0; i < outcomes.size(); ++i ) {
+         std::fprintf( scenario_out, "{\"scenario\":%zu,\"seed\":%llu", i, (unsigned long long)scenario_seed( seed, i ) );
+         for ( const auto& m : metric_fields ) {
+            std::fprintf( scenario_out, ",\"%s\":%.4f", m.name, outcomes[i].*m.field );
+         }
+         std::fprintf( scenario_out, "}\n" );
+      }
+      std::fclose( scenario_out );
+   }
+
+   std::vector<double> values( outcomes.size() );
+   for ( const auto& m : metric_fields ) {
+      double sum = 0;
+      for ( size_t i = 0; i < outcomes.size(); ++i ) {
+         values[i] = outcomes[i].*m.field;
+         sum += values[i];
+      }
+      const double mean = sum / double( values.size() );
+      double variance = 0;
+      for ( const double v : values ) {
+         variance += ( v - mean ) * ( v - mean );
+      }
+      std::sort( values.begin(), values.end() );
+
+      std::fprintf( out, "{\"metric\":\"%s\",\"scenarios\":%zu,\"mean\":%.4f,\"stddev\":%.4f,\"min\":%.4f,"
+                         "\"p05\":%.4f,\"p25\":%.4f,\"p50\":%.4f,\"p75\":%.4f,\"p95\":%.4f,\"max\":%.4f}\n",
+                    m.name, values.size(), mean, std::sqrt( variance / double( values.size() ) ), values.front(),
+                    percentile( values, 0.05 ), percentile( values, 0.25 ), percentile( values, 0.50 ),
+                    percentile( values, 0.75 ), percentile( values, 0.95 ), values.back() );
+   }
+
+   if ( out != stdout ) {
+      std::fclose( out );
+   }
+
+   std::fprintf( stderr, "%u scenarios on %u threads in %.3f s\n", scenario_count, pool.size(), elapsed_sec );
+   return 0;
+}
@@ -0,0 +1,121 @@
+#include <action-trace.hpp>
+#include <sco-engine.hpp>
+#include <trace-replay.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace pieos::sim;
+
+namespace {
+
+   void usage( const char* prog ) {
+      std::fprintf( stderr,
+         "Usage: %s [OPTION...] TRACE_FILE\n"
+         "Replays recorded pieosdistsco actions and notifications against an in-memory SCO contract state\n"
+         "and prints the final stakepool and stakeaccount state as JSON.\n\n"
+         "  --summary          print the stake pool only, without stakeaccount rows\n"
+         "  --strict           stop at the first failed action\n"
+         "  --convert FILE     write the records read to FILE in the binary trace format\n"
+         "  --convert-json FILE  write the records read to FILE in the JSON lines trace format\n"
+         "  --quiet            print no state, only replay statistics\n"
+         "  -h, --help         print this help\n", prog );
+   }
+
+}
+
+int main( int argc, char** argv ) {
+   std::string trace_path, convert_path;
+   trace_writer::format convert_format = trace_writer::format::binary;
+   bool summary = false, strict = false, quiet = false;
+
+   for ( int i = 1; i < argc; ++i ) {
+      const std::string arg = argv[i];
+      if ( arg == "--summary" ) {
+         summary = true;
+      } else if ( arg == "--strict" ) {
+         strict = true;
+      } else if ( arg == "--quiet" ) {
+         quiet = true;
+      } else if ( ( arg == "--convert" || arg == "--convert-json" ) && i + 1 < argc ) {
+         convert_format = ( arg == "--convert" ) ? trace_writer::format::binary : trace_writer::format::json;
+         convert_path = argv[++i];
+      } else if ( arg == "-h" || arg == "--help" ) {
+         usage( argv[0] );
+         return 0;
+      } else if ( !arg.empty() && arg[0] != '-' && trace_path.empty() ) {
+         trace_path = arg;
+      } else {
+         usage( argv[0] );
+         return 1;
+      }
+   }
+
+   if ( trace_path.empty() ) {
+      usage( argv[0] );
+      return 1;
+   }
+
+   trace_reader reader;
+   if ( !reader.open( trace_path ) ) {
+      std::fprintf( stderr, "cannot open trace file %s\n", trace_path.c_str() );
+      return 1;
+   }
+
+   trace_writer writer;
+   if ( !convert_path.empty() && !writer.open( convert_path, convert_format ) ) {
+      std::fprintf( stderr, "cannot open output trace file %s\n", convert_path.c_str() );
+      return 1;
+   }
+
+   sco_engine engine;
+   replay_stats stats;
+   trace_record record;
+
+   const auto start = std::chrono::steady_clock::now();
+   try {
+      while ( reader.next( record ) ) {
+         ++stats.records;
+         if ( record.type < trace_type::count ) {
+            ++stats.by_type[size_t(record.type)];
+         }
+         if ( !convert_path.empty() ) {
+            writer.write( record );
+         }
+
+         try {
+            apply_trace_record( engine, record );
+         } catch ( const check_failure& e ) {
+            ++stats.failed;
+            std::fprintf( stderr, "record %llu (%s %s at %s) failed: %s\n", (unsigned long long)reader.line(),
+                          trace_type_name( record.type ), name_string( record.account ).c_str(),
+                          format_block_time( record.block_slot ).c_str(), e.what() );
+            if ( strict ) {
+               return 2;
+            }
+         }
+      }
+   } catch ( const std::exception& e ) {
+      std::fprintf( stderr, "error reading %s: %s\n", trace_path.c_str(), e.what() );
+      return 1;
+   }
+   const auto elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+   writer.close();
+
+   if ( !quiet ) {
+      write_state_json( stdout, engine, !summary );
+   }
+
+   std::fprintf( stderr, "replayed %llu records (%s) in %.3f s, %.0f records/s, %llu failed\n",
+                 (unsigned long long)stats.records, reader.is_binary() ? "binary" : "json", elapsed,
+                 elapsed > 0 ? stats.records / elapsed : 0.0, (unsigned long long)stats.failed );
+   for ( size_t t = 0; t < size_t(trace_type::count); ++t ) {
+      if ( stats.by_type[t] > 0 ) {
+         std::fprintf( stderr, "  %-12s %llu\n", trace_type_name( trace_type(t) ), (unsigned long long)stats.by_type[t] );
+      }
+   }
+
+   return stats.failed > 0 ? 2 : 0;
+}
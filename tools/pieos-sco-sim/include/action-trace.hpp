@@ -0,0 +1,152 @@
+#pragma once
+
+#include <flat-json.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace pieos::sim {
+
+   /**
+    * @brief recorded `pieosdistsco` action, transfer notification or `eosio` table change
+    *
+    * Field use by type:
+    *  - transfer     : account = from, amount = EOS quantity (eosio.token transfer notification to the contract)
+    *  - init         : -
+    *  - open         : account = owner, account2 = ram_payer
+    *  - close        : account = owner
+    *  - stake        : account = owner, amount = EOS quantity
+    *  - unstake      : account = owner, amount = EOS quantity
+    *  - compound     : account = owner
+    *  - movestake    : account = from, account2 = to, amount = EOS quantity
+    *  - proxyvoted   : account = account, amount = proxy vote EOS quantity
+    *  - harvestproxy : account = account
+    *  - withdraw     : account = owner, amount = quantity, amount2 = token (0: EOS, 1: PIEOS)
+    *  - claimvested  : account = account, amount = PIEOS quantity
+    *  - updaterex    : account = updater
+    *  - setacctype   : account = account, amount = account type
+    *  - sellram      : amount = bytes
+    *  - tokenopen    : account = owner (PIEOS token contract `open` of a user balance)
+    *  - rexpool      : amount = total_lendable, amount2 = total_rex (`eosio` `rexpool` row)
+    *  - rexincome    : amount = EOS proceeds added to the REX pool
+    *  - setmaint     : account = task, amount = interval_sec
+    *  - gc           : amount = max_rows
+    *  - setreserve   : amount = target_percent (PIEOS SCO pool)
+    *  - distribute   : amount = max_accounts
+    *  - rexfee       : amount = EOS fees channeled to REX through the return buckets (rent, name bid and RAM fees)
+    *  - rexrent      : account = from, amount = EOS loan payment (`deposit` and `rentcpu` of another account)
+    */
+   enum class trace_type : uint8_t {
+      transfer = 0,
+      init,
+      open,
+      close,
+      stake,
+      unstake,
+      compound,
+      proxyvoted,
+      harvestproxy,
+      withdraw,
+      claimvested,
+      updaterex,
+      setacctype,
+      sellram,
+      tokenopen,
+      rexpool,
+      rexincome,
+      setmaint,
+      gc,
+      setreserve,
+      movestake,
+      distribute,
+      rexfee,
+      rexrent,
+      count
+   };
+
+   const char* trace_type_name( const trace_type type );
+   bool trace_type_from_name( std::string_view name, trace_type& type );
+
+   /**
+    * @brief fixed-size binary trace record, the unit of the binary trace format
+    *
+    * A binary trace file is a `trace_file_header` followed by `trace_record`s, little-endian.
+    */
+   struct trace_record {
+      uint32_t   block_slot = 0; // block timestamp slot
+      trace_type type       = trace_type::transfer;
+      uint8_t    reserved[3] = { 0, 0, 0 };
+      uint64_t   account    = 0;
+      uint64_t   account2   = 0;
+      int64_t    amount     = 0;
+      int64_t    amount2    = 0;
+   };
+   static_assert( sizeof(trace_record) == 40, "trace_record layout" );
+
+   struct trace_file_header {
+      char     magic[8]    = { 'P', 'S', 'C', 'O', 'T', 'R', 'C', '1' };
+      uint32_t version     = 1;
+      uint32_t record_size = sizeof(trace_record);
+   };
+   static_assert( sizeof(trace_file_header) == 16, "trace_file_header layout" );
+
+   /**
+    * @brief reads a trace file in either format
+    *
+    * The binary format is detected by its header magic, anything else is read as JSON lines, one flat object per line:
+    *
+    *    {"time":"2020-07-15T00:00:00.500","act":"stake","owner":"alice","amount":"10.0000 EOS"}
+    *
+    * `time` (ISO-8601 UTC block time) or `slot` (block timestamp slot) sets the block time.
+    * Account keys are `account`, `owner`, `from`, `updater` or `task`, and `ram_payer`;
+    * quantity keys are `amount`, `quantity`, `proxy_vote`, `bytes`, `type`, `interval_sec`, `total_lendable`, `total_rex`.
+    */
+   class trace_reader {
+   public:
+      trace_reader() = default;
+      ~trace_reader();
+      trace_reader( const trace_reader& ) = delete;
+      trace_reader& operator=( const trace_reader& ) = delete;
+
+      /// @return false if the file cannot be opened
+      bool open( const std::string& path );
+
+      /// @return false at end of file, throws std::runtime_error on a malformed record
+      bool next( trace_record& record );
+
+      bool is_binary() const { return _binary; }
+      uint64_t line() const { return _line; }
+
+   private:
+      bool parse_json_line( std::string_view line, trace_record& record );
+
+      std::FILE*  _file   = nullptr;
+      bool        _binary = false;
+      uint64_t    _line   = 0;
+      std::string _buffer;
+   };
+
+   /**
+    * @brief writes trace records in the binary or the JSON lines format
+    */
+   class trace_writer {
+   public:
+      enum class format { binary, json };
+
+      trace_writer() = default;
+      ~trace_writer();
+      trace_writer( const trace_writer& ) = delete;
+      trace_writer& operator=( const trace_writer& ) = delete;
+
+      bool open( const std::string& path, const format fmt );
+      void write( const trace_record& record );
+      void close();
+
+   private:
+      std::FILE* _file = nullptr;
+      format     _format = format::binary;
+   };
+
+} // namespace pieos::sim
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace pieos::sim {
+
+   /**
+    * @brief native encoding of EOSIO account names (base32, up to 13 characters) to the 64-bit `name` value
+    *
+    * @return encoded name value, or 0 for an empty or invalid name
+    */
+   constexpr uint64_t name_value( std::string_view str ) {
+      if ( str.size() > 13 ) {
+         return 0;
+      }
+
+      auto char_to_value = []( char c ) -> uint64_t {
+         if ( c == '.' ) return 0;
+         if ( c >= '1' && c <= '5' ) return uint64_t( c - '1' ) + 1;
+         if ( c >= 'a' && c <= 'z' ) return uint64_t( c - 'a' ) + 6;
+         return 0xff;
+      };
+
+      uint64_t value = 0;
+      for ( size_t i = 0; i < str.size(); ++i ) {
+         const uint64_t v = char_to_value( str[i] );
+         if ( v == 0xff ) {
+            return 0;
+         }
+         if ( i < 12 ) {
+            value |= ( v & 0x1f ) << ( 64 - 5 * ( i + 1 ) );
+         } else {
+            if ( v > 0x0f ) {
+               return 0;
+            }
+            value |= v & 0x0f;
+         }
+      }
+      return value;
+   }
+
+   /**
+    * @brief decodes a 64-bit `name` value to its string form
+    */
+   inline std::string name_string( uint64_t value ) {
+      static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+      std::string str( 13, '.' );
+
+      uint64_t tmp = value;
+      for ( uint32_t i = 0; i <= 12; ++i ) {
+         const char c = charmap[ tmp & ( i == 0 ? 0x0f : 0x1f ) ];
+         str[12 - i] = c;
+         tmp >>= ( i == 0 ? 4 : 5 );
+      }
+
+      const auto last = str.find_last_not_of( '.' );
+      str.resize( last == std::string::npos ? 0 : last + 1 );
+      return str;
+   }
+
+   constexpr uint64_t operator""_nv( const char* s, size_t n ) {
+      return name_value( std::string_view( s, n ) );
+   }
+
+} // namespace pieos::sim
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace pieos::sim {
+
+   ///////////////////////////////////
+   /// scalar values of JSON lines traces and table dumps
+
+   /// "2020-07-15T00:00:00.500" (ISO-8601 UTC block time) -> block timestamp slot
+   bool parse_block_time( std::string_view s, uint32_t& slot );
+
+   bool parse_int( std::string_view s, int64_t& out );
+
+   /// "10.0000 EOS" -> 100000, "EOS"; a plain integer has no symbol
+   bool parse_amount( std::string_view s, int64_t& amount, std::string_view& symbol );
+
+   /// "10.0000 EOS" style formatting of a 4-decimal amount
+   std::string format_amount( const int64_t amount, std::string_view symbol );
+
+   /// ISO-8601 UTC time of a block timestamp slot, "2020-07-15T00:00:00.500"
+   std::string format_block_time( const uint32_t slot );
+
+   namespace detail {
+
+      inline void skip_ws( std::string_view s, size_t& i ) {
+         while ( i < s.size() && ( s[i] == ' ' || s[i] == '\t' || s[i] == '\r' ) ) ++i;
+      }
+
+      // reads a JSON string (no escapes in names, symbols or times), a bare scalar or a nested value
+      inline bool read_value( std::string_view s, size_t& i, std::string_view& out ) {
+         skip_ws( s, i );
+         if ( i >= s.size() ) return false;
+         if ( s[i] == '"' ) {
+            const auto end = s.find( '"', i + 1 );
+            if ( end == std::string_view::npos ) return false;
+            out = s.substr( i + 1, end - i - 1 );
+            i = end + 1;
+            return true;
+         }
+         const size_t start = i;
+         if ( s[i] == '[' || s[i] == '{' ) {
+            // nested array or object, returned as raw text
+            int depth = 0;
+            bool in_string = false;
+            for ( ; i < s.size(); ++i ) {
+               if ( in_string ) {
+                  if ( s[i] == '"' ) in_string = false;
+               } else if ( s[i] == '"' ) {
+                  in_string = true;
+               } else if ( s[i] == '[' || s[i] == '{' ) {
+                  ++depth;
+               } else if ( ( s[i] == ']' || s[i] == '}' ) && --depth == 0 ) {
+                  ++i;
+                  break;
+               }
+            }
+            out = s.substr( start, i - start );
+            return depth == 0;
+         }
+         while ( i < s.size() && s[i] != ',' && s[i] != '}' && s[i] != ' ' ) ++i;
+         out = s.substr( start, i - start );
+         return !out.empty();
+      }
+
+   } // namespace detail
+
+   /**
+    * @brief parses one flat JSON object line, `on_field( key, value )` is called for each field in order
+    *
+    * Nested objects and arrays are passed to `on_field` as raw text, string escapes are not decoded.
+    * `on_field` returns nullptr to continue or an error message to stop.
+    *
+    * @return nullptr on success or the error message; `blank` is set for an empty line
+    */
+   template<typename OnField>
+   const char* parse_flat_json_object( std::string_view s, bool& blank, OnField&& on_field ) {
+      size_t i = 0;
+      detail::skip_ws( s, i );
+      blank = ( i >= s.size() || s[i] == '\n' );
+      if ( blank ) {
+         return nullptr;
+      }
+
+      if ( s[i] != '{' ) return "expected JSON object";
+      ++i;
+
+      while ( true ) {
+         detail::skip_ws( s, i );
+         if ( i < s.size() && s[i] == '}' ) break;
+
+         std::string_view key, value;
+         if ( !detail::read_value( s, i, key ) ) return "expected key";
+         detail::skip_ws( s, i );
+         if ( i >= s.size() || s[i] != ':' ) return "expected ':'";
+         ++i;
+         if ( !detail::read_value( s, i, value ) ) return "expected value";
+
+         if ( const char* error = on_field( key, value ) ) {
+            return error;
+         }
+
+         detail::skip_ws( s, i );
+         if ( i < s.size() && s[i] == ',' ) { ++i; continue; }
+         if ( i < s.size() && s[i] == '}' ) break;
+         return "expected ',' or '}'";
+      }
+      return nullptr;
+   }
+
+} // namespace pieos::sim
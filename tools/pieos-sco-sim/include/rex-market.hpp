@@ -0,0 +1,173 @@
+#pragma once
+
+#include <sco-state.hpp>
+
+#include <pieos-rex-math.hpp>
+#include <pieos-sco-math.hpp>
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+namespace pieos::sim {
+
+   /**
+    * @brief emulator of the `eosio` REX market (`rexpool`, `rexretpool`, `retbuckets`, `rexfund`, `rexbal`,
+    * `rexqueue`, `cpuloan`/`netloan`) for any number of accounts
+    *
+    * The actions follow the system contract's `deposit`, `withdraw`, `buyrex`, `sellrex`, `updaterex`, `runrex`
+    * and `rentcpu`, using the shared REX arithmetic (pieos-rex-math.hpp): proceeds channeled to REX are
+    * distributed through the 12 hour return buckets over 30 days, bought REX matures in REX maturity buckets,
+    * a `sellrex` the available unlent EOS cannot cover is queued and filled by later `runrex` calls in order time,
+    * and expired loans return their EOS to the pool.
+    * CPU and NET loans share one loan table, voting requirements and resource limits are not modeled.
+    *
+    * The pool totals can be overwritten from recorded `rexpool` table deltas, so that REX profits earned
+    * on chain are reflected in the replayed valuation.
+    */
+   class rex_market {
+   public:
+      using pool = rex_math::pool;
+
+      struct order {
+         int64_t  rex_requested = 0;
+         int64_t  proceeds      = 0;
+         int64_t  stake_change  = 0;
+         uint32_t order_time    = 0;
+         bool     is_open       = true;
+      };
+
+      struct loan {
+         uint64_t from         = 0;
+         int64_t  total_staked = 0;
+      };
+
+      /// current time (seconds since epoch) of the REX actions
+      uint32_t now() const { return _now; }
+      void set_time( const uint32_t now ) { _now = now; }
+
+      const pool& get_pool() const { return _pool; }
+      const rex_math::return_state& return_state() const { return _ret; }
+      const std::map<uint64_t, rex_math::balance>& balances() const { return _balances; }
+      const std::map<uint64_t, order>& orders() const { return _orders; }
+      size_t open_order_count() const { return _open_orders.size(); }
+      size_t loan_count() const { return _loans.size(); }
+
+      /**
+       * @brief overwrites the REX pool totals from a recorded `rexpool` table row,
+       * the rent connector of a new pool starts at the system contract's initial balance
+       */
+      void set_pool( const int64_t total_lendable, const int64_t total_rex );
+
+      /**
+       * @brief restores the pool totals and `owner`'s REX fund and (matured) REX balance, e.g. from a snapshot
+       */
+      void restore( const pool& p, const uint64_t owner, const int64_t fund, const int64_t rex );
+
+      /**
+       * @brief adds REX proceeds to the lendable pool at once, bypassing the return buckets
+       */
+      void add_proceeds( const int64_t amount ) {
+         _pool.total_lendable += amount;
+         _pool.total_unlent   += amount;
+      }
+
+      /**
+       * @brief channels fees (rent, name bids, ram fees) to REX through the return buckets (`channel_to_rex`)
+       */
+      void channel_to_rex( const int64_t amount ) {
+         rex_math::add_to_rex_return_pool( _pool, _ret, amount, _now );
+      }
+
+      /// `rexfund` of `owner`, including the proceeds of its filled sell order (see `get_rex_fund_balance`)
+      int64_t fund_balance( const uint64_t owner ) const;
+      /// `rexbal` of `owner`
+      int64_t rex_balance( const uint64_t owner ) const;
+      /// REX of `owner` that can be sold now
+      int64_t matured_rex( const uint64_t owner ) const;
+
+      /// number of `deposit`, `withdraw`, `buyrex`, `sellrex`, `updaterex`, `runrex` and `rentcpu` actions received
+      uint64_t action_count() const { return _actions; }
+
+      /// mirror of `calc_rex_pool_lendable_change_amount`
+      int64_t lendable_change_amount() const {
+         return rex_math::lendable_change_amount( _ret, _now );
+      }
+
+      int64_t rex_to_core_token( const int64_t rex, const int64_t lendable_change_amount ) const {
+         if ( _pool.total_rex == 0 ) {
+            return 0;
+         }
+         return sco_math::rex_to_core_token( rex, _pool.total_lendable + lendable_change_amount, _pool.total_rex );
+      }
+
+      /// mirror of `core_token_to_rex_balance`
+      int64_t core_token_to_rex( const int64_t core_token, const int64_t lendable_change_amount ) const {
+         if ( _pool.total_rex == 0 ) {
+            return core_token * rex_math::REX_RATIO;
+         }
+         return sco_math::core_token_to_rex( core_token, _pool.total_lendable + lendable_change_amount, _pool.total_rex );
+      }
+
+      int64_t total_rex_to_core_token( const uint64_t owner ) const {
+         const int64_t rex = rex_balance( owner );
+         if ( rex <= 0 ) {
+            return 0;
+         }
+         return rex_to_core_token( rex, lendable_change_amount() );
+      }
+
+      /// mirror of `get_rex_available_unlent`, EOS a new `sellrex` order can be filled with immediately
+      int64_t available_unlent( const int64_t lendable_change_amount ) const;
+
+      /// `owner`'s open `rexqueue` order
+      bool has_open_order( const uint64_t owner ) const {
+         auto itr = _orders.find( owner );
+         return itr != _orders.end() && itr->second.is_open;
+      }
+
+      ///////////////////////////////////
+      /// `eosio` REX actions
+
+      void deposit( const uint64_t owner, const int64_t amount );
+      void withdraw( const uint64_t owner, const int64_t amount );
+      void buyrex( const uint64_t from, const int64_t amount );
+
+      /**
+       * @return EOS proceeds added to the REX fund, zero if the order was queued
+       */
+      int64_t sellrex( const uint64_t from, const int64_t rex );
+
+      void updaterex( const uint64_t owner );
+
+      /**
+       * @brief distributes the return buckets, returns expired loans and fills open sell orders, up to `max` of each
+       */
+      void runrex( const uint16_t max );
+
+      /**
+       * @brief rents EOS of the pool for `payment` from `from`'s REX fund, the loan expires in 30 days
+       * @return EOS lent
+       */
+      int64_t rentcpu( const uint64_t from, const int64_t payment );
+
+   private:
+      void update_rex_pool() { rex_math::update_rex_pool( _pool, _ret, _now ); }
+      void transfer_from_fund( const uint64_t owner, const int64_t amount );
+      /// moves the proceeds of `owner`'s filled sell order to the REX fund, returns the REX of its open order
+      int64_t update_rex_account( const uint64_t owner, const int64_t proceeds );
+      bool rex_loans_available() const { return _pool.total_rex > 0 && _open_orders.empty(); }
+
+      pool                                  _pool;
+      rex_math::return_state                _ret;
+      std::map<uint64_t, int64_t>           _funds;
+      std::map<uint64_t, rex_math::balance> _balances;
+      std::map<uint64_t, order>             _orders;
+      std::set<std::pair<uint32_t, uint64_t>> _open_orders;  // (order time, owner), `rexqueue` `bytime` index
+      std::multimap<uint32_t, loan>         _loans;        // expiration => loan, `byexpr` index
+      uint32_t _now     = 0;
+      uint64_t _actions = 0;
+   };
+
+} // namespace pieos::sim
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pieos::sim {
+
+   /**
+    * @brief splitmix64 generator, cheap to seed per scenario so that every scenario only depends on (seed, index)
+    * and the results do not depend on the thread count or the scheduling
+    */
+   class scenario_rng {
+   public:
+      explicit scenario_rng( const uint64_t seed ) : _state( seed ) {}
+
+      uint64_t next() {
+         uint64_t z = ( _state += 0x9e3779b97f4a7c15ull );
+         z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+         z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+         return z ^ ( z >> 31 );
+      }
+
+      /// uniform in [0, 1)
+      double uniform() { return double( next() >> 11 ) * ( 1.0 / 9007199254740992.0 ); }
+      double uniform( const double lo, const double hi ) { return lo + ( hi - lo ) * uniform(); }
+      uint32_t uniform_int( const uint32_t lo, const uint32_t hi ) { return lo + uint32_t( next() % ( uint64_t( hi - lo ) + 1 ) ); }
+      bool chance( const double p ) { return uniform() < p; }
+
+   private:
+      uint64_t _state;
+   };
+
+   /// seed of the `index`-th independent stream of `seed`
+   inline uint64_t scenario_seed( const uint64_t seed, const uint64_t index ) {
+      scenario_rng rng( seed ^ ( index * 0xd1b54a32d192ed03ull ) );
+      return rng.next();
+   }
+
+} // namespace pieos::sim
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <sco-state.hpp>
+#include <rex-market.hpp>
+
+#include <cstdint>
+
+namespace pieos::sim {
+
+   /**
+    * @brief native PIEOS SCO(Stake-Coin-Offering) contract state machine
+    *
+    * Each public action method mirrors the action of the same name in
+    * contracts/pieos-stake-coin-offering/src/pieos-stake-coin-offering.cpp, using the contract's share
+    * and issuance arithmetic (pieos-sco-math.hpp). Inline actions sent by the contract are applied
+    * to the `eosio` REX stand-in and the token balances at once.
+    * Authorization is not checked, recorded actions were already authorized on chain.
+    * A failed contract `check()` throws `check_failure` and leaves the state partially updated,
+    * callers replaying recorded (successful) actions treat it as divergence.
+    */
+   class sco_engine {
+   public:
+      enum class token : uint8_t { core = 0, sco = 1 };
+
+      explicit sco_engine( const sco_config& config = sco_config() ) : _config( config ) {}
+
+      const sco_config& config() const { return _config; }
+      const sco_state& state() const { return _state; }
+      sco_state& state() { return _state; }
+      const rex_market& rex() const { return _rex; }
+      rex_market& rex() { return _rex; }
+
+      /// current block timestamp slot
+      uint32_t block_slot() const { return _block_slot; }
+      void set_block_slot( const uint32_t slot ) {
+         _block_slot = slot;
+         _rex.set_time( block_slot_to_sec( slot ) );
+      }
+
+      /// number of inline actions sent by the contract (token `issue`/`transfer`, `eosio` REX, `updaterex` and receipt actions)
+      uint64_t inline_action_count() const { return _inline_actions + _rex.action_count(); }
+
+      ///////////////////////////////////
+      /// contract actions
+
+      void receive_token( const uint64_t from, const uint64_t to, const int64_t quantity );
+      void init();
+      void open( const uint64_t owner, const uint64_t ram_payer );
+      void close( const uint64_t owner );
+      void stake( const uint64_t owner, const int64_t amount );
+      void unstake( const uint64_t owner, const int64_t amount );
+      void compound( const uint64_t owner );
+      void movestake( const uint64_t from, const uint64_t to, const int64_t amount );
+      void proxyvoted( const uint64_t account, const int64_t proxy_vote );
+      void harvestproxy( const uint64_t account );
+      void withdraw( const uint64_t owner, const token sym, const int64_t amount );
+      void claimvested( const uint64_t account, const int64_t amount );
+      void updaterex( const uint64_t updater );
+      void setmaint( const uint64_t task, const uint32_t interval_sec );
+      void setreserve( const uint32_t target_percent );
+      void gc( const uint32_t max_rows );
+      void distribute( const uint32_t max_accounts );
+      void setacctype( const uint64_t account, const uint32_t type );
+      void sellram( const int64_t bytes );
+
+      ///////////////////////////////////
+      /// external chain state
+
+      /// `open` of a PIEOS token balance row by a user on the PIEOS token contract
+      void open_sco_token_account( const uint64_t owner );
+
+   private:
+      struct unstake_core_token_outcome {
+         int64_t staked_and_profit_redeemed = 0;
+         int64_t token_earned               = 0;
+         int64_t rex_to_sell                = 0;
+         int64_t rex_sold_core_token        = 0;
+         sco_math::unstake_settlement settlement = sco_math::unstake_settlement::liquid;
+         int64_t reserve_refill             = 0;
+      };
+
+      struct compound_core_token_outcome {
+         int64_t staking_profit  = 0;
+         int64_t contract_profit = 0;
+         int64_t compounded      = 0;
+      };
+
+      struct unstake_by_proxy_outcome {
+         int64_t proxy_vote_profit_redeemed = 0;
+         int64_t token_earned               = 0;
+      };
+
+      void add_on_contract_token_balance( const uint64_t owner, const token sym, const int64_t value, const uint64_t ram_payer );
+      void sub_on_contract_token_balance( const uint64_t owner, const token sym, const int64_t value );
+
+      bool is_account_type( const uint64_t account, const uint32_t account_type ) const;
+      void check_staking_allowed_account( const uint64_t account ) const;
+      bool is_sco_token_account_open( const uint64_t account ) const;
+
+      int64_t get_total_core_token_amount_for_staked() const;
+
+      struct gc_outcome {
+         uint32_t rows_visited = 0;
+         uint32_t rows_erased  = 0;
+         int64_t  bytes_freed  = 0;
+      };
+
+      static bool is_empty_stake_account( const stake_account& sa );
+      void track_contract_paid_row( const uint64_t owner );
+      void track_staker( const uint64_t owner );
+      gc_outcome collect_contract_paid_rows( const uint32_t max_rows );
+
+      bool is_maintenance_task( const uint64_t task ) const;
+      void run_scheduled_maintenance();
+      void run_maintenance_task( const uint64_t task );
+      void set_maintenance_task_run( const uint64_t task );
+
+      void stake_core_token( const uint64_t owner, const int64_t stake );
+      unstake_core_token_outcome unstake_core_token( const uint64_t owner, const int64_t unstake_amount );
+      compound_core_token_outcome compound_core_token( const uint64_t owner );
+      void stake_by_proxy_vote( const uint64_t account, const int64_t stake_proxy_vote_amount );
+      unstake_by_proxy_outcome unstake_by_proxy_vote( const uint64_t account, const int64_t unstake_proxy_vote_amount );
+      unstake_by_proxy_outcome harvest_proxy_vote_profit( const uint64_t account );
+      void transfer_proxy_vote_outcome( const uint64_t account, const unstake_by_proxy_outcome& outcome );
+
+      void issue_accrued_SCO_token();
+
+      /// inline token actions sent by the contract
+      void transfer_core_token( const uint64_t to, const int64_t quantity );
+      void transfer_sco_token( const uint64_t to, const int64_t quantity );
+      void issue_sco_token( const int64_t quantity );
+      /// receipt action (`stakelog`, `proxylog`, `issuelog`, `settlelog`, `balancelog`) sent by the contract to itself
+      void send_receipt() { ++_inline_actions; }
+
+      uint32_t rex_maturity_sec( const uint32_t buyrex_slot ) const;
+      int64_t matured_stake( stake_account& sa ) const;
+      void open_stake_lots( stake_account& sa ) const;
+
+      sco_config _config;
+      sco_state  _state;
+      rex_market _rex;
+      uint32_t   _block_slot = 0;
+      uint64_t   _inline_actions = 0;
+   };
+
+} // namespace pieos::sim
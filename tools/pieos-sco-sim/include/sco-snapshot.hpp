@@ -0,0 +1,215 @@
+#pragma once
+
+#include <sco-engine.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pieos::sim {
+
+   /**
+    * @brief fixed-layout, memory-mappable snapshot of the SCO contract and PIEOS token tables
+    *
+    * File layout (little-endian, all records 8-byte aligned):
+    *
+    *    snapshot_header
+    *    section[0] records ... section[n] records   (each section starts on a 64-byte boundary)
+    *
+    * The header holds the offset, record count and record size of every section. Records of the
+    * multi-row sections are sorted by their account name value, so a loader can binary search them
+    * in place; names sort the same way as their string form.
+    * `checksum` is the 64-bit FNV-1a hash of everything after the header.
+    */
+   enum class snapshot_section : uint32_t {
+      stake_pool = 0,   // `stakepool`, 1 record, none before `init`
+      stake_account,    // `stakeaccount`, one record per scope
+      reserved,         // `reserved`, one record per scope
+      account_type,     // `acctype`, one record per scope
+      token_account,    // PIEOS token `accounts`, one record per scope, including the SCO contract
+      token_stat,       // PIEOS token `stat`, 1 record, none before the token is created
+      eosio_state,      // `eosio` REX pool and the SCO contract's EOS, REX fund and REX balances, 1 record
+      liquid_reserve,   // `liqreserve` of the PIEOS SCO pool, 1 record, none if not set
+      count
+   };
+
+   struct snapshot_section_entry {
+      uint64_t offset      = 0; // from the start of the file
+      uint64_t count       = 0;
+      uint32_t record_size = 0;
+      uint32_t reserved    = 0;
+   };
+   static_assert( sizeof(snapshot_section_entry) == 24, "snapshot_section_entry layout" );
+
+   struct snapshot_header {
+      char     magic[8]       = { 'P', 'S', 'C', 'O', 'S', 'N', 'P', '1' };
+      uint32_t version        = 2;
+      uint32_t header_size    = sizeof(snapshot_header);
+      uint32_t block_slot     = 0; // block timestamp slot of the snapshot state
+      uint32_t section_count  = uint32_t(snapshot_section::count);
+      uint64_t contract       = 0; // SCO contract account
+      uint64_t token_contract = 0; // PIEOS token contract account
+      uint64_t file_size      = 0;
+      uint64_t checksum       = 0;
+      snapshot_section_entry sections[size_t(snapshot_section::count)];
+   };
+   static_assert( sizeof(snapshot_header) == 56 + 24 * size_t(snapshot_section::count), "snapshot_header layout" );
+
+   struct snapshot_stake_pool {
+      int64_t  total_staked               = 0;
+      int64_t  total_staked_share         = 0;
+      int64_t  core_token_for_staked      = 0;
+      int64_t  total_proxy_vote           = 0;
+      int64_t  total_proxy_vote_share     = 0;
+      int64_t  core_token_for_proxy_vote  = 0;
+      int64_t  total_token_share          = 0;
+      int64_t  sco_token_unredeemed       = 0;
+      int64_t  last_total_issued          = 0;
+      uint32_t last_issue_time            = 0;
+      uint32_t padding                    = 0;
+   };
+   static_assert( sizeof(snapshot_stake_pool) == 80, "snapshot_stake_pool layout" );
+
+   struct snapshot_stake_account {
+      uint64_t owner             = 0;
+      int64_t  core_token_bal    = 0;
+      int64_t  sco_token_bal     = 0;
+      int64_t  staked            = 0;
+      int64_t  staked_share      = 0;
+      int64_t  proxy_vote        = 0;
+      int64_t  proxy_vote_share  = 0;
+      int64_t  token_share       = 0;
+      uint32_t last_stake_time   = 0;
+      uint32_t padding           = 0;
+      uint64_t ram_payer         = 0;
+   };
+   static_assert( sizeof(snapshot_stake_account) == 80, "snapshot_stake_account layout" );
+
+   struct snapshot_reserved {
+      uint64_t owner  = 0;
+      int64_t  issued = 0;
+   };
+
+   struct snapshot_account_type {
+      uint64_t account  = 0;
+      uint32_t acc_type = 0;
+      uint32_t padding  = 0;
+   };
+
+   struct snapshot_token_account {
+      uint64_t owner   = 0;
+      int64_t  balance = 0;
+   };
+
+   struct snapshot_token_stat {
+      int64_t  supply     = 0;
+      int64_t  max_supply = 0; // 0 if not known to the exporter
+      uint64_t issuer     = 0;
+   };
+
+   struct snapshot_eosio_state {
+      int64_t contract_core_token_balance = 0; // eosio.token EOS balance of the SCO contract
+      int64_t rex_fund                    = 0; // `rexfund` of the SCO contract
+      int64_t rex_balance                 = 0; // `rexbal` of the SCO contract
+      int64_t total_lent                  = 0; // `rexpool`
+      int64_t total_unlent                = 0;
+      int64_t total_rent                  = 0;
+      int64_t total_lendable              = 0;
+      int64_t total_rex                   = 0;
+   };
+   static_assert( sizeof(snapshot_eosio_state) == 64, "snapshot_eosio_state layout" );
+
+   struct snapshot_liquid_reserve {
+      int64_t  balance        = 0;
+      uint32_t target_percent = 0;
+      uint32_t padding        = 0;
+   };
+   static_assert( sizeof(snapshot_liquid_reserve) == 16, "snapshot_liquid_reserve layout" );
+
+   /**
+    * @brief read-only view of the records of one snapshot section
+    */
+   template<typename T>
+   struct snapshot_rows {
+      const T* data  = nullptr;
+      size_t   count = 0;
+
+      const T* begin() const { return data; }
+      const T* end() const { return data + count; }
+      size_t size() const { return count; }
+      bool empty() const { return count == 0; }
+      const T& operator[]( const size_t i ) const { return data[i]; }
+
+      /// binary search by the first (account name) field
+      const T* find( const uint64_t key ) const {
+         const T* itr = std::lower_bound( begin(), end(), key, []( const T& row, const uint64_t k ) {
+            return *reinterpret_cast<const uint64_t*>( &row ) < k;
+         } );
+         return ( itr != end() && *reinterpret_cast<const uint64_t*>( itr ) == key ) ? itr : nullptr;
+      }
+   };
+
+   /**
+    * @brief writes the engine state as a snapshot file
+    *
+    * @return false if the file cannot be written
+    */
+   bool write_snapshot( const std::string& path, const sco_engine& engine );
+
+   /**
+    * @brief memory-maps a snapshot file read-only
+    *
+    * Opening validates the header and the section bounds only, it does not touch the records;
+    * `verify_checksum()` reads the whole file.
+    */
+   class snapshot_view {
+   public:
+      snapshot_view() = default;
+      ~snapshot_view();
+      snapshot_view( const snapshot_view& ) = delete;
+      snapshot_view& operator=( const snapshot_view& ) = delete;
+
+      /// @return false if the file cannot be opened, throws std::runtime_error on an invalid snapshot
+      bool open( const std::string& path );
+      void close();
+
+      bool verify_checksum() const;
+
+      const snapshot_header& header() const { return *reinterpret_cast<const snapshot_header*>( _base ); }
+      uint32_t block_slot() const { return header().block_slot; }
+
+      /// @return nullptr if the table row does not exist
+      const snapshot_stake_pool* stake_pool() const { return single<snapshot_stake_pool>( snapshot_section::stake_pool ); }
+      const snapshot_token_stat* token_stat() const { return single<snapshot_token_stat>( snapshot_section::token_stat ); }
+      const snapshot_liquid_reserve* liquid_reserve() const { return single<snapshot_liquid_reserve>( snapshot_section::liquid_reserve ); }
+      const snapshot_eosio_state& eosio_state() const { return *rows<snapshot_eosio_state>( snapshot_section::eosio_state ).data; }
+
+      snapshot_rows<snapshot_stake_account> stake_accounts() const { return rows<snapshot_stake_account>( snapshot_section::stake_account ); }
+      snapshot_rows<snapshot_reserved> reserved() const { return rows<snapshot_reserved>( snapshot_section::reserved ); }
+      snapshot_rows<snapshot_account_type> account_types() const { return rows<snapshot_account_type>( snapshot_section::account_type ); }
+      snapshot_rows<snapshot_token_account> token_accounts() const { return rows<snapshot_token_account>( snapshot_section::token_account ); }
+
+   private:
+      template<typename T>
+      snapshot_rows<T> rows( const snapshot_section section ) const {
+         const auto& s = header().sections[size_t(section)];
+         return { reinterpret_cast<const T*>( _base + s.offset ), size_t( s.count ) };
+      }
+
+      template<typename T>
+      const T* single( const snapshot_section section ) const {
+         const auto r = rows<T>( section );
+         return r.empty() ? nullptr : r.data;
+      }
+
+      const uint8_t* _base = nullptr;
+      size_t         _size = 0;
+   };
+
+   /**
+    * @brief restores the engine state from a snapshot, so that a replay can continue from it
+    */
+   void load_snapshot( const snapshot_view& snapshot, sco_engine& engine );
+
+} // namespace pieos::sim
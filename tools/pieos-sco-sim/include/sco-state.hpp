@@ -0,0 +1,177 @@
+#pragma once
+
+#include <eosio-name.hpp>
+#include <pieos-sco-math.hpp>
+
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pieos::sim {
+
+   /**
+    * @brief failed `check()` of a simulated contract action, carries the same message as the on-chain assertion
+    */
+   class check_failure : public std::runtime_error {
+   public:
+      using std::runtime_error::runtime_error;
+   };
+
+   inline void check( bool pred, const char* msg ) {
+      if ( !pred ) {
+         throw check_failure( msg );
+      }
+   }
+
+   ///////////////////////////////////
+   /// block time
+
+   static constexpr int64_t BLOCK_TIMESTAMP_EPOCH_MS = 946684800000ll; // 2000-01-01T00:00:00.000
+   static constexpr int64_t BLOCK_INTERVAL_MS        = 500;
+   static constexpr uint32_t SECONDS_PER_DAY         = 24 * 3600;
+
+   constexpr uint32_t block_slot_from_sec( const uint32_t sec ) {
+      return uint32_t( ( int64_t(sec) * 1000 - BLOCK_TIMESTAMP_EPOCH_MS ) / BLOCK_INTERVAL_MS );
+   }
+
+   constexpr uint32_t block_slot_to_sec( const uint32_t slot ) {
+      return uint32_t( ( int64_t(slot) * BLOCK_INTERVAL_MS + BLOCK_TIMESTAMP_EPOCH_MS ) / 1000 );
+   }
+
+   /**
+    * @brief native mirror of the PIEOS SCO contract's account names and distribution schedule
+    * (contracts/include/pieos.hpp and the pieos_sco class constants), adjustable for what-if runs
+    */
+   struct sco_config {
+      uint64_t contract                     = "pieosdistsco"_nv;
+      uint64_t token_contract               = "pieostokenct"_nv;
+      uint64_t proxy_voting_account         = "pieosproxy11"_nv;
+      uint64_t admin_account                = "pieosadminac"_nv;
+      uint64_t stability_fund_account       = "pieosstbfund"_nv;
+      uint64_t marketing_operation_account  = "pieosmarketi"_nv;
+      uint64_t development_team_account     = "pieosdevteam"_nv;
+      uint64_t rex_fund_account             = "eosio.rex"_nv;
+      uint64_t rex_ram_fund_account         = "eosio.ram"_nv;
+
+      uint32_t sco_start_slot = block_slot_from_sec( 1594771200 ); // July 15, 2020 12:00:00 AM (GMT)
+      uint32_t sco_end_slot   = block_slot_from_sec( 1626307200 ); // July 15, 2021 12:00:00 AM (GMT)
+
+      int64_t dist_stake_coin_offering      = 128'000'000'0000ll;
+      int64_t dist_stability_fund           = 18'000'000'0000ll;
+      int64_t dist_marketing_operation_fund = 18'000'000'0000ll;
+      int64_t dist_development_team         = 36'000'000'0000ll;
+
+      uint32_t rex_maturity_days = 5;
+   };
+
+   static constexpr uint32_t ACCOUNT_TYPE_NORMAL_USER_ACCOUNT = 0;
+   static constexpr uint32_t ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_EOS_STAKED_SCO = 1;
+   static constexpr uint32_t ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_PROXY_VOTE_SCO = 2;
+
+   static constexpr uint64_t MAINTENANCE_TASK_UPDATEREX = "updaterex"_nv;
+   static constexpr uint64_t MAINTENANCE_TASK_GC = "gc"_nv;
+   static constexpr uint32_t MAINTENANCE_TASKS_PER_ACTION = 1;
+
+   static constexpr uint32_t GC_MAX_ROWS_PER_ACTION = 100;
+   static constexpr uint32_t GC_ROWS_PER_MAINTENANCE_RUN = 4;
+   static constexpr int64_t  STAKE_ACCOUNT_ROW_RAM_BYTES = 7 * 16 + 4 + 108 + 108;
+   static constexpr int64_t  CONTRACT_PAID_ROW_RAM_BYTES = 8 + 108;
+
+   static constexpr uint32_t DISTRIBUTE_MAX_ACCOUNTS_PER_ACTION = 100;
+   static constexpr int64_t  DISTRIBUTE_MIN_TOKEN_AMOUNT = 100'0000;
+
+   /**
+    * @brief `stakepool` table row, amounts in indivisible units of (EOS,4), (SEOS,4), (SPROXY,4), (SPIEOS,4), (PIEOS,4)
+    */
+   struct stake_pool {
+      int64_t  total_staked               = 0;
+      int64_t  total_staked_share         = 0;
+      int64_t  core_token_for_staked      = 0;
+      int64_t  total_proxy_vote           = 0;
+      int64_t  total_proxy_vote_share     = 0;
+      int64_t  core_token_for_proxy_vote  = 0;
+      int64_t  total_token_share          = 0;
+      int64_t  sco_token_unredeemed       = 0;
+      int64_t  last_total_issued          = 0;
+      uint32_t last_issue_time            = 0; // block timestamp slot
+   };
+
+   /**
+    * @brief `stakeaccount` PIEOS SCO record and `deposits` EOS and PIEOS balances of one account scope
+    */
+   struct stake_account {
+      int64_t  core_token_bal    = 0;
+      int64_t  sco_token_bal     = 0;
+      int64_t  staked            = 0;
+      int64_t  staked_share      = 0;
+      int64_t  proxy_vote        = 0;
+      int64_t  proxy_vote_share  = 0;
+      int64_t  token_share       = 0;
+      uint32_t last_stake_time   = 0; // block timestamp slot
+      uint64_t ram_payer         = 0;
+      std::vector<sco_math::stake_lot> stake_lots; // `stakelots` unmatured lots, empty as if the record did not exist
+   };
+
+   /**
+    * @brief `liqreserve` table row of the PIEOS SCO pool, the balance in (EOS,4) units
+    */
+   struct liquid_reserve {
+      uint32_t target_percent = 0; // 0.01% of the pool's staked EOS value
+      int64_t  balance        = 0;
+   };
+
+   static constexpr uint32_t MAX_LIQUID_RESERVE_PERCENT = 2000;
+
+   /**
+    * @brief `maintenance` table row, by task name
+    */
+   struct maintenance_task {
+      uint32_t interval_sec = 0;
+      uint32_t last_run     = 0; // block timestamp slot
+   };
+
+   /**
+    * @brief `gcstate` singleton row
+    */
+   struct gc_state {
+      uint64_t cursor       = 0;
+      uint64_t rows_erased  = 0;
+      int64_t  bytes_freed  = 0;
+      int64_t  bytes_unsold = 0;
+   };
+
+   /**
+    * @brief `diststate` singleton row
+    */
+   struct distribute_state {
+      uint64_t cursor      = 0;
+      int64_t  distributed = 0;
+   };
+
+   /**
+    * @brief in-memory state of the SCO contract tables and the token balances the contract reads
+    */
+   struct sco_state {
+      bool                                     initialized = false;
+      stake_pool                               pool;
+      liquid_reserve                           reserve;           // `liqreserve` of the PIEOS SCO pool
+      std::unordered_map<uint64_t, stake_account> accounts;       // `stakeaccount`, by scope
+      std::unordered_map<uint64_t, int64_t>    reserved;          // `reserved`, issued vested PIEOS by scope
+      std::unordered_map<uint64_t, uint32_t>   account_types;     // `acctype`, by scope
+      std::unordered_map<uint64_t, maintenance_task> maintenance; // `maintenance`, by task
+      std::set<uint64_t>                       paid_rows;         // `paidrows`, ordered like the table
+      gc_state                                 gc;                // `gcstate`
+      std::set<uint64_t>                       stakers;           // `stakers`, ordered like the table
+      distribute_state                         dist;              // `diststate`
+
+      int64_t                                  contract_core_token_balance = 0; // eosio.token EOS balance of contract
+      int64_t                                  contract_sco_token_balance  = 0; // PIEOS balance of contract
+      int64_t                                  sco_token_supply            = 0; // PIEOS `stat` supply
+      std::unordered_map<uint64_t, int64_t>    sco_token_accounts;             // PIEOS `accounts` rows of other accounts
+      std::unordered_map<uint64_t, int64_t>    core_token_received;            // EOS transferred by the contract, by recipient
+   };
+
+} // namespace pieos::sim
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <sco-snapshot.hpp>
+#include <work-stealing-pool.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace pieos::sim {
+
+   /**
+    * @brief one failed invariant of a snapshot, `account` is 0 for the contract-wide checks
+    *
+    * Contract-wide checks:
+    *  - total_staked, total_staked_share, total_proxy_vote, total_proxy_vote_share, total_token_share :
+    *      expected = `stakepool` total, actual = sum over the `stakeaccount` rows
+    *  - core_token_holdings : expected = sum of `core_token_bal` + core_token_for_staked + core_token_for_proxy_vote
+    *      + `liqreserve` balance + total_staked, actual = EOS balance + REX fund + REX value of the contract (less is a finding)
+    *  - sco_token_holdings : expected = sco_token_unredeemed + sum of `sco_token_bal`,
+    *      actual = PIEOS balance of the contract (less is a finding)
+    *  - sco_token_supply : expected = PIEOS `stat` supply, actual = sum of the PIEOS `accounts` balances
+    *
+    * Account checks (actual = the offending value):
+    *  - row_order : `stakeaccount` rows not strictly ordered by owner (duplicate or unsorted scope)
+    *  - negative_core_token_bal, negative_sco_token_bal, negative_staked, negative_staked_share, negative_proxy_vote,
+    *    negative_proxy_vote_share, negative_token_share
+    *  - staked_share_without_stake, stake_without_staked_share, proxy_vote_share_without_proxy_vote,
+    *    proxy_vote_without_share, token_share_without_stake
+    *  - staked_share_value, proxy_vote_share_value : expected = staked EOS or proxy vote of the account,
+    *      actual = EOS value of its share of the pool, when less than the principal beyond the rounding (1 ppm)
+    */
+   struct audit_finding {
+      const char* check    = "";
+      uint64_t    account  = 0;
+      const char* symbol   = "";
+      int64_t     expected = 0;
+      int64_t     actual   = 0;
+   };
+
+   /**
+    * @brief sums of the `stakeaccount` rows
+    */
+   struct audit_totals {
+      int64_t staked           = 0;
+      int64_t staked_share     = 0;
+      int64_t proxy_vote       = 0;
+      int64_t proxy_vote_share = 0;
+      int64_t token_share      = 0;
+      int64_t core_token_bal   = 0;
+      int64_t sco_token_bal    = 0;
+   };
+
+   struct audit_report {
+      uint64_t                   accounts = 0;
+      audit_totals               totals;
+      std::vector<audit_finding> findings; // account findings in row order, then the contract-wide ones
+   };
+
+   /// `stakeaccount` rows summed and checked by one job of the audit
+   static constexpr size_t AUDIT_ROWS_PER_JOB = 16384;
+
+   /**
+    * @brief checks the `stakeaccount` rows of a snapshot and the `stakepool` totals and token holdings against them
+    *
+    * The rows are split into jobs of `AUDIT_ROWS_PER_JOB` run on `pool`, every job keeps its own partial sums
+    * and findings, merged in row order afterwards, so the report does not depend on the thread count.
+    * The REX value of the contract is taken at the snapshot's `rexpool` price, return buckets not yet
+    * distributed are not in the snapshot.
+    */
+   audit_report audit_snapshot( const snapshot_view& snapshot, work_stealing_pool& pool );
+
+} // namespace pieos::sim
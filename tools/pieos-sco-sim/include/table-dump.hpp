@@ -0,0 +1,29 @@
+#pragma once
+
+#include <sco-engine.hpp>
+
+#include <string>
+
+namespace pieos::sim {
+
+   /**
+    * @brief loads the SCO contract tables and the token and `eosio` rows it reads from a table dump of a node
+    *
+    * A table dump is JSON lines, one table row per line, with the row fields flattened next to
+    * `code`, `table` and `scope` (and `payer` when dumped with `--show-payer`), e.g. from
+    * `cleos get table ... | jq -c '.rows[] | . + {code:..., table:..., scope:...}'`:
+    *
+    *    {"code":"pieosdistsco","table":"stakepool","scope":"pieosdistsco","total_staked":"10.0000 EOS",...}
+    *    {"code":"pieosdistsco","table":"stakeaccount","scope":"alice","payer":"alice","core_token_bal":"0.0000 EOS",...,"pool_id":"PIEOS"}
+    *    {"code":"pieosdistsco","table":"deposits","scope":"alice","payer":"alice","balance":"1.0000 EOS"}
+    *
+    * Tables read: SCO contract `stakepool`, `stakeaccount`, `deposits`, `liqreserve`, `reserved`, `acctype`, `stakers`; PIEOS token `accounts`, `stat`;
+    * `eosio` `rexpool`, `rexfund` and `rexbal` rows of the SCO contract; `eosio.token` `accounts` of the SCO contract.
+    * Rows of other tables and accounts are ignored. `core_token_bal` and `sco_token_bal` of a `stakeaccount` record
+    * not yet migrated to `deposits` are added to the account's deposit balances.
+    *
+    * @return false if the file cannot be opened, throws std::runtime_error on a malformed row
+    */
+   bool load_table_dump( const std::string& path, sco_engine& engine );
+
+} // namespace pieos::sim
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <action-trace.hpp>
+#include <sco-engine.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace pieos::sim {
+
+   /**
+    * @brief applies one recorded trace record to the engine, advancing the block time first
+    *
+    * Throws `check_failure` when the simulated contract action fails.
+    */
+   void apply_trace_record( sco_engine& engine, const trace_record& record );
+
+   struct replay_stats {
+      uint64_t records  = 0;
+      uint64_t failed   = 0;
+      uint64_t by_type[size_t(trace_type::count)] = {};
+   };
+
+   /**
+    * @brief writes the final `stakepool` and all `stakeaccount` rows as a JSON document, accounts ordered by name
+    *
+    * @param with_accounts - include the `stakeaccount` rows
+    */
+   void write_state_json( std::FILE* out, const sco_engine& engine, const bool with_accounts );
+
+} // namespace pieos::sim
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pieos::sim {
+
+   /**
+    * @brief runs a batch of independent jobs on a fixed number of threads with work stealing
+    *
+    * The job indices of a batch are split into one contiguous range per worker. A worker takes
+    * jobs from the back of its own queue and, once it runs dry, steals from the front of the
+    * other workers' queues, so uneven job costs (e.g. simulated timelines of different lengths)
+    * keep every thread busy until the batch is done.
+    * No jobs are added while a batch runs, a worker that finds every queue empty exits.
+    */
+   class work_stealing_pool {
+   public:
+      explicit work_stealing_pool( const unsigned threads = 0 )
+         : _threads( threads ? threads : std::max( 1u, std::thread::hardware_concurrency() ) ) {}
+
+      unsigned size() const { return _threads; }
+
+      /**
+       * @brief calls `job( index, worker )` for every index in [0, count) and waits for all of them,
+       * `worker` is in [0, size()). The first exception thrown by a job stops the batch and is rethrown.
+       */
+      template<typename Job>
+      void run( const size_t count, Job&& job ) {
+         if ( count == 0 ) {
+            return;
+         }
+         const unsigned workers = unsigned( std::min<size_t>( _threads, count ) );
+
+         std::vector<queue> queues( workers );
+         for ( unsigned w = 0; w < workers; ++w ) {
+            for ( size_t i = count * w / workers; i < count * ( w + 1 ) / workers; ++i ) {
+               queues[w].jobs.push_back( i );
+            }
+         }
+
+         std::atomic<bool>  stop{ false };
+         std::exception_ptr error;
+         std::mutex         error_mutex;
+
+         auto work = [&]( const unsigned w ) {
+            size_t index = 0;
+            while ( !stop.load( std::memory_order_relaxed ) && next_job( queues, w, index ) ) {
+               try {
+                  job( index, w );
+               } catch ( ... ) {
+                  std::lock_guard<std::mutex> lock( error_mutex );
+                  if ( !error ) {
+                     error = std::current_exception();
+                  }
+                  stop = true;
+               }
+            }
+         };
+
+         std::vector<std::thread> threads;
+         threads.reserve( workers - 1 );
+         for ( unsigned w = 1; w < workers; ++w ) {
+            threads.emplace_back( work, w );
+         }
+         work( 0 );
+         for ( auto& t : threads ) {
+            t.join();
+         }
+
+         if ( error ) {
+            std::rethrow_exception( error );
+         }
+      }
+
+   private:
+      struct queue {
+         std::mutex         mutex;
+         std::deque<size_t> jobs;
+      };
+
+      static bool next_job( std::vector<queue>& queues, const unsigned w, size_t& index ) {
+         {
+            auto& own = queues[w];
+            std::lock_guard<std::mutex> lock( own.mutex );
+            if ( !own.jobs.empty() ) {
+               index = own.jobs.back();
+               own.jobs.pop_back();
+               return true;
+            }
+         }
+         const size_t n = queues.size();
+         for ( size_t k = 1; k < n; ++k ) {
+            auto& victim = queues[( w + k ) % n];
+            std::lock_guard<std::mutex> lock( victim.mutex );
+            if ( !victim.jobs.empty() ) {
+               index = victim.jobs.front();
+               victim.jobs.pop_front();
+               return true;
+            }
+         }
+         return false;
+      }
+
+      unsigned _threads;
+   };
+
+} // namespace pieos::sim
@@ -0,0 +1,214 @@
+#include <action-trace.hpp>
+#include <eosio-name.hpp>
+#include <sco-state.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace pieos::sim {
+
+   namespace {
+
+      const char* const trace_type_names[] = {
+         "transfer", "init", "open", "close", "stake", "unstake", "compound", "proxyvoted", "harvestproxy",
+         "withdraw", "claimvested", "updaterex", "setacctype", "sellram", "tokenopen", "rexpool", "rexincome",
+         "setmaint", "gc", "setreserve", "movestake", "distribute", "rexfee", "rexrent"
+      };
+      static_assert( sizeof(trace_type_names) / sizeof(trace_type_names[0]) == size_t(trace_type::count) );
+
+   } // namespace
+
+   const char* trace_type_name( const trace_type type ) {
+      return type < trace_type::count ? trace_type_names[size_t(type)] : "unknown";
+   }
+
+   bool trace_type_from_name( std::string_view name, trace_type& type ) {
+      for ( size_t i = 0; i < size_t(trace_type::count); ++i ) {
+         if ( name == trace_type_names[i] ) {
+            type = trace_type(i);
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+
+   trace_reader::~trace_reader() {
+      if ( _file ) std::fclose( _file );
+   }
+
+   bool trace_reader::open( const std::string& path ) {
+      _file = std::fopen( path.c_str(), "rb" );
+      if ( !_file ) {
+         return false;
+      }
+
+      trace_file_header expected, header;
+      if ( std::fread( &header, sizeof(header), 1, _file ) == 1 && std::memcmp( header.magic, expected.magic, sizeof(header.magic) ) == 0 ) {
+         if ( header.version != expected.version || header.record_size != expected.record_size ) {
+            throw std::runtime_error( "unsupported binary trace version" );
+         }
+         _binary = true;
+      } else {
+         std::rewind( _file );
+         _binary = false;
+      }
+      return true;
+   }
+
+   bool trace_reader::next( trace_record& record ) {
+      if ( _binary ) {
+         const size_t read = std::fread( &record, 1, sizeof(record), _file );
+         if ( read == 0 && std::feof( _file ) ) {
+            return false;
+         }
+         ++_line;
+         if ( read != sizeof(record) ) {
+            throw std::runtime_error( std::string( "record " ) + std::to_string( _line ) + ": truncated binary record" );
+         }
+         return true;
+      }
+
+      char chunk[4096];
+      while ( true ) {
+         _buffer.clear();
+         bool got = false;
+         while ( std::fgets( chunk, sizeof(chunk), _file ) ) {
+            got = true;
+            _buffer.append( chunk );
+            if ( !_buffer.empty() && _buffer.back() == '\n' ) break;
+         }
+         if ( !got ) {
+            return false;
+         }
+         ++_line;
+         if ( parse_json_line( _buffer, record ) ) {
+            return true;
+         }
+      }
+   }
+
+   // @return false for blank lines
+   bool trace_reader::parse_json_line( std::string_view s, trace_record& record ) {
+      record = trace_record();
+      bool has_type = false;
+      std::string_view amount_symbol;
+
+      bool blank = false;
+      const char* error = parse_flat_json_object( s, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+         if ( key == "act" || key == "action" ) {
+            if ( !trace_type_from_name( value, record.type ) ) return "unknown action";
+            has_type = true;
+         } else if ( key == "time" ) {
+            if ( !parse_block_time( value, record.block_slot ) ) return "invalid time";
+         } else if ( key == "slot" ) {
+            int64_t v;
+            if ( !parse_int( value, v ) ) return "invalid slot";
+            record.block_slot = uint32_t( v );
+         } else if ( key == "account" || key == "owner" || key == "from" || key == "updater" || key == "task" ) {
+            record.account = name_value( value );
+            if ( record.account == 0 && !value.empty() ) return "invalid account name";
+         } else if ( key == "ram_payer" || key == "to" ) {
+            record.account2 = name_value( value );
+            if ( record.account2 == 0 && !value.empty() ) return "invalid account name";
+         } else if ( key == "amount" || key == "quantity" || key == "proxy_vote" || key == "bytes" || key == "type" || key == "interval_sec" || key == "max_rows" || key == "max_accounts" || key == "total_lendable" || key == "target_percent" ) {
+            if ( !parse_amount( value, record.amount, amount_symbol ) ) return "invalid amount";
+         } else if ( key == "total_rex" ) {
+            std::string_view sym;
+            if ( !parse_amount( value, record.amount2, sym ) ) return "invalid total_rex";
+         }
+         // other keys (memo, ...) are ignored
+         return nullptr;
+      } );
+
+      if ( !error && !blank && !has_type ) {
+         error = "missing act";
+      }
+      if ( error ) {
+         throw std::runtime_error( std::string( "line " ) + std::to_string( _line ) + ": " + error );
+      }
+      if ( blank ) {
+         return false;
+      }
+
+      if ( record.type == trace_type::withdraw ) {
+         record.amount2 = ( amount_symbol == "PIEOS" ) ? 1 : 0;
+      }
+      return true;
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+
+   trace_writer::~trace_writer() {
+      close();
+   }
+
+   bool trace_writer::open( const std::string& path, const format fmt ) {
+      _format = fmt;
+      _file = std::fopen( path.c_str(), fmt == format::binary ? "wb" : "w" );
+      if ( !_file ) {
+         return false;
+      }
+      if ( fmt == format::binary ) {
+         trace_file_header header;
+         std::fwrite( &header, sizeof(header), 1, _file );
+      }
+      return true;
+   }
+
+   void trace_writer::write( const trace_record& r ) {
+      if ( _format == format::binary ) {
+         std::fwrite( &r, sizeof(r), 1, _file );
+         return;
+      }
+
+      std::string line = "{\"time\":\"" + format_block_time( r.block_slot ) + "\",\"act\":\"" + trace_type_name( r.type ) + "\"";
+      auto add_name = [&]( const char* key, const uint64_t v ) {
+         line += std::string( ",\"" ) + key + "\":\"" + name_string( v ) + "\"";
+      };
+      auto add_str = [&]( const char* key, const std::string& v ) {
+         line += std::string( ",\"" ) + key + "\":\"" + v + "\"";
+      };
+      auto add_int = [&]( const char* key, const int64_t v ) {
+         line += std::string( ",\"" ) + key + "\":" + std::to_string( v );
+      };
+
+      switch ( r.type ) {
+         case trace_type::transfer:     add_name( "from", r.account ); add_str( "quantity", format_amount( r.amount, "EOS" ) ); break;
+         case trace_type::open:         add_name( "owner", r.account ); add_name( "ram_payer", r.account2 ); break;
+         case trace_type::close:
+         case trace_type::compound:
+         case trace_type::tokenopen:    add_name( "owner", r.account ); break;
+         case trace_type::stake:
+         case trace_type::unstake:      add_name( "owner", r.account ); add_str( "amount", format_amount( r.amount, "EOS" ) ); break;
+         case trace_type::movestake:    add_name( "from", r.account ); add_name( "to", r.account2 ); add_str( "amount", format_amount( r.amount, "EOS" ) ); break;
+         case trace_type::proxyvoted:   add_name( "account", r.account ); add_str( "proxy_vote", format_amount( r.amount, "EOS" ) ); break;
+         case trace_type::harvestproxy: add_name( "account", r.account ); break;
+         case trace_type::withdraw:     add_name( "owner", r.account ); add_str( "amount", format_amount( r.amount, r.amount2 ? "PIEOS" : "EOS" ) ); break;
+         case trace_type::claimvested:  add_name( "account", r.account ); add_str( "amount", format_amount( r.amount, "PIEOS" ) ); break;
+         case trace_type::updaterex:    add_name( "updater", r.account ); break;
+         case trace_type::setacctype:   add_name( "account", r.account ); add_int( "type", r.amount ); break;
+         case trace_type::sellram:      add_int( "bytes", r.amount ); break;
+         case trace_type::rexpool:      add_str( "total_lendable", format_amount( r.amount, "EOS" ) ); add_str( "total_rex", format_amount( r.amount2, "REX" ) ); break;
+         case trace_type::rexincome:
+         case trace_type::rexfee:       add_str( "amount", format_amount( r.amount, "EOS" ) ); break;
+         case trace_type::rexrent:      add_name( "from", r.account ); add_str( "amount", format_amount( r.amount, "EOS" ) ); break;
+         case trace_type::setmaint:     add_name( "task", r.account ); add_int( "interval_sec", r.amount ); break;
+         case trace_type::gc:           add_int( "max_rows", r.amount ); break;
+         case trace_type::distribute:   add_int( "max_accounts", r.amount ); break;
+         case trace_type::setreserve:   add_str( "pool_id", "PIEOS" ); add_int( "target_percent", r.amount ); break;
+         default: break;
+      }
+      line += "}\n";
+      std::fputs( line.c_str(), _file );
+   }
+
+   void trace_writer::close() {
+      if ( _file ) {
+         std::fclose( _file );
+         _file = nullptr;
+      }
+   }
+
+} // namespace pieos::sim
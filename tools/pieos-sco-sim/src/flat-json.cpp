@@ -0,0 +1,118 @@
+#include <flat-json.hpp>
+#include <sco-state.hpp>
+
+#include <cstdio>
+
+namespace pieos::sim {
+
+   namespace {
+
+      // days since 1970-01-01 of a proleptic Gregorian calendar date
+      int64_t days_from_civil( int64_t y, const unsigned m, const unsigned d ) {
+         y -= m <= 2;
+         const int64_t era = ( y >= 0 ? y : y - 399 ) / 400;
+         const unsigned yoe = unsigned( y - era * 400 );
+         const unsigned doy = ( 153 * ( m + ( m > 2 ? -3 : 9 ) ) + 2 ) / 5 + d - 1;
+         const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+         return era * 146097 + int64_t( doe ) - 719468;
+      }
+
+      void civil_from_days( int64_t z, int64_t& y, unsigned& m, unsigned& d ) {
+         z += 719468;
+         const int64_t era = ( z >= 0 ? z : z - 146096 ) / 146097;
+         const unsigned doe = unsigned( z - era * 146097 );
+         const unsigned yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+         const unsigned doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+         const unsigned mp = ( 5 * doy + 2 ) / 153;
+         d = doy - ( 153 * mp + 2 ) / 5 + 1;
+         m = mp < 10 ? mp + 3 : mp - 9;
+         y = int64_t( yoe ) + era * 400 + ( m <= 2 );
+      }
+
+      bool parse_uint( std::string_view s, size_t pos, size_t len, unsigned& out ) {
+         if ( pos + len > s.size() ) return false;
+         out = 0;
+         for ( size_t i = pos; i < pos + len; ++i ) {
+            if ( s[i] < '0' || s[i] > '9' ) return false;
+            out = out * 10 + unsigned( s[i] - '0' );
+         }
+         return true;
+      }
+
+   } // namespace
+
+   bool parse_block_time( std::string_view s, uint32_t& slot ) {
+      unsigned y, mo, d, h, mi, sec, ms = 0;
+      if ( !parse_uint( s, 0, 4, y ) || !parse_uint( s, 5, 2, mo ) || !parse_uint( s, 8, 2, d )
+           || !parse_uint( s, 11, 2, h ) || !parse_uint( s, 14, 2, mi ) || !parse_uint( s, 17, 2, sec ) ) {
+         return false;
+      }
+      if ( s.size() >= 23 && s[19] == '.' && !parse_uint( s, 20, 3, ms ) ) {
+         return false;
+      }
+      const int64_t epoch_ms = ( days_from_civil( y, mo, d ) * SECONDS_PER_DAY + h * 3600 + mi * 60 + sec ) * 1000 + ms;
+      slot = uint32_t( ( epoch_ms - BLOCK_TIMESTAMP_EPOCH_MS ) / BLOCK_INTERVAL_MS );
+      return true;
+   }
+
+   bool parse_int( std::string_view s, int64_t& out ) {
+      if ( s.empty() ) return false;
+      bool neg = false;
+      size_t i = 0;
+      if ( s[0] == '-' ) { neg = true; i = 1; }
+      if ( i == s.size() ) return false;
+      int64_t v = 0;
+      for ( ; i < s.size(); ++i ) {
+         if ( s[i] < '0' || s[i] > '9' ) return false;
+         v = v * 10 + ( s[i] - '0' );
+      }
+      out = neg ? -v : v;
+      return true;
+   }
+
+   bool parse_amount( std::string_view s, int64_t& amount, std::string_view& symbol ) {
+      symbol = {};
+      const auto space = s.find( ' ' );
+      std::string_view number = s;
+      if ( space != std::string_view::npos ) {
+         number = s.substr( 0, space );
+         symbol = s.substr( space + 1 );
+      }
+      const auto dot = number.find( '.' );
+      if ( dot == std::string_view::npos ) {
+         return parse_int( number, amount );
+      }
+      int64_t whole = 0, frac = 0;
+      const std::string_view frac_str = number.substr( dot + 1 );
+      if ( frac_str.size() != 4 || !parse_int( number.substr( 0, dot ), whole ) || !parse_int( frac_str, frac ) ) {
+         return false;
+      }
+      const bool neg = !number.empty() && number[0] == '-';
+      amount = whole * 10000 + ( neg ? -frac : frac );
+      return true;
+   }
+
+   std::string format_amount( const int64_t amount, std::string_view symbol ) {
+      const bool neg = amount < 0;
+      const uint64_t abs = neg ? uint64_t( -( amount + 1 ) ) + 1 : uint64_t( amount );
+      char buf[64];
+      std::snprintf( buf, sizeof(buf), "%s%llu.%04llu %.*s", neg ? "-" : "",
+                     (unsigned long long)( abs / 10000 ), (unsigned long long)( abs % 10000 ),
+                     int( symbol.size() ), symbol.data() );
+      return buf;
+   }
+
+   std::string format_block_time( const uint32_t slot ) {
+      const int64_t epoch_ms = int64_t( slot ) * BLOCK_INTERVAL_MS + BLOCK_TIMESTAMP_EPOCH_MS;
+      const int64_t secs = epoch_ms / 1000;
+      int64_t y; unsigned m, d;
+      civil_from_days( secs / SECONDS_PER_DAY, y, m, d );
+      const int64_t sod = secs % SECONDS_PER_DAY;
+      // sized for any int64_t year, although a block timestamp slot only reaches year 2068
+      char buf[64];
+      std::snprintf( buf, sizeof(buf), "%04lld-%02u-%02uT%02lld:%02lld:%02lld.%03lld", (long long)y, m, d,
+                     (long long)( sod / 3600 ), (long long)( sod / 60 % 60 ), (long long)( sod % 60 ), (long long)( epoch_ms % 1000 ) );
+      return buf;
+   }
+
+} // namespace pieos::sim
@@ -0,0 +1,201 @@
+#include <rex-market.hpp>
+
+namespace pieos::sim {
+
+   void rex_market::set_pool( const int64_t total_lendable, const int64_t total_rex ) {
+      _pool.total_lendable = total_lendable;
+      _pool.total_rex      = total_rex;
+      _pool.total_unlent   = total_lendable - _pool.total_lent;
+      if ( _pool.total_rent == 0 ) {
+         _pool.total_rent = rex_math::INIT_TOTAL_RENT;
+      }
+   }
+
+   void rex_market::restore( const pool& p, const uint64_t owner, const int64_t fund, const int64_t rex ) {
+      _pool = p;
+      if ( fund > 0 ) {
+         _funds[owner] = fund;
+      }
+      if ( rex > 0 ) {
+         auto& b = _balances[owner];
+         b.rex_balance = rex;
+         b.matured_rex = rex;
+         rex_math::update_vote_stake( b, _pool );
+      }
+   }
+
+   int64_t rex_market::fund_balance( const uint64_t owner ) const {
+      int64_t fund = 0;
+      if ( auto itr = _funds.find( owner ); itr != _funds.end() ) {
+         fund = itr->second;
+      }
+      if ( auto itr = _orders.find( owner ); itr != _orders.end() && !itr->second.is_open ) {
+         fund += itr->second.proceeds;
+      }
+      return fund;
+   }
+
+   int64_t rex_market::rex_balance( const uint64_t owner ) const {
+      auto itr = _balances.find( owner );
+      return itr != _balances.end() ? itr->second.rex_balance : 0;
+   }
+
+   int64_t rex_market::matured_rex( const uint64_t owner ) const {
+      auto itr = _balances.find( owner );
+      if ( itr == _balances.end() ) {
+         return 0;
+      }
+      int64_t matured = itr->second.matured_rex;
+      for ( const auto& [maturity, rex] : itr->second.rex_maturities ) {
+         if ( maturity > _now ) break;
+         matured += rex;
+      }
+      return matured;
+   }
+
+   int64_t rex_market::available_unlent( const int64_t lendable_change_amount ) const {
+      // REX return proceeds are added to both the lendable and the unlent EOS of the pool
+      int64_t available = sco_math::rex_available_unlent( _pool.total_unlent + lendable_change_amount, _pool.total_lent );
+
+      uint32_t n = 0;
+      for ( auto itr = _open_orders.begin(); itr != _open_orders.end() && n < rex_math::ORDERS_FILLED_PER_ACTION; ++itr, ++n ) {
+         available -= rex_to_core_token( _orders.at( itr->second ).rex_requested, lendable_change_amount );
+      }
+      return available;
+   }
+
+   void rex_market::transfer_from_fund( const uint64_t owner, const int64_t amount ) {
+      auto itr = _funds.find( owner );
+      check( itr != _funds.end() && amount <= itr->second, "insufficient funds" );
+      itr->second -= amount;
+   }
+
+   int64_t rex_market::update_rex_account( const uint64_t owner, const int64_t proceeds ) {
+      int64_t to_fund = proceeds;
+      int64_t rex_in_sell_order = 0;
+      if ( auto itr = _orders.find( owner ); itr != _orders.end() ) {
+         if ( itr->second.is_open ) {
+            rex_in_sell_order = itr->second.rex_requested;
+         } else {
+            to_fund += itr->second.proceeds;
+            _orders.erase( itr );
+         }
+      }
+      if ( to_fund > 0 ) {
+         _funds[owner] += to_fund;
+      }
+      return rex_in_sell_order;
+   }
+
+   void rex_market::deposit( const uint64_t owner, const int64_t amount ) {
+      ++_actions;
+      check( amount > 0, "must deposit a positive amount" );
+      _funds[owner] += amount;
+      update_rex_account( owner, 0 );
+   }
+
+   void rex_market::withdraw( const uint64_t owner, const int64_t amount ) {
+      ++_actions;
+      check( amount > 0, "must withdraw a positive amount" );
+      update_rex_account( owner, 0 );
+      transfer_from_fund( owner, amount );
+   }
+
+   void rex_market::buyrex( const uint64_t from, const int64_t amount ) {
+      ++_actions;
+      check( amount > 0, "must use positive amount" );
+      transfer_from_fund( from, amount );
+
+      const int64_t rex_received = rex_math::add_to_rex_pool( _pool, amount );
+      auto [bitr, new_balance] = _balances.try_emplace( from );
+      rex_math::add_to_rex_balance( bitr->second, new_balance, _pool, amount, rex_received, _now );
+
+      runrex( rex_math::ORDERS_FILLED_PER_ACTION );
+      update_rex_account( from, 0 );
+   }
+
+   int64_t rex_market::sellrex( const uint64_t from, const int64_t rex ) {
+      ++_actions;
+      runrex( rex_math::ORDERS_FILLED_PER_ACTION );
+
+      auto bitr = _balances.find( from );
+      check( bitr != _balances.end(), "user must first buyrex" );
+      check( rex > 0, "asset must be a positive amount of (REX, 4)" );
+      auto& b = bitr->second;
+      rex_math::process_rex_maturities( b, _now );
+      check( rex <= b.matured_rex, "insufficient available rex" );
+
+      const auto fill = rex_math::fill_rex_order( _pool, b, rex );
+      check( !fill.success || fill.proceeds > 0, "proceeds are negligible" );
+
+      int64_t pending_sell_order = update_rex_account( from, fill.proceeds );
+      if ( !fill.success ) {
+         auto [oitr, inserted] = _orders.try_emplace( from );
+         if ( inserted ) {
+            oitr->second.rex_requested = rex;
+            oitr->second.order_time    = _now;
+            _open_orders.emplace( _now, from );
+         } else {
+            oitr->second.rex_requested += rex;
+         }
+         pending_sell_order = oitr->second.rex_requested;
+      }
+      check( pending_sell_order <= b.matured_rex, "insufficient funds for current and scheduled orders" );
+      return fill.proceeds;
+   }
+
+   void rex_market::updaterex( const uint64_t owner ) {
+      ++_actions;
+      runrex( rex_math::ORDERS_FILLED_PER_ACTION );
+
+      auto bitr = _balances.find( owner );
+      check( bitr != _balances.end(), "account has no REX balance" );
+      rex_math::update_vote_stake( bitr->second, _pool );
+      update_rex_account( owner, 0 );
+      rex_math::process_rex_maturities( bitr->second, _now );
+   }
+
+   void rex_market::runrex( const uint16_t max ) {
+      update_rex_pool();
+
+      // CPU and NET loans, each table up to `max` expired loans on chain
+      for ( uint32_t i = 0; i < 2u * max; ++i ) {
+         auto litr = _loans.begin();
+         if ( litr == _loans.end() || litr->first > _now ) break;
+         rex_math::return_loan( _pool, litr->second.total_staked );
+         _loans.erase( litr );
+      }
+
+      auto oitr = _open_orders.begin();
+      for ( uint16_t i = 0; i < max && oitr != _open_orders.end(); ++i ) {
+         auto& o = _orders.at( oitr->second );
+         const auto fill = rex_math::fill_rex_order( _pool, _balances.at( oitr->second ), o.rex_requested );
+         if ( fill.success ) {
+            o.proceeds     = fill.proceeds;
+            o.stake_change = fill.stake_change;
+            o.is_open      = false;
+            oitr = _open_orders.erase( oitr );
+         } else {
+            ++oitr;
+         }
+      }
+   }
+
+   int64_t rex_market::rentcpu( const uint64_t from, const int64_t payment ) {
+      ++_actions;
+      runrex( rex_math::ORDERS_FILLED_PER_ACTION );
+      check( rex_loans_available(), "rex loans are currently not available" );
+      check( payment > 0, "must use positive asset amount" );
+      update_rex_account( from, 0 );
+      transfer_from_fund( from, payment );
+
+      const int64_t rented = rex_math::bancor_output( _pool.total_rent, _pool.total_unlent, payment );
+      check( payment < rented, "loan price does not favor renting" );
+      rex_math::rent_rex( _pool, payment );
+      rex_math::add_to_rex_return_pool( _pool, _ret, payment, _now );
+
+      _loans.emplace( _now + rex_math::LOAN_PERIOD_SEC, loan{ from, rented } );
+      return rented;
+   }
+
+} // namespace pieos::sim
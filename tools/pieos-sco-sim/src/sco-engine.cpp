@@ -0,0 +1,1103 @@
+#include <sco-engine.hpp>
+
+#include <pieos-sco-math.hpp>
+
+#include <algorithm>
+
+namespace pieos::sim {
+
+   namespace {
+      constexpr int64_t share_ratio = sco_math::SHARE_RATIO;
+      constexpr int64_t token_scale = sco_math::STAKE_AMOUNT_SCALE_TO_GENERATED_SCO_TOKEN_AMOUNT;
+   }
+
+   void sco_engine::receive_token( const uint64_t from, const uint64_t to, const int64_t quantity ) {
+      if ( from == _config.contract || to != _config.contract || quantity <= 0 ) {
+         return;
+      }
+
+      if ( from == _config.rex_fund_account ) {
+         // REX fund withdrawals are applied with the contract's inline `withdraw` action
+         return;
+      }
+
+      _state.contract_core_token_balance += quantity;
+
+      if ( is_account_type( from, ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_EOS_STAKED_SCO ) ) {
+         check( _state.initialized, "stake pool not initialized" );
+         _state.pool.core_token_for_staked += quantity;
+      } else if ( is_account_type( from, ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_PROXY_VOTE_SCO ) ) {
+         check( _state.initialized, "stake pool not initialized" );
+         _state.pool.core_token_for_proxy_vote += quantity;
+      } else if ( from == _config.rex_ram_fund_account ) {
+         add_on_contract_token_balance( _config.admin_account, token::core, quantity, _config.contract );
+      } else {
+         add_on_contract_token_balance( from, token::core, quantity, from );
+      }
+   }
+
+   void sco_engine::init() {
+      check( !_state.initialized, "stake pool already initialized" );
+      _state.initialized = true;
+      _state.pool = stake_pool();
+   }
+
+   // the contract requires `ram_payer` auth but bills the record to `owner`
+   void sco_engine::open( const uint64_t owner, const uint64_t /*ram_payer*/ ) {
+      auto sa_itr = _state.accounts.find( owner );
+      if ( sa_itr == _state.accounts.end() ) {
+         stake_account sa;
+         sa.ram_payer = owner;
+         _state.accounts.emplace( owner, sa );
+      }
+   }
+
+   void sco_engine::close( const uint64_t owner ) {
+      auto sa_itr = _state.accounts.find( owner );
+      check( sa_itr != _state.accounts.end(), "stake account record not found (close)" );
+
+      check( is_empty_stake_account( sa_itr->second ), "stake account has non-zero balance(s)" );
+
+      _state.accounts.erase( sa_itr );
+      _state.paid_rows.erase( owner );
+   }
+
+   void sco_engine::stake( const uint64_t owner, const int64_t amount ) {
+      check( amount >= 1'0000, "invalid stake amount" );
+      check( _state.initialized, "stake pool not initialized" );
+      check_staking_allowed_account( owner );
+
+      sub_on_contract_token_balance( owner, token::core, amount );
+
+      issue_accrued_SCO_token();
+
+      stake_core_token( owner, amount );
+
+      // refill the liquid reserve from the staked EOS before the rest is deposited to REX
+      int64_t rex_purchase = amount;
+      auto& reserve = _state.reserve;
+      if ( reserve.target_percent > 0 ) {
+         const int64_t reserve_refill = sco_math::liquid_reserve_refill( get_total_core_token_amount_for_staked() + amount, reserve.target_percent, reserve.balance, amount );
+         reserve.balance += reserve_refill;
+         rex_purchase -= reserve_refill;
+      }
+
+      if ( rex_purchase > 0 ) {
+         // (inline actions) deposit and buyrex
+         check( rex_purchase <= _state.contract_core_token_balance, "overdrawn balance" );
+         _state.contract_core_token_balance -= rex_purchase;
+         _rex.deposit( _config.contract, rex_purchase );
+         _rex.buyrex( _config.contract, rex_purchase );
+      }
+
+      run_scheduled_maintenance();
+   }
+
+   void sco_engine::unstake( const uint64_t owner, const int64_t amount ) {
+      check( amount > 0, "invalid unstake amount" );
+      check( _state.initialized, "stake pool not initialized" );
+      check_staking_allowed_account( owner );
+
+      issue_accrued_SCO_token();
+
+      const int64_t unstake_amount = amount;
+      auto unstake_outcome = unstake_core_token( owner, unstake_amount );
+
+      if ( unstake_outcome.rex_to_sell > 0 ) {
+         _rex.sellrex( _config.contract, unstake_outcome.rex_to_sell );
+
+         if ( unstake_outcome.settlement == sco_math::unstake_settlement::sellrex ) {
+            _rex.withdraw( _config.contract, unstake_outcome.rex_sold_core_token );
+            _state.contract_core_token_balance += unstake_outcome.rex_sold_core_token;
+         }
+      }
+
+      if ( unstake_outcome.token_earned > 0 ) {
+         if ( is_sco_token_account_open( owner ) ) {
+            transfer_sco_token( owner, unstake_outcome.token_earned );
+         } else {
+            add_on_contract_token_balance( owner, token::sco, unstake_outcome.token_earned, owner );
+         }
+      }
+
+      if ( unstake_outcome.staked_and_profit_redeemed > 0 ) {
+         int64_t redeemed_to_unstaker = unstake_outcome.staked_and_profit_redeemed;
+
+         const int64_t eos_staking_profit = unstake_outcome.staked_and_profit_redeemed - unstake_amount;
+         if ( eos_staking_profit > 0 ) {
+            const int64_t contract_profit = sco_math::contract_profit_share( eos_staking_profit );
+            if ( contract_profit > 0 ) {
+               redeemed_to_unstaker -= contract_profit;
+               add_on_contract_token_balance( _config.admin_account, token::core, contract_profit, _config.contract );
+            }
+         }
+
+         if ( redeemed_to_unstaker > 0 ) {
+            if ( unstake_outcome.settlement == sco_math::unstake_settlement::queued ) {
+               add_on_contract_token_balance( owner, token::core, redeemed_to_unstaker, owner );
+            } else {
+               transfer_core_token( owner, redeemed_to_unstaker );
+            }
+         }
+      }
+      send_receipt(); // settlelog
+
+      run_scheduled_maintenance();
+   }
+
+   void sco_engine::compound( const uint64_t owner ) {
+      check( _state.initialized, "stake pool not initialized" );
+      check_staking_allowed_account( owner );
+
+      issue_accrued_SCO_token();
+
+      auto compound_outcome = compound_core_token( owner );
+      check( compound_outcome.compounded > 0, "no staking profit to compound" );
+
+      if ( compound_outcome.contract_profit > 0 ) {
+         send_receipt(); // settlelog
+      }
+
+      run_scheduled_maintenance();
+   }
+
+   void sco_engine::movestake( const uint64_t from, const uint64_t to, const int64_t amount ) {
+      check( amount > 0, "invalid move amount" );
+      check( from != to, "cannot move stake to self" );
+      check( _state.initialized, "stake pool not initialized" );
+      check_staking_allowed_account( from );
+      check_staking_allowed_account( to );
+
+      auto from_itr = _state.accounts.find( from );
+      check( from_itr != _state.accounts.end(), "stake account record not found (move stake)" );
+      auto& from_sa = from_itr->second;
+      check( amount <= from_sa.staked, "not enough staked balance" );
+      check( amount <= matured_stake( from_sa ), "cannot move stake until rex maturity time" );
+
+      const int64_t staked_share_to_move = sco_math::mul_div( amount, from_sa.staked_share, from_sa.staked );
+      const int64_t token_share_to_move = sco_math::mul_div( amount, from_sa.token_share, sco_math::weighted_staking_amount( from_sa.staked, from_sa.proxy_vote ) );
+
+      from_sa.staked       -= amount;
+      from_sa.staked_share -= staked_share_to_move;
+      from_sa.token_share  -= token_share_to_move;
+
+      // no issuance, no REX and no inline actions, the pool totals are unchanged
+      auto to_itr = _state.accounts.find( to );
+      if ( to_itr == _state.accounts.end() ) {
+         stake_account sa;
+         sa.ram_payer = from;
+         to_itr = _state.accounts.emplace( to, sa ).first;
+      }
+      auto& to_sa = to_itr->second;
+      open_stake_lots( to_sa );
+      to_sa.staked       += amount;
+      to_sa.staked_share += staked_share_to_move;
+      to_sa.token_share  += token_share_to_move;
+      track_staker( to );
+   }
+
+   void sco_engine::proxyvoted( const uint64_t account, const int64_t proxy_vote ) {
+      check( proxy_vote < 100000000'0000, "exceeds maximum proxy vote amount" );
+      check( _state.initialized, "stake pool not initialized" );
+      check_staking_allowed_account( account );
+
+      int64_t current_proxy_vote = 0;
+      {
+         auto sa_itr = _state.accounts.find( account );
+         current_proxy_vote = ( sa_itr == _state.accounts.end() ) ? 0 : sa_itr->second.proxy_vote;
+      }
+
+      const int64_t proxy_vote_delta = proxy_vote - current_proxy_vote;
+      check( proxy_vote == 0 || proxy_vote_delta >= 1'0000 || proxy_vote_delta < -1'0000, "invalid proxy_vote_delta" );
+
+      issue_accrued_SCO_token();
+
+      if ( proxy_vote_delta > 0 ) {
+         stake_by_proxy_vote( account, proxy_vote_delta );
+      } else {
+         const int64_t unstake_proxy_vote_amount = -proxy_vote_delta;
+         auto unstake_by_proxy_outcome = unstake_by_proxy_vote( account, unstake_proxy_vote_amount );
+
+         transfer_proxy_vote_outcome( account, unstake_by_proxy_outcome );
+      }
+
+      run_scheduled_maintenance();
+   }
+
+   void sco_engine::harvestproxy( const uint64_t account ) {
+      check( _state.initialized, "stake pool not initialized" );
+      check_staking_allowed_account( account );
+
+      issue_accrued_SCO_token();
+
+      auto harvest_outcome = harvest_proxy_vote_profit( account );
+      check( harvest_outcome.proxy_vote_profit_redeemed > 0 || harvest_outcome.token_earned > 0, "no proxy vote profit to harvest" );
+
+      transfer_proxy_vote_outcome( account, harvest_outcome );
+
+      run_scheduled_maintenance();
+   }
+
+   void sco_engine::withdraw( const uint64_t owner, const token sym, const int64_t amount ) {
+      check( amount > 0, "invalid withdrawal amount" );
+      check_staking_allowed_account( owner );
+
+      sub_on_contract_token_balance( owner, sym, amount );
+
+      if ( sym == token::core ) {
+         if ( amount > _state.contract_core_token_balance ) {
+            // proceeds of the queued REX sell orders are paid to the contract's REX fund
+            const int64_t rex_fund_withdrawal = amount - _state.contract_core_token_balance;
+            check( rex_fund_withdrawal <= _rex.fund_balance( _config.contract ), "not enough SCO contract's EOS balance because of pending REX sell orders" );
+            _rex.withdraw( _config.contract, rex_fund_withdrawal );
+            _state.contract_core_token_balance += rex_fund_withdrawal;
+         }
+         transfer_core_token( owner, amount );
+      } else {
+         transfer_sco_token( owner, amount );
+      }
+
+      run_scheduled_maintenance();
+   }
+
+   void sco_engine::claimvested( const uint64_t account, const int64_t amount ) {
+      check( amount > 0, "invalid claim amount" );
+
+      // built-in schedules of the reserved fund accounts (the contract's `vesting` table is not mirrored)
+      const uint32_t sco_start_slot = _config.sco_start_slot;
+      const uint32_t sco_end_slot = _config.sco_end_slot;
+      const uint32_t sco_mid_slot = sco_start_slot + ( sco_end_slot - sco_start_slot ) / 2;
+
+      int64_t max_claimable = 0;
+
+      if ( account == _config.marketing_operation_account ) {
+         max_claimable = sco_math::scheduled_vested_amount( _config.dist_marketing_operation_fund, _block_slot, sco_start_slot, sco_start_slot, sco_start_slot );
+      } else if ( account == _config.stability_fund_account ) {
+         max_claimable = sco_math::scheduled_vested_amount( _config.dist_stability_fund, _block_slot, sco_mid_slot, sco_mid_slot, sco_mid_slot );
+      } else if ( account == _config.development_team_account ) {
+         max_claimable = sco_math::scheduled_vested_amount( _config.dist_development_team, _block_slot, sco_start_slot, sco_start_slot, sco_end_slot );
+      } else {
+         check( false, "not reserved vesting account" );
+      }
+
+      auto va_itr = _state.reserved.find( account );
+      const int64_t already_claimed = ( va_itr == _state.reserved.end() ) ? 0 : va_itr->second;
+
+      check( already_claimed + amount <= max_claimable, "exceeds max claimable token amount" );
+
+      _state.reserved[account] = already_claimed + amount;
+
+      issue_sco_token( amount );
+      transfer_sco_token( account, amount );
+   }
+
+   void sco_engine::updaterex( const uint64_t /*updater*/ ) {
+      _rex.updaterex( _config.contract );
+      set_maintenance_task_run( MAINTENANCE_TASK_UPDATEREX );
+   }
+
+   void sco_engine::setmaint( const uint64_t task, const uint32_t interval_sec ) {
+      check( is_maintenance_task( task ), "unknown maintenance task" );
+
+      auto mt_itr = _state.maintenance.find( task );
+      if ( interval_sec == 0 ) {
+         check( mt_itr != _state.maintenance.end(), "maintenance task not scheduled" );
+         _state.maintenance.erase( mt_itr );
+      } else if ( mt_itr == _state.maintenance.end() ) {
+         _state.maintenance.emplace( task, maintenance_task{ interval_sec, _block_slot } );
+      } else {
+         mt_itr->second.interval_sec = interval_sec;
+      }
+   }
+
+   void sco_engine::setreserve( const uint32_t target_percent ) {
+      check( target_percent <= MAX_LIQUID_RESERVE_PERCENT, "target_percent out of range" );
+      _state.reserve.target_percent = target_percent;
+   }
+
+   void sco_engine::gc( const uint32_t max_rows ) {
+      check( max_rows > 0 && max_rows <= GC_MAX_ROWS_PER_ACTION, "max_rows out of range" );
+
+      const auto outcome = collect_contract_paid_rows( max_rows );
+      check( outcome.rows_visited > 0, "no contract-paid stake account records" );
+   }
+
+   void sco_engine::distribute( const uint32_t max_accounts ) {
+      check( max_accounts > 0 && max_accounts <= DISTRIBUTE_MAX_ACCOUNTS_PER_ACTION, "max_accounts out of range" );
+      check( _state.initialized, "stake pool not initialized" );
+
+      auto& stakers = _state.stakers;
+      check( !stakers.empty(), "no stakers to distribute" );
+
+      issue_accrued_SCO_token();
+
+      auto& sp = _state.pool;
+      auto& ds = _state.dist;
+      const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( sp.total_staked, sp.total_proxy_vote );
+
+      uint32_t visited = 0;
+      int64_t bulk_transferred = 0;
+
+      auto st_itr = stakers.lower_bound( ds.cursor );
+      if ( st_itr == stakers.end() ) {
+         st_itr = stakers.begin();
+      }
+
+      while ( st_itr != stakers.end() && visited < max_accounts ) {
+         ++visited;
+         const uint64_t owner = *st_itr;
+
+         auto sa_itr = _state.accounts.find( owner );
+         if ( sa_itr == _state.accounts.end() || sa_itr->second.token_share == 0 ) {
+            st_itr = stakers.erase( st_itr );
+            continue;
+         }
+         ++st_itr;
+         auto& sa = sa_itr->second;
+
+         // stakers without a PIEOS balance record are skipped (contract accounts are not modeled)
+         if ( !is_sco_token_account_open( owner ) ) {
+            continue;
+         }
+
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t TS0 = sp.total_token_share;
+         const int64_t token_share_to_redeem = sco_math::earned_token_share( sa.token_share, sco_math::weighted_staking_amount( sa.staked, sa.proxy_vote ), EP0, TS0 );
+         const int64_t token_earned = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
+         if ( token_earned < DISTRIBUTE_MIN_TOKEN_AMOUNT ) {
+            continue;
+         }
+
+         sa.token_share          -= token_share_to_redeem;
+         sp.total_token_share     = TS0 - token_share_to_redeem;
+         sp.sco_token_unredeemed  = std::max<int64_t>( sp.sco_token_unredeemed - token_earned, 0 );
+
+         _state.sco_token_accounts[owner] += token_earned;
+         bulk_transferred += token_earned;
+         ds.distributed += token_earned;
+      }
+
+      if ( bulk_transferred > 0 ) {
+         // one `bulktransfer` of the PIEOS token contract
+         check( bulk_transferred <= _state.contract_sco_token_balance, "overdrawn balance" );
+         ++_inline_actions;
+         _state.contract_sco_token_balance -= bulk_transferred;
+      }
+
+      ds.cursor = ( st_itr == stakers.end() ) ? 0 : *st_itr;
+   }
+
+   void sco_engine::setacctype( const uint64_t account, const uint32_t type ) {
+      if ( type == ACCOUNT_TYPE_NORMAL_USER_ACCOUNT ) {
+         _state.account_types.erase( account );
+      } else {
+         _state.account_types[account] = type;
+      }
+   }
+
+   void sco_engine::sellram( const int64_t bytes ) {
+      // proceeds are received through the `eosio.ram` transfer notification
+      auto& gs = _state.gc;
+      gs.bytes_unsold = ( bytes >= gs.bytes_unsold ) ? 0 : gs.bytes_unsold - bytes;
+   }
+
+   void sco_engine::open_sco_token_account( const uint64_t owner ) {
+      _state.sco_token_accounts.emplace( owner, 0 );
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+
+   void sco_engine::add_on_contract_token_balance( const uint64_t owner, const token sym, const int64_t value, const uint64_t ram_payer ) {
+      auto sa_itr = _state.accounts.find( owner );
+      if ( sa_itr == _state.accounts.end() ) {
+         sa_itr = _state.accounts.emplace( owner, stake_account() ).first;
+         sa_itr->second.ram_payer = ram_payer;
+         if ( ram_payer == _config.contract ) {
+            track_contract_paid_row( owner );
+         }
+      }
+
+      if ( sym == token::core ) {
+         sa_itr->second.core_token_bal += value;
+      } else {
+         sa_itr->second.sco_token_bal += value;
+      }
+      send_receipt(); // balancelog
+   }
+
+   void sco_engine::sub_on_contract_token_balance( const uint64_t owner, const token sym, const int64_t value ) {
+      auto sa_itr = _state.accounts.find( owner );
+      check( sa_itr != _state.accounts.end(), "deposit record not found" );
+
+      auto& sa = sa_itr->second;
+      if ( sym == token::core ) {
+         check( sa.core_token_bal >= value, "overdrawn core token balance" );
+         sa.core_token_bal -= value;
+      } else {
+         check( sa.sco_token_bal >= value, "overdrawn sco token balance" );
+         sa.sco_token_bal -= value;
+      }
+      send_receipt(); // balancelog
+   }
+
+   bool sco_engine::is_account_type( const uint64_t account, const uint32_t account_type ) const {
+      auto itr = _state.account_types.find( account );
+      if ( itr == _state.account_types.end() ) {
+         return account_type == ACCOUNT_TYPE_NORMAL_USER_ACCOUNT;
+      }
+      return itr->second == account_type;
+   }
+
+   void sco_engine::check_staking_allowed_account( const uint64_t account ) const {
+      check( is_account_type( account, ACCOUNT_TYPE_NORMAL_USER_ACCOUNT ) && account != _config.contract, "staking not allowed for this account" );
+   }
+
+   bool sco_engine::is_sco_token_account_open( const uint64_t account ) const {
+      return _state.sco_token_accounts.find( account ) != _state.sco_token_accounts.end();
+   }
+
+   int64_t sco_engine::get_total_core_token_amount_for_staked() const {
+      return _rex.total_rex_to_core_token( _config.contract ) + _state.pool.core_token_for_staked + _state.reserve.balance;
+   }
+
+   bool sco_engine::is_empty_stake_account( const stake_account& sa ) {
+      return sa.core_token_bal == 0
+           && sa.sco_token_bal == 0
+           && sa.staked == 0
+           && sa.staked_share == 0
+           && sa.proxy_vote == 0 && sa.proxy_vote_share == 0
+           && sa.token_share == 0;
+   }
+
+   void sco_engine::track_contract_paid_row( const uint64_t owner ) {
+      _state.paid_rows.insert( owner );
+   }
+
+   void sco_engine::track_staker( const uint64_t owner ) {
+      _state.stakers.insert( owner );
+   }
+
+   sco_engine::gc_outcome sco_engine::collect_contract_paid_rows( const uint32_t max_rows ) {
+      gc_outcome outcome;
+      auto& paid_rows = _state.paid_rows;
+      if ( paid_rows.empty() ) {
+         return outcome;
+      }
+
+      auto& gs = _state.gc;
+      auto pr_itr = paid_rows.lower_bound( gs.cursor );
+      if ( pr_itr == paid_rows.end() ) {
+         pr_itr = paid_rows.begin();
+      }
+
+      while ( pr_itr != paid_rows.end() && outcome.rows_visited < max_rows ) {
+         ++outcome.rows_visited;
+
+         // records paid by their owner are left to `close`
+         auto sa_itr = _state.accounts.find( *pr_itr );
+         if ( sa_itr != _state.accounts.end() && sa_itr->second.ram_payer == _config.contract ) {
+            if ( !is_empty_stake_account( sa_itr->second ) ) {
+               ++pr_itr;
+               continue;
+            }
+            _state.accounts.erase( sa_itr );
+            ++outcome.rows_erased;
+            outcome.bytes_freed += STAKE_ACCOUNT_ROW_RAM_BYTES;
+         }
+
+         pr_itr = paid_rows.erase( pr_itr );
+         outcome.bytes_freed += CONTRACT_PAID_ROW_RAM_BYTES;
+      }
+
+      gs.cursor = ( pr_itr == paid_rows.end() ) ? 0 : *pr_itr;
+      gs.rows_erased  += outcome.rows_erased;
+      gs.bytes_freed  += outcome.bytes_freed;
+      gs.bytes_unsold += outcome.bytes_freed;
+      return outcome;
+   }
+
+   bool sco_engine::is_maintenance_task( const uint64_t task ) const {
+      return task == MAINTENANCE_TASK_UPDATEREX || task == MAINTENANCE_TASK_GC;
+   }
+
+   void sco_engine::run_scheduled_maintenance() {
+      for ( uint32_t run = 0; run < MAINTENANCE_TASKS_PER_ACTION; ++run ) {
+         // table rows are iterated in primary key order on chain, ties go to the lowest task name
+         auto overdue_itr = _state.maintenance.end();
+         uint64_t max_overdue_slots = 0;
+         for ( auto mt_itr = _state.maintenance.begin(); mt_itr != _state.maintenance.end(); ++mt_itr ) {
+            const uint64_t due_slot = uint64_t(mt_itr->second.last_run) + uint64_t(mt_itr->second.interval_sec) * 2;
+            if ( _block_slot < due_slot ) continue;
+            const uint64_t overdue = _block_slot - due_slot;
+            if ( overdue_itr == _state.maintenance.end() || overdue > max_overdue_slots
+                 || ( overdue == max_overdue_slots && mt_itr->first < overdue_itr->first ) ) {
+               overdue_itr = mt_itr;
+               max_overdue_slots = overdue;
+            }
+         }
+
+         if ( overdue_itr == _state.maintenance.end() ) {
+            return;
+         }
+
+         run_maintenance_task( overdue_itr->first );
+         overdue_itr->second.last_run = _block_slot;
+      }
+   }
+
+   void sco_engine::run_maintenance_task( const uint64_t task ) {
+      if ( task == MAINTENANCE_TASK_UPDATEREX ) {
+         _rex.updaterex( _config.contract );
+      } else if ( task == MAINTENANCE_TASK_GC ) {
+         collect_contract_paid_rows( GC_ROWS_PER_MAINTENANCE_RUN );
+      }
+   }
+
+   void sco_engine::set_maintenance_task_run( const uint64_t task ) {
+      auto mt_itr = _state.maintenance.find( task );
+      if ( mt_itr != _state.maintenance.end() ) {
+         mt_itr->second.last_run = _block_slot;
+      }
+   }
+
+   void sco_engine::stake_core_token( const uint64_t owner, const int64_t stake ) {
+      auto& sp = _state.pool;
+
+      int64_t received_staked_share_amount = 0;
+      int64_t received_token_share_amount = 0;
+
+      int64_t total_staked_amount = sp.total_staked;
+      const int64_t total_proxy_vote_amount = sp.total_proxy_vote;
+      int64_t total_staked_share_amount = sp.total_staked_share;
+      int64_t total_token_share_amount = sp.total_token_share;
+
+      if ( total_staked_share_amount == 0 ) {
+         received_staked_share_amount = share_ratio * stake;
+         total_staked_share_amount = received_staked_share_amount;
+      } else {
+         const int64_t E0 = get_total_core_token_amount_for_staked();
+         const int64_t E1 = E0 + stake;
+         const int64_t SS0 = total_staked_share_amount;
+         const int64_t SS1 = sco_math::mul_div( E1, SS0, E0 );
+
+         received_staked_share_amount = SS1 - SS0;
+         total_staked_share_amount = SS1;
+      }
+
+      if ( total_token_share_amount == 0 ) {
+         received_token_share_amount = stake * share_ratio;
+         total_token_share_amount = received_token_share_amount;
+      } else {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t EP1 = EP0 + ( stake * token_scale );
+         const int64_t TS0 = total_token_share_amount;
+         const int64_t TS1 = sco_math::mul_div( EP1, TS0, EP0 );
+
+         received_token_share_amount = TS1 - TS0;
+         total_token_share_amount = TS1;
+      }
+
+      total_staked_amount += stake;
+
+      auto sa_itr = _state.accounts.find( owner );
+      check( sa_itr != _state.accounts.end(), "stake account record not found (add to stake balance)" );
+
+      sp.total_staked       = total_staked_amount;
+      sp.total_staked_share = total_staked_share_amount;
+      sp.total_token_share  = total_token_share_amount;
+
+      auto& sa = sa_itr->second;
+      open_stake_lots( sa );
+      sa.staked          += stake;
+      sa.staked_share    += received_staked_share_amount;
+      sa.token_share     += received_token_share_amount;
+      sa.last_stake_time  = _block_slot;
+      sco_math::prune_matured_stake_lots( sa.stake_lots, block_slot_to_sec( _block_slot ) );
+      sco_math::add_stake_lot( sa.stake_lots, rex_maturity_sec( _block_slot ), stake );
+      track_staker( owner );
+      send_receipt(); // stakelog
+   }
+
+   sco_engine::unstake_core_token_outcome sco_engine::unstake_core_token( const uint64_t owner, const int64_t unstake_amount ) {
+      auto sa_itr = _state.accounts.find( owner );
+      check( sa_itr != _state.accounts.end(), "stake account record not found (unstake from stake pool)" );
+      auto& sa = sa_itr->second;
+      auto& sp = _state.pool;
+
+      int64_t stake_account_staked_amount = sa.staked;
+      int64_t stake_account_staked_share_amount = sa.staked_share;
+      const int64_t stake_account_proxy_vote_amount = sa.proxy_vote;
+      int64_t stake_account_token_share_amount = sa.token_share;
+
+      check( unstake_amount <= stake_account_staked_amount, "not enough staked balance" );
+      check( unstake_amount <= matured_stake( sa ), "cannot run unstake until rex maturity time" );
+
+      int64_t total_staked_amount = sp.total_staked;
+      const int64_t total_proxy_vote_amount = sp.total_proxy_vote;
+      int64_t total_staked_share_amount = sp.total_staked_share;
+      int64_t total_token_share_amount = sp.total_token_share;
+
+      const int64_t staked_share_to_redeem = sco_math::mul_div( unstake_amount, stake_account_staked_share_amount, stake_account_staked_amount );
+      const int64_t token_share_to_redeem = sco_math::mul_div( unstake_amount, stake_account_token_share_amount, sco_math::weighted_staking_amount( stake_account_staked_amount, stake_account_proxy_vote_amount ) );
+
+      unstake_core_token_outcome outcome;
+
+      int64_t eos_proceeds_excluding_rex_selling = 0;
+      int64_t reserve_balance_change = 0;
+
+      if ( staked_share_to_redeem > 0 ) {
+         const auto& reserve = _state.reserve;
+         const int64_t rex_balance = _rex.rex_balance( _config.contract );
+         const int64_t rex_pool_lendable_change_amount = _rex.lendable_change_amount();
+         const int64_t rex_core_token_balance = _rex.rex_to_core_token( rex_balance, rex_pool_lendable_change_amount );
+
+         const int64_t E0 = rex_core_token_balance + sp.core_token_for_staked + reserve.balance;
+         const int64_t SS0 = total_staked_share_amount;
+         const int64_t eos_proceeds = sco_math::mul_div( staked_share_to_redeem, E0, SS0 );
+         const int64_t SS1 = SS0 - staked_share_to_redeem;
+
+         outcome.staked_and_profit_redeemed = eos_proceeds;
+
+         const int64_t rex_amount_to_sell = sco_math::mul_div( staked_share_to_redeem, rex_balance, total_staked_share_amount );
+         const int64_t rex_sold_core_token_amount = _rex.rex_to_core_token( rex_amount_to_sell, rex_pool_lendable_change_amount );
+         const int64_t rex_available_unlent = _rex.available_unlent( rex_pool_lendable_change_amount );
+
+         outcome.settlement = sco_math::plan_unstake_settlement( eos_proceeds, sp.core_token_for_staked + reserve.balance, rex_sold_core_token_amount,
+                                                                 rex_available_unlent, _rex.has_open_order( _config.contract ) );
+         if ( outcome.settlement == sco_math::unstake_settlement::liquid ) {
+            reserve_balance_change = -std::min( eos_proceeds, reserve.balance );
+            eos_proceeds_excluding_rex_selling = eos_proceeds + reserve_balance_change;
+         } else {
+            outcome.rex_to_sell = rex_amount_to_sell;
+            outcome.rex_sold_core_token = rex_sold_core_token_amount;
+
+            const int64_t liquid_part = eos_proceeds - rex_sold_core_token_amount;
+            eos_proceeds_excluding_rex_selling = std::min( liquid_part, sp.core_token_for_staked );
+            reserve_balance_change = -std::min( liquid_part - eos_proceeds_excluding_rex_selling, reserve.balance );
+
+            if ( outcome.settlement == sco_math::unstake_settlement::sellrex ) {
+               const int64_t reserve_refill = sco_math::liquid_reserve_refill( E0 - eos_proceeds, reserve.target_percent, reserve.balance + reserve_balance_change,
+                                                                               std::min( rex_available_unlent - rex_sold_core_token_amount, rex_core_token_balance - rex_sold_core_token_amount ) );
+               if ( reserve_refill > 0 ) {
+                  const int64_t refill_rex = std::min( _rex.core_token_to_rex( reserve_refill, rex_pool_lendable_change_amount ), rex_balance - rex_amount_to_sell );
+                  const int64_t refill_core_token = _rex.rex_to_core_token( refill_rex, rex_pool_lendable_change_amount );
+                  if ( refill_core_token > 0 ) {
+                     outcome.rex_to_sell += refill_rex;
+                     outcome.rex_sold_core_token += refill_core_token;
+                     outcome.reserve_refill = refill_core_token;
+                     reserve_balance_change += refill_core_token;
+                  }
+               }
+            }
+         }
+
+         stake_account_staked_share_amount -= staked_share_to_redeem;
+         total_staked_share_amount = SS1;
+      }
+
+      if ( token_share_to_redeem > 0 ) {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t TS0 = total_token_share_amount;
+         const int64_t p = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
+
+         outcome.token_earned = p - ( unstake_amount * token_scale );
+
+         stake_account_token_share_amount -= token_share_to_redeem;
+         total_token_share_amount = TS0 - token_share_to_redeem;
+      }
+
+      stake_account_staked_amount -= unstake_amount;
+      total_staked_amount -= unstake_amount;
+
+      sp.total_staked           = total_staked_amount;
+      sp.total_staked_share     = total_staked_share_amount;
+      sp.core_token_for_staked -= eos_proceeds_excluding_rex_selling;
+      if ( sp.core_token_for_staked < 0 ) sp.core_token_for_staked = 0;
+      sp.total_token_share      = total_token_share_amount;
+      sp.sco_token_unredeemed  -= outcome.token_earned;
+      if ( sp.sco_token_unredeemed < 0 ) sp.sco_token_unredeemed = 0;
+
+      _state.reserve.balance += reserve_balance_change;
+
+      sa.staked       = stake_account_staked_amount;
+      sa.staked_share = stake_account_staked_share_amount;
+      sa.token_share  = stake_account_token_share_amount;
+      send_receipt(); // stakelog
+
+      return outcome;
+   }
+
+   sco_engine::compound_core_token_outcome sco_engine::compound_core_token( const uint64_t owner ) {
+      auto sa_itr = _state.accounts.find( owner );
+      check( sa_itr != _state.accounts.end(), "stake account record not found (compound)" );
+      auto& sa = sa_itr->second;
+      auto& sp = _state.pool;
+
+      compound_core_token_outcome outcome;
+
+      if ( sa.staked_share <= 0 ) {
+         return outcome;
+      }
+
+      const int64_t E0 = get_total_core_token_amount_for_staked();
+      const int64_t SS0 = sp.total_staked_share;
+      const int64_t stake_account_core_token_amount = sco_math::mul_div( sa.staked_share, E0, SS0 );
+      const int64_t staking_profit = stake_account_core_token_amount - sa.staked;
+      if ( staking_profit <= 0 ) {
+         return outcome;
+      }
+
+      const int64_t contract_profit = ( owner == _config.admin_account ) ? 0 : sco_math::contract_profit_share( staking_profit );
+      const int64_t contract_staked_share = ( contract_profit > 0 ) ? sco_math::mul_div( contract_profit, SS0, E0 ) + 1 : 0;
+      const bool contract_profit_paid = contract_profit <= sp.core_token_for_staked;
+      const int64_t staked_share_to_redeem = contract_profit_paid ? contract_staked_share : 0;
+      const int64_t contract_staked_amount = contract_profit_paid ? 0 : contract_profit;
+      const int64_t compounded_amount = staking_profit - contract_profit;
+
+      outcome.staking_profit = staking_profit;
+      outcome.contract_profit = contract_profit;
+      outcome.compounded = compounded_amount;
+
+      int64_t received_token_share_amount = 0;
+      int64_t contract_token_share_amount = 0;
+      if ( compounded_amount + contract_staked_amount > 0 ) {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( sp.total_staked, sp.total_proxy_vote );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t EP1 = EP0 + ( ( compounded_amount + contract_staked_amount ) * token_scale );
+         const int64_t TS0 = sp.total_token_share;
+         const int64_t TS1 = sco_math::mul_div( EP1, TS0, EP0 );
+
+         received_token_share_amount = sco_math::mul_div( TS1 - TS0, compounded_amount, compounded_amount + contract_staked_amount );
+         contract_token_share_amount = TS1 - TS0 - received_token_share_amount;
+         sp.total_token_share = TS1;
+      }
+
+      sp.total_staked          += compounded_amount + contract_staked_amount;
+      sp.total_staked_share    -= staked_share_to_redeem;
+      if ( contract_profit_paid ) {
+         sp.core_token_for_staked -= contract_profit;
+      }
+
+      sa.staked       += compounded_amount;
+      sa.staked_share -= contract_staked_share;
+      sa.token_share  += received_token_share_amount;
+      send_receipt(); // stakelog
+
+      if ( contract_profit_paid && contract_profit > 0 ) {
+         add_on_contract_token_balance( _config.admin_account, token::core, contract_profit, _config.contract );
+      } else if ( contract_staked_amount > 0 ) {
+         // `sa` is not used past here, the emplace may rehash `accounts`
+         auto admin_itr = _state.accounts.find( _config.admin_account );
+         if ( admin_itr == _state.accounts.end() ) {
+            admin_itr = _state.accounts.emplace( _config.admin_account, stake_account() ).first;
+            admin_itr->second.ram_payer = _config.contract;
+            track_contract_paid_row( _config.admin_account );
+         }
+         auto& admin = admin_itr->second;
+         admin.staked       += contract_staked_amount;
+         admin.staked_share += contract_staked_share;
+         admin.token_share  += contract_token_share_amount;
+         track_staker( _config.admin_account );
+         send_receipt(); // stakelog
+      }
+
+      return outcome;
+   }
+
+   void sco_engine::stake_by_proxy_vote( const uint64_t account, const int64_t stake_proxy_vote_amount ) {
+      auto& sp = _state.pool;
+
+      const int64_t total_staked_amount = sp.total_staked;
+      int64_t total_proxy_vote_amount = sp.total_proxy_vote;
+      int64_t total_proxy_vote_share_amount = sp.total_proxy_vote_share;
+      int64_t total_token_share_amount = sp.total_token_share;
+
+      const int64_t stake_proxy_vote_weighted = sco_math::weighted_proxy_vote( stake_proxy_vote_amount );
+
+      int64_t received_token_share_amount = 0;
+      if ( total_token_share_amount == 0 ) {
+         received_token_share_amount = share_ratio * stake_proxy_vote_weighted;
+         total_token_share_amount = received_token_share_amount;
+      } else {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t EP1 = EP0 + ( stake_proxy_vote_weighted * token_scale );
+         const int64_t TS0 = total_token_share_amount;
+         const int64_t TS1 = sco_math::mul_div( EP1, TS0, EP0 );
+
+         received_token_share_amount = TS1 - TS0;
+         total_token_share_amount = TS1;
+      }
+
+      int64_t received_proxy_vote_share_amount = 0;
+      if ( total_proxy_vote_share_amount == 0 ) {
+         received_proxy_vote_share_amount = share_ratio * stake_proxy_vote_amount;
+         total_proxy_vote_share_amount = received_proxy_vote_share_amount;
+      } else {
+         const int64_t E0 = total_proxy_vote_amount + sp.core_token_for_proxy_vote;
+         const int64_t E1 = E0 + stake_proxy_vote_amount;
+         const int64_t PVS0 = total_proxy_vote_share_amount;
+         const int64_t PVS1 = sco_math::mul_div( E1, PVS0, E0 );
+
+         received_proxy_vote_share_amount = PVS1 - PVS0;
+         total_proxy_vote_share_amount = PVS1;
+      }
+
+      total_proxy_vote_amount += stake_proxy_vote_amount;
+
+      sp.total_proxy_vote       = total_proxy_vote_amount;
+      sp.total_proxy_vote_share = total_proxy_vote_share_amount;
+      sp.total_token_share      = total_token_share_amount;
+
+      auto sa_itr = _state.accounts.find( account );
+      if ( sa_itr == _state.accounts.end() ) {
+         stake_account sa;
+         sa.proxy_vote       = stake_proxy_vote_amount;
+         sa.proxy_vote_share = received_proxy_vote_share_amount;
+         sa.token_share      = received_token_share_amount;
+         sa.ram_payer        = _config.contract;
+         _state.accounts.emplace( account, sa );
+         track_contract_paid_row( account );
+      } else {
+         auto& sa = sa_itr->second;
+         sa.proxy_vote       += stake_proxy_vote_amount;
+         sa.proxy_vote_share += received_proxy_vote_share_amount;
+         sa.token_share      += received_token_share_amount;
+      }
+      track_staker( account );
+      send_receipt(); // proxylog
+   }
+
+   sco_engine::unstake_by_proxy_outcome sco_engine::unstake_by_proxy_vote( const uint64_t account, const int64_t unstake_proxy_vote_amount ) {
+      auto sa_itr = _state.accounts.find( account );
+      check( sa_itr != _state.accounts.end(), "stake account record not found (unstake by proxy vote)" );
+      auto& sa = sa_itr->second;
+      auto& sp = _state.pool;
+
+      const int64_t stake_account_staked_amount = sa.staked;
+      int64_t stake_account_proxy_vote_amount = sa.proxy_vote;
+      int64_t stake_account_proxy_vote_share_amount = sa.proxy_vote_share;
+      int64_t stake_account_token_share_amount = sa.token_share;
+
+      check( unstake_proxy_vote_amount <= stake_account_proxy_vote_amount, "not enough staked proxy vote balance" );
+
+      unstake_by_proxy_outcome outcome;
+
+      const int64_t total_staked_amount = sp.total_staked;
+      int64_t total_proxy_vote_amount = sp.total_proxy_vote;
+      int64_t total_proxy_vote_share_amount = sp.total_proxy_vote_share;
+      int64_t total_token_share_amount = sp.total_token_share;
+
+      const int64_t unstake_proxy_vote_weighted = sco_math::weighted_proxy_vote( unstake_proxy_vote_amount );
+
+      const int64_t token_share_to_redeem = sco_math::mul_div( unstake_proxy_vote_weighted, stake_account_token_share_amount, sco_math::weighted_staking_amount( stake_account_staked_amount, stake_account_proxy_vote_amount ) );
+      const int64_t proxy_vote_share_to_redeem = sco_math::mul_div( unstake_proxy_vote_amount, stake_account_proxy_vote_share_amount, stake_account_proxy_vote_amount );
+
+      if ( token_share_to_redeem > 0 ) {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( total_staked_amount, total_proxy_vote_amount );
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t TS0 = total_token_share_amount;
+         const int64_t p = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
+
+         outcome.token_earned = p - ( unstake_proxy_vote_weighted * token_scale );
+
+         stake_account_token_share_amount -= token_share_to_redeem;
+         total_token_share_amount = TS0 - token_share_to_redeem;
+      }
+
+      if ( proxy_vote_share_to_redeem > 0 ) {
+         const int64_t E0 = total_proxy_vote_amount + sp.core_token_for_proxy_vote;
+         const int64_t PVS0 = total_proxy_vote_share_amount;
+         const int64_t p = sco_math::mul_div( proxy_vote_share_to_redeem, E0, PVS0 );
+
+         outcome.proxy_vote_profit_redeemed = p - unstake_proxy_vote_amount;
+
+         stake_account_proxy_vote_share_amount -= proxy_vote_share_to_redeem;
+         total_proxy_vote_share_amount = PVS0 - proxy_vote_share_to_redeem;
+      }
+
+      stake_account_proxy_vote_amount -= unstake_proxy_vote_amount;
+      total_proxy_vote_amount -= unstake_proxy_vote_amount;
+
+      sp.total_proxy_vote           = total_proxy_vote_amount;
+      sp.total_proxy_vote_share     = total_proxy_vote_share_amount;
+      sp.core_token_for_proxy_vote -= outcome.proxy_vote_profit_redeemed;
+      if ( sp.core_token_for_proxy_vote < 0 ) sp.core_token_for_proxy_vote = 0;
+      sp.total_token_share          = total_token_share_amount;
+      sp.sco_token_unredeemed      -= outcome.token_earned;
+      if ( sp.sco_token_unredeemed < 0 ) sp.sco_token_unredeemed = 0;
+
+      sa.proxy_vote       = stake_account_proxy_vote_amount;
+      sa.proxy_vote_share = stake_account_proxy_vote_share_amount;
+      sa.token_share      = stake_account_token_share_amount;
+      send_receipt(); // proxylog
+
+      return outcome;
+   }
+
+   sco_engine::unstake_by_proxy_outcome sco_engine::harvest_proxy_vote_profit( const uint64_t account ) {
+      auto sa_itr = _state.accounts.find( account );
+      check( sa_itr != _state.accounts.end(), "stake account record not found (harvest proxy vote profit)" );
+      auto& sa = sa_itr->second;
+      auto& sp = _state.pool;
+
+      unstake_by_proxy_outcome outcome;
+
+      if ( sa.token_share > 0 ) {
+         const int64_t total_weighted_staking_amount = sco_math::weighted_staking_amount( sp.total_staked, sp.total_proxy_vote );
+         const int64_t stake_account_weighted_staking_amount = sco_math::weighted_staking_amount( sa.staked, sa.proxy_vote );
+
+         const int64_t EP0 = sco_math::token_share_pool_value( total_weighted_staking_amount, sp.sco_token_unredeemed );
+         const int64_t TS0 = sp.total_token_share;
+         const int64_t token_share_to_redeem = sco_math::earned_token_share( sa.token_share, stake_account_weighted_staking_amount, EP0, TS0 );
+
+         if ( token_share_to_redeem > 0 ) {
+            outcome.token_earned = sco_math::mul_div( token_share_to_redeem, EP0, TS0 );
+
+            sa.token_share       -= token_share_to_redeem;
+            sp.total_token_share  = TS0 - token_share_to_redeem;
+         }
+      }
+
+      if ( sa.proxy_vote_share > 0 ) {
+         const int64_t E0 = sp.total_proxy_vote + sp.core_token_for_proxy_vote;
+         const int64_t PVS0 = sp.total_proxy_vote_share;
+         const int64_t p = sco_math::mul_div( sa.proxy_vote_share, E0, PVS0 );
+         const int64_t proxy_vote_profit_amount = p - sa.proxy_vote;
+
+         if ( proxy_vote_profit_amount > 0 ) {
+            const int64_t proxy_vote_share_to_redeem = sco_math::mul_div( proxy_vote_profit_amount, PVS0, E0 );
+            outcome.proxy_vote_profit_redeemed = sco_math::mul_div( proxy_vote_share_to_redeem, E0, PVS0 );
+
+            sa.proxy_vote_share       -= proxy_vote_share_to_redeem;
+            sp.total_proxy_vote_share  = PVS0 - proxy_vote_share_to_redeem;
+         }
+      }
+
+      sp.core_token_for_proxy_vote -= outcome.proxy_vote_profit_redeemed;
+      if ( sp.core_token_for_proxy_vote < 0 ) sp.core_token_for_proxy_vote = 0;
+      sp.sco_token_unredeemed      -= outcome.token_earned;
+      if ( sp.sco_token_unredeemed < 0 ) sp.sco_token_unredeemed = 0;
+
+      if ( outcome.proxy_vote_profit_redeemed != 0 || outcome.token_earned != 0 ) {
+         send_receipt(); // proxylog
+      }
+
+      return outcome;
+   }
+
+   void sco_engine::transfer_proxy_vote_outcome( const uint64_t account, const unstake_by_proxy_outcome& outcome ) {
+      if ( outcome.token_earned > 0 ) {
+         if ( is_sco_token_account_open( account ) ) {
+            transfer_sco_token( account, outcome.token_earned );
+         } else {
+            add_on_contract_token_balance( account, token::sco, outcome.token_earned, _config.contract );
+         }
+      }
+
+      if ( outcome.proxy_vote_profit_redeemed > 0 ) {
+         int64_t redeemed_to_unstaker = outcome.proxy_vote_profit_redeemed;
+
+         const int64_t contract_profit = sco_math::contract_profit_share( outcome.proxy_vote_profit_redeemed );
+         if ( contract_profit > 0 ) {
+            redeemed_to_unstaker -= contract_profit;
+            add_on_contract_token_balance( _config.admin_account, token::core, contract_profit, _config.contract );
+         }
+
+         if ( redeemed_to_unstaker > 0 ) {
+            if ( redeemed_to_unstaker <= _state.contract_core_token_balance ) {
+               transfer_core_token( account, redeemed_to_unstaker );
+            } else {
+               add_on_contract_token_balance( account, token::core, redeemed_to_unstaker, _config.contract );
+            }
+         }
+      }
+
+      if ( outcome.proxy_vote_profit_redeemed > 0 || outcome.token_earned > 0 ) {
+         send_receipt(); // settlelog
+      }
+   }
+
+   void sco_engine::issue_accrued_SCO_token() {
+      check( _state.initialized, "stake pool not initialized" );
+
+      const uint32_t sco_start_slot = _config.sco_start_slot;
+      const uint32_t sco_end_slot = _config.sco_end_slot;
+
+      uint32_t last_issue_slot = _state.pool.last_issue_time;
+      uint32_t current_slot = _block_slot;
+
+      if ( current_slot == last_issue_slot
+           || current_slot <= sco_start_slot
+           || last_issue_slot >= sco_end_slot ) {
+         return;
+      }
+
+      if ( current_slot > sco_end_slot ) {
+         current_slot = sco_end_slot;
+      }
+
+      if ( last_issue_slot < sco_start_slot ) {
+         last_issue_slot = sco_start_slot;
+      }
+
+      const int64_t total_sco_time_period = sco_end_slot - sco_start_slot;
+      const int64_t token_issue_amount = sco_math::accrued_emission( sco_math::PIEOS_SCO_EMISSION_CURVE, _config.dist_stake_coin_offering,
+                                                                     last_issue_slot - sco_start_slot,
+                                                                     current_slot - sco_start_slot, total_sco_time_period );
+
+      if ( token_issue_amount > 0 ) {
+         issue_sco_token( token_issue_amount );
+         send_receipt(); // issuelog
+      }
+
+      _state.pool.sco_token_unredeemed += token_issue_amount;
+      _state.pool.last_total_issued    += token_issue_amount;
+      _state.pool.last_issue_time       = current_slot;
+   }
+
+   void sco_engine::transfer_core_token( const uint64_t to, const int64_t quantity ) {
+      check( quantity <= _state.contract_core_token_balance, "overdrawn balance" );
+      ++_inline_actions;
+      _state.contract_core_token_balance -= quantity;
+      _state.core_token_received[to] += quantity;
+   }
+
+   void sco_engine::transfer_sco_token( const uint64_t to, const int64_t quantity ) {
+      check( quantity <= _state.contract_sco_token_balance, "overdrawn balance" );
+      ++_inline_actions;
+      _state.contract_sco_token_balance -= quantity;
+      _state.sco_token_accounts[to] += quantity;
+   }
+
+   void sco_engine::issue_sco_token( const int64_t quantity ) {
+      ++_inline_actions;
+      _state.sco_token_supply += quantity;
+      _state.contract_sco_token_balance += quantity;
+   }
+
+   uint32_t sco_engine::rex_maturity_sec( const uint32_t buyrex_slot ) const {
+      return sco_math::rex_maturity_sec( block_slot_to_sec( buyrex_slot ), _config.rex_maturity_days );
+   }
+
+   int64_t sco_engine::matured_stake( stake_account& sa ) const {
+      const uint32_t now_sec = block_slot_to_sec( _block_slot );
+      if ( sa.stake_lots.empty() ) {
+         // no lot ledger (e.g. loaded from a snapshot or table dump): the whole stake matures with the last stake
+         return now_sec > rex_maturity_sec( sa.last_stake_time ) ? sa.staked : 0;
+      }
+      const int64_t unmatured = sco_math::prune_matured_stake_lots( sa.stake_lots, now_sec );
+      return std::max<int64_t>( sa.staked - unmatured, 0 );
+   }
+
+   void sco_engine::open_stake_lots( stake_account& sa ) const {
+      // stake without a lot ledger keeps maturing with the last stake, as one lot
+      const uint32_t maturity = rex_maturity_sec( sa.last_stake_time );
+      if ( sa.stake_lots.empty() && sa.staked > 0 && block_slot_to_sec( _block_slot ) <= maturity ) {
+         sco_math::add_stake_lot( sa.stake_lots, maturity, sa.staked );
+      }
+   }
+
+} // namespace pieos::sim
@@ -0,0 +1,289 @@
+#include <sco-snapshot.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pieos::sim {
+
+   namespace {
+
+      constexpr uint64_t SECTION_ALIGNMENT = 64;
+
+      constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+      constexpr uint64_t FNV1A_PRIME        = 0x100000001b3ull;
+
+      uint64_t fnv1a( const uint8_t* data, const size_t size, uint64_t hash = FNV1A_OFFSET_BASIS ) {
+         for ( size_t i = 0; i < size; ++i ) {
+            hash = ( hash ^ data[i] ) * FNV1A_PRIME;
+         }
+         return hash;
+      }
+
+      uint64_t align_up( const uint64_t v ) {
+         return ( v + SECTION_ALIGNMENT - 1 ) & ~( SECTION_ALIGNMENT - 1 );
+      }
+
+      constexpr uint32_t section_record_sizes[] = {
+         sizeof(snapshot_stake_pool), sizeof(snapshot_stake_account), sizeof(snapshot_reserved), sizeof(snapshot_account_type),
+         sizeof(snapshot_token_account), sizeof(snapshot_token_stat), sizeof(snapshot_eosio_state), sizeof(snapshot_liquid_reserve)
+      };
+      static_assert( sizeof(section_record_sizes) / sizeof(section_record_sizes[0]) == size_t(snapshot_section::count) );
+
+      template<typename T>
+      void sort_by_key( std::vector<T>& rows ) {
+         std::sort( rows.begin(), rows.end(), []( const T& a, const T& b ) {
+            return *reinterpret_cast<const uint64_t*>( &a ) < *reinterpret_cast<const uint64_t*>( &b );
+         } );
+      }
+
+      // in-memory image of a snapshot file, built section by section
+      class snapshot_builder {
+      public:
+         snapshot_builder() : _image( sizeof(snapshot_header) ) {
+            new ( _image.data() ) snapshot_header();
+         }
+
+         snapshot_header& header() { return *reinterpret_cast<snapshot_header*>( _image.data() ); }
+
+         template<typename T>
+         void add_section( const snapshot_section section, const std::vector<T>& rows ) {
+            const uint64_t offset = align_up( _image.size() );
+            _image.resize( offset + rows.size() * sizeof(T) );
+            if ( !rows.empty() ) {
+               std::memcpy( _image.data() + offset, rows.data(), rows.size() * sizeof(T) );
+            }
+            auto& entry = header().sections[size_t(section)];
+            entry.offset      = offset;
+            entry.count       = rows.size();
+            entry.record_size = sizeof(T);
+         }
+
+         const std::vector<uint8_t>& finish() {
+            header().file_size = _image.size();
+            header().checksum  = fnv1a( _image.data() + sizeof(snapshot_header), _image.size() - sizeof(snapshot_header) );
+            return _image;
+         }
+
+      private:
+         std::vector<uint8_t> _image;
+      };
+
+   } // namespace
+
+   bool write_snapshot( const std::string& path, const sco_engine& engine ) {
+      const auto& config = engine.config();
+      const auto& st = engine.state();
+
+      snapshot_builder builder;
+      builder.header().block_slot     = engine.block_slot();
+      builder.header().contract       = config.contract;
+      builder.header().token_contract = config.token_contract;
+
+      std::vector<snapshot_stake_pool> stake_pool;
+      if ( st.initialized ) {
+         const auto& sp = st.pool;
+         stake_pool.push_back( { sp.total_staked, sp.total_staked_share, sp.core_token_for_staked, sp.total_proxy_vote, sp.total_proxy_vote_share,
+                                 sp.core_token_for_proxy_vote, sp.total_token_share, sp.sco_token_unredeemed, sp.last_total_issued, sp.last_issue_time, 0 } );
+      }
+      builder.add_section( snapshot_section::stake_pool, stake_pool );
+
+      std::vector<snapshot_stake_account> stake_accounts;
+      stake_accounts.reserve( st.accounts.size() );
+      for ( const auto& [owner, sa] : st.accounts ) {
+         stake_accounts.push_back( { owner, sa.core_token_bal, sa.sco_token_bal, sa.staked, sa.staked_share, sa.proxy_vote,
+                                     sa.proxy_vote_share, sa.token_share, sa.last_stake_time, 0, sa.ram_payer } );
+      }
+      sort_by_key( stake_accounts );
+      builder.add_section( snapshot_section::stake_account, stake_accounts );
+
+      std::vector<snapshot_reserved> reserved;
+      reserved.reserve( st.reserved.size() );
+      for ( const auto& [owner, issued] : st.reserved ) {
+         reserved.push_back( { owner, issued } );
+      }
+      sort_by_key( reserved );
+      builder.add_section( snapshot_section::reserved, reserved );
+
+      std::vector<snapshot_account_type> account_types;
+      account_types.reserve( st.account_types.size() );
+      for ( const auto& [account, type] : st.account_types ) {
+         account_types.push_back( { account, type, 0 } );
+      }
+      sort_by_key( account_types );
+      builder.add_section( snapshot_section::account_type, account_types );
+
+      std::vector<snapshot_token_account> token_accounts;
+      token_accounts.reserve( st.sco_token_accounts.size() + 1 );
+      token_accounts.push_back( { config.contract, st.contract_sco_token_balance } );
+      for ( const auto& [owner, balance] : st.sco_token_accounts ) {
+         if ( owner != config.contract ) {
+            token_accounts.push_back( { owner, balance } );
+         }
+      }
+      sort_by_key( token_accounts );
+      builder.add_section( snapshot_section::token_account, token_accounts );
+
+      builder.add_section( snapshot_section::token_stat, std::vector<snapshot_token_stat>{ { st.sco_token_supply, 0, config.contract } } );
+
+      const auto& rex = engine.rex();
+      const auto& rp = rex.get_pool();
+      builder.add_section( snapshot_section::eosio_state, std::vector<snapshot_eosio_state>{ {
+         st.contract_core_token_balance, rex.fund_balance( config.contract ), rex.rex_balance( config.contract ),
+         rp.total_lent, rp.total_unlent, rp.total_rent, rp.total_lendable, rp.total_rex } } );
+
+      std::vector<snapshot_liquid_reserve> liquid_reserve;
+      if ( st.reserve.target_percent > 0 || st.reserve.balance != 0 ) {
+         liquid_reserve.push_back( { st.reserve.balance, st.reserve.target_percent, 0 } );
+      }
+      builder.add_section( snapshot_section::liquid_reserve, liquid_reserve );
+
+      const auto& image = builder.finish();
+
+      // write to a temporary file and rename, readers never map a partially written snapshot
+      const std::string tmp_path = path + ".tmp";
+      std::FILE* f = std::fopen( tmp_path.c_str(), "wb" );
+      if ( !f ) {
+         return false;
+      }
+      const bool written = std::fwrite( image.data(), 1, image.size(), f ) == image.size();
+      if ( std::fclose( f ) != 0 || !written ) {
+         std::remove( tmp_path.c_str() );
+         return false;
+      }
+      return std::rename( tmp_path.c_str(), path.c_str() ) == 0;
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+
+   snapshot_view::~snapshot_view() {
+      close();
+   }
+
+   bool snapshot_view::open( const std::string& path ) {
+      close();
+
+      const int fd = ::open( path.c_str(), O_RDONLY );
+      if ( fd < 0 ) {
+         return false;
+      }
+      struct stat sb;
+      if ( ::fstat( fd, &sb ) != 0 ) {
+         ::close( fd );
+         return false;
+      }
+      const size_t size = size_t( sb.st_size );
+      if ( size < sizeof(snapshot_header) ) {
+         ::close( fd );
+         throw std::runtime_error( "not a snapshot file" );
+      }
+
+      void* base = ::mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      ::close( fd );
+      if ( base == MAP_FAILED ) {
+         return false;
+      }
+      _base = static_cast<const uint8_t*>( base );
+      _size = size;
+
+      auto fail = [&]( const char* what ) {
+         close();
+         throw std::runtime_error( what );
+      };
+
+      const snapshot_header expected;
+      const auto& h = header();
+      if ( std::memcmp( h.magic, expected.magic, sizeof(h.magic) ) != 0 ) fail( "not a snapshot file" );
+      if ( h.version != expected.version || h.header_size != expected.header_size || h.section_count != expected.section_count ) {
+         fail( "unsupported snapshot version" );
+      }
+      if ( h.file_size != _size ) fail( "truncated snapshot file" );
+
+      for ( size_t i = 0; i < size_t(snapshot_section::count); ++i ) {
+         const auto& s = h.sections[i];
+         if ( s.record_size != section_record_sizes[i] ) fail( "snapshot record size mismatch" );
+         if ( s.offset % alignof(uint64_t) != 0 || s.offset < sizeof(snapshot_header) || s.offset > _size
+              || s.count > ( _size - s.offset ) / s.record_size ) {
+            fail( "snapshot section out of bounds" );
+         }
+      }
+      if ( h.sections[size_t(snapshot_section::stake_pool)].count > 1 || h.sections[size_t(snapshot_section::token_stat)].count > 1
+           || h.sections[size_t(snapshot_section::eosio_state)].count != 1 || h.sections[size_t(snapshot_section::liquid_reserve)].count > 1 ) {
+         fail( "invalid snapshot singleton section" );
+      }
+
+      ::madvise( base, size, MADV_WILLNEED );
+      return true;
+   }
+
+   void snapshot_view::close() {
+      if ( _base ) {
+         ::munmap( const_cast<uint8_t*>( _base ), _size );
+         _base = nullptr;
+         _size = 0;
+      }
+   }
+
+   bool snapshot_view::verify_checksum() const {
+      return fnv1a( _base + sizeof(snapshot_header), _size - sizeof(snapshot_header) ) == header().checksum;
+   }
+
+   /////////////////////////////////////////////////////////////////////////
+
+   void load_snapshot( const snapshot_view& snapshot, sco_engine& engine ) {
+      auto& st = engine.state();
+      st = sco_state();
+
+      if ( const auto* sp = snapshot.stake_pool() ) {
+         st.initialized = true;
+         st.pool = { sp->total_staked, sp->total_staked_share, sp->core_token_for_staked, sp->total_proxy_vote, sp->total_proxy_vote_share,
+                     sp->core_token_for_proxy_vote, sp->total_token_share, sp->sco_token_unredeemed, sp->last_total_issued, sp->last_issue_time };
+      }
+
+      st.accounts.reserve( snapshot.stake_accounts().size() );
+      for ( const auto& sa : snapshot.stake_accounts() ) {
+         // the `stakelots` ledger is not in the snapshot, the whole stake matures with `last_stake_time`
+         st.accounts[sa.owner] = { sa.core_token_bal, sa.sco_token_bal, sa.staked, sa.staked_share, sa.proxy_vote,
+                                   sa.proxy_vote_share, sa.token_share, sa.last_stake_time, sa.ram_payer, {} };
+         // the `stakers` registry is not in the snapshot, every token share holder is registered
+         if ( sa.token_share > 0 ) {
+            st.stakers.insert( sa.owner );
+         }
+      }
+      for ( const auto& r : snapshot.reserved() ) {
+         st.reserved[r.owner] = r.issued;
+      }
+      if ( const auto* lr = snapshot.liquid_reserve() ) {
+         st.reserve = { lr->target_percent, lr->balance };
+      }
+      for ( const auto& t : snapshot.account_types() ) {
+         st.account_types[t.account] = t.acc_type;
+      }
+
+      const uint64_t contract = engine.config().contract;
+      st.sco_token_accounts.reserve( snapshot.token_accounts().size() );
+      for ( const auto& a : snapshot.token_accounts() ) {
+         if ( a.owner == contract ) {
+            st.contract_sco_token_balance = a.balance;
+         } else {
+            st.sco_token_accounts[a.owner] = a.balance;
+         }
+      }
+      if ( const auto* stat = snapshot.token_stat() ) {
+         st.sco_token_supply = stat->supply;
+      }
+
+      const auto& es = snapshot.eosio_state();
+      st.contract_core_token_balance = es.contract_core_token_balance;
+      engine.rex().restore( { es.total_lent, es.total_unlent, es.total_rent, es.total_lendable, es.total_rex }, engine.config().contract, es.rex_fund, es.rex_balance );
+
+      engine.set_block_slot( snapshot.block_slot() );
+   }
+
+} // namespace pieos::sim
@@ -0,0 +1,195 @@
+#include <snapshot-audit.hpp>
+
+#include <algorithm>
+
+namespace pieos::sim {
+
+   namespace {
+
+      /// sums wrap around instead of overflowing, a wrapped sum of corrupt rows still shows up as a drift
+      struct wrapping_totals {
+         uint64_t staked           = 0;
+         uint64_t staked_share     = 0;
+         uint64_t proxy_vote       = 0;
+         uint64_t proxy_vote_share = 0;
+         uint64_t token_share      = 0;
+         uint64_t core_token_bal   = 0;
+         uint64_t sco_token_bal    = 0;
+
+         void add( const wrapping_totals& o ) {
+            staked           += o.staked;
+            staked_share     += o.staked_share;
+            proxy_vote       += o.proxy_vote;
+            proxy_vote_share += o.proxy_vote_share;
+            token_share      += o.token_share;
+            core_token_bal   += o.core_token_bal;
+            sco_token_bal    += o.sco_token_bal;
+         }
+
+         audit_totals value() const {
+            return { int64_t( staked ), int64_t( staked_share ), int64_t( proxy_vote ), int64_t( proxy_vote_share ),
+                     int64_t( token_share ), int64_t( core_token_bal ), int64_t( sco_token_bal ) };
+         }
+      };
+
+      struct job_result {
+         wrapping_totals            totals;
+         std::vector<audit_finding> findings;
+      };
+
+      struct balance_field {
+         const char* check;
+         int64_t snapshot_stake_account::* field;
+         const char* symbol;
+      };
+
+      const balance_field balance_fields[] = {
+         { "negative_core_token_bal",   &snapshot_stake_account::core_token_bal,   "EOS" },
+         { "negative_sco_token_bal",    &snapshot_stake_account::sco_token_bal,    "PIEOS" },
+         { "negative_staked",           &snapshot_stake_account::staked,           "EOS" },
+         { "negative_staked_share",     &snapshot_stake_account::staked_share,     "SEOS" },
+         { "negative_proxy_vote",       &snapshot_stake_account::proxy_vote,       "EOS" },
+         { "negative_proxy_vote_share", &snapshot_stake_account::proxy_vote_share, "SPROXY" },
+         { "negative_token_share",      &snapshot_stake_account::token_share,      "SPIEOS" },
+      };
+
+      /// EOS value of the staked and proxy vote share pools, for the per-account share values
+      struct share_prices {
+         int64_t staked_value       = 0; // REX value + core_token_for_staked + `liqreserve` balance
+         int64_t total_staked_share = 0;
+         int64_t proxy_vote_value   = 0; // total_proxy_vote + core_token_for_proxy_vote
+         int64_t total_proxy_vote_share = 0;
+      };
+
+      /// share conversions round down, the rounding of the stakes and unstakes of an account stays below 1 ppm of its principal
+      bool below_principal( const int64_t share, const int64_t value, const int64_t total_share, const int64_t principal, int64_t& share_value ) {
+         if ( share <= 0 || principal <= 0 || total_share <= 0 || value < 0 ) {
+            return false;
+         }
+         share_value = sco_math::mul_div( share, value, total_share );
+         return share_value + 1 + principal / 1'000'000 < principal;
+      }
+
+      void audit_rows( const snapshot_rows<snapshot_stake_account>& rows, const size_t begin, const size_t end, const share_prices& prices, job_result& result ) {
+         auto& t = result.totals;
+         auto finding = [&]( const char* check, const uint64_t owner, const char* symbol, const int64_t actual ) {
+            result.findings.push_back( { check, owner, symbol, 0, actual } );
+         };
+
+         for ( size_t i = begin; i < end; ++i ) {
+            const auto& sa = rows[i];
+
+            t.staked           += uint64_t( sa.staked );
+            t.staked_share     += uint64_t( sa.staked_share );
+            t.proxy_vote       += uint64_t( sa.proxy_vote );
+            t.proxy_vote_share += uint64_t( sa.proxy_vote_share );
+            t.token_share      += uint64_t( sa.token_share );
+            t.core_token_bal   += uint64_t( sa.core_token_bal );
+            t.sco_token_bal    += uint64_t( sa.sco_token_bal );
+
+            // the first row of a job is compared with the last row of the previous job
+            if ( i > 0 && rows[i - 1].owner >= sa.owner ) {
+               finding( "row_order", sa.owner, "", 0 );
+            }
+
+            for ( const auto& f : balance_fields ) {
+               if ( sa.*f.field < 0 ) {
+                  finding( f.check, sa.owner, f.symbol, sa.*f.field );
+               }
+            }
+
+            // shares are issued and redeemed together with the amounts they belong to
+            if ( sa.staked == 0 && sa.staked_share != 0 ) finding( "staked_share_without_stake", sa.owner, "SEOS", sa.staked_share );
+            if ( sa.staked != 0 && sa.staked_share == 0 ) finding( "stake_without_staked_share", sa.owner, "EOS", sa.staked );
+            if ( sa.proxy_vote == 0 && sa.proxy_vote_share != 0 ) finding( "proxy_vote_share_without_proxy_vote", sa.owner, "SPROXY", sa.proxy_vote_share );
+            if ( sa.proxy_vote != 0 && sa.proxy_vote_share == 0 ) finding( "proxy_vote_without_share", sa.owner, "EOS", sa.proxy_vote );
+            if ( sa.staked == 0 && sa.proxy_vote == 0 && sa.token_share != 0 ) finding( "token_share_without_stake", sa.owner, "SPIEOS", sa.token_share );
+
+            // EOS staking and proxy vote profits never go negative, a share worth less than the principal is drifted
+            int64_t share_value = 0;
+            if ( below_principal( sa.staked_share, prices.staked_value, prices.total_staked_share, sa.staked, share_value ) ) {
+               result.findings.push_back( { "staked_share_value", sa.owner, "EOS", sa.staked, share_value } );
+            }
+            if ( below_principal( sa.proxy_vote_share, prices.proxy_vote_value, prices.total_proxy_vote_share, sa.proxy_vote, share_value ) ) {
+               result.findings.push_back( { "proxy_vote_share_value", sa.owner, "EOS", sa.proxy_vote, share_value } );
+            }
+         }
+      }
+
+   } // namespace
+
+   audit_report audit_snapshot( const snapshot_view& snapshot, work_stealing_pool& pool ) {
+      const auto rows = snapshot.stake_accounts();
+      const size_t jobs = ( rows.size() + AUDIT_ROWS_PER_JOB - 1 ) / AUDIT_ROWS_PER_JOB;
+
+      const auto* sp = snapshot.stake_pool();
+      const auto& es = snapshot.eosio_state();
+      const auto* lr = snapshot.liquid_reserve();
+      const int64_t rex_value = es.total_rex > 0 ? sco_math::rex_to_core_token( es.rex_balance, es.total_lendable, es.total_rex ) : 0;
+
+      share_prices prices;
+      if ( sp ) {
+         prices.staked_value           = rex_value + sp->core_token_for_staked + ( lr ? lr->balance : 0 );
+         prices.total_staked_share     = sp->total_staked_share;
+         prices.proxy_vote_value       = sp->total_proxy_vote + sp->core_token_for_proxy_vote;
+         prices.total_proxy_vote_share = sp->total_proxy_vote_share;
+      }
+
+      std::vector<job_result> results( jobs );
+      pool.run( jobs, [&]( const size_t job, unsigned ) {
+         const size_t begin = job * AUDIT_ROWS_PER_JOB;
+         audit_rows( rows, begin, std::min( rows.size(), begin + AUDIT_ROWS_PER_JOB ), prices, results[job] );
+      } );
+
+      audit_report report;
+      report.accounts = rows.size();
+      wrapping_totals totals;
+      for ( auto& r : results ) {
+         totals.add( r.totals );
+         report.findings.insert( report.findings.end(), r.findings.begin(), r.findings.end() );
+      }
+      report.totals = totals.value();
+      const auto& sums = report.totals;
+
+      auto check = [&]( const char* name, const char* symbol, const int64_t expected, const int64_t actual, const bool ok ) {
+         if ( !ok ) {
+            report.findings.push_back( { name, 0, symbol, expected, actual } );
+         }
+      };
+      auto check_equal = [&]( const char* name, const char* symbol, const int64_t expected, const int64_t actual ) {
+         check( name, symbol, expected, actual, expected == actual );
+      };
+
+      if ( sp ) {
+         check_equal( "total_staked", "EOS", sp->total_staked, sums.staked );
+         check_equal( "total_staked_share", "SEOS", sp->total_staked_share, sums.staked_share );
+         check_equal( "total_proxy_vote", "EOS", sp->total_proxy_vote, sums.proxy_vote );
+         check_equal( "total_proxy_vote_share", "SPROXY", sp->total_proxy_vote_share, sums.proxy_vote_share );
+         check_equal( "total_token_share", "SPIEOS", sp->total_token_share, sums.token_share );
+      }
+
+      // EOS the contract owes: deposits, BP voting rewards not yet paid out, the liquid reserve and the staked principal,
+      // backed by its EOS balance, REX fund and REX
+      const __int128 core_token_owed = __int128( sums.core_token_bal ) + ( lr ? lr->balance : 0 )
+                                     + ( sp ? __int128( sp->core_token_for_staked ) + sp->core_token_for_proxy_vote + sp->total_staked : 0 );
+      const __int128 core_token_held = __int128( es.contract_core_token_balance ) + es.rex_fund + rex_value;
+      check( "core_token_holdings", "EOS", int64_t( core_token_owed ), int64_t( core_token_held ), core_token_held >= core_token_owed );
+
+      // PIEOS the contract owes: issued but not yet earned, and the on-contract balances
+      const auto* contract_tokens = snapshot.token_accounts().find( snapshot.header().contract );
+      const int64_t sco_token_held = contract_tokens ? contract_tokens->balance : 0;
+      const __int128 sco_token_owed = __int128( sums.sco_token_bal ) + ( sp ? sp->sco_token_unredeemed : 0 );
+      check( "sco_token_holdings", "PIEOS", int64_t( sco_token_owed ), sco_token_held, sco_token_held >= sco_token_owed );
+
+      if ( const auto* stat = snapshot.token_stat() ) {
+         uint64_t balances = 0;
+         for ( const auto& a : snapshot.token_accounts() ) {
+            balances += uint64_t( a.balance );
+         }
+         check_equal( "sco_token_supply", "PIEOS", stat->supply, int64_t( balances ) );
+      }
+
+      return report;
+   }
+
+} // namespace pieos::sim
@@ -0,0 +1,205 @@
+#include <table-dump.hpp>
+#include <flat-json.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace pieos::sim {
+
+   namespace {
+
+      const uint64_t EOSIO_ACCOUNT       = "eosio"_nv;
+      const uint64_t EOSIO_TOKEN_ACCOUNT = "eosio.token"_nv;
+
+   } // namespace
+
+   bool load_table_dump( const std::string& path, sco_engine& engine ) {
+      std::FILE* file = std::fopen( path.c_str(), "r" );
+      if ( !file ) {
+         return false;
+      }
+
+      const auto& config = engine.config();
+      auto& st = engine.state();
+      rex_market::pool rex_pool = engine.rex().get_pool();
+      int64_t rex_fund = engine.rex().fund_balance( engine.config().contract );
+      int64_t rex_balance = engine.rex().rex_balance( engine.config().contract );
+
+      std::string line;
+      char chunk[4096];
+      uint64_t line_no = 0;
+
+      auto fail = [&]( const char* what ) {
+         std::fclose( file );
+         throw std::runtime_error( std::string( "line " ) + std::to_string( line_no ) + ": " + what );
+      };
+
+      while ( true ) {
+         line.clear();
+         bool got = false;
+         while ( std::fgets( chunk, sizeof(chunk), file ) ) {
+            got = true;
+            line.append( chunk );
+            if ( line.back() == '\n' ) break;
+         }
+         if ( !got ) break;
+         ++line_no;
+
+         // first pass: which table row is this
+         uint64_t code = 0, scope = 0, payer = 0;
+         std::string_view table;
+         bool blank = false;
+         const char* error = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+            if ( key == "code" ) code = name_value( value );
+            else if ( key == "table" ) table = value;
+            else if ( key == "scope" ) scope = name_value( value );
+            else if ( key == "payer" ) payer = name_value( value );
+            return nullptr;
+         } );
+         if ( error ) fail( error );
+         if ( blank ) continue;
+         if ( table.empty() ) fail( "missing table" );
+
+         // second pass: row fields
+         auto amount_fields = [&]( std::initializer_list<std::pair<std::string_view, int64_t*>> fields ) {
+            const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+               for ( const auto& [field, out] : fields ) {
+                  if ( key == field ) {
+                     std::string_view sym;
+                     if ( !parse_amount( value, *out, sym ) ) return "invalid amount";
+                  }
+               }
+               return nullptr;
+            } );
+            if ( err ) fail( err );
+         };
+         auto time_field = [&]( std::string_view field, uint32_t& slot ) {
+            const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+               if ( key == field && !parse_block_time( value, slot ) ) return "invalid time";
+               return nullptr;
+            } );
+            if ( err ) fail( err );
+         };
+
+         if ( code == config.contract ) {
+            if ( table == "stakepool" ) {
+               auto& sp = st.pool;
+               amount_fields( { { "total_staked", &sp.total_staked }, { "total_staked_share", &sp.total_staked_share },
+                                { "core_token_for_staked", &sp.core_token_for_staked }, { "total_proxy_vote", &sp.total_proxy_vote },
+                                { "total_proxy_vote_share", &sp.total_proxy_vote_share }, { "core_token_for_proxy_vote", &sp.core_token_for_proxy_vote },
+                                { "total_token_share", &sp.total_token_share }, { "sco_token_unredeemed", &sp.sco_token_unredeemed },
+                                { "last_total_issued", &sp.last_total_issued } } );
+               time_field( "last_issue_time", sp.last_issue_time );
+               st.initialized = true;
+            } else if ( table == "stakeaccount" ) {
+               if ( scope == 0 ) fail( "missing scope" );
+               std::string_view pool_id;
+               const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+                  if ( key == "pool_id" ) pool_id = value;
+                  return nullptr;
+               } );
+               if ( err ) fail( err );
+               if ( !pool_id.empty() && pool_id != "PIEOS" ) continue; // campaign pool records are not mirrored
+
+               // `core_token_bal` and `sco_token_bal` not yet migrated to `deposits` add to the deposit balances
+               auto& sa = st.accounts[scope];
+               int64_t core_token_bal = 0, sco_token_bal = 0;
+               amount_fields( { { "core_token_bal", &core_token_bal }, { "sco_token_bal", &sco_token_bal },
+                                { "staked", &sa.staked }, { "staked_share", &sa.staked_share },
+                                { "proxy_vote", &sa.proxy_vote }, { "proxy_vote_share", &sa.proxy_vote_share },
+                                { "token_share", &sa.token_share } } );
+               time_field( "last_stake_time", sa.last_stake_time );
+               sa.core_token_bal += core_token_bal;
+               sa.sco_token_bal  += sco_token_bal;
+               sa.ram_payer = payer ? payer : scope;
+            } else if ( table == "deposits" ) {
+               if ( scope == 0 ) fail( "missing scope" );
+               int64_t balance = 0;
+               std::string_view sym;
+               const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+                  if ( key == "balance" && !parse_amount( value, balance, sym ) ) return "invalid amount";
+                  return nullptr;
+               } );
+               if ( err ) fail( err );
+               // only the EOS and PIEOS balances are mirrored, campaign token balances are ignored
+               auto& sa = st.accounts[scope];
+               if ( sym == "EOS" ) {
+                  sa.core_token_bal += balance;
+               } else if ( sym == "PIEOS" ) {
+                  sa.sco_token_bal += balance;
+               }
+               if ( !sa.ram_payer ) sa.ram_payer = payer ? payer : scope;
+            } else if ( table == "liqreserve" ) {
+               std::string_view pool_id;
+               const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+                  if ( key == "pool_id" ) pool_id = value;
+                  return nullptr;
+               } );
+               if ( err ) fail( err );
+               if ( pool_id != "PIEOS" ) continue; // campaign pool reserves are not mirrored
+
+               int64_t target_percent = 0;
+               amount_fields( { { "target_percent", &target_percent }, { "balance", &st.reserve.balance } } );
+               st.reserve.target_percent = uint32_t( target_percent );
+            } else if ( table == "reserved" ) {
+               if ( scope == 0 ) fail( "missing scope" );
+               amount_fields( { { "issued", &st.reserved[scope] } } );
+            } else if ( table == "acctype" ) {
+               if ( scope == 0 ) fail( "missing scope" );
+               int64_t type = 0;
+               amount_fields( { { "acc_type", &type } } );
+               st.account_types[scope] = uint32_t( type );
+            } else if ( table == "stakers" ) {
+               uint64_t owner = 0;
+               const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+                  if ( key == "owner" ) owner = name_value( value );
+                  return nullptr;
+               } );
+               if ( err ) fail( err );
+               if ( owner == 0 ) fail( "missing owner" );
+               st.stakers.insert( owner );
+            }
+         } else if ( code == config.token_contract ) {
+            if ( table == "accounts" ) {
+               if ( scope == 0 ) fail( "missing scope" );
+               int64_t balance = 0;
+               amount_fields( { { "balance", &balance } } );
+               if ( scope == config.contract ) {
+                  st.contract_sco_token_balance = balance;
+               } else {
+                  st.sco_token_accounts[scope] = balance;
+               }
+            } else if ( table == "stat" ) {
+               amount_fields( { { "supply", &st.sco_token_supply } } );
+            }
+         } else if ( code == EOSIO_ACCOUNT ) {
+            if ( table == "rexpool" ) {
+               amount_fields( { { "total_lent", &rex_pool.total_lent }, { "total_unlent", &rex_pool.total_unlent },
+                                { "total_rent", &rex_pool.total_rent }, { "total_lendable", &rex_pool.total_lendable },
+                                { "total_rex", &rex_pool.total_rex } } );
+            } else if ( table == "rexfund" || table == "rexbal" ) {
+               int64_t owner_amount = 0;
+               uint64_t owner = 0;
+               const char* err = parse_flat_json_object( line, blank, [&]( std::string_view key, std::string_view value ) -> const char* {
+                  if ( key == "owner" ) owner = name_value( value );
+                  return nullptr;
+               } );
+               if ( err ) fail( err );
+               if ( owner == config.contract ) {
+                  amount_fields( { { table == "rexfund" ? "balance" : "rex_balance", &owner_amount } } );
+                  ( table == "rexfund" ? rex_fund : rex_balance ) = owner_amount;
+               }
+            }
+         } else if ( code == EOSIO_TOKEN_ACCOUNT ) {
+            if ( table == "accounts" && scope == config.contract ) {
+               amount_fields( { { "balance", &st.contract_core_token_balance } } );
+            }
+         }
+      }
+
+      std::fclose( file );
+      engine.rex().restore( rex_pool, engine.config().contract, rex_fund, rex_balance );
+      return true;
+   }
+
+} // namespace pieos::sim
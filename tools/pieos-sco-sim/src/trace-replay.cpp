@@ -0,0 +1,100 @@
+#include <trace-replay.hpp>
+#include <eosio-name.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace pieos::sim {
+
+   void apply_trace_record( sco_engine& engine, const trace_record& r ) {
+      if ( r.block_slot != 0 ) {
+         engine.set_block_slot( r.block_slot );
+      }
+
+      switch ( r.type ) {
+         case trace_type::transfer:     engine.receive_token( r.account, engine.config().contract, r.amount ); break;
+         case trace_type::init:         engine.init(); break;
+         case trace_type::open:         engine.open( r.account, r.account2 ); break;
+         case trace_type::close:        engine.close( r.account ); break;
+         case trace_type::stake:        engine.stake( r.account, r.amount ); break;
+         case trace_type::unstake:      engine.unstake( r.account, r.amount ); break;
+         case trace_type::compound:     engine.compound( r.account ); break;
+         case trace_type::movestake:    engine.movestake( r.account, r.account2, r.amount ); break;
+         case trace_type::proxyvoted:   engine.proxyvoted( r.account, r.amount ); break;
+         case trace_type::harvestproxy: engine.harvestproxy( r.account ); break;
+         case trace_type::withdraw:     engine.withdraw( r.account, r.amount2 ? sco_engine::token::sco : sco_engine::token::core, r.amount ); break;
+         case trace_type::claimvested:  engine.claimvested( r.account, r.amount ); break;
+         case trace_type::updaterex:    engine.updaterex( r.account ); break;
+         case trace_type::setacctype:   engine.setacctype( r.account, uint32_t( r.amount ) ); break;
+         case trace_type::sellram:      engine.sellram( r.amount ); break;
+         case trace_type::tokenopen:    engine.open_sco_token_account( r.account ); break;
+         case trace_type::rexpool:      engine.rex().set_pool( r.amount, r.amount2 ); break;
+         case trace_type::rexincome:    engine.rex().add_proceeds( r.amount ); break;
+         case trace_type::rexfee:       engine.rex().channel_to_rex( r.amount ); break;
+         case trace_type::rexrent:
+            engine.rex().deposit( r.account, r.amount );
+            engine.rex().rentcpu( r.account, r.amount );
+            break;
+         case trace_type::setmaint:     engine.setmaint( r.account, uint32_t( r.amount ) ); break;
+         case trace_type::gc:           engine.gc( uint32_t( r.amount ) ); break;
+         case trace_type::distribute:   engine.distribute( uint32_t( r.amount ) ); break;
+         case trace_type::setreserve:   engine.setreserve( uint32_t( r.amount ) ); break;
+         default:
+            check( false, "unknown trace record type" );
+      }
+   }
+
+   void write_state_json( std::FILE* out, const sco_engine& engine, const bool with_accounts ) {
+      const auto& st = engine.state();
+      const auto& sp = st.pool;
+
+      std::fprintf( out, "{\n  \"stakepool\": {\n" );
+      std::fprintf( out, "    \"total_staked\": \"%s\",\n", format_amount( sp.total_staked, "EOS" ).c_str() );
+      std::fprintf( out, "    \"total_staked_share\": \"%s\",\n", format_amount( sp.total_staked_share, "SEOS" ).c_str() );
+      std::fprintf( out, "    \"core_token_for_staked\": \"%s\",\n", format_amount( sp.core_token_for_staked, "EOS" ).c_str() );
+      std::fprintf( out, "    \"total_proxy_vote\": \"%s\",\n", format_amount( sp.total_proxy_vote, "EOS" ).c_str() );
+      std::fprintf( out, "    \"total_proxy_vote_share\": \"%s\",\n", format_amount( sp.total_proxy_vote_share, "SPROXY" ).c_str() );
+      std::fprintf( out, "    \"core_token_for_proxy_vote\": \"%s\",\n", format_amount( sp.core_token_for_proxy_vote, "EOS" ).c_str() );
+      std::fprintf( out, "    \"total_token_share\": \"%s\",\n", format_amount( sp.total_token_share, "SPIEOS" ).c_str() );
+      std::fprintf( out, "    \"sco_token_unredeemed\": \"%s\",\n", format_amount( sp.sco_token_unredeemed, "PIEOS" ).c_str() );
+      std::fprintf( out, "    \"last_total_issued\": \"%s\",\n", format_amount( sp.last_total_issued, "PIEOS" ).c_str() );
+      std::fprintf( out, "    \"last_issue_time\": \"%s\"\n  },\n", format_block_time( sp.last_issue_time ).c_str() );
+      std::fprintf( out, "  \"liqreserve\": { \"target_percent\": %u, \"balance\": \"%s\" },\n",
+                    st.reserve.target_percent, format_amount( st.reserve.balance, "EOS" ).c_str() );
+
+      const auto& rp = engine.rex().get_pool();
+      std::fprintf( out, "  \"rex\": { \"total_lendable\": \"%s\", \"total_rex\": \"%s\", \"rex_balance\": \"%s\", \"rex_fund\": \"%s\", \"return_buckets\": %zu, \"open_orders\": %zu },\n",
+                    format_amount( rp.total_lendable, "EOS" ).c_str(), format_amount( rp.total_rex, "REX" ).c_str(),
+                    format_amount( engine.rex().rex_balance( engine.config().contract ), "REX" ).c_str(), format_amount( engine.rex().fund_balance( engine.config().contract ), "EOS" ).c_str(),
+                    engine.rex().return_state().buckets.size(), engine.rex().open_order_count() );
+      std::fprintf( out, "  \"contract_balances\": { \"core_token\": \"%s\", \"sco_token\": \"%s\", \"sco_token_supply\": \"%s\" },\n",
+                    format_amount( st.contract_core_token_balance, "EOS" ).c_str(), format_amount( st.contract_sco_token_balance, "PIEOS" ).c_str(),
+                    format_amount( st.sco_token_supply, "PIEOS" ).c_str() );
+      std::fprintf( out, "  \"stakeaccount_count\": %zu", st.accounts.size() );
+
+      if ( with_accounts ) {
+         std::vector<std::pair<std::string, const stake_account*>> rows;
+         rows.reserve( st.accounts.size() );
+         for ( const auto& [owner, sa] : st.accounts ) {
+            rows.emplace_back( name_string( owner ), &sa );
+         }
+         std::sort( rows.begin(), rows.end(), []( const auto& a, const auto& b ) { return a.first < b.first; } );
+
+         std::fprintf( out, ",\n  \"stakeaccount\": [" );
+         bool first = true;
+         for ( const auto& [owner, sa] : rows ) {
+            std::fprintf( out, "%s\n    { \"owner\": \"%s\", \"core_token_bal\": \"%s\", \"sco_token_bal\": \"%s\", \"staked\": \"%s\", \"staked_share\": \"%s\", "
+                               "\"proxy_vote\": \"%s\", \"proxy_vote_share\": \"%s\", \"token_share\": \"%s\", \"last_stake_time\": \"%s\" }",
+                          first ? "" : ",", owner.c_str(),
+                          format_amount( sa->core_token_bal, "EOS" ).c_str(), format_amount( sa->sco_token_bal, "PIEOS" ).c_str(),
+                          format_amount( sa->staked, "EOS" ).c_str(), format_amount( sa->staked_share, "SEOS" ).c_str(),
+                          format_amount( sa->proxy_vote, "EOS" ).c_str(), format_amount( sa->proxy_vote_share, "SPROXY" ).c_str(),
+                          format_amount( sa->token_share, "SPIEOS" ).c_str(), format_block_time( sa->last_stake_time ).c_str() );
+            first = false;
+         }
+         std::fprintf( out, "\n  ]" );
+      }
+      std::fprintf( out, "\n}\n" );
+   }
+
+} // namespace pieos::sim
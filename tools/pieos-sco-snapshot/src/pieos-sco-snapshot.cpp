@@ -0,0 +1,288 @@
+#include <action-trace.hpp>
+#include <sco-engine.hpp>
+#include <sco-snapshot.hpp>
+#include <snapshot-audit.hpp>
+#include <table-dump.hpp>
+#include <trace-replay.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace pieos::sim;
+
+namespace {
+
+   void usage( const char* prog ) {
+      std::fprintf( stderr,
+         "Usage: %s COMMAND ...\n"
+         "Writes and reads memory-mappable snapshots of the pieosdistsco and PIEOS token tables.\n\n"
+         "  export --trace TRACE_FILE [--time TIME] SNAPSHOT    replay a trace and snapshot the final state\n"
+         "  export --tables DUMP_FILE [--time TIME] SNAPSHOT    snapshot a JSON lines table dump of a node\n"
+         "  info SNAPSHOT                                      print header, row counts and pool totals\n"
+         "  dump SNAPSHOT [--summary]                          print the state as JSON, like pieos-sco-replay\n"
+         "  get SNAPSHOT ACCOUNT                               print the rows of one account\n"
+         "  audit SNAPSHOT [--threads N]                       check the stakepool totals and token holdings against\n"
+         "                                                     the stakeaccount rows on all cores, print the drifts\n"
+         "                                                     as JSON lines\n\n"
+         "TIME is the ISO-8601 UTC block time of the snapshot state, by default the last trace record time\n"
+         "or the stakepool last_issue_time of a table dump.\n", prog );
+   }
+
+   double seconds_since( const std::chrono::steady_clock::time_point start ) {
+      return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+   }
+
+   int export_snapshot( const std::vector<std::string>& args ) {
+      std::string trace_path, dump_path, out_path, time;
+      for ( size_t i = 0; i < args.size(); ++i ) {
+         if ( args[i] == "--trace" && i + 1 < args.size() ) trace_path = args[++i];
+         else if ( args[i] == "--tables" && i + 1 < args.size() ) dump_path = args[++i];
+         else if ( args[i] == "--time" && i + 1 < args.size() ) time = args[++i];
+         else if ( out_path.empty() ) out_path = args[i];
+         else return -1;
+      }
+      if ( out_path.empty() || trace_path.empty() == dump_path.empty() ) {
+         return -1;
+      }
+
+      sco_engine engine;
+      if ( !trace_path.empty() ) {
+         trace_reader reader;
+         if ( !reader.open( trace_path ) ) {
+            std::fprintf( stderr, "cannot open trace file %s\n", trace_path.c_str() );
+            return 1;
+         }
+         trace_record record;
+         uint64_t failed = 0;
+         while ( reader.next( record ) ) {
+            try {
+               apply_trace_record( engine, record );
+            } catch ( const check_failure& ) {
+               ++failed;
+            }
+         }
+         if ( failed > 0 ) {
+            std::fprintf( stderr, "warning: %llu trace records failed, run pieos-sco-replay for details\n", (unsigned long long)failed );
+         }
+      } else if ( !load_table_dump( dump_path, engine ) ) {
+         std::fprintf( stderr, "cannot open table dump %s\n", dump_path.c_str() );
+         return 1;
+      }
+
+      if ( !time.empty() ) {
+         uint32_t slot = 0;
+         if ( !parse_block_time( time, slot ) ) {
+            std::fprintf( stderr, "invalid time %s\n", time.c_str() );
+            return 1;
+         }
+         engine.set_block_slot( slot );
+      } else if ( !dump_path.empty() ) {
+         engine.set_block_slot( engine.state().pool.last_issue_time );
+      }
+
+      if ( !write_snapshot( out_path, engine ) ) {
+         std::fprintf( stderr, "cannot write snapshot %s\n", out_path.c_str() );
+         return 1;
+      }
+      std::fprintf( stderr, "wrote %s: %zu stakeaccount rows at %s\n", out_path.c_str(), engine.state().accounts.size(),
+                    format_block_time( engine.block_slot() ).c_str() );
+      return 0;
+   }
+
+   bool open_snapshot( snapshot_view& snapshot, const std::string& path ) {
+      if ( !snapshot.open( path ) ) {
+         std::fprintf( stderr, "cannot open snapshot %s\n", path.c_str() );
+         return false;
+      }
+      return true;
+   }
+
+   int info( const std::string& path ) {
+      snapshot_view snapshot;
+      const auto open_start = std::chrono::steady_clock::now();
+      if ( !open_snapshot( snapshot, path ) ) {
+         return 1;
+      }
+      const double open_time = seconds_since( open_start );
+
+      const auto& h = snapshot.header();
+      std::printf( "snapshot       %s\n", path.c_str() );
+      std::printf( "block time     %s\n", format_block_time( h.block_slot ).c_str() );
+      std::printf( "contract       %s, token %s\n", name_string( h.contract ).c_str(), name_string( h.token_contract ).c_str() );
+      std::printf( "file size      %llu bytes, opened in %.3f ms\n", (unsigned long long)h.file_size, open_time * 1000 );
+
+      const auto verify_start = std::chrono::steady_clock::now();
+      const bool checksum_ok = snapshot.verify_checksum();
+      std::printf( "checksum       %s (%.3f ms)\n", checksum_ok ? "ok" : "MISMATCH", seconds_since( verify_start ) * 1000 );
+
+      std::printf( "stakeaccount   %zu rows\n", snapshot.stake_accounts().size() );
+      std::printf( "reserved       %zu rows\n", snapshot.reserved().size() );
+      std::printf( "acctype        %zu rows\n", snapshot.account_types().size() );
+      std::printf( "token accounts %zu rows\n", snapshot.token_accounts().size() );
+
+      // a full scan of the stakeaccount rows, cross-checked against the stakepool totals
+      const auto scan_start = std::chrono::steady_clock::now();
+      int64_t staked = 0, staked_share = 0, proxy_vote = 0, proxy_vote_share = 0, token_share = 0;
+      for ( const auto& sa : snapshot.stake_accounts() ) {
+         staked += sa.staked;
+         staked_share += sa.staked_share;
+         proxy_vote += sa.proxy_vote;
+         proxy_vote_share += sa.proxy_vote_share;
+         token_share += sa.token_share;
+      }
+      const double scan_time = seconds_since( scan_start );
+
+      if ( const auto* sp = snapshot.stake_pool() ) {
+         auto line = [&]( const char* label, const int64_t total, const int64_t sum, const char* symbol ) {
+            std::printf( "%-15s%s, sum of accounts %s%s\n", label, format_amount( total, symbol ).c_str(),
+                         format_amount( sum, symbol ).c_str(), total == sum ? "" : " (differs)" );
+         };
+         line( "total_staked", sp->total_staked, staked, "EOS" );
+         line( "staked_share", sp->total_staked_share, staked_share, "SEOS" );
+         line( "proxy_vote", sp->total_proxy_vote, proxy_vote, "EOS" );
+         line( "proxy_share", sp->total_proxy_vote_share, proxy_vote_share, "SPROXY" );
+         line( "token_share", sp->total_token_share, token_share, "SPIEOS" );
+      } else {
+         std::printf( "stakepool      not initialized\n" );
+      }
+      if ( const auto* lr = snapshot.liquid_reserve() ) {
+         std::printf( "liqreserve     %s, target %u.%02u%%\n", format_amount( lr->balance, "EOS" ).c_str(), lr->target_percent / 100, lr->target_percent % 100 );
+      }
+      std::printf( "scan           %zu rows in %.3f ms\n", snapshot.stake_accounts().size(), scan_time * 1000 );
+
+      return checksum_ok ? 0 : 2;
+   }
+
+   int dump( const std::string& path, const bool summary ) {
+      snapshot_view snapshot;
+      if ( !open_snapshot( snapshot, path ) ) {
+         return 1;
+      }
+      sco_engine engine;
+      load_snapshot( snapshot, engine );
+      write_state_json( stdout, engine, !summary );
+      return 0;
+   }
+
+   int get( const std::string& path, const std::string& account_name ) {
+      snapshot_view snapshot;
+      if ( !open_snapshot( snapshot, path ) ) {
+         return 1;
+      }
+
+      const uint64_t account = name_value( account_name );
+      bool found = false;
+      if ( const auto* sa = snapshot.stake_accounts().find( account ) ) {
+         std::printf( "stakeaccount   core_token_bal %s, sco_token_bal %s, staked %s, staked_share %s, proxy_vote %s, "
+                      "proxy_vote_share %s, token_share %s, last_stake_time %s, ram_payer %s\n",
+                      format_amount( sa->core_token_bal, "EOS" ).c_str(), format_amount( sa->sco_token_bal, "PIEOS" ).c_str(),
+                      format_amount( sa->staked, "EOS" ).c_str(), format_amount( sa->staked_share, "SEOS" ).c_str(),
+                      format_amount( sa->proxy_vote, "EOS" ).c_str(), format_amount( sa->proxy_vote_share, "SPROXY" ).c_str(),
+                      format_amount( sa->token_share, "SPIEOS" ).c_str(), format_block_time( sa->last_stake_time ).c_str(),
+                      name_string( sa->ram_payer ).c_str() );
+         found = true;
+      }
+      if ( const auto* r = snapshot.reserved().find( account ) ) {
+         std::printf( "reserved       issued %s\n", format_amount( r->issued, "PIEOS" ).c_str() );
+         found = true;
+      }
+      if ( const auto* t = snapshot.account_types().find( account ) ) {
+         std::printf( "acctype        %u\n", t->acc_type );
+         found = true;
+      }
+      if ( const auto* a = snapshot.token_accounts().find( account ) ) {
+         std::printf( "token balance  %s\n", format_amount( a->balance, "PIEOS" ).c_str() );
+         found = true;
+      }
+      if ( !found ) {
+         std::fprintf( stderr, "no rows for %s\n", account_name.c_str() );
+         return 2;
+      }
+      return 0;
+   }
+
+   int audit( const std::vector<std::string>& args ) {
+      std::string path;
+      unsigned threads = 0;
+      for ( size_t i = 0; i < args.size(); ++i ) {
+         if ( args[i] == "--threads" && i + 1 < args.size() ) {
+            char* end = nullptr;
+            const unsigned long n = std::strtoul( args[++i].c_str(), &end, 10 );
+            if ( args[i].empty() || *end != '\0' || n > 1024 ) return -1;
+            threads = unsigned( n );
+         } else if ( path.empty() ) {
+            path = args[i];
+         } else {
+            return -1;
+         }
+      }
+      if ( path.empty() ) {
+         return -1;
+      }
+
+      snapshot_view snapshot;
+      if ( !open_snapshot( snapshot, path ) ) {
+         return 1;
+      }
+      if ( !snapshot.verify_checksum() ) {
+         std::fprintf( stderr, "snapshot %s checksum mismatch\n", path.c_str() );
+         return 2;
+      }
+
+      work_stealing_pool pool( threads );
+      const auto start = std::chrono::steady_clock::now();
+      const audit_report report = audit_snapshot( snapshot, pool );
+      const double elapsed = seconds_since( start );
+
+      for ( const auto& f : report.findings ) {
+         const std::string symbol = f.symbol;
+         auto amount = [&]( const int64_t v ) { return symbol.empty() ? std::to_string( v ) : format_amount( v, symbol ); };
+         std::printf( "{\"check\":\"%s\",\"account\":\"%s\",\"expected\":\"%s\",\"actual\":\"%s\",\"drift\":\"%s\"}\n",
+                      f.check, f.account ? name_string( f.account ).c_str() : "", amount( f.expected ).c_str(),
+                      amount( f.actual ).c_str(), amount( f.actual - f.expected ).c_str() );
+      }
+
+      std::fprintf( stderr, "audited %llu stakeaccount rows at %s on %u threads in %.3f ms, %zu findings\n",
+                    (unsigned long long)report.accounts, format_block_time( snapshot.block_slot() ).c_str(), pool.size(),
+                    elapsed * 1000, report.findings.size() );
+      return report.findings.empty() ? 0 : 2;
+   }
+
+}
+
+int main( int argc, char** argv ) {
+   if ( argc < 3 ) {
+      usage( argv[0] );
+      return 1;
+   }
+
+   const std::string command = argv[1];
+   const std::vector<std::string> args( argv + 2, argv + argc );
+
+   int rc = -1;
+   try {
+      if ( command == "export" ) {
+         rc = export_snapshot( args );
+      } else if ( command == "info" && args.size() == 1 ) {
+         rc = info( args[0] );
+      } else if ( command == "dump" && ( args.size() == 1 || ( args.size() == 2 && args[1] == "--summary" ) ) ) {
+         rc = dump( args[0], args.size() == 2 );
+      } else if ( command == "get" && args.size() == 2 ) {
+         rc = get( args[0], args[1] );
+      } else if ( command == "audit" ) {
+         rc = audit( args );
+      }
+   } catch ( const std::exception& e ) {
+      std::fprintf( stderr, "error: %s\n", e.what() );
+      return 1;
+   }
+
+   if ( rc < 0 ) {
+      usage( argv[0] );
+      return 1;
+   }
+   return rc;
+}
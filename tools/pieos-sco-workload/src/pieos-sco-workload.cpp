@@ -0,0 +1,511 @@
+#include <action-trace.hpp>
+#include <scenario-rng.hpp>
+#include <sco-state.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace pieos::sim;
+
+namespace {
+
+   void usage( const char* prog ) {
+      std::fprintf( stderr,
+         "Usage: %s [OPTION...] --output FILE\n"
+         "Generates a deterministic, seeded pieosdistsco workload in the trace format of pieos-sco-replay:\n"
+         "bursts of EOS deposits, stake waves and unstake waves after the REX maturity, proxy vote sync storms\n"
+         "of pieosproxy11, BP voting reward transfers, token transfers in and out, and REX fees and loans.\n"
+         "The same seed and options always write the same trace.\n\n"
+         "  --accounts N               number of user accounts (default 1000)\n"
+         "  --days N                   days of the SCO period covered (default 30)\n"
+         "  --seed S                   seed of the generator (default 1)\n"
+         "  --json                     write JSON lines instead of the binary trace format\n"
+         "  --output FILE              trace file to write\n"
+         "\n"
+         "  --deposit-percent P        stakers depositing EOS in a day, in percent (default 2)\n"
+         "  --deposit-bursts N         deposit bursts per day (default 4)\n"
+         "  --burst-minutes N          length of a deposit burst (default 15)\n"
+         "  --deposit-stake-percent P  deposits staked right away, in percent (default 70)\n"
+         "  --stake-wave-days N        days between stake waves, 0 for none (default 7)\n"
+         "  --stake-wave-percent P     stakers staking in a wave, in percent (default 10)\n"
+         "  --unstake-wave-percent P   stakers of a wave unstaking once their REX matured, in percent (default 50)\n"
+         "  --proxy-percent P          accounts voting through the proxy, in percent (default 30)\n"
+         "  --proxy-sync-hours N       hours between proxy vote sync storms, 0 for none (default 24)\n"
+         "  --proxy-sync-percent P     proxy voters synced in a storm, in percent (default 50)\n"
+         "  --actions-per-block N      proxyvoted actions per block of a storm (default 50)\n"
+         "  --compound-percent P       stakers compounding in a day, in percent (default 1)\n"
+         "  --harvest-percent P        proxy voters harvesting in a day, in percent (default 1)\n"
+         "  --transfer-percent P       stakers transferring EOS in or withdrawing in a day, in percent (default 1)\n"
+         "  --bp-reward-apr P          BP voting rewards for the staked and proxy-voted EOS, in percent per year (default 2)\n"
+         "  --rex-fee-apr P            REX fees channeled to the return buckets, in percent of the pool per year (default 1)\n"
+         "  --rex-rents N              REX loans rented per day (default 10)\n"
+         "  --distribute-hours N       hours between distribute cranks, 0 for none (default 6)\n"
+         "  -h, --help                 print this help\n", prog );
+   }
+
+   constexpr int64_t EOS = 1'0000;
+   constexpr uint32_t BLOCKS_PER_HOUR = 3600 * 1000 / BLOCK_INTERVAL_MS;
+   constexpr uint32_t BLOCKS_PER_DAY = 24 * BLOCKS_PER_HOUR;
+
+   constexpr uint64_t staked_reward_account = "wlrwstake"_nv;
+   constexpr uint64_t proxy_reward_account  = "wlrwproxy"_nv;
+   constexpr uint64_t rex_renter_account    = "wlrexrenter"_nv;
+   constexpr int64_t  rex_pool_lendable     = 100'000'000 * EOS;
+
+   struct workload_mix {
+      uint32_t accounts              = 1000;
+      uint32_t days                  = 30;
+      double   deposit_percent       = 2;
+      uint32_t deposit_bursts        = 4;
+      uint32_t burst_minutes         = 15;
+      double   deposit_stake_percent = 70;
+      uint32_t stake_wave_days       = 7;
+      double   stake_wave_percent    = 10;
+      double   unstake_wave_percent  = 50;
+      double   proxy_percent         = 30;
+      uint32_t proxy_sync_hours      = 24;
+      double   proxy_sync_percent    = 50;
+      uint32_t actions_per_block     = 50;
+      double   compound_percent      = 1;
+      double   harvest_percent       = 1;
+      double   transfer_percent      = 1;
+      double   bp_reward_apr_percent = 2;
+      double   rex_fee_apr_percent   = 1;
+      uint32_t rex_rents             = 10;
+      uint32_t distribute_hours      = 6;
+   };
+
+   /**
+    * @brief seeded workload generator
+    *
+    * Every component of the mix (deposits, waves, proxy syncs, ...) draws from its own random stream, so changing
+    * one rate leaves the accounts and times of the others as they were. A day is planned as a list of intents
+    * (block slot, kind, account), sorted by time and then turned into trace records against a model of the
+    * accounts' deposits, stake and proxy vote, so that the records are in time order and the generated actions
+    * pass the contract's checks: no unstake before the REX of the last stake matured, no withdraw beyond the deposits,
+    * no proxy vote change under 1 EOS. `compound` and `harvestproxy` are sent regardless of the profit accrued
+    * and fail like on chain when there is none to pay.
+    */
+   class workload_generator {
+   public:
+      workload_generator( const workload_mix& mix, const uint64_t seed, trace_writer& writer )
+         : _mix( mix ), _writer( writer ),
+           _roles_rng( scenario_seed( seed, 0 ) ), _deposit_rng( scenario_seed( seed, 1 ) ), _wave_rng( scenario_seed( seed, 2 ) ),
+           _proxy_rng( scenario_seed( seed, 3 ) ), _activity_rng( scenario_seed( seed, 4 ) ), _rex_rng( scenario_seed( seed, 5 ) ),
+           _amount_rng( scenario_seed( seed, 6 ) ) {}
+
+      void run() {
+         _accounts.resize( _mix.accounts );
+         for ( uint32_t i = 0; i < _mix.accounts; ++i ) {
+            ( _roles_rng.chance( _mix.proxy_percent / 100 ) ? _proxy_voters : _stakers ).push_back( i );
+         }
+
+         const sco_config config;
+         _start_slot = config.sco_start_slot + 2;
+         emit( _start_slot, trace_type::init );
+         emit( _start_slot, trace_type::setacctype, staked_reward_account, 0, ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_EOS_STAKED_SCO );
+         emit( _start_slot, trace_type::setacctype, proxy_reward_account, 0, ACCOUNT_TYPE_BP_VOTE_REWARD_ACCOUNT_FOR_PROXY_VOTE_SCO );
+         emit( _start_slot, trace_type::rexpool, 0, 0, rex_pool_lendable, rex_pool_lendable * 10000 );
+         _rex_maturity_days = config.rex_maturity_days;
+
+         for ( uint32_t day = 0; day < _mix.days; ++day ) {
+            plan_day( day );
+            run_day( day );
+         }
+      }
+
+      uint64_t records() const { return _records; }
+      const uint64_t* records_by_type() const { return _by_type; }
+
+   private:
+      enum class intent_kind : uint8_t {
+         bp_rewards, rex_fee, deposit, wave_stake, wave_unstake, proxy_sync, compound, harvest, transfer, rex_rent, distribute
+      };
+
+      struct intent {
+         uint32_t    slot    = 0;
+         uint32_t    seq     = 0;
+         intent_kind kind    = intent_kind::deposit;
+         uint32_t    account = 0; // index into `_accounts`
+      };
+
+      /// contract balances of one account as the generator expects them
+      struct account_model {
+         int64_t  deposit        = 0; // `core_token_bal`
+         int64_t  staked         = 0; // staked EOS, without REX profits
+         int64_t  proxy_vote     = 0;
+         uint32_t last_stake_day = 0;
+         bool     has_staked     = false;
+      };
+
+      static uint64_t account_name( uint32_t i ) {
+         static const char* charmap = "abcdefghijklmnopqrstuvwxyz12345";
+         std::string name = "wl";
+         do {
+            name.push_back( charmap[i % 31] );
+            i /= 31;
+         } while ( i > 0 );
+         return name_value( name );
+      }
+
+      /// 10 to 100000 EOS, log-uniform
+      int64_t random_amount() {
+         return int64_t( std::pow( 10.0, _amount_rng.uniform( 1.0, 5.0 ) ) ) * EOS;
+      }
+
+      uint32_t day_slot( const uint32_t day ) const { return _start_slot + day * BLOCKS_PER_DAY; }
+
+      void plan( const uint32_t slot, const intent_kind kind, const uint32_t account = 0 ) {
+         _intents.push_back( { slot, uint32_t( _intents.size() ), kind, account } );
+      }
+
+      /// picks about `percent` of `pool` at random, without repetition
+      template<typename Fn>
+      static void sample( scenario_rng& rng, const std::vector<uint32_t>& pool, const double percent, Fn&& fn ) {
+         const uint32_t n = uint32_t( std::lround( double( pool.size() ) * percent / 100 ) );
+         if ( n == 0 ) {
+            return;
+         }
+         // Floyd's sampling: n draws for any share of the population, a bitmap marks the picked ones
+         std::vector<uint32_t> picked;
+         picked.reserve( n );
+         std::vector<bool> taken( pool.size(), false );
+         for ( uint32_t j = uint32_t( pool.size() ) - n; j < pool.size(); ++j ) {
+            const uint32_t t = rng.uniform_int( 0, j );
+            const uint32_t k = taken[t] ? j : t;
+            taken[k] = true;
+            picked.push_back( k );
+         }
+         for ( const uint32_t k : picked ) {
+            fn( pool[k] );
+         }
+      }
+
+      void plan_day( const uint32_t day ) {
+         _intents.clear();
+         const uint32_t base = day_slot( day );
+
+         // BP voting rewards and REX fees are paid once a day, right after midnight
+         plan( base + 10, intent_kind::bp_rewards );
+         plan( base + 20, intent_kind::rex_fee );
+
+         // deposits arrive in bursts of `burst_minutes`
+         if ( _mix.deposit_bursts > 0 ) {
+            std::vector<uint32_t> bursts( _mix.deposit_bursts );
+            const uint32_t burst_blocks = std::max( 1u, _mix.burst_minutes * 60 * 1000 / uint32_t( BLOCK_INTERVAL_MS ) );
+            for ( auto& b : bursts ) {
+               b = base + _deposit_rng.uniform_int( 0, BLOCKS_PER_DAY - burst_blocks );
+            }
+            sample( _deposit_rng, _stakers, _mix.deposit_percent, [&]( const uint32_t a ) {
+               const uint32_t b = bursts[_deposit_rng.uniform_int( 0, _mix.deposit_bursts - 1 )];
+               plan( b + _deposit_rng.uniform_int( 0, burst_blocks - 1 ), intent_kind::deposit, a );
+            } );
+         }
+
+         // a stake wave over the first 6 hours of its day, and the unstake wave of an earlier one once its REX matured
+         if ( _mix.stake_wave_days > 0 && day % _mix.stake_wave_days == 0 ) {
+            sample( _wave_rng, _stakers, _mix.stake_wave_percent, [&]( const uint32_t a ) {
+               plan( base + _wave_rng.uniform_int( 0, 6 * BLOCKS_PER_HOUR - 1 ), intent_kind::wave_stake, a );
+            } );
+         }
+         if ( _mix.stake_wave_days > 0 && day > _rex_maturity_days && ( day - _rex_maturity_days - 1 ) % _mix.stake_wave_days == 0 ) {
+            for ( const uint32_t a : _wave_stakers ) {
+               if ( _wave_rng.chance( _mix.unstake_wave_percent / 100 ) ) {
+                  plan( base + _wave_rng.uniform_int( 0, 6 * BLOCKS_PER_HOUR - 1 ), intent_kind::wave_unstake, a );
+               }
+            }
+            _wave_stakers.clear();
+         }
+
+         // proxy vote sync storms, `actions_per_block` proxyvoted actions per block pushed by the proxy
+         if ( _mix.proxy_sync_hours > 0 ) {
+            for ( uint32_t hour = 0; hour < 24; ++hour ) {
+               if ( ( day * 24 + hour ) % _mix.proxy_sync_hours != 0 ) {
+                  continue;
+               }
+               const uint32_t storm = base + hour * BLOCKS_PER_HOUR + _proxy_rng.uniform_int( 0, BLOCKS_PER_HOUR / 2 );
+               uint32_t n = 0;
+               sample( _proxy_rng, _proxy_voters, _mix.proxy_sync_percent, [&]( const uint32_t a ) {
+                  plan( storm + n++ / std::max( 1u, _mix.actions_per_block ), intent_kind::proxy_sync, a );
+               } );
+            }
+         }
+
+         sample( _activity_rng, _stakers, _mix.compound_percent, [&]( const uint32_t a ) {
+            plan( base + _activity_rng.uniform_int( 0, BLOCKS_PER_DAY - 1 ), intent_kind::compound, a );
+         } );
+         sample( _activity_rng, _proxy_voters, _mix.harvest_percent, [&]( const uint32_t a ) {
+            plan( base + _activity_rng.uniform_int( 0, BLOCKS_PER_DAY - 1 ), intent_kind::harvest, a );
+         } );
+         sample( _activity_rng, _stakers, _mix.transfer_percent, [&]( const uint32_t a ) {
+            plan( base + _activity_rng.uniform_int( 0, BLOCKS_PER_DAY - 1 ), intent_kind::transfer, a );
+         } );
+
+         for ( uint32_t i = 0; i < _mix.rex_rents; ++i ) {
+            plan( base + _rex_rng.uniform_int( 0, BLOCKS_PER_DAY - 1 ), intent_kind::rex_rent );
+         }
+         if ( _mix.distribute_hours > 0 ) {
+            for ( uint32_t hour = 0; hour < 24; ++hour ) {
+               if ( ( day * 24 + hour ) % _mix.distribute_hours == 0 ) {
+                  plan( base + hour * BLOCKS_PER_HOUR + 30, intent_kind::distribute );
+               }
+            }
+         }
+
+         std::sort( _intents.begin(), _intents.end(), []( const intent& a, const intent& b ) {
+            return a.slot != b.slot ? a.slot < b.slot : a.seq < b.seq;
+         } );
+      }
+
+      void run_day( const uint32_t day ) {
+         for ( const auto& in : _intents ) {
+            auto& m = _accounts[in.account];
+            const uint64_t owner = account_name( in.account );
+            switch ( in.kind ) {
+               case intent_kind::bp_rewards: {
+                  const int64_t staked_reward = int64_t( double( _total_staked ) * _mix.bp_reward_apr_percent / 100 / 365 );
+                  const int64_t proxy_reward = int64_t( double( _total_proxy_vote ) * _mix.bp_reward_apr_percent / 100 / 365 );
+                  if ( staked_reward > 0 ) emit( in.slot, trace_type::transfer, staked_reward_account, 0, staked_reward );
+                  if ( proxy_reward > 0 ) emit( in.slot, trace_type::transfer, proxy_reward_account, 0, proxy_reward );
+                  break;
+               }
+               case intent_kind::rex_fee: {
+                  const int64_t fee = int64_t( double( rex_pool_lendable ) * _mix.rex_fee_apr_percent / 100 / 365 );
+                  if ( fee > 0 ) emit( in.slot, trace_type::rexfee, 0, 0, fee );
+                  break;
+               }
+               case intent_kind::deposit: {
+                  const int64_t amount = random_amount();
+                  emit( in.slot, trace_type::transfer, owner, 0, amount );
+                  m.deposit += amount;
+                  if ( _deposit_rng.chance( _mix.deposit_stake_percent / 100 ) ) {
+                     stake( in.slot, day, in.account, amount );
+                  }
+                  break;
+               }
+               case intent_kind::wave_stake: {
+                  const int64_t amount = random_amount();
+                  emit( in.slot, trace_type::transfer, owner, 0, amount );
+                  m.deposit += amount;
+                  stake( in.slot, day, in.account, amount );
+                  _wave_stakers.push_back( in.account );
+                  break;
+               }
+               case intent_kind::wave_unstake: {
+                  // stake added since the wave keeps the REX bought by the last stake from maturing
+                  if ( m.staked <= 0 || day <= m.last_stake_day + _rex_maturity_days ) {
+                     break;
+                  }
+                  const int64_t amount = _wave_rng.chance( 0.5 ) ? m.staked
+                                       : std::max<int64_t>( 1'0000, int64_t( double( m.staked ) * _wave_rng.uniform( 0.1, 0.9 ) ) );
+                  // the redeemed EOS are transferred to the owner, or credited to its deposit if the REX sell order is queued
+                  emit( in.slot, trace_type::unstake, owner, 0, amount );
+                  m.staked -= amount;
+                  _total_staked -= amount;
+                  break;
+               }
+               case intent_kind::proxy_sync: {
+                  int64_t proxy_vote;
+                  if ( m.proxy_vote == 0 ) {
+                     proxy_vote = random_amount();
+                  } else if ( _proxy_rng.chance( 0.02 ) ) {
+                     proxy_vote = 0;
+                  } else {
+                     proxy_vote = int64_t( double( m.proxy_vote ) * _proxy_rng.uniform( 0.8, 1.25 ) ) / EOS * EOS;
+                  }
+                  // a proxy vote change of less than 1 EOS is rejected by the contract
+                  if ( proxy_vote != 0 && std::abs( proxy_vote - m.proxy_vote ) <= 1'0000 ) {
+                     break;
+                  }
+                  emit( in.slot, trace_type::proxyvoted, owner, 0, proxy_vote );
+                  _total_proxy_vote += proxy_vote - m.proxy_vote;
+                  m.proxy_vote = proxy_vote;
+                  break;
+               }
+               case intent_kind::compound:
+                  if ( m.has_staked ) emit( in.slot, trace_type::compound, owner );
+                  break;
+               case intent_kind::harvest:
+                  if ( m.proxy_vote > 0 ) emit( in.slot, trace_type::harvestproxy, owner );
+                  break;
+               case intent_kind::transfer:
+                  if ( m.deposit > 0 && _activity_rng.chance( 0.5 ) ) {
+                     emit( in.slot, trace_type::withdraw, owner, 0, m.deposit, 0 );
+                     m.deposit = 0;
+                  } else {
+                     const int64_t amount = random_amount();
+                     emit( in.slot, trace_type::transfer, owner, 0, amount );
+                     m.deposit += amount;
+                  }
+                  break;
+               case intent_kind::rex_rent:
+                  emit( in.slot, trace_type::rexrent, rex_renter_account, 0, int64_t( _rex_rng.uniform( 1, 100 ) ) * EOS );
+                  break;
+               case intent_kind::distribute:
+                  if ( _total_staked > 0 ) emit( in.slot, trace_type::distribute, 0, 0, DISTRIBUTE_MAX_ACCOUNTS_PER_ACTION );
+                  break;
+            }
+         }
+      }
+
+      void stake( const uint32_t slot, const uint32_t day, const uint32_t account, const int64_t amount ) {
+         auto& m = _accounts[account];
+         emit( slot, trace_type::stake, account_name( account ), 0, amount );
+         m.deposit -= amount;
+         m.staked += amount;
+         m.last_stake_day = day;
+         m.has_staked = true;
+         _total_staked += amount;
+      }
+
+      void emit( const uint32_t slot, const trace_type type, const uint64_t account = 0, const uint64_t account2 = 0,
+                 const int64_t amount = 0, const int64_t amount2 = 0 ) {
+         trace_record r;
+         r.block_slot = slot;
+         r.type       = type;
+         r.account    = account;
+         r.account2   = account2;
+         r.amount     = amount;
+         r.amount2    = amount2;
+         _writer.write( r );
+         ++_records;
+         ++_by_type[size_t(type)];
+      }
+
+      const workload_mix&        _mix;
+      trace_writer&              _writer;
+      scenario_rng               _roles_rng, _deposit_rng, _wave_rng, _proxy_rng, _activity_rng, _rex_rng, _amount_rng;
+      std::vector<account_model> _accounts;
+      std::vector<uint32_t>      _stakers;
+      std::vector<uint32_t>      _proxy_voters;
+      std::vector<uint32_t>      _wave_stakers;     // stakers of the last stake wave, until its unstake wave
+      std::vector<intent>        _intents;
+      uint32_t                   _start_slot = 0;
+      uint32_t                   _rex_maturity_days = 0;
+      int64_t                    _total_staked = 0;
+      int64_t                    _total_proxy_vote = 0;
+      uint64_t                   _records = 0;
+      uint64_t                   _by_type[size_t(trace_type::count)] = {};
+   };
+
+   bool parse_uint( const char* arg, const unsigned long max, uint32_t& value ) {
+      char* end = nullptr;
+      const unsigned long n = std::strtoul( arg, &end, 10 );
+      if ( *arg == '\0' || *end != '\0' || n > max ) {
+         return false;
+      }
+      value = uint32_t( n );
+      return true;
+   }
+
+   bool parse_percent( const char* arg, const double max, double& value ) {
+      char* end = nullptr;
+      const double v = std::strtod( arg, &end );
+      if ( *arg == '\0' || *end != '\0' || !( v >= 0 && v <= max ) ) {
+         return false;
+      }
+      value = v;
+      return true;
+   }
+
+}
+
+int main( int argc, char** argv ) {
+   workload_mix mix;
+   uint64_t seed = 1;
+   bool json = false;
+   std::string output_path;
+
+   for ( int i = 1; i < argc; ++i ) {
+      const std::string arg = argv[i];
+      bool ok = true;
+      if ( arg == "-h" || arg == "--help" ) {
+         usage( argv[0] );
+         return 0;
+      } else if ( arg == "--json" ) {
+         json = true;
+      } else if ( i + 1 >= argc ) {
+         ok = false;
+      } else if ( arg == "--accounts" ) {
+         ok = parse_uint( argv[++i], 10'000'000, mix.accounts ) && mix.accounts > 0;
+      } else if ( arg == "--days" ) {
+         ok = parse_uint( argv[++i], 372, mix.days ) && mix.days > 0;
+      } else if ( arg == "--seed" ) {
+         char* end = nullptr;
+         seed = std::strtoull( argv[++i], &end, 10 );
+         ok = *end == '\0';
+      } else if ( arg == "--output" ) {
+         output_path = argv[++i];
+      } else if ( arg == "--deposit-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.deposit_percent );
+      } else if ( arg == "--deposit-bursts" ) {
+         ok = parse_uint( argv[++i], 1440, mix.deposit_bursts );
+      } else if ( arg == "--burst-minutes" ) {
+         ok = parse_uint( argv[++i], 1440, mix.burst_minutes ) && mix.burst_minutes > 0;
+      } else if ( arg == "--deposit-stake-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.deposit_stake_percent );
+      } else if ( arg == "--stake-wave-days" ) {
+         ok = parse_uint( argv[++i], 372, mix.stake_wave_days );
+      } else if ( arg == "--stake-wave-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.stake_wave_percent );
+      } else if ( arg == "--unstake-wave-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.unstake_wave_percent );
+      } else if ( arg == "--proxy-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.proxy_percent );
+      } else if ( arg == "--proxy-sync-hours" ) {
+         ok = parse_uint( argv[++i], 24 * 372, mix.proxy_sync_hours );
+      } else if ( arg == "--proxy-sync-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.proxy_sync_percent );
+      } else if ( arg == "--actions-per-block" ) {
+         ok = parse_uint( argv[++i], 100'000, mix.actions_per_block ) && mix.actions_per_block > 0;
+      } else if ( arg == "--compound-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.compound_percent );
+      } else if ( arg == "--harvest-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.harvest_percent );
+      } else if ( arg == "--transfer-percent" ) {
+         ok = parse_percent( argv[++i], 100, mix.transfer_percent );
+      } else if ( arg == "--bp-reward-apr" ) {
+         ok = parse_percent( argv[++i], 100, mix.bp_reward_apr_percent );
+      } else if ( arg == "--rex-fee-apr" ) {
+         ok = parse_percent( argv[++i], 100, mix.rex_fee_apr_percent );
+      } else if ( arg == "--rex-rents" ) {
+         ok = parse_uint( argv[++i], 100'000, mix.rex_rents );
+      } else if ( arg == "--distribute-hours" ) {
+         ok = parse_uint( argv[++i], 24 * 372, mix.distribute_hours );
+      } else {
+         ok = false;
+      }
+      if ( !ok ) {
+         usage( argv[0] );
+         return 1;
+      }
+   }
+
+   if ( output_path.empty() ) {
+      usage( argv[0] );
+      return 1;
+   }
+
+   trace_writer writer;
+   if ( !writer.open( output_path, json ? trace_writer::format::json : trace_writer::format::binary ) ) {
+      std::fprintf( stderr, "cannot open output trace file %s\n", output_path.c_str() );
+      return 1;
+   }
+
+   workload_generator generator( mix, seed, writer );
+   generator.run();
+   writer.close();
+
+   std::fprintf( stderr, "wrote %llu records (%s) for %u accounts over %u days\n", (unsigned long long)generator.records(),
+                 json ? "json" : "binary", mix.accounts, mix.days );
+   for ( size_t t = 0; t < size_t(trace_type::count); ++t ) {
+      if ( generator.records_by_type()[t] > 0 ) {
+         std::fprintf( stderr, "  %-12s %llu\n", trace_type_name( trace_type(t) ), (unsigned long long)generator.records_by_type()[t] );
+      }
+   }
+   return 0;
+}